@@ -0,0 +1,351 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Parameter sweep of the cda scenario.
+//
+// Every combination of the capacities, compression settings, packet sizes,
+// train lengths, codecs, levels and run numbers given on the command line
+// is simulated by a cda process of its own, in its own directory
+// <output>/run-<index>, with up to --jobs processes at a time.  The outcome
+// of each run is gathered in <output>/results.csv and <output>/results.json.
+//
+// ./waf --run "cda-sweep --capacities=1,2,5 --codecs=ns3::ZlibCompressionCodec --levels=1,9 --runs=3"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "ns3/core-module.h"
+#include "src/json/json.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("CdaSweep");
+
+/// One simulation of the sweep
+struct SweepRun
+{
+  uint32_t index;           //!< Position in the sweep
+  uint32_t capacity;        //!< Capacity of the compression link, in Mbps
+  uint32_t compression;     //!< Whether the compression link compresses
+  uint32_t packetSize;      //!< Size of the probe packets
+  uint32_t trainLength;     //!< Packets per probe train
+  std::string codec;        //!< Codec type name
+  uint32_t level;           //!< Codec level
+  uint32_t run;             //!< RngRun of the replica
+  std::string directory;    //!< Working directory of the run
+  int status;               //!< Exit status of the process
+};
+
+/**
+ * \brief Parse a comma-separated list
+ * \param list the list
+ * \return the values
+ */
+template <typename T>
+static std::vector<T>
+ParseList (const std::string &list)
+{
+  std::vector<T> values;
+  std::istringstream iss (list);
+  std::string item;
+  while (std::getline (iss, item, ','))
+    {
+      std::istringstream value (item);
+      T v;
+      value >> v;
+      if (value.fail ())
+        {
+          NS_FATAL_ERROR ("Invalid value \"" << item << "\" in list \"" << list << "\"");
+        }
+      values.push_back (v);
+    }
+  return values;
+}
+
+/**
+ * \brief Create a directory, which may exist already
+ * \param path the directory
+ */
+static void
+MakeDirectory (const std::string &path)
+{
+  if (mkdir (path.c_str (), 0755) < 0 && errno != EEXIST)
+    {
+      NS_FATAL_ERROR ("Cannot create directory \"" << path << "\": " << std::strerror (errno));
+    }
+}
+
+/**
+ * \brief Start the cda process of a run
+ * \param program path of the cda program
+ * \param run the run
+ * \return the process id
+ */
+static pid_t
+StartRun (const std::string &program, const SweepRun &run)
+{
+  std::vector<std::string> args;
+  args.push_back (program);
+  args.push_back ("--config=config.json");
+  args.push_back ("--capacity=" + std::to_string (run.capacity));
+  args.push_back ("--compressionEnabled=" + std::to_string (run.compression));
+  args.push_back ("--packetSize=" + std::to_string (run.packetSize));
+  args.push_back ("--trainLength=" + std::to_string (run.trainLength));
+  args.push_back ("--pcap=0");
+  args.push_back ("--results=result.json");
+  args.push_back ("--RngRun=" + std::to_string (run.run));
+
+  pid_t pid = fork ();
+  if (pid < 0)
+    {
+      NS_FATAL_ERROR ("Cannot fork: " << std::strerror (errno));
+    }
+  if (pid == 0)
+    {
+      std::vector<char *> argv;
+      for (std::vector<std::string>::iterator i = args.begin (); i != args.end (); ++i)
+        {
+          argv.push_back (const_cast<char *> (i->c_str ()));
+        }
+      argv.push_back (0);
+      int log = -1;
+      if (chdir (run.directory.c_str ()) == 0)
+        {
+          log = open ("cda.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        }
+      if (log < 0)
+        {
+          _exit (126);
+        }
+      dup2 (log, STDOUT_FILENO);
+      dup2 (log, STDERR_FILENO);
+      close (log);
+      execv (program.c_str (), &argv[0]);
+      _exit (127);
+    }
+  return pid;
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string capacities = "1";
+  std::string compressions = "1";
+  std::string packetSizes = "1100";
+  std::string trainLengths = "6000";
+  std::string codecs = "ns3::ZlibCompressionCodec";
+  std::string levels = "9";
+  uint32_t runs = 1;
+  uint32_t firstRun = 1;
+  uint32_t jobs = 0;
+  std::string config = "scratch/config.json";
+  std::string output = "cda-sweep";
+  std::string program = argv[0];
+  program = program.substr (0, program.rfind ('/') + 1) + "cda";
+
+  CommandLine cmd;
+  cmd.AddValue ("capacities", "Capacities of the compression link in Mbps", capacities);
+  cmd.AddValue ("compressions", "Compression settings of the compression link, 0 and/or 1", compressions);
+  cmd.AddValue ("packetSizes", "Sizes of the probe packets in bytes", packetSizes);
+  cmd.AddValue ("trainLengths", "Numbers of packets of each probe train", trainLengths);
+  cmd.AddValue ("codecs", "Codec type names", codecs);
+  cmd.AddValue ("levels", "Codec levels", levels);
+  cmd.AddValue ("runs", "Number of replicas of each combination", runs);
+  cmd.AddValue ("firstRun", "RngRun of the first replica", firstRun);
+  cmd.AddValue ("jobs", "Number of simulations run at a time, 0 for one per core", jobs);
+  cmd.AddValue ("config", "JSON config file the runs start from", config);
+  cmd.AddValue ("output", "Directory receiving the runs and results", output);
+  cmd.AddValue ("program", "Path of the cda program", program);
+  cmd.Parse (argc, argv);
+
+  // the runs change directory
+  if (program[0] != '/')
+    {
+      char cwd[4096];
+      if (getcwd (cwd, sizeof (cwd)) == 0)
+        {
+          NS_FATAL_ERROR ("Cannot get the working directory: " << std::strerror (errno));
+        }
+      program = std::string (cwd) + "/" + program;
+    }
+  if (access (program.c_str (), X_OK) < 0)
+    {
+      NS_FATAL_ERROR ("Cannot run the cda program \"" << program << "\", set --program");
+    }
+
+  if (jobs == 0)
+    {
+      jobs = std::max<long> (1, sysconf (_SC_NPROCESSORS_ONLN));
+    }
+
+  Json::Value base;
+  std::ifstream configDoc (config.c_str (), std::ifstream::binary);
+  if (!configDoc)
+    {
+      NS_FATAL_ERROR ("Cannot open config file \"" << config << "\"");
+    }
+  configDoc >> base;
+
+  // Every combination, the replicas of a combination next to each other
+  std::vector<SweepRun> sweep;
+  std::vector<uint32_t> capacityList = ParseList<uint32_t> (capacities);
+  std::vector<uint32_t> compressionList = ParseList<uint32_t> (compressions);
+  std::vector<uint32_t> packetSizeList = ParseList<uint32_t> (packetSizes);
+  std::vector<uint32_t> trainLengthList = ParseList<uint32_t> (trainLengths);
+  std::vector<std::string> codecList = ParseList<std::string> (codecs);
+  std::vector<uint32_t> levelList = ParseList<uint32_t> (levels);
+  MakeDirectory (output);
+  for (uint32_t a = 0; a < capacityList.size (); ++a)
+    for (uint32_t b = 0; b < compressionList.size (); ++b)
+      for (uint32_t c = 0; c < packetSizeList.size (); ++c)
+        for (uint32_t d = 0; d < trainLengthList.size (); ++d)
+          for (uint32_t e = 0; e < codecList.size (); ++e)
+            for (uint32_t f = 0; f < levelList.size (); ++f)
+              for (uint32_t r = 0; r < runs; ++r)
+                {
+                  SweepRun run;
+                  run.index = sweep.size ();
+                  run.capacity = capacityList[a];
+                  run.compression = compressionList[b];
+                  run.packetSize = packetSizeList[c];
+                  run.trainLength = trainLengthList[d];
+                  run.codec = codecList[e];
+                  run.level = levelList[f];
+                  run.run = firstRun + r;
+                  run.directory = output + "/run-" + std::to_string (run.index);
+                  run.status = -1;
+                  MakeDirectory (run.directory);
+                  Json::Value runConfig = base;
+                  runConfig["compression_codec"] = run.codec;
+                  runConfig["compression_level"] = run.level;
+                  std::ofstream out ((run.directory + "/config.json").c_str ());
+                  out << runConfig << std::endl;
+                  sweep.push_back (run);
+                }
+
+  std::cout << "Sweeping " << sweep.size () << " runs on " << jobs << " processes" << std::endl;
+  std::map<pid_t, uint32_t> running;
+  uint32_t next = 0;
+  uint32_t done = 0;
+  while (done < sweep.size ())
+    {
+      while (next < sweep.size () && running.size () < jobs)
+        {
+          running[StartRun (program, sweep[next])] = next;
+          next++;
+        }
+      int status;
+      pid_t pid = waitpid (-1, &status, 0);
+      if (pid < 0)
+        {
+          NS_FATAL_ERROR ("waitpid failed: " << std::strerror (errno));
+        }
+      std::map<pid_t, uint32_t>::iterator i = running.find (pid);
+      if (i == running.end ())
+        {
+          continue;
+        }
+      SweepRun &run = sweep[i->second];
+      run.status = WIFEXITED (status) ? WEXITSTATUS (status) : 128 + WTERMSIG (status);
+      running.erase (i);
+      done++;
+      std::cout << "[" << done << "/" << sweep.size () << "] " << run.directory
+                << (run.status == 0 ? " done" : " failed with status " + std::to_string (run.status))
+                << std::endl;
+    }
+
+  // Gather the outcomes, in sweep order
+  static const char *columns[] = {
+    "capacity", "compression_enabled", "packet_size", "train_length", "codec", "level", "run",
+    "detected", "delta_ms", "confidence", "high_entropy_ms", "low_entropy_ms", "tx_frames", "tx_ratio"
+  };
+  static const uint32_t nColumns = sizeof (columns) / sizeof (columns[0]);
+  Json::Value table (Json::arrayValue);
+  std::ofstream csv ((output + "/results.csv").c_str ());
+  csv << "index,status";
+  for (uint32_t c = 0; c < nColumns; ++c)
+    {
+      csv << "," << columns[c];
+    }
+  csv << std::endl;
+  uint32_t failed = 0;
+  for (std::vector<SweepRun>::iterator run = sweep.begin (); run != sweep.end (); ++run)
+    {
+      Json::Value result;
+      std::ifstream resultDoc ((run->directory + "/result.json").c_str (), std::ifstream::binary);
+      if (run->status != 0 || !(resultDoc >> result))
+        {
+          // what the run was meant to do, without outcome
+          result = Json::Value (Json::objectValue);
+          result["capacity"] = run->capacity;
+          result["compression_enabled"] = run->compression != 0;
+          result["packet_size"] = run->packetSize;
+          result["train_length"] = run->trainLength;
+          result["codec"] = run->codec;
+          result["level"] = run->level;
+          result["run"] = run->run;
+          failed++;
+        }
+      result["index"] = run->index;
+      result["status"] = run->status;
+      table.append (result);
+
+      csv << run->index << "," << run->status;
+      for (uint32_t c = 0; c < nColumns; ++c)
+        {
+          const Json::Value &value = result[columns[c]];
+          csv << ",";
+          if (value.isString ())
+            {
+              csv << value.asString ();
+            }
+          else if (value.isBool ())
+            {
+              csv << value.asBool ();
+            }
+          else if (value.isIntegral ())
+            {
+              csv << value.asLargestInt ();
+            }
+          else if (value.isDouble ())
+            {
+              csv << value.asDouble ();
+            }
+        }
+      csv << std::endl;
+    }
+  std::ofstream json ((output + "/results.json").c_str ());
+  json << table << std::endl;
+
+  std::cout << "Results in " << output << "/results.csv and " << output << "/results.json";
+  if (failed > 0)
+    {
+      std::cout << ", " << failed << " runs failed";
+    }
+  std::cout << std::endl;
+  return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,46 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Offline conversion of the binary trace of a cda run to pcap.
+//
+// The frames sent and received by each device are written to
+// <prefix>-<node>-<device>.pcap, truncated to the snap length the trace was
+// recorded with (cda --traceSnaplen), with their wire size as original
+// length.
+//
+// ./waf --run "cda-trace-to-pcap --input=cda.trace --prefix=cda"
+
+#include <iostream>
+#include "ns3/core-module.h"
+#include "ns3/point-to-point-binary-trace.h"
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  std::string input = "cda.trace";
+  std::string prefix = "cda";
+
+  CommandLine cmd;
+  cmd.AddValue ("input", "Binary trace written by cda --binaryTrace", input);
+  cmd.AddValue ("prefix", "Prefix of the pcap files", prefix);
+  cmd.Parse (argc, argv);
+
+  uint64_t frames = PointToPointBinaryTrace::ConvertToPcap (input, prefix);
+  std::cout << "Wrote " << frames << " frames from " << input << std::endl;
+  return 0;
+}
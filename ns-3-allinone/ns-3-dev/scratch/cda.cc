@@ -16,6 +16,8 @@
 
 // - Tracing of queues and packet receptions to file "cda.tr"
 
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <string>
 #include <iostream>
@@ -34,6 +36,89 @@ using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("Cda");
 
+/**
+ * Append the trains of a JSON list to the cycle of a client, each like
+ * {"packets": 1000, "source": "ns3::EntropyPayloadSource", "attributes": {"Model": "Text"}}
+ */
+static void
+AddTrains (Ptr<CdaClient> client, const Json::Value &trains)
+{
+  for (Json::Value::ArrayIndex i = 0; i < trains.size (); ++i)
+    {
+      const Json::Value &train = trains[i];
+      Ptr<CdaPayloadSource> source;
+      std::string sourceType = train.get ("source", "").asString ();
+      if (!sourceType.empty ())
+        {
+          ObjectFactory factory;
+          factory.SetTypeId (sourceType);
+          const Json::Value &attributes = train["attributes"];
+          for (Json::Value::const_iterator a = attributes.begin (); a != attributes.end (); ++a)
+            {
+              factory.Set (a.name (), StringValue (a->asString ()));
+            }
+          source = factory.Create<CdaPayloadSource> ();
+        }
+      client->AddTrain (source, train["packets"].asUInt ());
+    }
+}
+
+/**
+ * Split an "a.b.c.d/len" prefix of a filter rule into its address and mask.
+ * A bare address stands for a single host, as if given with /32.
+ */
+static void
+ParsePrefix (const std::string &prefix, Ipv4Address &address, Ipv4Mask &mask)
+{
+  std::string::size_type slash = prefix.find ('/');
+  address = Ipv4Address (prefix.substr (0, slash).c_str ());
+  if (slash == std::string::npos)
+    {
+      mask = Ipv4Mask::GetOnes ();
+      return;
+    }
+  std::string length = prefix.substr (slash + 1);
+  if (length.empty () || length.size () > 2
+      || length.find_first_not_of ("0123456789") != std::string::npos
+      || std::atoi (length.c_str ()) > 32)
+    {
+      NS_FATAL_ERROR ("Bad prefix \"" << prefix << "\" in compression filter rule");
+    }
+  mask = Ipv4Mask (prefix.substr (slash).c_str ());
+}
+
+/**
+ * Build the compression filter of a JSON list of rules, each like
+ * {"protocol": 17, "port": 5000, "dscp": 46, "source": "10.1.1.0/24", "action": "bypass"}
+ */
+static Ptr<Ipv4CompressionFilter>
+MakeCompressionFilter (const Json::Value &rules)
+{
+  Ptr<Ipv4CompressionFilter> filter = CreateObject<Ipv4CompressionFilter> ();
+  for (Json::Value::ArrayIndex i = 0; i < rules.size (); ++i)
+    {
+      const Json::Value &r = rules[i];
+      Ipv4CompressionFilter::Rule rule;
+      rule.protocol = r.get ("protocol", -1).asInt ();
+      rule.dscp = r.get ("dscp", -1).asInt ();
+      if (r.isMember ("port"))
+        {
+          rule.destinationPortMin = rule.destinationPortMax = r["port"].asUInt ();
+        }
+      if (r.isMember ("source_port"))
+        {
+          rule.sourcePortMin = rule.sourcePortMax = r["source_port"].asUInt ();
+        }
+      ParsePrefix (r.get ("source", "0.0.0.0/0").asString (), rule.source, rule.sourceMask);
+      ParsePrefix (r.get ("destination", "0.0.0.0/0").asString (),
+                   rule.destination, rule.destinationMask);
+      rule.action = r.get ("action", "bypass").asString () == "compress"
+        ? CompressionFilter::COMPRESS : CompressionFilter::BYPASS;
+      filter->AddRule (rule);
+    }
+  return filter;
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -47,7 +132,17 @@ main (int argc, char *argv[])
   Json::CharReaderBuilder rbuilder;
   // Configure the Builder, then ...
   std::string errs;
-  std::ifstream config_doc("scratch/config.json", std::ifstream::binary);
+  // The config file may be given with --config, see the command line below
+  std::string configFile = "scratch/config.json";
+  for (int i = 1; i < argc; ++i)
+    {
+      std::string arg = argv[i];
+      if (arg.compare (0, 9, "--config=") == 0)
+        {
+          configFile = arg.substr (9);
+        }
+    }
+  std::ifstream config_doc(configFile.c_str (), std::ifstream::binary);
   config_doc >> root;
   // printf("1\n");
   // bool parsingSuccessful = Json::parseFromStream (rbuilder, config_doc, &root, &errs);
@@ -69,6 +164,68 @@ main (int argc, char *argv[])
   std::string compressionProtocol = Json::writeString (wbuilder, outputCompressionProtocol);
   std::cout << "COMPRESSION PROTO: " << compressionProtocol << std::endl;
   int proto = stoi (compressionProtocol);
+  // Codec and level are optional, zlib at level 9 otherwise
+  std::string codec = root.get ("compression_codec", "ns3::ZlibCompressionCodec").asString ();
+  int level = root.get ("compression_level", 9).asInt ();
+  std::cout << "COMPRESSION CODEC: " << codec << " LEVEL: " << level << std::endl;
+  Config::SetDefault ("ns3::ZlibCompressionCodec::Level", IntegerValue (level));
+  // Measure the codec speed on this host instead of using its nominal rate
+  bool calibrate = root.get ("calibrate_codec", false).asBool ();
+  Config::SetDefault ("ns3::CompressionCodec::Calibrate", BooleanValue (calibrate));
+  // Send frames uncompressed when compressing them would not pay off
+  bool adaptive = root.get ("adaptive_compression", false).asBool ();
+  Config::SetDefault ("ns3::PointToPointNetDevice::AdaptiveCompression", BooleanValue (adaptive));
+  // Keep the compression history across frames instead of per frame
+  bool stateful = root.get ("stateful_compression", false).asBool ();
+  Config::SetDefault ("ns3::PointToPointNetDevice::StatefulCompression", BooleanValue (stateful));
+  // Compress the frames queued on the link together, up to aggregation_frames at a time
+  bool aggregation = root.get ("aggregation", false).asBool ();
+  uint32_t aggregationFrames = root.get ("aggregation_frames", 16).asUInt ();
+  Config::SetDefault ("ns3::PointToPointNetDevice::AggregationEnabled", BooleanValue (aggregation));
+  Config::SetDefault ("ns3::PointToPointNetDevice::AggregationMaxFrames", UintegerValue (aggregationFrames));
+  // Compress the IPv4/UDP headers of the probe packets against per-flow contexts
+  bool headerCompression = root.get ("header_compression", false).asBool ();
+  Config::SetDefault ("ns3::PointToPointNetDevice::HeaderCompression", BooleanValue (headerCompression));
+  // Rules choosing per flow whether the compression links compress or bypass
+  const Json::Value compressionFilters = root["compression_filters"];
+  // Compress on this many worker threads; the results do not depend on the number
+  uint32_t compressionThreads = root.get ("compression_threads", 0).asUInt ();
+  Config::SetDefault ("ns3::PointToPointNetDevice::CompressionOffload", BooleanValue (compressionThreads > 0));
+  Config::SetGlobal ("CompressionWorkerThreads", UintegerValue (compressionThreads));
+  // CSV file the compression counters of the compression link are written to
+  std::string compressionSummary = root.get ("compression_summary", "").asString ();
+  // Generator of the high-entropy probe payloads, and the file it replays if any
+  std::string payloadSource = root.get ("payload_source", "ns3::RandomPayloadSource").asString ();
+  std::string payloadFile = root.get ("payload_file", "").asString ();
+  Config::SetDefault ("ns3::CdaClient::PayloadSource", TypeIdValue (TypeId::LookupByName (payloadSource)));
+  Config::SetDefault ("ns3::FilePayloadSource::Filename", StringValue (payloadFile));
+  // Trains of payloads sent in turn, instead of one high-entropy and one all-zero train
+  const Json::Value trains = root["trains"];
+  double trainGap = root.get ("train_gap", 100.0).asDouble ();
+  Config::SetDefault ("ns3::CdaClient::TrainGap", TimeValue (Seconds (trainGap)));
+  // Pacing of the packets of a train, at line rate unless send_rate is given,
+  // and packets sent by a single event when they are due at the same time
+  std::string pacing = root.get ("pacing", "Fixed").asString ();
+  std::string sendRate = root.get ("send_rate", "0bps").asString ();
+  uint32_t burstSize = root.get ("burst_size", 10).asUInt ();
+  uint32_t maxBatch = root.get ("max_batch", 1).asUInt ();
+  Config::SetDefault ("ns3::CdaClient::Pacing", StringValue (pacing));
+  Config::SetDefault ("ns3::CdaClient::Rate", StringValue (sendRate));
+  Config::SetDefault ("ns3::CdaClient::BurstSize", UintegerValue (burstSize));
+  Config::SetDefault ("ns3::CdaClient::MaxBatch", UintegerValue (maxBatch));
+  // Transport of the probes, and concurrent flows of the client, each with
+  // its own trains, e.g. [{"packets": 4000, "start": 0.5, "trains": [...]}]
+  std::string protocol = root.get ("protocol", "ns3::UdpSocketFactory").asString ();
+  Config::SetDefault ("ns3::CdaClient::Protocol", TypeIdValue (TypeId::LookupByName (protocol)));
+  Config::SetDefault ("ns3::CdaServer::Protocol", TypeIdValue (TypeId::LookupByName (protocol)));
+  const Json::Value flows = root["flows"];
+  if (trains.size () > 0)
+    {
+      Config::SetDefault ("ns3::CdaDetector::TrainKinds", UintegerValue (trains.size ()));
+    }
+  // Confidence the detector needs, besides a 100 ms difference of train durations
+  double minConfidence = root.get ("min_confidence", 0.0).asDouble ();
+  Config::SetDefault ("ns3::CdaDetector::MinConfidence", DoubleValue (minConfidence));
   // End json parsing
   
   Config::SetDefault ("ns3::QueueBase::MaxSize", StringValue ("6000p"));
@@ -83,50 +240,143 @@ main (int argc, char *argv[])
 
   uint32_t capacity = 1;
   bool compressionEnabled = 1;
+  bool compressionEngine = 0;
+  uint32_t packetSize = 1100;
+  uint32_t trainLength = 6000;
+  bool pcap = 1;
+  std::string binaryTrace;
+  uint32_t traceSnaplen = 0;
+  std::string resultFile;
 
+  cmd.AddValue ("config", "JSON config file", configFile);
   cmd.AddValue ("capacity", "Capacity of compression link in Mbps", capacity);
   cmd.AddValue ("compressionEnabled", "Enable or disable compression link", compressionEnabled);
+  cmd.AddValue ("compressionEngine", "Charge codec processing time on the compression link", compressionEngine);
+  cmd.AddValue ("packetSize", "Size of the probe packets in bytes", packetSize);
+  cmd.AddValue ("trainLength", "Number of packets of each probe train", trainLength);
+  cmd.AddValue ("pcap", "Write pcap traces of the links", pcap);
+  cmd.AddValue ("binaryTrace", "Log the frames of the links to this compact binary trace instead of pcap", binaryTrace);
+  cmd.AddValue ("traceSnaplen", "Frame bytes logged with each event of the binary trace", traceSnaplen);
+  cmd.AddValue ("results", "JSON file receiving the outcome of the run", resultFile);
   cmd.Parse (argc, argv);
 
   std::cout << "Capacity of Compression link: " << capacity << std::endl;
   std::cout << "Compression Enabled: " << compressionEnabled << std::endl;
 
-  // Explicitly create the nodes required by the topology (shown above).
-
-  NodeContainer n;
-  n.Create (4);
-
+  // The topology, by default the chain
   //
-  NodeContainer n0n1 = NodeContainer (n.Get (0), n.Get (1));
-  NodeContainer n1n2 = NodeContainer (n.Get (1), n.Get (2));
-  NodeContainer n2n3 = NodeContainer (n.Get (2), n.Get (3));
-
-  PointToPointHelper p2p1;
-  p2p1.SetDeviceAttribute ("DataRate", StringValue ("8Mbps"));
-  p2p1.SetDeviceAttribute ("CompressionEnabled", BooleanValue (0));
+  //   client 0 --8Mbps-- 1 --capacity, compressed-- 2 --8Mbps-- 3 server
+  //
+  Json::Value topology = root["topology"];
+  if (topology.isNull ())
+    {
+      topology["nodes"] = 4;
+      topology["client"] = 0;
+      topology["server"] = 3;
+      for (int i = 0; i < 3; ++i)
+        {
+          Json::Value link;
+          link["from"] = i;
+          link["to"] = i + 1;
+          link["compression"] = (i == 1);
+          topology["links"].append (link);
+        }
+    }
 
-  PointToPointHelper p2p2;
-  p2p2.SetDeviceAttribute ("DataRate", StringValue (std::to_string (capacity) + "Mbps"));
-  p2p2.SetDeviceAttribute ("CompressionEnabled", BooleanValue (compressionEnabled));
-  p2p2.SetDeviceAttribute ("CompressionProtocol", IntegerValue (proto));
+  // The system of each node, e.g. [0, 0, 1, 1]: the systems are simulated
+  // in parallel by the threads of a MultithreadedSimulatorImpl
+  const Json::Value &partitions = topology["partitions"];
+  uint32_t systems = 1;
+  for (Json::Value::ArrayIndex i = 0; i < partitions.size (); ++i)
+    {
+      systems = std::max (systems, partitions[i].asUInt () + 1);
+    }
+  if (systems > 1)
+    {
+      NS_ABORT_MSG_IF (!binaryTrace.empty (), "The binary trace is shared by all the links: it needs a single partition");
+      NS_ABORT_MSG_IF (compressionThreads > 0, "The compression worker pool is shared by all the links: it needs a single partition");
+#ifndef NS3_MULTITHREADED
+      NS_FATAL_ERROR ("Partitions need a build configured with --enable-multithreaded");
+#endif
+      Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+    }
 
-  PointToPointHelper p2p3;
-  p2p3.SetDeviceAttribute ("DataRate", StringValue ("8Mbps"));
-  p2p3.SetDeviceAttribute ("CompressionEnabled", BooleanValue (0));
+  NodeContainer n;
+  for (uint32_t i = 0; i < topology["nodes"].asUInt (); ++i)
+    {
+      n.Create (1, partitions.isValidIndex (i) ? partitions[i].asUInt () : 0);
+    }
 
-  NetDeviceContainer c0c1 = p2p1.Install (n0n1);
-  NetDeviceContainer c1c2 = p2p2.Install (n1n2);
-  NetDeviceContainer c2c3 = p2p3.Install (n2n3);
+  // Links, and the devices of the compression links
+  std::vector<PointToPointHelper> p2p;
+  std::vector<NodeContainer> linkNodes;
+  std::vector<NetDeviceContainer> linkDevices;
+  NetDeviceContainer compressionDevices;
+  const Json::Value &links = topology["links"];
+  for (Json::Value::ArrayIndex i = 0; i < links.size (); ++i)
+    {
+      // {"from": 1, "to": 2, "rate": "2Mbps", "delay": "10ms", "queue": "1000p",
+      //  "compression": true, "codec": "ns3::ZlibCompressionCodec", "level": 6}
+      const Json::Value &link = links[i];
+      bool compression = link.get ("compression", false).asBool ();
+      std::string defaultRate = compression ? std::to_string (capacity) + "Mbps" : "8Mbps";
+      PointToPointHelper helper;
+      helper.SetDeviceAttribute ("DataRate", StringValue (link.get ("rate", defaultRate).asString ()));
+      helper.SetChannelAttribute ("Delay", StringValue (link.get ("delay", "0ms").asString ()));
+      if (link.isMember ("queue"))
+        {
+          helper.SetQueue ("ns3::DropTailQueue<Packet>", "MaxSize", StringValue (link["queue"].asString ()));
+        }
+      helper.SetDeviceAttribute ("CompressionEnabled", BooleanValue (compression && compressionEnabled));
+      if (compression)
+        {
+          helper.SetDeviceAttribute ("CompressionProtocol", IntegerValue (proto));
+          helper.SetDeviceAttribute ("CompressionEngineEnabled", BooleanValue (compressionEngine));
+        }
+      NodeContainer nodes (n.Get (link["from"].asUInt ()), n.Get (link["to"].asUInt ()));
+      NetDeviceContainer devices = helper.Install (nodes);
+      if (compression)
+        {
+          // Both ends use the codec of the link, at its level
+          std::string linkCodec = link.get ("codec", codec).asString ();
+          ObjectFactory factory;
+          factory.SetTypeId (linkCodec);
+          struct TypeId::AttributeInformation info;
+          if (TypeId::LookupByName (linkCodec).LookupAttributeByName ("Level", &info))
+            {
+              factory.Set ("Level", IntegerValue (link.get ("level", level).asInt ()));
+            }
+          for (uint32_t d = 0; d < devices.GetN (); ++d)
+            {
+              Ptr<PointToPointNetDevice> device = DynamicCast<PointToPointNetDevice> (devices.Get (d));
+              device->SetCompressionCodec (factory.Create<CompressionCodec> ());
+              if (compressionFilters.size () > 0)
+                {
+                  device->AddCompressionFilter (MakeCompressionFilter (compressionFilters));
+                }
+            }
+          compressionDevices.Add (devices);
+        }
+      p2p.push_back (helper);
+      linkNodes.push_back (nodes);
+      linkDevices.push_back (devices);
+    }
 
   InternetStackHelper stack;
   stack.Install (n);
 
+  // A subnet per link
   Ipv4AddressHelper address;
   address.SetBase ("10.1.1.0", "255.255.255.0");
+  for (uint32_t i = 0; i < linkDevices.size (); ++i)
+    {
+      address.Assign (linkDevices[i]);
+      address.NewNetwork ();
+    }
 
-  Ipv4InterfaceContainer i0i1 = address.Assign (c0c1);
-  Ipv4InterfaceContainer i1i2 = address.Assign (c1c2);
-  Ipv4InterfaceContainer i2i3 = address.Assign (c2c3);
+  Ptr<Node> clientNode = n.Get (topology["client"].asUInt ());
+  Ptr<Node> serverNode = n.Get (topology["server"].asUInt ());
+  Ipv4Address serverAddress = serverNode->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ();
 
   Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
 
@@ -140,52 +390,109 @@ main (int argc, char *argv[])
   uint16_t port = 9; // well-known echo port number
 
   CdaServerHelper server (port);
-  ApplicationContainer apps = server.Install (n.Get (3));
+  ApplicationContainer apps = server.Install (serverNode);
+  Ptr<CdaServer> cdaServer = DynamicCast<CdaServer> (apps.Get (0));
   apps.Start (Seconds (start));
   apps.Stop (Seconds (stop));
 
   //
-  // Create a CdaClient application to send UDP datagrams from node zero to
-  // node three.
+  // Create a CdaClient application to send UDP datagrams from the client
+  // node to the server node.
   //
-  uint32_t packetSize = 1100;
-  uint32_t maxPacketCount = 12000;
+  uint32_t maxPacketCount = 2 * trainLength;
 
   Time interPacketInterval = MicroSeconds (0);
-  CdaClientHelper client (i2i3.GetAddress (1), port);
+  CdaClientHelper client (serverAddress, port);
   client.SetAttribute ("MaxPackets", UintegerValue (maxPacketCount));
   client.SetAttribute ("Interval", TimeValue (interPacketInterval));
   client.SetAttribute ("PacketSize", UintegerValue (packetSize));
-  apps = client.Install (n.Get (0));
-  apps.Start (Seconds (start + 1));
-  apps.Stop (Seconds (stop));
+  if (flows.size () == 0)
+    {
+      apps = client.Install (clientNode);
+      AddTrains (apps.Get (0)->GetObject<CdaClient> (), trains);
+      apps.Start (Seconds (start + 1));
+      apps.Stop (Seconds (stop));
+    }
+  for (Json::Value::ArrayIndex i = 0; i < flows.size (); ++i)
+    {
+      const Json::Value &flow = flows[i];
+      client.SetAttribute ("MaxPackets", UintegerValue (flow.get ("packets", maxPacketCount).asUInt ()));
+      apps = client.Install (clientNode);
+      AddTrains (apps.Get (0)->GetObject<CdaClient> (), flow.isMember ("trains") ? flow["trains"] : trains);
+      apps.Start (Seconds (start + 1 + flow.get ("start", 0.0).asDouble ()));
+      apps.Stop (Seconds (stop));
+    }
 
   AsciiTraceHelper ascii;
   // p2p.EnableAsciiAll (ascii.CreateFileStream ("cda.tr"));
 
-  p2p1.EnablePcap ("l1-cda", n0n1, false);
-  p2p2.EnablePcap ("l1-cda", n1n2, false);
-  p2p3.EnablePcap ("l1-cda", n2n3, false);
+  if (!compressionSummary.empty ())
+    {
+      PointToPointHelper::EnableCompressionSummary (compressionSummary, compressionDevices);
+    }
 
-  if (compressionEnabled)
+  if (!binaryTrace.empty ())
     {
-      std::string fileName = "cda-" + std::to_string (capacity) + "-compression-";
-      p2p1.EnablePcapAll (fileName, false);
-      p2p2.EnablePcapAll (fileName, false);
-      p2p3.EnablePcapAll (fileName, false);
+      NetDeviceContainer traced;
+      for (uint32_t i = 0; i < linkDevices.size (); ++i)
+        {
+          traced.Add (linkDevices[i]);
+        }
+      PointToPointHelper::EnableBinaryTrace (binaryTrace, traced, traceSnaplen);
     }
-  else
+  else if (pcap)
     {
-      std::string fileName = "cda-" + std::to_string (capacity) + "-noCompression-";
-      p2p1.EnablePcapAll (fileName, false);
-      p2p2.EnablePcapAll (fileName, false);
-      p2p1.EnablePcapAll (fileName, false);
+      for (uint32_t i = 0; i < p2p.size (); ++i)
+        {
+          p2p[i].EnablePcap ("l1-cda", linkNodes[i], false);
+        }
+      std::string fileName = "cda-" + std::to_string (capacity)
+        + (compressionEnabled ? "-compression-" : "-noCompression-");
+      p2p[0].EnablePcapAll (fileName, false);
     }
 
   //
   // Now, do the actual simulation.
   //
   Simulator::Run ();
+
+  if (!resultFile.empty ())
+    {
+      // Outcome of the run, gathered by cda-sweep
+      Ptr<CdaDetector> detector = cdaServer->GetDetector ();
+      // counters of the first compression link, in the direction of the server
+      UintegerValue txFrames, txOriginal, txCompressed;
+      if (compressionDevices.GetN () > 0)
+        {
+          Ptr<NetDevice> device = compressionDevices.Get (0);
+          device->GetAttribute ("CompressTxFrames", txFrames);
+          device->GetAttribute ("CompressTxOriginalBytes", txOriginal);
+          device->GetAttribute ("CompressTxCompressedBytes", txCompressed);
+        }
+      UintegerValue run;
+      GlobalValue::GetValueByName ("RngRun", run);
+
+      Json::Value result;
+      result["capacity"] = capacity;
+      result["compression_enabled"] = compressionEnabled;
+      result["packet_size"] = packetSize;
+      result["train_length"] = trainLength;
+      result["codec"] = codec;
+      result["level"] = level;
+      result["run"] = Json::UInt64 (run.Get ());
+      result["detected"] = detector->IsCompressionDetected ();
+      result["delta_ms"] = Json::Int64 (detector->GetDelta ().GetMilliSeconds ());
+      result["confidence"] = detector->GetConfidence ();
+      result["high_entropy_ms"] = Json::Int64 (detector->GetTrainDuration (0).GetMilliSeconds ());
+      result["low_entropy_ms"] = Json::Int64 (detector->GetTrainDuration (1).GetMilliSeconds ());
+      result["tx_frames"] = Json::UInt64 (txFrames.Get ());
+      result["tx_ratio"] = txCompressed.Get () > 0 ? double (txOriginal.Get ()) / txCompressed.Get () : 0.0;
+      result["flows"] = cdaServer->GetNFlows ();
+      result["throughput_bps"] = cdaServer->GetThroughput ();
+      result["fairness"] = cdaServer->GetFairness ();
+      std::ofstream out (resultFile.c_str ());
+      out << Json::writeString (wbuilder, result) << std::endl;
+    }
   Simulator::Simulator::Destroy ();
   NS_LOG_INFO ("Done.");
   return 0;
@@ -31,8 +31,9 @@ namespace ns3 {
 
 /**
  * \ingroup Cda
- * \brief Create a server application which waits for input UDP packets
- *        and sends them back to the original sender.
+ * \brief Create a server application which waits for input UDP packets,
+ *        or TCP connections when its Protocol attribute says so, and sends
+ *        them back to the original sender.
  */
 class CdaServerHelper
 {
@@ -101,7 +102,8 @@ private:
 
 /**
  * \ingroup Cda
- * \brief Create an application which sends a UDP packet and waits for an echo of this packet
+ * \brief Create an application which sends UDP packets, or a TCP stream when
+ * its Protocol attribute says so, and waits for an echo of these packets
  */
 class CdaClientHelper
 {
@@ -15,9 +15,6 @@
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
-#include <fstream>
-using namespace std;
-
 #include "ns3/log.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv6-address.h"
@@ -30,8 +27,13 @@ using namespace std;
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
 #include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/udp-socket-factory.h"
 #include "ns3/trace-source-accessor.h"
+#include "ns3/object-factory.h"
 #include "cda-client.h"
+#include "cda-payload-source.h"
 
 namespace ns3 {
 
@@ -56,6 +58,29 @@ CdaClient::GetTypeId (void)
                    TimeValue (Seconds (1.0)),
                    MakeTimeAccessor (&CdaClient::m_interval),
                    MakeTimeChecker ())
+    .AddAttribute ("Rate",
+                   "The rate at which the payloads of a train are sent, overriding "
+                   "Interval unless zero",
+                   DataRateValue (DataRate ()),
+                   MakeDataRateAccessor (&CdaClient::m_rate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("Pacing",
+                   "How the packets of a train are spaced",
+                   EnumValue (PACING_FIXED),
+                   MakeEnumAccessor (&CdaClient::m_pacing),
+                   MakeEnumChecker (PACING_FIXED, "Fixed",
+                                    PACING_POISSON, "Poisson",
+                                    PACING_BURST, "Burst"))
+    .AddAttribute ("BurstSize",
+                   "The number of packets sent back to back in burst pacing",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&CdaClient::m_burstSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxBatch",
+                   "The largest number of packets due at the same time sent by a single event",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&CdaClient::m_maxBatch),
+                   MakeUintegerChecker<uint32_t> (1))
     .AddAttribute ("RemoteAddress", 
                    "The destination Address of the outbound packets",
                    AddressValue (),
@@ -71,6 +96,21 @@ CdaClient::GetTypeId (void)
                    MakeUintegerAccessor (&CdaClient::SetDataSize,
                                          &CdaClient::GetDataSize),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("PayloadSource",
+                   "Type of the CdaPayloadSource generating the high-entropy payloads",
+                   TypeIdValue (RandomPayloadSource::GetTypeId ()),
+                   MakeTypeIdAccessor (&CdaClient::m_payloadSourceTypeId),
+                   MakeTypeIdChecker ())
+    .AddAttribute ("Protocol",
+                   "The type of protocol to use, e.g. ns3::UdpSocketFactory or ns3::TcpSocketFactory",
+                   TypeIdValue (UdpSocketFactory::GetTypeId ()),
+                   MakeTypeIdAccessor (&CdaClient::m_protocolTid),
+                   MakeTypeIdChecker ())
+    .AddAttribute ("TrainGap",
+                   "The time to wait between the last packet of a train and the first of the next",
+                   TimeValue (Seconds (100.0)),
+                   MakeTimeAccessor (&CdaClient::m_trainGap),
+                   MakeTimeChecker ())
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&CdaClient::m_txTrace),
                      "ns3::Packet::TracedCallback")
@@ -95,6 +135,12 @@ CdaClient::CdaClient ()
   m_sendEvent = EventId ();
   m_data = 0;
   m_dataSize = 0;
+  m_payloadSource = 0;
+  m_train = 0;
+  m_trainSent = 0;
+  m_burstSent = 0;
+  m_poisson = 0;
+  m_blocked = false;
 }
 
 CdaClient::~CdaClient()
@@ -122,10 +168,96 @@ CdaClient::SetRemote (Address addr)
   m_peerAddress = addr;
 }
 
+void
+CdaClient::SetPayloadSource (Ptr<CdaPayloadSource> source)
+{
+  NS_LOG_FUNCTION (this << source);
+  m_payloadSource = source;
+}
+
+Ptr<CdaPayloadSource>
+CdaClient::GetPayloadSource (void)
+{
+  if (m_payloadSource == 0)
+    {
+      ObjectFactory factory;
+      factory.SetTypeId (m_payloadSourceTypeId);
+      m_payloadSource = factory.Create<CdaPayloadSource> ();
+    }
+  return m_payloadSource;
+}
+
+void
+CdaClient::AddTrain (Ptr<CdaPayloadSource> source, uint32_t packets)
+{
+  NS_LOG_FUNCTION (this << source << packets);
+  NS_ASSERT_MSG (packets > 0, "Empty train");
+  Train train;
+  train.source = source;
+  train.packets = packets;
+  m_trains.push_back (train);
+}
+
+Ptr<ExponentialRandomVariable>
+CdaClient::GetPoisson (void)
+{
+  // Created on first use, so the other pacings leave the automatic stream
+  // numbers of the simulation as they were
+  if (m_poisson == 0)
+    {
+      m_poisson = CreateObject<ExponentialRandomVariable> ();
+    }
+  return m_poisson;
+}
+
+Time
+CdaClient::GetMeanInterval (void) const
+{
+  if (m_rate.GetBitRate () > 0)
+    {
+      return m_rate.CalculateBytesTxTime (m_size);
+    }
+  return m_interval;
+}
+
+int64_t
+CdaClient::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  int64_t currentStream = stream;
+  currentStream += GetPayloadSource ()->AssignStreams (currentStream);
+  for (std::vector<Train>::iterator i = m_trains.begin (); i != m_trains.end (); ++i)
+    {
+      if (i->source != 0 && i->source != m_payloadSource)
+        {
+          currentStream += i->source->AssignStreams (currentStream);
+        }
+    }
+  if (m_pacing == PACING_POISSON)
+    {
+      GetPoisson ()->SetStream (currentStream++);
+    }
+  return (currentStream - stream);
+}
+
 void
 CdaClient::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  for (std::vector<Train>::iterator i = m_trains.begin (); i != m_trains.end (); ++i)
+    {
+      if (i->source != 0)
+        {
+          i->source->Dispose ();
+        }
+    }
+  m_trains.clear ();
+  m_poisson = 0;
+  if (m_payloadSource != 0)
+    {
+      m_payloadSource->Dispose ();
+      m_payloadSource = 0;
+    }
   Application::DoDispose ();
 }
 
@@ -136,8 +268,7 @@ CdaClient::StartApplication (void)
 
   if (m_socket == 0)
     {
-      TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
-      m_socket = Socket::CreateSocket (GetNode (), tid);
+      m_socket = Socket::CreateSocket (GetNode (), m_protocolTid);
       if (Ipv4Address::IsMatchingType(m_peerAddress) == true)
         {
           if (m_socket->Bind () == -1)
@@ -177,7 +308,27 @@ CdaClient::StartApplication (void)
     }
 
   m_socket->SetRecvCallback (MakeCallback (&CdaClient::HandleRead, this));
-  m_socket->SetAllowBroadcast (true);
+  m_socket->SetSendCallback (MakeCallback (&CdaClient::HandleSend, this));
+  if (m_socket->GetSocketType () != Socket::NS3_SOCK_STREAM)
+    {
+      m_socket->SetAllowBroadcast (true);
+    }
+  if (m_trains.empty ())
+    {
+      if (m_count / 2 > 0)
+        {
+          AddTrain (GetPayloadSource (), m_count / 2);
+        }
+      if (m_count - m_count / 2 > 0)
+        {
+          AddTrain (0, m_count - m_count / 2);
+        }
+    }
+  if (m_count == 0 || m_trains.empty ())
+    {
+      NS_LOG_LOGIC ("Nothing to send");
+      return;
+    }
   ScheduleTransmit (Seconds (0.));
 }
 
@@ -190,9 +341,11 @@ CdaClient::StopApplication ()
     {
       m_socket->Close ();
       m_socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+      m_socket->SetSendCallback (MakeNullCallback<void, Ptr<Socket>, uint32_t> ());
       m_socket = 0;
     }
 
+  m_blocked = false;
   Simulator::Cancel (m_sendEvent);
 }
 
@@ -233,45 +386,81 @@ CdaClient::Send (void)
 
   NS_ASSERT (m_sendEvent.IsExpired ());
 
+  Time gap;
+  uint32_t batch = 0;
+  do
+    {
+      if (m_socket->GetSocketType () == Socket::NS3_SOCK_STREAM
+          && m_socket->GetTxAvailable () < m_size)
+        {
+          // resumed by HandleSend
+          NS_LOG_LOGIC ("Send buffer full, waiting");
+          m_blocked = true;
+          return;
+        }
+      gap = GetNextGap (SendPacket ());
+    }
+  while (gap.IsZero () && ++batch < m_maxBatch && m_sent < m_count);
+
+  if (m_sent < m_count)
+    {
+      ScheduleTransmit (gap);
+    }
+}
+
+Time
+CdaClient::GetNextGap (bool trainEnd)
+{
+  if (trainEnd)
+    {
+      m_burstSent = 0;
+      return m_trainGap;
+    }
+  Time interval = GetMeanInterval ();
+  switch (m_pacing)
+    {
+    case PACING_POISSON:
+      return Seconds (GetPoisson ()->GetValue (interval.GetSeconds (), 0));
+    case PACING_BURST:
+      if (++m_burstSent < m_burstSize)
+        {
+          return Seconds (0);
+        }
+      m_burstSent = 0;
+      // Bursts start BurstSize intervals apart, for the same mean rate
+      return interval * static_cast<int64_t> (m_burstSize);
+    default:
+      return interval;
+    }
+}
+
+bool
+CdaClient::SendPacket (void)
+{
+  NS_LOG_FUNCTION (this);
+
   Ptr<Packet> p;
-  if (m_sent < m_count / 2)
+  const Train &train = m_trains[m_train];
+  if (train.source != 0)
     {
       //
-      // If m_dataSize is non-zero, we have a data buffer of the same size that we
-      // are expected to copy and send.  This state of affairs is created if one of
-      // the Fill functions is called.  In this case, m_size must have been set
-      // to agree with m_dataSize
+      // The payloads of the source are written to a buffer reused across
+      // packets.
       //
-      delete [] m_data;
-      m_data = new uint8_t [m_size];
-      m_dataSize = m_size;
-      ifstream file;
-      file.open ("/dev/random");
-      if (file.is_open ())
+      if (m_data == 0 || m_dataSize != m_size)
         {
-          // file.seekg(m_sent*1100);
-          char c;
-          uint32_t j = 0;
-          while(j < m_size)
-            {
-              c = file.get();
-              for (int i = 0; i < 8; i++)
-                {
-                  m_data[j]  = ((c >> i) & 1);
-                  j++;
-                }
-            }
+          delete [] m_data;
+          m_data = new uint8_t [m_size];
+          m_dataSize = m_size;
         }
+      train.source->Fill (m_data, m_dataSize);
       p = Create<Packet> (m_data, m_dataSize);
     }
   else
     {
       //
-      // If m_dataSize is zero, the client has indicated that it doesn't care
-      // about the data itself either by specifying the data size by setting
-      // the corresponding attribute or by not calling a SetFill function.  In
-      // this case, we don't worry about it either.  But we do allow m_size
-      // to have a value different from the (zero) m_dataSize.
+      // A train without source sends all-zero payloads, which need no
+      // buffer at all.
       //
       p = Create<Packet> (m_size);
     }
@@ -290,6 +479,12 @@ CdaClient::Send (void)
     }
   m_socket->Send (p);
   ++m_sent;
+  bool trainEnd = (++m_trainSent == train.packets);
+  if (trainEnd)
+    {
+      m_trainSent = 0;
+      m_train = (m_train + 1) % m_trains.size ();
+    }
 
   if (Ipv4Address::IsMatchingType (m_peerAddress))
     {
@@ -312,13 +507,17 @@ CdaClient::Send (void)
                    Inet6SocketAddress::ConvertFrom (m_peerAddress).GetIpv6 () << " port " << Inet6SocketAddress::ConvertFrom (m_peerAddress).GetPort ());
     }
 
-  if (m_sent == m_count / 2) 
-    {
-      ScheduleTransmit (Seconds (100.) );
-    } 
-  else if (m_sent < m_count)
+  return trainEnd;
+}
+
+void
+CdaClient::HandleSend (Ptr<Socket> socket, uint32_t available)
+{
+  NS_LOG_FUNCTION (this << socket << available);
+  if (m_blocked && available >= m_size)
     {
-      ScheduleTransmit (m_interval);
+      m_blocked = false;
+      Send ();
     }
 }
 
@@ -24,17 +24,38 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/traced-callback.h"
+#include "ns3/data-rate.h"
+#include <vector>
 
 namespace ns3 {
 
 class Socket;
 class Packet;
+class CdaPayloadSource;
+class ExponentialRandomVariable;
 
 /**
  * \ingroup Cda
  * \brief A Cda client
  *
  * Every packet sent should be returned by the server and received here.
+ *
+ * The packets are sent in trains of payloads of the same kind, separated
+ * by TrainGap, and the trains are cycled through until MaxPackets packets
+ * are sent.  Unless trains are added with AddTrain, the client sends a
+ * train of MaxPackets / 2 high-entropy payloads from the PayloadSource,
+ * then a train of all-zero payloads.
+ *
+ * Within a train the packets are paced one Interval apart on average, or
+ * at Rate if it is set, either at fixed times, as a Poisson process, or
+ * in bursts of BurstSize back-to-back packets.  Packets due at the same
+ * time are sent from the same event, up to MaxBatch at a time, which
+ * saves simulator events when the client sends at line rate.
+ *
+ * The payloads are sent over UDP, or over the socket type given by
+ * Protocol.  Over TCP, a payload that does not fit in the send buffer
+ * waits until the buffer drains, so with a zero Interval the client is a
+ * bulk sender limited by congestion control.
  */
 class CdaClient : public Application 
 {
@@ -45,6 +66,14 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  /// How the packets of a train are spaced
+  enum Pacing
+  {
+    PACING_FIXED,       //!< One Interval between packets
+    PACING_POISSON,     //!< Exponential times between packets, of mean Interval
+    PACING_BURST        //!< BurstSize packets back to back every BurstSize Intervals
+  };
+
   CdaClient ();
 
   virtual ~CdaClient ();
@@ -86,6 +115,42 @@ public:
    */
   uint32_t GetDataSize (void) const;
 
+  /**
+   * \brief Set the generator of the high-entropy payloads
+   * \param source the payload source
+   */
+  void SetPayloadSource (Ptr<CdaPayloadSource> source);
+
+  /**
+   * \brief Get the generator of the high-entropy payloads, creating it
+   * from the PayloadSource attribute on first use
+   * \return the payload source
+   */
+  Ptr<CdaPayloadSource> GetPayloadSource (void);
+
+  /**
+   * \brief Append a train to the cycle of trains sent
+   *
+   * \param source the generator of the payloads of the train, or 0 for
+   * all-zero payloads
+   * \param packets number of packets of the train
+   */
+  void AddTrain (Ptr<CdaPayloadSource> source, uint32_t packets);
+
+  /**
+   * \brief Get the mean time between the packets of a train
+   * \return Interval, or the time to send a packet at Rate if it is set
+   */
+  Time GetMeanInterval (void) const;
+
+  /**
+   * \brief Assign a fixed random variable stream number to the random
+   * variables used by the pacing and the payload sources
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this application
+   */
+  int64_t AssignStreams (int64_t stream);
 
 protected:
   virtual void DoDispose (void);
@@ -101,9 +166,25 @@ private:
    */
   void ScheduleTransmit (Time dt);
   /**
-   * \brief Send a packet
+   * \brief Send the packets due now, up to MaxBatch of them, and schedule
+   * the next transmission
    */
   void Send (void);
+  /**
+   * \brief Send a packet
+   * \return whether the packet ends its train
+   */
+  bool SendPacket (void);
+  /**
+   * \return the generator of the times between packets in Poisson pacing
+   */
+  Ptr<ExponentialRandomVariable> GetPoisson (void);
+  /**
+   * \brief Get the time to wait before the next packet
+   * \param trainEnd whether the packet just sent ends its train
+   * \return the time until the next packet is due
+   */
+  Time GetNextGap (bool trainEnd);
 
   /**
    * \brief Handle a packet reception.
@@ -114,15 +195,45 @@ private:
    */
   void HandleRead (Ptr<Socket> socket);
 
+  /**
+   * \brief Resume sending once a full send buffer drains
+   *
+   * \param socket the socket
+   * \param available the space available in its send buffer
+   */
+  void HandleSend (Ptr<Socket> socket, uint32_t available);
+
   uint32_t m_count; //!< Maximum number of packets the application will send
   Time m_interval; //!< Packet inter-send time
+  DataRate m_rate; //!< Sending rate within a train, overriding m_interval if set
+  Pacing m_pacing; //!< How the packets of a train are spaced
+  uint32_t m_burstSize; //!< Packets per burst in burst pacing
+  uint32_t m_burstSent; //!< Packets of the current burst already sent
+  uint32_t m_maxBatch; //!< Most packets sent by a single event
+  Ptr<ExponentialRandomVariable> m_poisson; //!< Times between packets in Poisson pacing
   uint32_t m_size; //!< Size of the sent packet
 
   uint32_t m_dataSize; //!< packet payload size (must be equal to m_size)
   uint8_t *m_data; //!< packet payload data
+  TypeId m_payloadSourceTypeId; //!< Type of the payload source created on first use
+  Ptr<CdaPayloadSource> m_payloadSource; //!< Generator of the high-entropy payloads
+
+  /// A train of packets whose payloads come from the same source
+  struct Train
+  {
+    Ptr<CdaPayloadSource> source; //!< Generator of the payloads, or 0 for zeros
+    uint32_t packets; //!< Number of packets of the train
+  };
+
+  std::vector<Train> m_trains; //!< Trains sent in turn
+  uint32_t m_train; //!< Index of the train being sent
+  uint32_t m_trainSent; //!< Packets of the current train already sent
+  Time m_trainGap; //!< Time between the end of a train and the next one
 
   uint32_t m_sent; //!< Counter for sent packets
   Ptr<Socket> m_socket; //!< Socket
+  TypeId m_protocolTid; //!< Type of the socket factory
+  bool m_blocked; //!< Whether sending waits for space in the send buffer
   Address m_peerAddress; //!< Remote peer address
   uint16_t m_peerPort; //!< Remote peer port
   EventId m_sendEvent; //!< Event to send the next packet
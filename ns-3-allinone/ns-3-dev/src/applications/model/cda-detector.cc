@@ -0,0 +1,228 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cmath>
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "cda-detector.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CdaDetector");
+
+NS_OBJECT_ENSURE_REGISTERED (CdaDetector);
+
+TypeId
+CdaDetector::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CdaDetector")
+    .SetParent<Object> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<CdaDetector> ()
+    .AddAttribute ("TrainGap",
+                   "Silence between two arrivals that starts a new train",
+                   TimeValue (Seconds (1.0)),
+                   MakeTimeAccessor (&CdaDetector::m_trainGap),
+                   MakeTimeChecker ())
+    .AddAttribute ("Threshold",
+                   "Smallest difference of mean train durations detected as compression",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&CdaDetector::m_threshold),
+                   MakeTimeChecker ())
+    .AddAttribute ("TrainKinds",
+                   "Number of kinds of trains the client cycles through",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&CdaDetector::m_nKinds),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MinConfidence",
+                   "Smallest confidence that the kinds differ detected as compression",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&CdaDetector::m_minConfidence),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+  ;
+  return tid;
+}
+
+CdaDetector::KindStatistics::KindStatistics ()
+  : median (0.5),
+    p95 (0.95)
+{
+}
+
+CdaDetector::CdaDetector ()
+  : m_nKinds (2),
+    m_nTrains (0),
+    m_inTrain (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CdaDetector::~CdaDetector ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CdaDetector::KindStatistics &
+CdaDetector::GetCurrentKind (void)
+{
+  if (m_kinds.size () != m_nKinds)
+    {
+      m_kinds.resize (m_nKinds);
+    }
+  return m_kinds[m_nTrains % m_nKinds];
+}
+
+void
+CdaDetector::Receive (Time now)
+{
+  NS_LOG_FUNCTION (this << now);
+  if (m_inTrain && now - m_lastArrival > m_trainGap)
+    {
+      Stop ();
+    }
+  if (!m_inTrain)
+    {
+      NS_LOG_LOGIC ("Train " << m_nTrains << " starts at " << now);
+      m_inTrain = true;
+      m_trainStart = now;
+    }
+  else
+    {
+      KindStatistics &kind = GetCurrentKind ();
+      double interArrival = (now - m_lastArrival).GetSeconds ();
+      kind.interArrivals.Update (interArrival);
+      kind.median.Update (interArrival);
+      kind.p95.Update (interArrival);
+    }
+  m_lastArrival = now;
+}
+
+void
+CdaDetector::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_inTrain)
+    {
+      return;
+    }
+  NS_LOG_LOGIC ("Train " << m_nTrains << " ends at " << m_lastArrival);
+  GetCurrentKind ().durations.Update ((m_lastArrival - m_trainStart).GetSeconds ());
+  m_nTrains++;
+  m_inTrain = false;
+}
+
+uint32_t
+CdaDetector::GetNTrains (void) const
+{
+  return m_nTrains;
+}
+
+Time
+CdaDetector::GetTrainDuration (uint32_t kind) const
+{
+  if (kind >= m_kinds.size () || m_kinds[kind].durations.Count () == 0)
+    {
+      return Seconds (0);
+    }
+  return Seconds (m_kinds[kind].durations.Mean ());
+}
+
+bool
+CdaDetector::GetExtremeKinds (uint32_t &slowest, uint32_t &fastest) const
+{
+  uint32_t found = 0;
+  for (uint32_t i = 0; i < m_kinds.size (); ++i)
+    {
+      if (m_kinds[i].interArrivals.Count () == 0)
+        {
+          continue;
+        }
+      if (found == 0 || m_kinds[i].interArrivals.Mean () > m_kinds[slowest].interArrivals.Mean ())
+        {
+          slowest = i;
+        }
+      if (found == 0 || m_kinds[i].interArrivals.Mean () < m_kinds[fastest].interArrivals.Mean ())
+        {
+          fastest = i;
+        }
+      found++;
+    }
+  return found >= 2;
+}
+
+Time
+CdaDetector::GetDelta (void) const
+{
+  uint32_t slowest, fastest;
+  if (!GetExtremeKinds (slowest, fastest))
+    {
+      return Seconds (0);
+    }
+  return Abs (GetTrainDuration (slowest) - GetTrainDuration (fastest));
+}
+
+double
+CdaDetector::GetConfidence (void) const
+{
+  uint32_t slowest, fastest;
+  if (!GetExtremeKinds (slowest, fastest))
+    {
+      return 0;
+    }
+  const Average<double> &a = m_kinds[slowest].interArrivals;
+  const Average<double> &b = m_kinds[fastest].interArrivals;
+  double diff = a.Mean () - b.Mean ();
+  if (a.Count () < 2 || b.Count () < 2)
+    {
+      return 0;
+    }
+  double se = std::sqrt (a.Var () / a.Count () + b.Var () / b.Count ());
+  if (se == 0)
+    {
+      return diff > 0 ? 1 : 0;
+    }
+  // two-sided, the statistic is normal for the sample sizes of a train
+  return std::erf (diff / se / std::sqrt (2.0));
+}
+
+bool
+CdaDetector::IsCompressionDetected (void) const
+{
+  return GetDelta () > m_threshold && GetConfidence () >= m_minConfidence;
+}
+
+void
+CdaDetector::Print (std::ostream &os) const
+{
+  for (uint32_t i = 0; i < m_kinds.size (); ++i)
+    {
+      const KindStatistics &kind = m_kinds[i];
+      if (kind.interArrivals.Count () == 0)
+        {
+          os << "Train kind " << i << ": trains = " << kind.durations.Count () << std::endl;
+          continue;
+        }
+      os << "Train kind " << i << ": trains = " << kind.durations.Count ()
+         << " duration = " << GetTrainDuration (i).GetMilliSeconds () << "ms"
+         << " inter-arrival mean = " << kind.interArrivals.Mean () * 1000 << "ms"
+         << " stddev = " << (kind.interArrivals.Count () > 1 ? kind.interArrivals.Stddev () * 1000 : 0) << "ms"
+         << " median = " << kind.median.Get () * 1000 << "ms"
+         << " p95 = " << kind.p95.Get () * 1000 << "ms" << std::endl;
+    }
+}
+
+} // namespace ns3
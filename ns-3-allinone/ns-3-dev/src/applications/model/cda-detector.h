@@ -0,0 +1,141 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef CDA_DETECTOR_H
+#define CDA_DETECTOR_H
+
+#include <ostream>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/average.h"
+#include "ns3/p2-quantile-estimator.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup Cda
+ * \brief Online detection of compression from the arrival times of trains
+ *
+ * Arrivals separated by more than TrainGap start a new train.  The trains
+ * are taken to cycle through TrainKinds kinds of payloads, in the order
+ * the CdaClient sends them, and repetitions of a kind are pooled.  For each
+ * kind the detector keeps the mean and variance of the train durations and
+ * of the packet inter-arrival times, and P-square estimates of the median
+ * and 95th percentile of the inter-arrival times, so its memory does not
+ * grow with the length of the run.
+ *
+ * The kinds with the largest and smallest mean inter-arrival time are
+ * compared: the delta is the difference of their mean train durations,
+ * and the confidence that their inter-arrival times differ is given by a
+ * Welch test under the normal approximation.  Compression is detected when
+ * the delta exceeds Threshold and the confidence reaches MinConfidence.
+ */
+class CdaDetector : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  CdaDetector ();
+  virtual ~CdaDetector ();
+
+  /**
+   * \brief Account for a packet arrival
+   * \param now the arrival time
+   */
+  void Receive (Time now);
+
+  /**
+   * \brief Close the train being received, at the end of the run
+   */
+  void Stop (void);
+
+  /**
+   * \return the number of trains closed
+   */
+  uint32_t GetNTrains (void) const;
+
+  /**
+   * \param kind the train kind
+   * \return the mean duration of the trains of this kind
+   */
+  Time GetTrainDuration (uint32_t kind) const;
+
+  /**
+   * \return the difference between the mean train durations of the slowest
+   * and fastest kinds
+   */
+  Time GetDelta (void) const;
+
+  /**
+   * \return the confidence, in [0, 1], that the inter-arrival times of the
+   * slowest and fastest kinds differ
+   */
+  double GetConfidence (void) const;
+
+  /**
+   * \return whether compression is detected
+   */
+  bool IsCompressionDetected (void) const;
+
+  /**
+   * \brief Print the statistics of each kind of train
+   * \param os the output stream
+   */
+  void Print (std::ostream &os) const;
+
+private:
+  /// Statistics of the trains of a kind
+  struct KindStatistics
+  {
+    KindStatistics ();
+    Average<double> durations;       //!< Train durations, in seconds
+    Average<double> interArrivals;   //!< Inter-arrival times, in seconds
+    P2QuantileEstimator median;      //!< Median inter-arrival time
+    P2QuantileEstimator p95;         //!< 95th percentile of the inter-arrival time
+  };
+
+  /**
+   * \return the statistics of the train being received
+   */
+  KindStatistics & GetCurrentKind (void);
+
+  /**
+   * \brief Find the kinds with the largest and smallest mean inter-arrival time
+   * \param [out] slowest the kind with the largest mean
+   * \param [out] fastest the kind with the smallest mean
+   * \return whether two kinds have inter-arrival samples
+   */
+  bool GetExtremeKinds (uint32_t &slowest, uint32_t &fastest) const;
+
+  Time m_trainGap;                     //!< Silence that separates trains
+  Time m_threshold;                    //!< Smallest delta detected as compression
+  uint32_t m_nKinds;                   //!< Number of kinds of trains in a cycle
+  double m_minConfidence;              //!< Smallest confidence detected as compression
+  std::vector<KindStatistics> m_kinds; //!< Statistics per kind
+  uint32_t m_nTrains;                  //!< Trains closed
+  bool m_inTrain;                      //!< Whether a train is being received
+  Time m_trainStart;                   //!< First arrival of the current train
+  Time m_lastArrival;                  //!< Last arrival
+};
+
+} // namespace ns3
+
+#endif /* CDA_DETECTOR_H */
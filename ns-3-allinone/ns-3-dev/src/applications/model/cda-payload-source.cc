@@ -0,0 +1,529 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include "ns3/object-factory.h"
+#include "ns3/random-variable-stream.h"
+#include "cda-payload-source.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CdaPayloadSource");
+
+NS_OBJECT_ENSURE_REGISTERED (CdaPayloadSource);
+NS_OBJECT_ENSURE_REGISTERED (RandomPayloadSource);
+NS_OBJECT_ENSURE_REGISTERED (EntropyPayloadSource);
+NS_OBJECT_ENSURE_REGISTERED (PoolPayloadSource);
+NS_OBJECT_ENSURE_REGISTERED (FilePayloadSource);
+
+CdaPayloadRng::CdaPayloadRng ()
+  : m_seeded (false),
+    m_state (0)
+{
+  m_seed = CreateObject<UniformRandomVariable> ();
+}
+
+CdaPayloadRng::~CdaPayloadRng ()
+{
+}
+
+void
+CdaPayloadRng::SetStream (int64_t stream)
+{
+  m_seed->SetStream (stream);
+}
+
+uint64_t
+CdaPayloadRng::Next (void)
+{
+  if (!m_seeded)
+    {
+      m_state = static_cast<uint64_t> (m_seed->GetInteger (0, 0xffffffff)) << 32
+        | m_seed->GetInteger (0, 0xffffffff);
+      m_seeded = true;
+    }
+  // splitmix64
+  uint64_t z = (m_state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+uint32_t
+CdaPayloadRng::NextBelow (uint32_t n)
+{
+  return static_cast<uint32_t> (((Next () >> 32) * n) >> 32);
+}
+
+double
+CdaPayloadRng::NextDouble (void)
+{
+  return (Next () >> 11) * (1.0 / 9007199254740992.0);
+}
+
+TypeId
+CdaPayloadSource::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CdaPayloadSource")
+    .SetParent<Object> ()
+    .SetGroupName ("Applications")
+  ;
+  return tid;
+}
+
+CdaPayloadSource::CdaPayloadSource ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CdaPayloadSource::~CdaPayloadSource ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+CdaPayloadSource::Fill (uint8_t *buffer, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  DoFill (buffer, size);
+}
+
+int64_t
+CdaPayloadSource::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  return DoAssignStreams (stream);
+}
+
+int64_t
+CdaPayloadSource::DoAssignStreams (int64_t stream)
+{
+  return 0;
+}
+
+TypeId
+RandomPayloadSource::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RandomPayloadSource")
+    .SetParent<CdaPayloadSource> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<RandomPayloadSource> ()
+    .AddAttribute ("BitsPerByte",
+                   "Number of random low bits in each payload byte, the others are zero",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&RandomPayloadSource::m_bitsPerByte),
+                   MakeUintegerChecker<uint32_t> (1, 8))
+  ;
+  return tid;
+}
+
+RandomPayloadSource::RandomPayloadSource ()
+  : m_bitsPerByte (1)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RandomPayloadSource::~RandomPayloadSource ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+int64_t
+RandomPayloadSource::DoAssignStreams (int64_t stream)
+{
+  m_rng.SetStream (stream);
+  return 1;
+}
+
+void
+RandomPayloadSource::DoFill (uint8_t *buffer, uint32_t size)
+{
+  uint64_t mask = ((1ULL << m_bitsPerByte) - 1) * 0x0101010101010101ULL;
+  uint32_t i = 0;
+  for (; i + 8 <= size; i += 8)
+    {
+      uint64_t word = m_rng.Next () & mask;
+      std::memcpy (buffer + i, &word, 8);
+    }
+  if (i < size)
+    {
+      uint64_t word = m_rng.Next () & mask;
+      std::memcpy (buffer + i, &word, size - i);
+    }
+}
+
+/// Vocabulary of the Text model, most frequent first
+static const char *g_words[] = {
+  "the", "of", "and", "to", "a", "in", "is", "that", "for", "it",
+  "as", "was", "with", "be", "by", "on", "not", "he", "this", "are",
+  "or", "his", "from", "at", "which", "but", "have", "an", "had", "they",
+  "you", "were", "their", "one", "all", "we", "can", "her", "has", "there",
+  "been", "if", "more", "when", "will", "would", "who", "so", "no", "network",
+  "packet", "link", "compression", "delay", "throughput", "traffic", "queue", "router",
+  "simulation", "protocol", "entropy", "payload", "detection", "capacity"
+};
+
+/// Number of words in g_words
+static const uint32_t g_nWords = sizeof (g_words) / sizeof (g_words[0]);
+
+/**
+ * \return the cumulative Zipf (exponent 1) distribution of the ranks of g_words
+ */
+static const std::vector<double> &
+GetWordDistribution (void)
+{
+  static std::vector<double> cdf;
+  if (cdf.empty ())
+    {
+      double sum = 0;
+      for (uint32_t k = 1; k <= g_nWords; ++k)
+        {
+          sum += 1.0 / k;
+          cdf.push_back (sum);
+        }
+      for (uint32_t k = 0; k < g_nWords; ++k)
+        {
+          cdf[k] /= sum;
+        }
+    }
+  return cdf;
+}
+
+TypeId
+EntropyPayloadSource::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::EntropyPayloadSource")
+    .SetParent<CdaPayloadSource> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<EntropyPayloadSource> ()
+    .AddAttribute ("Model",
+                   "How the payload bytes are drawn",
+                   EnumValue (ALPHABET),
+                   MakeEnumAccessor (&EntropyPayloadSource::m_model),
+                   MakeEnumChecker (ALPHABET, "Alphabet",
+                                    MARKOV, "Markov",
+                                    TEXT, "Text",
+                                    REPEATED_BLOCK, "RepeatedBlock"))
+    .AddAttribute ("AlphabetSize",
+                   "Number of distinct byte values drawn by the Alphabet, Markov and RepeatedBlock models",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&EntropyPayloadSource::m_alphabetSize),
+                   MakeUintegerChecker<uint32_t> (1, 256))
+    .AddAttribute ("RepeatProbability",
+                   "Probability that the Markov model repeats the previous byte",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&EntropyPayloadSource::m_repeatProbability),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("BlockSize",
+                   "Size of the block repeated by the RepeatedBlock model",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&EntropyPayloadSource::m_blockSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MutationProbability",
+                   "Probability that the RepeatedBlock model replaces a byte of the block",
+                   DoubleValue (0.01),
+                   MakeDoubleAccessor (&EntropyPayloadSource::m_mutationProbability),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+  ;
+  return tid;
+}
+
+EntropyPayloadSource::EntropyPayloadSource ()
+  : m_model (ALPHABET),
+    m_alphabetSize (256),
+    m_repeatProbability (0.5),
+    m_blockSize (64),
+    m_mutationProbability (0.01),
+    m_last (0),
+    m_blockOffset (0),
+    m_wordOffset (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+EntropyPayloadSource::~EntropyPayloadSource ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+int64_t
+EntropyPayloadSource::DoAssignStreams (int64_t stream)
+{
+  m_rng.SetStream (stream);
+  return 1;
+}
+
+uint8_t
+EntropyPayloadSource::NextSymbol (void)
+{
+  return static_cast<uint8_t> (m_rng.NextBelow (m_alphabetSize));
+}
+
+void
+EntropyPayloadSource::FillText (uint8_t *buffer, uint32_t size)
+{
+  const std::vector<double> &cdf = GetWordDistribution ();
+  uint32_t i = 0;
+  while (i < size)
+    {
+      if (m_wordOffset == m_word.size ())
+        {
+          double u = m_rng.NextDouble ();
+          uint32_t rank = std::lower_bound (cdf.begin (), cdf.end (), u) - cdf.begin ();
+          m_word = g_words[std::min (rank, g_nWords - 1)];
+          m_word += ' ';
+          m_wordOffset = 0;
+        }
+      uint32_t chunk = std::min<uint32_t> (size - i, m_word.size () - m_wordOffset);
+      std::memcpy (buffer + i, m_word.data () + m_wordOffset, chunk);
+      i += chunk;
+      m_wordOffset += chunk;
+    }
+}
+
+void
+EntropyPayloadSource::DoFill (uint8_t *buffer, uint32_t size)
+{
+  switch (m_model)
+    {
+    case ALPHABET:
+      for (uint32_t i = 0; i < size; ++i)
+        {
+          buffer[i] = NextSymbol ();
+        }
+      break;
+    case MARKOV:
+      for (uint32_t i = 0; i < size; ++i)
+        {
+          if (m_rng.NextDouble () >= m_repeatProbability)
+            {
+              m_last = NextSymbol ();
+            }
+          buffer[i] = m_last;
+        }
+      break;
+    case TEXT:
+      FillText (buffer, size);
+      break;
+    case REPEATED_BLOCK:
+      if (m_block.size () != m_blockSize)
+        {
+          m_block.resize (m_blockSize);
+          for (uint32_t i = 0; i < m_blockSize; ++i)
+            {
+              m_block[i] = NextSymbol ();
+            }
+          m_blockOffset = 0;
+        }
+      for (uint32_t i = 0; i < size; ++i)
+        {
+          buffer[i] = m_block[m_blockOffset];
+          if (m_mutationProbability > 0 && m_rng.NextDouble () < m_mutationProbability)
+            {
+              buffer[i] = NextSymbol ();
+            }
+          m_blockOffset = (m_blockOffset + 1) % m_blockSize;
+        }
+      break;
+    default:
+      NS_FATAL_ERROR ("Unknown payload model " << m_model);
+    }
+}
+
+TypeId
+PoolPayloadSource::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PoolPayloadSource")
+    .SetParent<CdaPayloadSource> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<PoolPayloadSource> ()
+    .AddAttribute ("PoolSize",
+                   "Number of payload bytes generated beforehand",
+                   UintegerValue (1 << 20),
+                   MakeUintegerAccessor (&PoolPayloadSource::m_poolSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Source",
+                   "Type of the CdaPayloadSource filling the pool",
+                   TypeIdValue (RandomPayloadSource::GetTypeId ()),
+                   MakeTypeIdAccessor (&PoolPayloadSource::m_sourceTypeId),
+                   MakeTypeIdChecker ())
+  ;
+  return tid;
+}
+
+PoolPayloadSource::PoolPayloadSource ()
+  : m_poolSize (1 << 20),
+    m_source (0),
+    m_offset (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PoolPayloadSource::~PoolPayloadSource ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+PoolPayloadSource::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_source = 0;
+  std::vector<uint8_t> ().swap (m_pool);
+  CdaPayloadSource::DoDispose ();
+}
+
+Ptr<CdaPayloadSource>
+PoolPayloadSource::GetSource (void)
+{
+  if (m_source == 0)
+    {
+      ObjectFactory factory;
+      factory.SetTypeId (m_sourceTypeId);
+      m_source = factory.Create<CdaPayloadSource> ();
+    }
+  return m_source;
+}
+
+int64_t
+PoolPayloadSource::DoAssignStreams (int64_t stream)
+{
+  return GetSource ()->AssignStreams (stream);
+}
+
+void
+PoolPayloadSource::DoFill (uint8_t *buffer, uint32_t size)
+{
+  if (m_pool.empty ())
+    {
+      NS_LOG_LOGIC ("Generating a pool of " << m_poolSize << " bytes");
+      m_pool.resize (m_poolSize);
+      GetSource ()->Fill (m_pool.data (), m_pool.size ());
+    }
+  while (size > 0)
+    {
+      uint32_t chunk = std::min<uint32_t> (size, m_pool.size () - m_offset);
+      std::memcpy (buffer, m_pool.data () + m_offset, chunk);
+      buffer += chunk;
+      size -= chunk;
+      m_offset = (m_offset + chunk) % m_pool.size ();
+    }
+}
+
+TypeId
+FilePayloadSource::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FilePayloadSource")
+    .SetParent<CdaPayloadSource> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<FilePayloadSource> ()
+    .AddAttribute ("Filename",
+                   "Name of the file whose bytes are replayed as payloads",
+                   StringValue (""),
+                   MakeStringAccessor (&FilePayloadSource::m_filename),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+FilePayloadSource::FilePayloadSource ()
+  : m_data (0),
+    m_size (0),
+    m_offset (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FilePayloadSource::~FilePayloadSource ()
+{
+  NS_LOG_FUNCTION (this);
+  Unmap ();
+}
+
+void
+FilePayloadSource::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Unmap ();
+  CdaPayloadSource::DoDispose ();
+}
+
+void
+FilePayloadSource::Map (void)
+{
+  NS_LOG_FUNCTION (this);
+  int fd = open (m_filename.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_FATAL_ERROR ("Cannot open payload file \"" << m_filename << "\": " << std::strerror (errno));
+    }
+  struct stat st;
+  if (fstat (fd, &st) < 0 || st.st_size == 0)
+    {
+      close (fd);
+      NS_FATAL_ERROR ("Payload file \"" << m_filename << "\" is empty");
+    }
+  void *data = mmap (0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (data == MAP_FAILED)
+    {
+      NS_FATAL_ERROR ("Cannot map payload file \"" << m_filename << "\": " << std::strerror (errno));
+    }
+  m_data = static_cast<const uint8_t *> (data);
+  m_size = st.st_size;
+  m_offset = 0;
+}
+
+void
+FilePayloadSource::Unmap (void)
+{
+  if (m_data != 0)
+    {
+      munmap (const_cast<uint8_t *> (m_data), m_size);
+      m_data = 0;
+      m_size = 0;
+    }
+}
+
+void
+FilePayloadSource::DoFill (uint8_t *buffer, uint32_t size)
+{
+  if (m_data == 0)
+    {
+      Map ();
+    }
+  while (size > 0)
+    {
+      uint32_t chunk = std::min<uint64_t> (size, m_size - m_offset);
+      std::memcpy (buffer, m_data + m_offset, chunk);
+      buffer += chunk;
+      size -= chunk;
+      m_offset = (m_offset + chunk) % m_size;
+    }
+}
+
+} // namespace ns3
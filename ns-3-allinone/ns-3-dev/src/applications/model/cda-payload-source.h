@@ -0,0 +1,307 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef CDA_PAYLOAD_SOURCE_H
+#define CDA_PAYLOAD_SOURCE_H
+
+#include <string>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/type-id.h"
+
+namespace ns3 {
+
+class UniformRandomVariable;
+
+/**
+ * \ingroup Cda
+ * \brief Fast generator of payload bytes
+ *
+ * A splitmix64 generator seeded from a UniformRandomVariable on first use,
+ * so that the payloads follow the RngSeedManager seed and run number
+ * without drawing a random variable per byte.
+ */
+class CdaPayloadRng
+{
+public:
+  CdaPayloadRng ();
+  ~CdaPayloadRng ();
+
+  /**
+   * \brief Set the stream the generator is seeded from
+   * \param stream the stream index
+   */
+  void SetStream (int64_t stream);
+
+  /**
+   * \return the next 64 bits of the generator
+   */
+  uint64_t Next (void);
+
+  /**
+   * \param n the number of values
+   * \return a value uniformly drawn in [0, n)
+   */
+  uint32_t NextBelow (uint32_t n);
+
+  /**
+   * \return a value uniformly drawn in [0, 1)
+   */
+  double NextDouble (void);
+
+private:
+  Ptr<UniformRandomVariable> m_seed;  //!< Stream the generator is seeded from
+  bool m_seeded;                      //!< Whether m_state was drawn from m_seed
+  uint64_t m_state;                   //!< State of the generator
+};
+
+/**
+ * \ingroup Cda
+ * \brief Interface of the generators of the high-entropy payloads of CdaClient
+ */
+class CdaPayloadSource : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  CdaPayloadSource ();
+  virtual ~CdaPayloadSource ();
+
+  /**
+   * \brief Write the next payload
+   *
+   * \param buffer the payload to fill
+   * \param size number of bytes to write
+   */
+  void Fill (uint8_t *buffer, uint32_t size);
+
+  /**
+   * \brief Assign a fixed random variable stream number to the random
+   * variables used by this source
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+
+private:
+  /**
+   * \brief Write the next payload
+   *
+   * \param buffer the payload to fill
+   * \param size number of bytes to write
+   */
+  virtual void DoFill (uint8_t *buffer, uint32_t size) = 0;
+
+  /**
+   * \brief Assign stream numbers; the default uses none
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  virtual int64_t DoAssignStreams (int64_t stream);
+};
+
+/**
+ * \ingroup Cda
+ * \brief Pseudo-random payloads
+ *
+ * The generator is drawn 64 bits at a time into 8 payload bytes.  Only the BitsPerByte low bits of each byte are
+ * random; the default of one bit per byte reproduces the payloads the
+ * client used to read from /dev/random.
+ */
+class RandomPayloadSource : public CdaPayloadSource
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  RandomPayloadSource ();
+  virtual ~RandomPayloadSource ();
+
+private:
+  virtual void DoFill (uint8_t *buffer, uint32_t size);
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  uint32_t m_bitsPerByte;  //!< Random low bits in each byte
+  CdaPayloadRng m_rng;     //!< Generator of the bytes
+};
+
+/**
+ * \ingroup Cda
+ * \brief Payloads of tunable entropy
+ *
+ * The Model attribute selects how the bytes are drawn, each with its own
+ * knobs, so that a sweep of one knob moves the payloads from incompressible
+ * to highly compressible:
+ *
+ * - Alphabet: bytes uniformly drawn among the first AlphabetSize values,
+ *   log2 (AlphabetSize) bits of entropy per byte.
+ * - Markov: each byte repeats the previous one with RepeatProbability,
+ *   otherwise is drawn as in Alphabet, which yields runs of mean length
+ *   1 / (1 - RepeatProbability).
+ * - Text: words of a small English vocabulary with Zipf-distributed
+ *   frequencies, separated by spaces, much like text corpora.
+ * - RepeatedBlock: a block of BlockSize Alphabet bytes repeated over and
+ *   over, each byte replaced by a fresh one with MutationProbability.
+ *
+ * The state of the models carries over from one payload to the next.
+ */
+class EntropyPayloadSource : public CdaPayloadSource
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief How the payload bytes are drawn
+   */
+  enum Model
+  {
+    ALPHABET,       /**< Uniform among AlphabetSize byte values */
+    MARKOV,         /**< Alphabet bytes repeated with RepeatProbability */
+    TEXT,           /**< Zipf-distributed words */
+    REPEATED_BLOCK  /**< A repeated block with random mutations */
+  };
+
+  EntropyPayloadSource ();
+  virtual ~EntropyPayloadSource ();
+
+private:
+  virtual void DoFill (uint8_t *buffer, uint32_t size);
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  /**
+   * \return a byte uniformly drawn in the alphabet
+   */
+  uint8_t NextSymbol (void);
+
+  /**
+   * \brief Fill with the Text model
+   * \param buffer the payload to fill
+   * \param size number of bytes to write
+   */
+  void FillText (uint8_t *buffer, uint32_t size);
+
+  Model m_model;                 //!< How the bytes are drawn
+  uint32_t m_alphabetSize;       //!< Number of distinct byte values
+  double m_repeatProbability;    //!< Markov probability of repeating a byte
+  uint32_t m_blockSize;          //!< Size of the RepeatedBlock block
+  double m_mutationProbability;  //!< RepeatedBlock probability of replacing a byte
+  CdaPayloadRng m_rng;           //!< Generator of the bytes
+
+  uint8_t m_last;                //!< Last Markov byte
+  std::vector<uint8_t> m_block;  //!< RepeatedBlock block
+  uint32_t m_blockOffset;        //!< Position in the block
+  std::string m_word;            //!< Text word being written, with its separator
+  uint32_t m_wordOffset;         //!< Bytes of m_word already written
+};
+
+/**
+ * \ingroup Cda
+ * \brief Payloads copied from a pool generated beforehand
+ *
+ * The pool is filled once by a source of type Source and handed out in
+ * consecutive slices, wrapping around at its end.  The pool should be
+ * much larger than the history of the codec so that repeating payloads
+ * do not become compressible.
+ */
+class PoolPayloadSource : public CdaPayloadSource
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  PoolPayloadSource ();
+  virtual ~PoolPayloadSource ();
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  virtual void DoFill (uint8_t *buffer, uint32_t size);
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  /**
+   * \return the source of the pool, created on first use
+   */
+  Ptr<CdaPayloadSource> GetSource (void);
+
+  uint32_t m_poolSize;             //!< Bytes in the pool
+  TypeId m_sourceTypeId;           //!< Type of the source filling the pool
+  Ptr<CdaPayloadSource> m_source;  //!< Source filling the pool
+  std::vector<uint8_t> m_pool;     //!< The payload bytes
+  uint32_t m_offset;               //!< Start of the next slice
+};
+
+/**
+ * \ingroup Cda
+ * \brief Payloads replayed from a file
+ *
+ * The file, for instance captured payloads, is mapped in memory on first
+ * use and handed out in consecutive slices, wrapping around at its end.
+ */
+class FilePayloadSource : public CdaPayloadSource
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  FilePayloadSource ();
+  virtual ~FilePayloadSource ();
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  virtual void DoFill (uint8_t *buffer, uint32_t size);
+
+  /**
+   * \brief Map the file in memory
+   */
+  void Map (void);
+
+  /**
+   * \brief Release the mapping, if any
+   */
+  void Unmap (void);
+
+  std::string m_filename;   //!< File to replay
+  const uint8_t *m_data;    //!< Mapped file, or 0
+  uint64_t m_size;          //!< Size of the file
+  uint64_t m_offset;        //!< Start of the next slice
+};
+
+} // namespace ns3
+
+#endif /* CDA_PAYLOAD_SOURCE_H */
@@ -30,8 +30,12 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/udp-socket-factory.h"
+
+#include "ns3/pointer.h"
 
 #include "cda-server.h"
+#include "cda-detector.h"
 
 namespace ns3 {
 
@@ -50,6 +54,15 @@ CdaServer::GetTypeId (void)
                    UintegerValue (9),
                    MakeUintegerAccessor (&CdaServer::m_port),
                    MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("Protocol",
+                   "The type of protocol to use, e.g. ns3::UdpSocketFactory or ns3::TcpSocketFactory",
+                   TypeIdValue (UdpSocketFactory::GetTypeId ()),
+                   MakeTypeIdAccessor (&CdaServer::m_protocolTid),
+                   MakeTypeIdChecker ())
+    .AddAttribute ("Detector", "The detector deciding whether the path compresses.",
+                   PointerValue (),
+                   MakePointerAccessor (&CdaServer::m_detector),
+                   MakePointerChecker<CdaDetector> ())
     .AddTraceSource ("Rx", "A packet has been received",
                      MakeTraceSourceAccessor (&CdaServer::m_rxTrace),
                      "ns3::Packet::TracedCallback")
@@ -60,30 +73,98 @@ CdaServer::GetTypeId (void)
   return tid;
 }
 
+CdaServer::Flow::Flow ()
+  : bytes (0)
+{
+}
+
+double
+CdaServer::Flow::GetThroughput (void) const
+{
+  double duration = (last - first).GetSeconds ();
+  return duration > 0 ? bytes * 8 / duration : 0;
+}
+
 CdaServer::CdaServer ()
 {
-  m_t1Start = 0.0;
-  m_t1End = 0.0;
-  m_t2Start = 0.0;
-  m_t2End = 0.0;
-  m_lastSentPacket = 0.0;
-  m_nPackets = 0;
+  m_detector = CreateObject<CdaDetector> ();
 }
 
 CdaServer::~CdaServer()
 {
   m_socket = 0;
   m_socket6 = 0;
-  m_t1Start = 0.0;
-  m_t1End = 0.0;
-  m_t2Start = 0.0;
-  m_t2End = 0.0;
-  m_lastSentPacket = 0.0;
+}
+
+Ptr<CdaDetector>
+CdaServer::GetDetector (void) const
+{
+  return m_detector;
+}
+
+uint32_t
+CdaServer::GetNFlows (void) const
+{
+  return m_flows.size ();
+}
+
+double
+CdaServer::GetThroughput (void) const
+{
+  double sum = 0;
+  for (std::map<Address, Flow>::const_iterator i = m_flows.begin (); i != m_flows.end (); ++i)
+    {
+      sum += i->second.GetThroughput ();
+    }
+  return sum;
+}
+
+double
+CdaServer::GetFairness (void) const
+{
+  double sum = 0;
+  double squares = 0;
+  for (std::map<Address, Flow>::const_iterator i = m_flows.begin (); i != m_flows.end (); ++i)
+    {
+      double throughput = i->second.GetThroughput ();
+      sum += throughput;
+      squares += throughput * throughput;
+    }
+  if (squares == 0)
+    {
+      return 0;
+    }
+  return sum * sum / (m_flows.size () * squares);
+}
+
+void
+CdaServer::PrintFlows (std::ostream &os) const
+{
+  for (std::map<Address, Flow>::const_iterator i = m_flows.begin (); i != m_flows.end (); ++i)
+    {
+      os << "Flow from ";
+      if (InetSocketAddress::IsMatchingType (i->first))
+        {
+          os << InetSocketAddress::ConvertFrom (i->first).GetIpv4 ()
+             << ":" << InetSocketAddress::ConvertFrom (i->first).GetPort ();
+        }
+      else if (Inet6SocketAddress::IsMatchingType (i->first))
+        {
+          os << Inet6SocketAddress::ConvertFrom (i->first).GetIpv6 ()
+             << ":" << Inet6SocketAddress::ConvertFrom (i->first).GetPort ();
+        }
+      os << ": bytes = " << i->second.bytes
+         << " throughput = " << i->second.GetThroughput () / 1e6 << "Mbps" << std::endl;
+    }
+  os << "Aggregate throughput = " << GetThroughput () / 1e6 << "Mbps"
+     << " fairness = " << GetFairness () << std::endl;
 }
 
 void
 CdaServer::DoDispose (void)
 {
+  m_detector = 0;
+  m_accepted.clear ();
   Application::DoDispose ();
 }
 
@@ -92,8 +173,7 @@ CdaServer::StartApplication (void)
 {
   if (m_socket == 0)
     {
-      TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
-      m_socket = Socket::CreateSocket (GetNode (), tid);
+      m_socket = Socket::CreateSocket (GetNode (), m_protocolTid);
       InetSocketAddress local = InetSocketAddress (Ipv4Address::GetAny (), m_port);
       if (m_socket->Bind (local) == -1)
         {
@@ -116,8 +196,7 @@ CdaServer::StartApplication (void)
 
   if (m_socket6 == 0)
     {
-      TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
-      m_socket6 = Socket::CreateSocket (GetNode (), tid);
+      m_socket6 = Socket::CreateSocket (GetNode (), m_protocolTid);
       Inet6SocketAddress local6 = Inet6SocketAddress (Ipv6Address::GetAny (), m_port);
       if (m_socket6->Bind (local6) == -1)
         {
@@ -138,10 +217,26 @@ CdaServer::StartApplication (void)
         }
     }
 
+  if (m_socket->GetSocketType () == Socket::NS3_SOCK_STREAM)
+    {
+      m_socket->Listen ();
+      m_socket6->Listen ();
+      m_socket->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                                   MakeCallback (&CdaServer::HandleAccept, this));
+      m_socket6->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                                    MakeCallback (&CdaServer::HandleAccept, this));
+    }
   m_socket->SetRecvCallback (MakeCallback (&CdaServer::HandleRead, this));
   m_socket6->SetRecvCallback (MakeCallback (&CdaServer::HandleRead, this));
 }
 
+void
+CdaServer::HandleAccept (Ptr<Socket> socket, const Address &from)
+{
+  socket->SetRecvCallback (MakeCallback (&CdaServer::HandleRead, this));
+  m_accepted.push_back (socket);
+}
+
 void 
 CdaServer::StopApplication ()
 {
@@ -155,26 +250,33 @@ CdaServer::StopApplication ()
       m_socket6->Close ();
       m_socket6->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
     }
+  for (std::vector<Ptr<Socket> >::iterator i = m_accepted.begin (); i != m_accepted.end (); ++i)
+    {
+      (*i)->Close ();
+      (*i)->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+    }
+  m_accepted.clear ();
 
-    m_t2End = m_lastSentPacket;
-    double t1Time = fabs (m_t1Start - m_t1End);
-    double t2Time = fabs (m_t2Start - m_t2End);
-    double delta = fabs (t1Time - t2Time);
+  m_detector->Stop ();
+  m_detector->Print (std::cout);
 
-    std::cout << "t1start = " << m_t1Start << std::endl;
-    std::cout << "t1End = " << m_t1End << std::endl;
-    std::cout << "t2Start = " << m_t2Start << std::endl;
-    std::cout << "t2End = " << m_t2End << std::endl;
+  std::cout << "High Entropy Train Time = " << m_detector->GetTrainDuration (0).GetMilliSeconds () << std::endl;
+  std::cout << "Low Entropy Train Time = " << m_detector->GetTrainDuration (1).GetMilliSeconds () << std::endl;
 
-    std::cout << "High Entropy Train Time = " << t1Time << std::endl;
-    std::cout << "Low Entropy Train Time = " << t2Time << std::endl;
-    
-    if (delta > 100)
+  int64_t delta = m_detector->GetDelta ().GetMilliSeconds ();
+  if (m_detector->IsCompressionDetected ())
     {
       std::cout << "Compression detected!\ndelta = " << delta << "ms" << std::endl;
-    } else {
+    }
+  else
+    {
       std::cout << "No compression was detected\ndelta = " << delta << "ms" << std::endl;
     }
+  std::cout << "confidence = " << m_detector->GetConfidence () << std::endl;
+  if (m_flows.size () > 1)
+    {
+      PrintFlows (std::cout);
+    }
 }
 
 void 
@@ -189,20 +291,14 @@ CdaServer::HandleRead (Ptr<Socket> socket)
       socket->GetSockName (localAddress);
       m_rxTrace (packet);
       m_rxTraceWithAddresses (packet, from, localAddress);
-
-      double recTime = Simulator::Now ().GetMilliSeconds ();
-      if (m_nPackets == 0)
+      m_detector->Receive (Simulator::Now ());
+      Flow &flow = m_flows[from];
+      if (flow.bytes == 0)
         {
-          m_t1Start = recTime;
-          m_lastSentPacket = recTime;
+          flow.first = Simulator::Now ();
         }
-      if (fabs(recTime - m_lastSentPacket) > 1000.0)
-      {
-        m_t1End = m_lastSentPacket;
-        m_t2Start = recTime;
-      }
-      m_lastSentPacket = recTime;
-      m_nPackets++;
+      flow.bytes += packet->GetSize ();
+      flow.last = Simulator::Now ();
     }
 }
 
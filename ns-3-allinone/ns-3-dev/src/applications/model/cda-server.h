@@ -24,11 +24,16 @@
 #include "ns3/ptr.h"
 #include "ns3/address.h"
 #include "ns3/traced-callback.h"
+#include "ns3/nstime.h"
+#include <map>
+#include <ostream>
+#include <vector>
 
 namespace ns3 {
 
 class Socket;
 class Packet;
+class CdaDetector;
 
 /**
  * \ingroup applications 
@@ -40,6 +45,12 @@ class Packet;
  * \brief A Cda server
  *
  * Every packet received is sent back.
+ *
+ * The server listens on UDP, or on the socket type given by Protocol, in
+ * which case it accepts any number of connections.  The arrivals of all
+ * the flows feed the detector, and the bytes received are also accounted
+ * per flow, identified by the address of its sender, to compare the
+ * throughput of concurrent flows.
  */
 class CdaServer : public Application 
 {
@@ -52,6 +63,34 @@ public:
   CdaServer ();
   virtual ~CdaServer ();
 
+  /**
+   * \brief Get the compression detector fed with the arrival times
+   * \return the detector
+   */
+  Ptr<CdaDetector> GetDetector (void) const;
+
+  /**
+   * \return the number of flows received
+   */
+  uint32_t GetNFlows (void) const;
+
+  /**
+   * \return the sum of the throughputs of the flows received, in bit/s
+   */
+  double GetThroughput (void) const;
+
+  /**
+   * \return the Jain fairness index of the throughputs of the flows
+   * received, 1 when they are all equal
+   */
+  double GetFairness (void) const;
+
+  /**
+   * \brief Print the bytes received and throughput of each flow
+   * \param os the output stream
+   */
+  void PrintFlows (std::ostream &os) const;
+
 protected:
   virtual void DoDispose (void);
 
@@ -69,16 +108,36 @@ private:
    */
   void HandleRead (Ptr<Socket> socket);
 
+  /**
+   * \brief Handle a connection accepted on a stream socket
+   *
+   * \param socket the socket of the connection
+   * \param from the address of the peer
+   */
+  void HandleAccept (Ptr<Socket> socket, const Address &from);
+
+  /// Bytes and arrival times of a flow
+  struct Flow
+  {
+    Flow ();
+    /**
+     * \return the throughput of the flow between its first and last
+     * arrival, in bit/s
+     */
+    double GetThroughput (void) const;
+    uint64_t bytes; //!< Bytes received
+    Time first;     //!< First arrival
+    Time last;      //!< Last arrival
+  };
+
   uint16_t m_port; //!< Port on which we listen for incoming packets.
   Ptr<Socket> m_socket; //!< IPv4 Socket
   Ptr<Socket> m_socket6; //!< IPv6 Socket
+  TypeId m_protocolTid; //!< Type of the socket factory
+  std::vector<Ptr<Socket> > m_accepted; //!< Sockets of the accepted connections
+  std::map<Address, Flow> m_flows; //!< Flows received, by sender address
   Address m_local; //!< local multicast address
-  double m_t1Start;
-  double m_t1End;
-  double m_t2Start;
-  double m_t2End;
-  double m_lastSentPacket;
-  uint32_t m_nPackets;
+  Ptr<CdaDetector> m_detector; //!< Compression detector
 
   /// Callbacks for tracing the packet Rx events
   TracedCallback<Ptr<const Packet> > m_rxTrace;
@@ -0,0 +1,911 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include "ns3/rng-seed-manager.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/address.h"
+#include "ns3/data-rate.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/type-id.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/cda-client.h"
+#include "ns3/cda-server.h"
+#include "ns3/cda-helper.h"
+#include "ns3/cda-payload-source.h"
+#include "ns3/cda-detector.h"
+#include "ns3/packet.h"
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+/**
+ * Join two new nodes by a SimpleChannel and give them IPv4 addresses
+ * \param n the container receiving the nodes
+ * \return the address of the second node
+ */
+static Ipv4Address
+CreateCdaNetwork (NodeContainer &n)
+{
+  n.Create (2);
+  InternetStackHelper internet;
+  internet.Install (n);
+  Ptr<SimpleNetDevice> txDev = CreateObject<SimpleNetDevice> ();
+  Ptr<SimpleNetDevice> rxDev = CreateObject<SimpleNetDevice> ();
+  n.Get (0)->AddDevice (txDev);
+  n.Get (1)->AddDevice (rxDev);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  rxDev->SetChannel (channel);
+  txDev->SetChannel (channel);
+  NetDeviceContainer d;
+  d.Add (txDev);
+  d.Add (rxDev);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  return ipv4.Assign (d).GetAddress (1);
+}
+
+/**
+ * Record the packets sent by a CdaClient
+ */
+struct CdaTxRecorder
+{
+  std::vector<Time> times;                 //!< Send times
+  std::vector<std::vector<uint8_t> > payloads; //!< Payloads sent
+
+  /**
+   * Tx trace sink
+   * \param p the packet sent
+   */
+  void Tx (Ptr<const Packet> p)
+  {
+    times.push_back (Simulator::Now ());
+    std::vector<uint8_t> payload (p->GetSize ());
+    p->CopyData (payload.data (), payload.size ());
+    payloads.push_back (payload);
+  }
+};
+
+/**
+ * \ingroup applications-test
+ * \ingroup tests
+ *
+ * Test that RandomPayloadSource fills are reproducible for a given stream
+ * and run, and differ across streams and runs
+ */
+class CdaRandomPayloadTestCase : public TestCase
+{
+public:
+  CdaRandomPayloadTestCase ();
+  virtual ~CdaRandomPayloadTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \param stream the stream of the source
+   * \param bitsPerByte the BitsPerByte attribute of the source
+   * \return the first bytes filled by a new RandomPayloadSource
+   */
+  std::vector<uint8_t> Fill (int64_t stream, uint32_t bitsPerByte);
+};
+
+CdaRandomPayloadTestCase::CdaRandomPayloadTestCase ()
+  : TestCase ("Test that RandomPayloadSource payloads are reproducible from the stream and the run")
+{
+}
+
+CdaRandomPayloadTestCase::~CdaRandomPayloadTestCase ()
+{
+}
+
+std::vector<uint8_t>
+CdaRandomPayloadTestCase::Fill (int64_t stream, uint32_t bitsPerByte)
+{
+  Ptr<RandomPayloadSource> source = CreateObject<RandomPayloadSource> ();
+  source->SetAttribute ("BitsPerByte", UintegerValue (bitsPerByte));
+  source->AssignStreams (stream);
+  // an odd size ends on a partial word
+  std::vector<uint8_t> bytes (1001);
+  source->Fill (bytes.data (), bytes.size ());
+  return bytes;
+}
+
+void
+CdaRandomPayloadTestCase::DoRun (void)
+{
+  uint64_t run = RngSeedManager::GetRun ();
+
+  std::vector<uint8_t> bytes = Fill (7, 8);
+  NS_TEST_ASSERT_MSG_EQ ((bytes == Fill (7, 8)), true, "Same stream, different payloads");
+  NS_TEST_ASSERT_MSG_EQ ((bytes == Fill (8, 8)), false, "Different streams, same payloads");
+  RngSeedManager::SetRun (run + 1);
+  NS_TEST_ASSERT_MSG_EQ ((bytes == Fill (7, 8)), false, "Different runs, same payloads");
+  RngSeedManager::SetRun (run);
+
+  std::vector<uint8_t> bits = Fill (7, 1);
+  uint32_t ones = 0;
+  for (std::size_t i = 0; i < bits.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_LT (bits[i], 2, "Byte with more than one random bit");
+      ones += bits[i];
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (ones, bits.size () / 2, bits.size () / 10, "Random bits are biased");
+}
+
+/**
+ * \ingroup applications-test
+ * \ingroup tests
+ *
+ * Test that PoolPayloadSource replays the pool generated by its source
+ */
+class CdaPoolPayloadTestCase : public TestCase
+{
+public:
+  CdaPoolPayloadTestCase ();
+  virtual ~CdaPoolPayloadTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CdaPoolPayloadTestCase::CdaPoolPayloadTestCase ()
+  : TestCase ("Test that PoolPayloadSource replays the payloads generated by its source")
+{
+}
+
+CdaPoolPayloadTestCase::~CdaPoolPayloadTestCase ()
+{
+}
+
+void
+CdaPoolPayloadTestCase::DoRun (void)
+{
+  const uint32_t poolSize = 100;
+  Ptr<PoolPayloadSource> pool = CreateObject<PoolPayloadSource> ();
+  pool->SetAttribute ("PoolSize", UintegerValue (poolSize));
+  pool->SetAttribute ("Source", TypeIdValue (RandomPayloadSource::GetTypeId ()));
+  pool->AssignStreams (3);
+  Ptr<RandomPayloadSource> random = CreateObject<RandomPayloadSource> ();
+  random->AssignStreams (3);
+  std::vector<uint8_t> expected (poolSize);
+  random->Fill (expected.data (), expected.size ());
+
+  // slices of several sizes, wrapping around the pool
+  uint32_t offset = 0;
+  uint32_t sizes[] = { 30, 60, 150, 1 };
+  for (uint32_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); ++s)
+    {
+      std::vector<uint8_t> bytes (sizes[s]);
+      pool->Fill (bytes.data (), bytes.size ());
+      for (uint32_t i = 0; i < bytes.size (); ++i)
+        {
+          NS_TEST_ASSERT_MSG_EQ ((uint32_t) bytes[i], (uint32_t) expected[(offset + i) % poolSize],
+                                 "Byte " << offset + i << " is not the one of the pool");
+        }
+      offset += sizes[s];
+    }
+}
+
+/**
+ * \ingroup applications-test
+ * \ingroup tests
+ *
+ * Test that FilePayloadSource replays a file, looping over it
+ */
+class CdaFilePayloadTestCase : public TestCase
+{
+public:
+  CdaFilePayloadTestCase ();
+  virtual ~CdaFilePayloadTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CdaFilePayloadTestCase::CdaFilePayloadTestCase ()
+  : TestCase ("Test that FilePayloadSource replays the bytes of a file")
+{
+}
+
+CdaFilePayloadTestCase::~CdaFilePayloadTestCase ()
+{
+}
+
+void
+CdaFilePayloadTestCase::DoRun (void)
+{
+  const uint32_t fileSize = 251;
+  std::string filename = CreateTempDirFilename ("cda-payload.bin");
+  {
+    std::ofstream file (filename.c_str (), std::ios::binary);
+    for (uint32_t i = 0; i < fileSize; ++i)
+      {
+        file.put (static_cast<char> (i));
+      }
+  }
+
+  Ptr<FilePayloadSource> source = CreateObject<FilePayloadSource> ();
+  source->SetAttribute ("Filename", StringValue (filename));
+  uint32_t offset = 0;
+  for (uint32_t n = 0; n < 4; ++n)
+    {
+      std::vector<uint8_t> bytes (200);
+      source->Fill (bytes.data (), bytes.size ());
+      for (uint32_t i = 0; i < bytes.size (); ++i)
+        {
+          NS_TEST_ASSERT_MSG_EQ ((uint32_t) bytes[i], (offset + i) % fileSize,
+                                 "Byte " << offset + i << " is not the one of the file");
+        }
+      offset += bytes.size ();
+    }
+  source->Dispose ();
+  std::remove (filename.c_str ());
+}
+
+/**
+ * \param bytes some bytes
+ * \return the entropy of the byte distribution, in bits per byte
+ */
+static double
+GetByteEntropy (const std::vector<uint8_t> &bytes)
+{
+  std::vector<uint32_t> counts (256, 0);
+  for (std::size_t i = 0; i < bytes.size (); ++i)
+    {
+      counts[bytes[i]]++;
+    }
+  double entropy = 0;
+  for (uint32_t v = 0; v < 256; ++v)
+    {
+      if (counts[v] > 0)
+        {
+          double p = static_cast<double> (counts[v]) / bytes.size ();
+          entropy -= p * std::log2 (p);
+        }
+    }
+  return entropy;
+}
+
+/**
+ * \ingroup applications-test
+ * \ingroup tests
+ *
+ * Test the byte statistics of the EntropyPayloadSource models
+ */
+class CdaEntropyPayloadTestCase : public TestCase
+{
+public:
+  CdaEntropyPayloadTestCase ();
+  virtual ~CdaEntropyPayloadTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \param model the Model attribute of the source
+   * \param name the name of another attribute of the source
+   * \param value the value of this attribute
+   * \return the first bytes filled by a new EntropyPayloadSource
+   */
+  std::vector<uint8_t> Fill (EntropyPayloadSource::Model model,
+                             std::string name, const AttributeValue &value);
+};
+
+CdaEntropyPayloadTestCase::CdaEntropyPayloadTestCase ()
+  : TestCase ("Test the byte statistics of the EntropyPayloadSource models")
+{
+}
+
+CdaEntropyPayloadTestCase::~CdaEntropyPayloadTestCase ()
+{
+}
+
+std::vector<uint8_t>
+CdaEntropyPayloadTestCase::Fill (EntropyPayloadSource::Model model,
+                                 std::string name, const AttributeValue &value)
+{
+  Ptr<EntropyPayloadSource> source = CreateObject<EntropyPayloadSource> ();
+  source->SetAttribute ("Model", EnumValue (model));
+  source->SetAttribute (name, value);
+  source->AssignStreams (11);
+  // filled a packet at a time, as CdaClient does
+  std::vector<uint8_t> bytes (1100 * 64);
+  for (std::size_t i = 0; i < bytes.size (); i += 1100)
+    {
+      source->Fill (bytes.data () + i, 1100);
+    }
+  return bytes;
+}
+
+void
+CdaEntropyPayloadTestCase::DoRun (void)
+{
+  std::vector<uint8_t> bytes = Fill (EntropyPayloadSource::ALPHABET, "AlphabetSize", UintegerValue (16));
+  for (std::size_t i = 0; i < bytes.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_LT (bytes[i], 16, "Byte outside of the alphabet");
+    }
+  NS_TEST_EXPECT_MSG_EQ_TOL (GetByteEntropy (bytes), 4.0, 0.01, "Alphabet of 16 bytes, not 4 bits per byte");
+  double alphabetEntropy = GetByteEntropy (Fill (EntropyPayloadSource::ALPHABET, "AlphabetSize", UintegerValue (256)));
+  NS_TEST_EXPECT_MSG_EQ_TOL (alphabetEntropy, 8.0, 0.01, "Full alphabet, not 8 bits per byte");
+
+  bytes = Fill (EntropyPayloadSource::MARKOV, "RepeatProbability", DoubleValue (0.9));
+  uint32_t repeats = 0;
+  for (std::size_t i = 1; i < bytes.size (); ++i)
+    {
+      repeats += (bytes[i] == bytes[i - 1]);
+    }
+  NS_TEST_EXPECT_MSG_EQ_TOL (static_cast<double> (repeats) / (bytes.size () - 1), 0.9, 0.01,
+                             "Markov model does not repeat with RepeatProbability");
+
+  bytes = Fill (EntropyPayloadSource::TEXT, "AlphabetSize", UintegerValue (256));
+  uint32_t spaces = 0;
+  for (std::size_t i = 0; i < bytes.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((bytes[i] == ' ' || (bytes[i] >= 'a' && bytes[i] <= 'z')), true,
+                             "Text model wrote a byte which is neither a letter nor a space");
+      spaces += (bytes[i] == ' ');
+    }
+  NS_TEST_EXPECT_MSG_GT (spaces, bytes.size () / 10, "Text model words are too long");
+  double textEntropy = GetByteEntropy (bytes);
+  NS_TEST_EXPECT_MSG_LT (textEntropy, 5.0, "Text model is not text-like");
+
+  bytes = Fill (EntropyPayloadSource::REPEATED_BLOCK, "MutationProbability", DoubleValue (0));
+  for (std::size_t i = 64; i < bytes.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t) bytes[i], (uint32_t) bytes[i - 64], "Block not repeated");
+    }
+  NS_TEST_EXPECT_MSG_LT (textEntropy, alphabetEntropy, "Entropy levels are not ordered");
+}
+
+/**
+ * \ingroup applications-test
+ * \ingroup tests
+ *
+ * Test that CdaClient sends its trains in turn, separated by TrainGap
+ */
+class CdaClientTrainsTestCase : public TestCase
+{
+public:
+  CdaClientTrainsTestCase ();
+  virtual ~CdaClientTrainsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CdaClientTrainsTestCase::CdaClientTrainsTestCase ()
+  : TestCase ("Test that CdaClient sends its trains in turn, separated by TrainGap")
+{
+}
+
+CdaClientTrainsTestCase::~CdaClientTrainsTestCase ()
+{
+}
+
+void
+CdaClientTrainsTestCase::DoRun (void)
+{
+  NodeContainer n;
+  Ipv4Address address = CreateCdaNetwork (n);
+
+  CdaClientHelper client (address, 4000);
+  client.SetAttribute ("MaxPackets", UintegerValue (6));
+  client.SetAttribute ("Interval", TimeValue (MilliSeconds (1)));
+  client.SetAttribute ("TrainGap", TimeValue (MilliSeconds (10)));
+  client.SetAttribute ("PacketSize", UintegerValue (100));
+  ApplicationContainer apps = client.Install (n.Get (0));
+  apps.Start (Seconds (1.0));
+  Ptr<CdaClient> app = DynamicCast<CdaClient> (apps.Get (0));
+  app->AddTrain (CreateObject<RandomPayloadSource> (), 2);
+  app->AddTrain (0, 1);
+  CdaTxRecorder recorder;
+  app->TraceConnectWithoutContext ("Tx", MakeCallback (&CdaTxRecorder::Tx, &recorder));
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (recorder.times.size (), 6, "Not MaxPackets packets sent");
+  int64_t expected[] = { 1000, 1001, 1011, 1021, 1022, 1032 };
+  for (uint32_t i = 0; i < 6; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (recorder.times[i], MilliSeconds (expected[i]), "Packet " << i << " sent at the wrong time");
+      bool zeros = std::vector<uint8_t> (100, 0) == recorder.payloads[i];
+      NS_TEST_EXPECT_MSG_EQ (zeros, (i % 3 == 2), "Packet " << i << " is not from its train");
+    }
+}
+
+/**
+ * \ingroup applications-test
+ * \ingroup tests
+ *
+ * Test that a CdaClient with MaxPackets set to 0 sends nothing
+ */
+class CdaClientNoPacketTestCase : public TestCase
+{
+public:
+  CdaClientNoPacketTestCase ();
+  virtual ~CdaClientNoPacketTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CdaClientNoPacketTestCase::CdaClientNoPacketTestCase ()
+  : TestCase ("Test that a CdaClient with MaxPackets set to 0 sends nothing")
+{
+}
+
+CdaClientNoPacketTestCase::~CdaClientNoPacketTestCase ()
+{
+}
+
+void
+CdaClientNoPacketTestCase::DoRun (void)
+{
+  NodeContainer n;
+  Ipv4Address address = CreateCdaNetwork (n);
+
+  CdaServerHelper server (4000);
+  ApplicationContainer apps = server.Install (n.Get (1));
+  apps.Start (Seconds (1.0));
+  apps.Stop (Seconds (10.0));
+  Ptr<CdaServer> serverApp = DynamicCast<CdaServer> (apps.Get (0));
+
+  CdaClientHelper client (address, 4000);
+  client.SetAttribute ("MaxPackets", UintegerValue (0));
+  apps = client.Install (n.Get (0));
+  apps.Start (Seconds (2.0));
+  apps.Stop (Seconds (10.0));
+  CdaTxRecorder recorder;
+  apps.Get (0)->TraceConnectWithoutContext ("Tx", MakeCallback (&CdaTxRecorder::Tx, &recorder));
+
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (recorder.times.size (), 0, "Packets sent with MaxPackets set to 0");
+  NS_TEST_EXPECT_MSG_EQ (serverApp->GetNFlows (), 0, "Packets received with MaxPackets set to 0");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup applications-test
+ * \ingroup tests
+ *
+ * Test the train statistics and the decision of CdaDetector
+ */
+class CdaDetectorTestCase : public TestCase
+{
+public:
+  CdaDetectorTestCase ();
+  virtual ~CdaDetectorTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Feed a train to a detector, followed by a silence longer than its
+   * TrainGap
+   * \param detector the detector
+   * \param now the time of the first arrival, then of the next train
+   * \param a the odd inter-arrival times
+   * \param b the even inter-arrival times
+   * \param n the number of arrivals
+   */
+  void Feed (Ptr<CdaDetector> detector, Time &now, Time a, Time b, uint32_t n);
+};
+
+CdaDetectorTestCase::CdaDetectorTestCase ()
+  : TestCase ("Test the train statistics and the decision of CdaDetector")
+{
+}
+
+CdaDetectorTestCase::~CdaDetectorTestCase ()
+{
+}
+
+void
+CdaDetectorTestCase::Feed (Ptr<CdaDetector> detector, Time &now, Time a, Time b, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      detector->Receive (now);
+      now += (i % 2 == 0) ? a : b;
+    }
+  now += Seconds (2);
+}
+
+void
+CdaDetectorTestCase::DoRun (void)
+{
+  // two repetitions of a slow and a fast train: trains of 200 arrivals
+  // whose 199 inter-arrival times alternate around 2ms and 1ms
+  Ptr<CdaDetector> detector = CreateObject<CdaDetector> ();
+  Time now = Seconds (1);
+  for (uint32_t repetition = 0; repetition < 2; ++repetition)
+    {
+      Feed (detector, now, MicroSeconds (1500), MicroSeconds (2500), 200);
+      Feed (detector, now, MicroSeconds (500), MicroSeconds (1500), 200);
+    }
+  NS_TEST_EXPECT_MSG_EQ (detector->GetNTrains (), 3, "The silences do not split the trains");
+  detector->Stop ();
+  NS_TEST_EXPECT_MSG_EQ (detector->GetNTrains (), 4, "Stop does not close the last train");
+  NS_TEST_EXPECT_MSG_EQ_TOL (detector->GetTrainDuration (0).GetSeconds (), 0.3975, 1e-9, "Wrong slow train duration");
+  NS_TEST_EXPECT_MSG_EQ_TOL (detector->GetTrainDuration (1).GetSeconds (), 0.1985, 1e-9, "Wrong fast train duration");
+  NS_TEST_EXPECT_MSG_EQ_TOL (detector->GetDelta ().GetSeconds (), 0.199, 1e-9, "Wrong delta");
+  NS_TEST_EXPECT_MSG_GT (detector->GetConfidence (), 0.999, "Distinct trains, low confidence");
+  NS_TEST_EXPECT_MSG_EQ (detector->IsCompressionDetected (), true, "Compression not detected");
+
+  // the same trains for both kinds
+  detector = CreateObject<CdaDetector> ();
+  now = Seconds (1);
+  for (uint32_t train = 0; train < 4; ++train)
+    {
+      Feed (detector, now, MicroSeconds (1500), MicroSeconds (2500), 200);
+    }
+  detector->Stop ();
+  NS_TEST_EXPECT_MSG_EQ (detector->GetDelta (), Seconds (0), "Same trains, non zero delta");
+  NS_TEST_EXPECT_MSG_EQ_TOL (detector->GetConfidence (), 0, 1e-9, "Same trains, non zero confidence");
+  NS_TEST_EXPECT_MSG_EQ (detector->IsCompressionDetected (), false, "Same trains, compression detected");
+
+  // three kinds, the delta is between the slowest and the fastest
+  detector = CreateObject<CdaDetector> ();
+  detector->SetAttribute ("TrainKinds", UintegerValue (3));
+  now = Seconds (1);
+  Feed (detector, now, MicroSeconds (1500), MicroSeconds (1500), 101);
+  Feed (detector, now, MicroSeconds (3000), MicroSeconds (3000), 101);
+  Feed (detector, now, MicroSeconds (1000), MicroSeconds (1000), 101);
+  detector->Stop ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (detector->GetTrainDuration (2).GetSeconds (), 0.1, 1e-9, "Wrong third train duration");
+  NS_TEST_EXPECT_MSG_EQ_TOL (detector->GetDelta ().GetSeconds (), 0.2, 1e-9, "Delta not between the extreme kinds");
+
+  // short trains with a small difference drowned in jitter
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      detector = CreateObject<CdaDetector> ();
+      detector->SetAttribute ("Threshold", TimeValue (MicroSeconds (500)));
+      detector->SetAttribute ("MinConfidence", DoubleValue (i == 0 ? 0.0 : 0.9));
+      now = Seconds (1);
+      Feed (detector, now, MicroSeconds (1000), MicroSeconds (3000), 20);
+      Feed (detector, now, MicroSeconds (1050), MicroSeconds (3050), 20);
+      detector->Stop ();
+      NS_TEST_EXPECT_MSG_EQ_TOL (detector->GetDelta ().GetSeconds (), 0.00095, 1e-9, "Wrong delta");
+      NS_TEST_EXPECT_MSG_LT (detector->GetConfidence (), 0.5, "Jitter ignored by the confidence");
+      NS_TEST_EXPECT_MSG_EQ (detector->IsCompressionDetected (), (i == 0),
+                             "MinConfidence " << (i == 0 ? 0.0 : 0.9) << " not applied");
+    }
+}
+
+/**
+ * Send a single train of all-zero payloads from a client to a port
+ * nobody listens on
+ * \param client the helper of the client, with its pacing set
+ * \param packets the number of packets sent
+ * \param recorder the recorder of the packets sent
+ * \return the number of events executed by the simulation
+ */
+static uint64_t
+RunCdaClient (CdaClientHelper &client, uint32_t packets, CdaTxRecorder &recorder)
+{
+  NodeContainer n;
+  Ipv4Address address = CreateCdaNetwork (n);
+  client.SetAttribute ("RemoteAddress", AddressValue (address));
+  client.SetAttribute ("MaxPackets", UintegerValue (packets));
+  ApplicationContainer apps = client.Install (n.Get (0));
+  apps.Start (Seconds (1.0));
+  Ptr<CdaClient> app = DynamicCast<CdaClient> (apps.Get (0));
+  app->AddTrain (0, packets);
+  app->TraceConnectWithoutContext ("Tx", MakeCallback (&CdaTxRecorder::Tx, &recorder));
+
+  Simulator::Run ();
+  uint64_t events = Simulator::GetEventCount ();
+  Simulator::Destroy ();
+  return events;
+}
+
+/**
+ * \ingroup applications-test
+ * \ingroup tests
+ *
+ * Test the send times of the Fixed, Poisson and Burst pacings of CdaClient
+ */
+class CdaClientPacingTestCase : public TestCase
+{
+public:
+  CdaClientPacingTestCase ();
+  virtual ~CdaClientPacingTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CdaClientPacingTestCase::CdaClientPacingTestCase ()
+  : TestCase ("Test the send times of the Fixed, Poisson and Burst pacings of CdaClient")
+{
+}
+
+CdaClientPacingTestCase::~CdaClientPacingTestCase ()
+{
+}
+
+void
+CdaClientPacingTestCase::DoRun (void)
+{
+  CdaClientHelper fixed (Ipv4Address (), 4000);
+  fixed.SetAttribute ("Interval", TimeValue (MilliSeconds (10)));
+  CdaTxRecorder fixedRecorder;
+  RunCdaClient (fixed, 5, fixedRecorder);
+  NS_TEST_ASSERT_MSG_EQ (fixedRecorder.times.size (), 5, "Not MaxPackets packets sent");
+  for (uint32_t i = 0; i < 5; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (fixedRecorder.times[i], MilliSeconds (1000 + 10 * i), "Fixed packet " << i << " sent at the wrong time");
+    }
+
+  // 100 bytes at 8000 bit/s, one packet every 100ms whatever the Interval
+  CdaClientHelper rate (Ipv4Address (), 4000);
+  rate.SetAttribute ("Rate", DataRateValue (DataRate ("8000bps")));
+  rate.SetAttribute ("PacketSize", UintegerValue (100));
+  CdaTxRecorder rateRecorder;
+  RunCdaClient (rate, 3, rateRecorder);
+  NS_TEST_ASSERT_MSG_EQ (rateRecorder.times.size (), 3, "Not MaxPackets packets sent");
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (rateRecorder.times[i], MilliSeconds (1000 + 100 * i), "Rate packet " << i << " sent at the wrong time");
+    }
+
+  CdaClientHelper burst (Ipv4Address (), 4000);
+  burst.SetAttribute ("Interval", TimeValue (MilliSeconds (10)));
+  burst.SetAttribute ("Pacing", StringValue ("Burst"));
+  burst.SetAttribute ("BurstSize", UintegerValue (3));
+  CdaTxRecorder burstRecorder;
+  RunCdaClient (burst, 7, burstRecorder);
+  NS_TEST_ASSERT_MSG_EQ (burstRecorder.times.size (), 7, "Not MaxPackets packets sent");
+  for (uint32_t i = 0; i < 7; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (burstRecorder.times[i], MilliSeconds (1000 + 30 * (i / 3)), "Burst packet " << i << " sent at the wrong time");
+    }
+
+  CdaClientHelper poisson (Ipv4Address (), 4000);
+  poisson.SetAttribute ("Interval", TimeValue (MilliSeconds (10)));
+  poisson.SetAttribute ("Pacing", StringValue ("Poisson"));
+  CdaTxRecorder poissonRecorder;
+  RunCdaClient (poisson, 1001, poissonRecorder);
+  NS_TEST_ASSERT_MSG_EQ (poissonRecorder.times.size (), 1001, "Not MaxPackets packets sent");
+  uint32_t distinct = 0;
+  for (uint32_t i = 1; i < 1001; ++i)
+    {
+      distinct += (poissonRecorder.times[i] - poissonRecorder.times[i - 1] != MilliSeconds (10));
+    }
+  NS_TEST_EXPECT_MSG_GT (distinct, 990, "Poisson gaps are not random");
+  // the standard deviation of the mean of 1000 gaps is 0.32ms
+  double mean = (poissonRecorder.times[1000] - poissonRecorder.times[0]).GetSeconds () / 1000;
+  NS_TEST_EXPECT_MSG_EQ_TOL (mean, 0.010, 0.0015, "Wrong mean Poisson gap");
+}
+
+/**
+ * \ingroup applications-test
+ * \ingroup tests
+ *
+ * Test that MaxBatch saves events without changing the send times
+ */
+class CdaClientBatchTestCase : public TestCase
+{
+public:
+  CdaClientBatchTestCase ();
+  virtual ~CdaClientBatchTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CdaClientBatchTestCase::CdaClientBatchTestCase ()
+  : TestCase ("Test that MaxBatch saves events without changing the send times")
+{
+}
+
+CdaClientBatchTestCase::~CdaClientBatchTestCase ()
+{
+}
+
+void
+CdaClientBatchTestCase::DoRun (void)
+{
+  CdaTxRecorder recorders[2];
+  uint64_t events[2];
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      CdaClientHelper client (Ipv4Address (), 4000);
+      client.SetAttribute ("Interval", TimeValue (MilliSeconds (1)));
+      client.SetAttribute ("Pacing", StringValue ("Burst"));
+      client.SetAttribute ("BurstSize", UintegerValue (10));
+      client.SetAttribute ("MaxBatch", UintegerValue (i == 0 ? 1 : 10));
+      events[i] = RunCdaClient (client, 100, recorders[i]);
+    }
+  NS_TEST_ASSERT_MSG_EQ (recorders[0].times.size (), 100, "Not MaxPackets packets sent");
+  NS_TEST_ASSERT_MSG_EQ (recorders[1].times.size (), 100, "Not MaxPackets packets sent in batches");
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (recorders[1].times[i], recorders[0].times[i], "Batched packet " << i << " sent at another time");
+    }
+  // one send event per burst instead of one per packet
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (events[0] - events[1], 90, "Send events not saved by MaxBatch");
+}
+
+/**
+ * \ingroup applications-test
+ * \ingroup tests
+ *
+ * Test that a CdaServer receives all the bytes of a TCP CdaClient as one flow
+ */
+class CdaClientServerTcpTestCase : public TestCase
+{
+public:
+  CdaClientServerTcpTestCase ();
+  virtual ~CdaClientServerTcpTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Rx trace sink
+   * \param p the packet received
+   */
+  void Rx (Ptr<const Packet> p);
+
+  uint32_t m_rxBytes; //!< Bytes received by the server
+};
+
+CdaClientServerTcpTestCase::CdaClientServerTcpTestCase ()
+  : TestCase ("Test that a CdaServer receives all the bytes of a TCP CdaClient as one flow"),
+    m_rxBytes (0)
+{
+}
+
+CdaClientServerTcpTestCase::~CdaClientServerTcpTestCase ()
+{
+}
+
+void
+CdaClientServerTcpTestCase::Rx (Ptr<const Packet> p)
+{
+  m_rxBytes += p->GetSize ();
+}
+
+void
+CdaClientServerTcpTestCase::DoRun (void)
+{
+  NodeContainer n;
+  Ipv4Address address = CreateCdaNetwork (n);
+
+  CdaServerHelper server (4000);
+  server.SetAttribute ("Protocol", TypeIdValue (TcpSocketFactory::GetTypeId ()));
+  ApplicationContainer apps = server.Install (n.Get (1));
+  apps.Start (Seconds (1.0));
+  apps.Stop (Seconds (10.0));
+  Ptr<CdaServer> serverApp = DynamicCast<CdaServer> (apps.Get (0));
+  serverApp->TraceConnectWithoutContext ("Rx", MakeCallback (&CdaClientServerTcpTestCase::Rx, this));
+
+  CdaClientHelper client (address, 4000);
+  client.SetAttribute ("Protocol", TypeIdValue (TcpSocketFactory::GetTypeId ()));
+  client.SetAttribute ("MaxPackets", UintegerValue (20));
+  client.SetAttribute ("Interval", TimeValue (MilliSeconds (10)));
+  client.SetAttribute ("TrainGap", TimeValue (MilliSeconds (100)));
+  client.SetAttribute ("PacketSize", UintegerValue (500));
+  apps = client.Install (n.Get (0));
+  apps.Start (Seconds (2.0));
+  apps.Stop (Seconds (10.0));
+
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_rxBytes, 20 * 500, "Bytes lost over TCP");
+  NS_TEST_EXPECT_MSG_EQ (serverApp->GetNFlows (), 1, "A TCP connection is not one flow");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup applications-test
+ * \ingroup tests
+ *
+ * Test that a CdaServer tells apart the flows of several CdaClient
+ */
+class CdaClientServerFlowsTestCase : public TestCase
+{
+public:
+  CdaClientServerFlowsTestCase ();
+  virtual ~CdaClientServerFlowsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CdaClientServerFlowsTestCase::CdaClientServerFlowsTestCase ()
+  : TestCase ("Test that a CdaServer tells apart the flows of several CdaClient")
+{
+}
+
+CdaClientServerFlowsTestCase::~CdaClientServerFlowsTestCase ()
+{
+}
+
+void
+CdaClientServerFlowsTestCase::DoRun (void)
+{
+  NodeContainer n;
+  Ipv4Address address = CreateCdaNetwork (n);
+
+  CdaServerHelper server (4000);
+  ApplicationContainer apps = server.Install (n.Get (1));
+  apps.Start (Seconds (1.0));
+  apps.Stop (Seconds (10.0));
+  Ptr<CdaServer> serverApp = DynamicCast<CdaServer> (apps.Get (0));
+
+  // three clients on the same node, sending at the same rate
+  CdaClientHelper client (address, 4000);
+  client.SetAttribute ("MaxPackets", UintegerValue (10));
+  client.SetAttribute ("Interval", TimeValue (MilliSeconds (10)));
+  client.SetAttribute ("TrainGap", TimeValue (MilliSeconds (10)));
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      apps = client.Install (n.Get (0));
+      apps.Start (Seconds (2.0) + MilliSeconds (i));
+      apps.Stop (Seconds (10.0));
+    }
+
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (serverApp->GetNFlows (), 3, "The clients are not told apart");
+  // the ARP resolution delays the first packets, shortening their flow a bit
+  NS_TEST_EXPECT_MSG_GT (serverApp->GetFairness (), 0.99, "Equal flows, unfair share");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (serverApp->GetFairness (), 1, "Fairness above 1");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup applications-test
+ * \ingroup tests
+ *
+ * \brief CdaClient and CdaServer TestSuite
+ */
+class CdaClientServerTestSuite : public TestSuite
+{
+public:
+  CdaClientServerTestSuite ();
+};
+
+CdaClientServerTestSuite::CdaClientServerTestSuite ()
+  : TestSuite ("cda-client-server", UNIT)
+{
+  AddTestCase (new CdaRandomPayloadTestCase, TestCase::QUICK);
+  AddTestCase (new CdaPoolPayloadTestCase, TestCase::QUICK);
+  AddTestCase (new CdaFilePayloadTestCase, TestCase::QUICK);
+  AddTestCase (new CdaEntropyPayloadTestCase, TestCase::QUICK);
+  AddTestCase (new CdaClientTrainsTestCase, TestCase::QUICK);
+  AddTestCase (new CdaClientNoPacketTestCase, TestCase::QUICK);
+  AddTestCase (new CdaDetectorTestCase, TestCase::QUICK);
+  AddTestCase (new CdaClientPacingTestCase, TestCase::QUICK);
+  AddTestCase (new CdaClientBatchTestCase, TestCase::QUICK);
+  AddTestCase (new CdaClientServerTcpTestCase, TestCase::QUICK);
+  AddTestCase (new CdaClientServerFlowsTestCase, TestCase::QUICK);
+}
+
+static CdaClientServerTestSuite cdaClientServerTestSuite; //!< Static variable for test initialization
@@ -72,13 +72,22 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
   m_eventCount = 0;
-  m_eventsWithContextEmpty = true;
+  m_eventsWithContext = new EventWithContextCell[EVENTS_WITH_CONTEXT_CELLS];
+  for (uint64_t i = 0; i < EVENTS_WITH_CONTEXT_CELLS; ++i)
+    {
+      m_eventsWithContext[i].sequence.store (i, std::memory_order_relaxed);
+    }
+  m_eventsWithContextTail.store (0, std::memory_order_relaxed);
+  m_eventsWithContextHead = 0;
+  m_eventsWithContextOverflowing.store (false, std::memory_order_relaxed);
+  m_eventsWithContextEmpty.store (true);
   m_main = SystemThread::Self();
 }
 
 DefaultSimulatorImpl::~DefaultSimulatorImpl ()
 {
   NS_LOG_FUNCTION (this);
+  delete [] m_eventsWithContext;
 }
 
 void
@@ -160,33 +169,65 @@ DefaultSimulatorImpl::IsFinished (void) const
   return m_events->IsEmpty () || m_stop;
 }
 
+void
+DefaultSimulatorImpl::InsertEventWithContext (const struct EventWithContext &event)
+{
+  Scheduler::Event ev;
+  ev.impl = event.event;
+  ev.key.m_ts = m_currentTs + event.timestamp;
+  ev.key.m_context = event.context;
+  ev.key.m_uid = m_uid;
+  m_uid++;
+  m_unscheduledEvents++;
+  m_events->Insert (ev);
+}
+
 void
 DefaultSimulatorImpl::ProcessEventsWithContext (void)
 {
-  if (m_eventsWithContextEmpty)
+  if (m_eventsWithContextEmpty.load (std::memory_order_acquire))
     {
       return;
     }
+  // synchronizes with the producer which cleared the flag
+  m_eventsWithContextEmpty.exchange (true, std::memory_order_acq_rel);
 
-  // swap queues
+  while (true)
+    {
+      EventWithContextCell &cell =
+        m_eventsWithContext[m_eventsWithContextHead % EVENTS_WITH_CONTEXT_CELLS];
+      if (cell.sequence.load (std::memory_order_acquire) != m_eventsWithContextHead + 1)
+        {
+          // empty, or reserved but not written yet
+          break;
+        }
+      InsertEventWithContext (cell.event);
+      cell.sequence.store (m_eventsWithContextHead + EVENTS_WITH_CONTEXT_CELLS,
+                           std::memory_order_release);
+      m_eventsWithContextHead++;
+    }
+
+  // the overflow holds the latest events of their producers: take them
+  // only once all the positions reserved in the queue have been read
+  if (!m_eventsWithContextOverflowing.load (std::memory_order_acquire))
+    {
+      return;
+    }
+  if (m_eventsWithContextTail.load (std::memory_order_acquire) != m_eventsWithContextHead)
+    {
+      m_eventsWithContextEmpty.store (false, std::memory_order_release);
+      return;
+    }
   EventsWithContext eventsWithContext;
   {
     CriticalSection cs (m_eventsWithContextMutex);
-    m_eventsWithContext.swap(eventsWithContext);
-    m_eventsWithContextEmpty = true;
+    m_eventsWithContextOverflow.swap (eventsWithContext);
+    m_eventsWithContextOverflowing.store (false, std::memory_order_release);
   }
   while (!eventsWithContext.empty ())
     {
-       EventWithContext event = eventsWithContext.front ();
-       eventsWithContext.pop_front ();
-       Scheduler::Event ev;
-       ev.impl = event.event;
-       ev.key.m_ts = m_currentTs + event.timestamp;
-       ev.key.m_context = event.context;
-       ev.key.m_uid = m_uid;
-       m_uid++;
-       m_unscheduledEvents++;
-       m_events->Insert (ev);
+      InsertEventWithContext (eventsWithContext.front ());
+      eventsWithContext.pop_front ();
     }
 }
 
@@ -270,11 +311,45 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
       // Current time added in ProcessEventsWithContext()
       ev.timestamp = delay.GetTimeStep ();
       ev.event = event;
-      {
-        CriticalSection cs (m_eventsWithContextMutex);
-        m_eventsWithContext.push_back(ev);
-        m_eventsWithContextEmpty = false;
-      }
+
+      bool queued = false;
+      if (!m_eventsWithContextOverflowing.load (std::memory_order_acquire))
+        {
+          uint64_t position = m_eventsWithContextTail.load (std::memory_order_relaxed);
+          while (true)
+            {
+              EventWithContextCell &cell =
+                m_eventsWithContext[position % EVENTS_WITH_CONTEXT_CELLS];
+              uint64_t sequence = cell.sequence.load (std::memory_order_acquire);
+              if (sequence == position)
+                {
+                  if (m_eventsWithContextTail.compare_exchange_weak (position, position + 1,
+                                                                     std::memory_order_relaxed))
+                    {
+                      cell.event = ev;
+                      cell.sequence.store (position + 1, std::memory_order_release);
+                      queued = true;
+                      break;
+                    }
+                }
+              else if (sequence < position)
+                {
+                  // full
+                  break;
+                }
+              else
+                {
+                  position = m_eventsWithContextTail.load (std::memory_order_relaxed);
+                }
+            }
+        }
+      if (!queued)
+        {
+          CriticalSection cs (m_eventsWithContextMutex);
+          m_eventsWithContextOverflow.push_back (ev);
+          m_eventsWithContextOverflowing.store (true, std::memory_order_release);
+        }
+      m_eventsWithContextEmpty.store (false, std::memory_order_release);
     }
 }
 
@@ -29,6 +29,7 @@
 
 #include "ptr.h"
 
+#include <atomic>
 #include <list>
 
 /**
@@ -96,17 +97,54 @@ private:
     /** The event implementation. */
     EventImpl *event;
   };
+  /**
+   * Insert an event from a different context into the main event queue.
+   *
+   * \param [in] event The event, with its context and delay.
+   */
+  void InsertEventWithContext (const EventWithContext &event);
+  /** A cell of the queue of events from a different context. */
+  struct EventWithContextCell {
+    /**
+     * The position in the queue at which the cell can be written, plus
+     * one once it has been written.
+     */
+    std::atomic<uint64_t> sequence;
+    /** The event. */
+    struct EventWithContext event;
+  };
+  /** Number of cells of the queue of events from a different context. */
+  static const uint64_t EVENTS_WITH_CONTEXT_CELLS = 1024;
+  /**
+   * The bounded lock-free queue of events from a different context.
+   *
+   * Producers reserve a position by advancing m_eventsWithContextTail,
+   * write the cell at that position modulo the number of cells, and
+   * publish it through its sequence; the main thread alone takes
+   * events from m_eventsWithContextHead.  Neither takes a lock nor
+   * allocates memory.
+   */
+  EventWithContextCell *m_eventsWithContext;
+  /** The next position reserved by a producer. */
+  std::atomic<uint64_t> m_eventsWithContextTail;
+  /** The next position read by the main thread. */
+  uint64_t m_eventsWithContextHead;
   /** Container type for the events from a different context. */
   typedef std::list<struct EventWithContext> EventsWithContext;
-  /** The container of events from a different context. */
-  EventsWithContext m_eventsWithContext;
+  /**
+   * The events from a different context scheduled while the queue was
+   * full, or while this list was not empty, in order.
+   */
+  EventsWithContext m_eventsWithContextOverflow;
+  /** Flag \c true if m_eventsWithContextOverflow is not empty. */
+  std::atomic<bool> m_eventsWithContextOverflowing;
+  /** Mutex to control access to m_eventsWithContextOverflow. */
+  SystemMutex m_eventsWithContextMutex;
   /**
    * Flag \c true if all events with context have been moved to the
    * primary event queue.
    */
-  bool m_eventsWithContextEmpty;
-  /** Mutex to control access to the list of events with context. */
-  SystemMutex m_eventsWithContextMutex;
+  std::atomic<bool> m_eventsWithContextEmpty;
 
   /** Container type for the events to run at Simulator::Destroy() */
   typedef std::list<EventId> DestroyEvents;
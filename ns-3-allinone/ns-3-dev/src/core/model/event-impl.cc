@@ -31,6 +31,115 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+namespace {
+
+/** Number of size classes of the event pool. */
+const std::size_t N_SIZE_CLASSES = EventImpl::MAX_POOLED_SIZE / EventImpl::GRANULARITY;
+
+/** A free block of the event pool. */
+struct FreeBlock
+{
+  FreeBlock *next;  /**< The next free block of the size class. */
+};
+
+/**
+ * The free lists of a thread.
+ *
+ * This is trivially destructible so that events deleted by the
+ * destructors of other thread or static objects, after the
+ * EventPoolGuard of the thread, still find it: they then go back to the
+ * global allocator.
+ */
+struct EventPool
+{
+  FreeBlock *head[N_SIZE_CLASSES];    /**< The first free block of each size class. */
+  std::size_t nFree[N_SIZE_CLASSES];  /**< The number of free blocks of each size class. */
+  bool closed;                        /**< Whether the thread is exiting. */
+};
+
+/** The free lists of this thread, zero-initialized. */
+thread_local EventPool g_eventPool;
+
+/** Releases the free blocks of a thread when it exits. */
+struct EventPoolGuard
+{
+  ~EventPoolGuard ()
+  {
+    g_eventPool.closed = true;
+    for (std::size_t i = 0; i < N_SIZE_CLASSES; ++i)
+      {
+        while (g_eventPool.head[i] != 0)
+          {
+            FreeBlock *block = g_eventPool.head[i];
+            g_eventPool.head[i] = block->next;
+            ::operator delete (block);
+          }
+        g_eventPool.nFree[i] = 0;
+      }
+  }
+};
+
+/** The guard of the free lists of this thread. */
+thread_local EventPoolGuard g_eventPoolGuard;
+
+/**
+ * Get the size class of an event.
+ *
+ * \param [in] size The size of the event.
+ * \return The index of the size class.
+ */
+inline std::size_t
+GetSizeClass (std::size_t size)
+{
+  return (size - 1) / EventImpl::GRANULARITY;
+}
+
+} // unnamed namespace
+
+void *
+EventImpl::operator new (std::size_t size)
+{
+  if (size == 0 || size > MAX_POOLED_SIZE)
+    {
+      return ::operator new (size);
+    }
+  std::size_t i = GetSizeClass (size);
+  FreeBlock *block = g_eventPool.head[i];
+  if (block != 0)
+    {
+      g_eventPool.head[i] = block->next;
+      g_eventPool.nFree[i]--;
+      return block;
+    }
+  // registers the guard, and thus the release of the blocks, of this thread
+  (void)&g_eventPoolGuard;
+  return ::operator new ((i + 1) * GRANULARITY);
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  if (p == 0)
+    {
+      return;
+    }
+  if (size == 0 || size > MAX_POOLED_SIZE)
+    {
+      ::operator delete (p);
+      return;
+    }
+  std::size_t i = GetSizeClass (size);
+  if (g_eventPool.closed || g_eventPool.nFree[i] >= MAX_FREE_BLOCKS)
+    {
+      ::operator delete (p);
+      return;
+    }
+  FreeBlock *block = static_cast<FreeBlock *> (p);
+  block->next = g_eventPool.head[i];
+  g_eventPool.head[i] = block;
+  g_eventPool.nFree[i]++;
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
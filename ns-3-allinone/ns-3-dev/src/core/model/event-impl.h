@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 /**
@@ -40,6 +41,13 @@ namespace ns3 {
  * when it reaches the time associated to this event. Most subclasses
  * are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * Events are allocated from a pool: each thread keeps a free list per
+ * size class, rounded up to GRANULARITY bytes, of the blocks of the events
+ * it deleted, and takes the blocks of new events from it.  Scheduling an
+ * event and running it thus reuse the storage of the events run before,
+ * rather than calling malloc and free once each.  Events larger than
+ * MAX_POOLED_SIZE, with large bound arguments, use the global allocator.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -48,6 +56,28 @@ public:
   EventImpl ();
   /** Destructor. */
   virtual ~EventImpl () = 0;
+  /**
+   * Allocate an event, from the pool of its size class.
+   *
+   * \param [in] size The size of the event.
+   * \return The storage of the event.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Release an event to the pool of its size class.
+   *
+   * \param [in] p The storage of the event.
+   * \param [in] size The size of the event, as given to operator new.
+   */
+  static void operator delete (void *p, std::size_t size);
+
+  /** Size classes of the pool, in bytes. */
+  static const std::size_t GRANULARITY = 16;
+  /** Largest event allocated from the pool, in bytes. */
+  static const std::size_t MAX_POOLED_SIZE = 256;
+  /** Largest number of free blocks kept by a thread for each size class. */
+  static const std::size_t MAX_FREE_BLOCKS = 65536;
+
   /**
    * Called by the simulation engine to notify the event that it is time
    * to execute.
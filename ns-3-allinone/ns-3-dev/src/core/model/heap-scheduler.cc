@@ -236,6 +236,13 @@ HeapScheduler::Remove (const Event &ev)
           NS_ASSERT (m_heap[i].impl == ev.impl);
           Exch (i, Last ());
           m_heap.pop_back ();
+          // the last event may belong above the removed one, not only below
+          while (i < m_heap.size () && !IsRoot (i)
+                 && IsLessStrictly (i, Parent (i)))
+            {
+              Exch (i, Parent (i));
+              i = Parent (i);
+            }
           TopDown (i);
           return;
         }
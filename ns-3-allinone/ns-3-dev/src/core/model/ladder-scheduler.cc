@@ -0,0 +1,307 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+#include <limits>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler class implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+namespace {
+
+/**
+ * \ingroup scheduler
+ * Order events from the latest to the earliest, as kept in the bottom.
+ *
+ * \param [in] a The first event.
+ * \param [in] b The second event.
+ * \returns \c true if \c a is later than \c b
+ */
+bool
+LaterFirst (const Scheduler::Event &a, const Scheduler::Event &b)
+{
+  return a.key > b.key;
+}
+
+} // unnamed namespace
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topStart (0),
+    m_topMin (std::numeric_limits<uint64_t>::max ()),
+    m_topMax (0),
+    m_nRungs (0)
+{
+  NS_LOG_FUNCTION (this);
+  // buckets are referenced across AddRung, which must not reallocate
+  m_rungs.reserve (MAX_RUNGS);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+LadderScheduler::GetCurrentStart (const Rung &rung)
+{
+  if (rung.current < rung.buckets.size ())
+    {
+      return rung.start + rung.current * rung.width;
+    }
+  return rung.end;
+}
+
+LadderScheduler::Bucket &
+LadderScheduler::GetBucket (Rung &rung, uint64_t ts)
+{
+  NS_ASSERT (ts >= rung.start && ts < rung.end);
+  uint64_t i = std::min<uint64_t> ((ts - rung.start) / rung.width, rung.buckets.size () - 1);
+  NS_ASSERT (i >= rung.current);
+  return rung.buckets[i];
+}
+
+void
+LadderScheduler::AddRung (const Bucket &events, uint64_t start, uint64_t last, uint64_t end)
+{
+  NS_LOG_FUNCTION (this << events.size () << start << last << end);
+  NS_ASSERT (m_nRungs < MAX_RUNGS);
+  if (m_nRungs == m_rungs.size ())
+    {
+      m_rungs.push_back (Rung ());
+    }
+  Rung &rung = m_rungs[m_nRungs++];
+  uint64_t span = last - start;
+  rung.start = start;
+  rung.end = end;
+  rung.width = span / events.size () + 1;
+  rung.current = 0;
+  // the buckets of a rung are all empty once it is consumed
+  rung.buckets.resize (span / rung.width + 1);
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      GetBucket (rung, i->key.m_ts).push_back (*i);
+    }
+}
+
+uint64_t
+LadderScheduler::GetBottomEnd (void) const
+{
+  if (m_nRungs > 0)
+    {
+      return GetCurrentStart (m_rungs[m_nRungs - 1]);
+    }
+  return m_topStart;
+}
+
+void
+LadderScheduler::Refill (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (m_bottom.empty ())
+    {
+      if (m_nRungs == 0)
+        {
+          if (m_top.empty ())
+            {
+              return;
+            }
+          AddRung (m_top, m_topMin, m_topMax, m_topMax + 1);
+          m_top.clear ();
+          m_topStart = m_topMax + 1;
+          m_topMin = std::numeric_limits<uint64_t>::max ();
+          m_topMax = 0;
+        }
+      Rung &rung = m_rungs[m_nRungs - 1];
+      while (rung.current < rung.buckets.size () && rung.buckets[rung.current].empty ())
+        {
+          rung.current++;
+        }
+      if (rung.current == rung.buckets.size ())
+        {
+          m_nRungs--;
+          continue;
+        }
+      Bucket &bucket = rung.buckets[rung.current++];
+      if (bucket.size () > THRESHOLD && m_nRungs < MAX_RUNGS)
+        {
+          uint64_t first = std::numeric_limits<uint64_t>::max ();
+          uint64_t last = 0;
+          for (Bucket::const_iterator i = bucket.begin (); i != bucket.end (); ++i)
+            {
+              first = std::min (first, i->key.m_ts);
+              last = std::max (last, i->key.m_ts);
+            }
+          // events at a single time stamp can only be sorted
+          if (last > first)
+            {
+              AddRung (bucket, first, last, GetCurrentStart (rung));
+              bucket.clear ();
+              continue;
+            }
+        }
+      m_bottom.swap (bucket);
+      std::sort (m_bottom.begin (), m_bottom.end (), LaterFirst);
+    }
+}
+
+void
+LadderScheduler::InsertBottom (const Scheduler::Event &ev)
+{
+  Bucket::iterator i = std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, LaterFirst);
+  m_bottom.insert (i, ev);
+  if (m_bottom.size () > THRESHOLD && m_nRungs < MAX_RUNGS
+      && m_bottom.front ().key.m_ts > m_bottom.back ().key.m_ts)
+    {
+      // spread a bottom grown by insertions over a rung of its own
+      AddRung (m_bottom, m_bottom.back ().key.m_ts, m_bottom.front ().key.m_ts, GetBottomEnd ());
+      m_bottom.clear ();
+      Refill ();
+    }
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      m_top.push_back (ev);
+      m_topMin = std::min (m_topMin, ts);
+      m_topMax = std::max (m_topMax, ts);
+    }
+  else
+    {
+      uint32_t i = 0;
+      while (i < m_nRungs && ts < GetCurrentStart (m_rungs[i]))
+        {
+          i++;
+        }
+      if (i < m_nRungs)
+        {
+          GetBucket (m_rungs[i], ts).push_back (ev);
+        }
+      else
+        {
+          InsertBottom (ev);
+        }
+    }
+  if (m_bottom.empty ())
+    {
+      Refill ();
+    }
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  // the bottom is only empty with the scheduler
+  return m_bottom.empty ();
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!m_bottom.empty ());
+  return m_bottom.back ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!m_bottom.empty ());
+  Event ev = m_bottom.back ();
+  m_bottom.pop_back ();
+  if (m_bottom.empty ())
+    {
+      Refill ();
+    }
+  NS_LOG_DEBUG (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  return ev;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  uint64_t ts = ev.key.m_ts;
+  Bucket *bucket = &m_bottom;
+  if (ts >= m_topStart)
+    {
+      bucket = &m_top;
+    }
+  else
+    {
+      for (uint32_t i = 0; i < m_nRungs; ++i)
+        {
+          if (ts >= GetCurrentStart (m_rungs[i]))
+            {
+              bucket = &GetBucket (m_rungs[i], ts);
+              break;
+            }
+        }
+    }
+  if (bucket == &m_bottom)
+    {
+      Bucket::iterator i = std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, LaterFirst);
+      NS_ASSERT (i != m_bottom.end () && i->impl == ev.impl);
+      m_bottom.erase (i);
+    }
+  else
+    {
+      Bucket::iterator i = bucket->begin ();
+      while (i != bucket->end () && i->key.m_uid != ev.key.m_uid)
+        {
+          ++i;
+        }
+      NS_ASSERT (i != bucket->end () && i->impl == ev.impl);
+      *i = bucket->back ();
+      bucket->pop_back ();
+    }
+  if (m_bottom.empty ())
+    {
+      Refill ();
+    }
+}
+
+} // namespace ns3
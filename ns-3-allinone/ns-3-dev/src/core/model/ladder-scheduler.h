@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler class declaration.
+ */
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue of
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by Wai Teng Tang, Rick Siow Mong Goh and
+ * Ian Li-Jin Thng (2005).  Events are kept in three tiers:
+ *
+ * - Top: an unsorted array of the events furthest in the future
+ * - Ladder: up to MAX_RUNGS rungs of buckets, each rung splitting one
+ *   bucket of the rung above into finer buckets
+ * - Bottom: a small sorted array holding the earliest events
+ *
+ * Events only get sorted once they reach the bottom, a bucket at a time,
+ * so insertion and removal take amortized constant time whatever the
+ * number of pending events.  All the tiers are contiguous arrays of
+ * Scheduler::Event whose storage is kept and reused as the rungs are
+ * consumed and rebuilt, which avoids an allocation per event and the
+ * pointer chasing of the node-based schedulers.
+ *
+ * Remove needs a linear search of the bucket, or of the top, holding the
+ * event: use EventId::Cancel rather than Simulator::Remove.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Bucket type: an unsorted array of Events. */
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /** A rung of the ladder. */
+  struct Rung
+  {
+    uint64_t start;               /**< Time stamp at the start of the first bucket. */
+    uint64_t end;                 /**< Time stamp at the end of the last bucket. */
+    uint64_t width;               /**< Duration of a bucket, in dimensionless time units;
+                                       the last bucket extends to the end of the rung. */
+    uint32_t current;             /**< Index of the first bucket not yet consumed. */
+    std::vector<Bucket> buckets;  /**< The buckets. */
+  };
+
+  /** Largest number of events of a bucket moved to the bottom as is. */
+  static const uint32_t THRESHOLD = 50;
+  /** Largest number of rungs. */
+  static const uint32_t MAX_RUNGS = 8;
+
+  /**
+   * Get the time stamp at the start of the first bucket not yet consumed
+   * of a rung; earlier events belong to the rungs below or to the bottom.
+   *
+   * \param [in] rung The rung.
+   * \returns The time stamp.
+   */
+  static uint64_t GetCurrentStart (const Rung &rung);
+  /**
+   * Get the bucket of a rung an event belongs to.
+   *
+   * \param [in] rung The rung.
+   * \param [in] ts The time stamp of the event.
+   * \returns The bucket.
+   */
+  static Bucket &GetBucket (Rung &rung, uint64_t ts);
+  /**
+   * Spread events over a new rung below the others, reusing the storage
+   * of a previous rung.  The width of the buckets is chosen for about one
+   * event per bucket.
+   *
+   * \param [in] events The events, all between \p start and \p end.
+   * \param [in] start The earliest time stamp of the events.
+   * \param [in] last The latest time stamp of the events.
+   * \param [in] end The time stamp at which the rung ends.
+   */
+  void AddRung (const Bucket &events, uint64_t start, uint64_t last, uint64_t end);
+  /**
+   * Get the time stamp below which events go to the bottom.
+   *
+   * \returns The time stamp.
+   */
+  uint64_t GetBottomEnd (void) const;
+  /**
+   * Move events into the bottom until it holds the earliest event, or
+   * the scheduler is empty.
+   */
+  void Refill (void);
+  /**
+   * Insert an event into the bottom, keeping it sorted.
+   *
+   * \param [in] ev The event.
+   */
+  void InsertBottom (const Scheduler::Event &ev);
+
+  /** Events at or after m_topStart, unsorted. */
+  Bucket m_top;
+  /** Time stamp from which events go to the top. */
+  uint64_t m_topStart;
+  /** Earliest time stamp in the top. */
+  uint64_t m_topMin;
+  /** Latest time stamp in the top. */
+  uint64_t m_topMax;
+  /** The rungs, the first m_nRungs of which are in use. */
+  std::vector<Rung> m_rungs;
+  /** Number of rungs in use. */
+  uint32_t m_nRungs;
+  /** Earliest events, sorted from the latest to the earliest. */
+  Bucket m_bottom;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
@@ -24,6 +24,9 @@
 #include <stdint.h>
 #include <string>
 #include <vector>
+#ifdef NS3_MULTITHREADED
+#include <atomic>
+#endif
 #include "ptr.h"
 #include "attribute.h"
 #include "object-base.h"
@@ -83,8 +86,19 @@ struct ObjectDeleter
  * all its aggregates. The DoDispose() method is always automatically
  * invoked from the Unref() method before destroying the Object,
  * even if the user did not call Dispose() directly.
+ *
+ * When ns-3 is configured with --enable-multithreaded, the reference
+ * count is atomic: the nodes, devices and channels of a simulation are
+ * referenced by the threads of a multithreaded simulator at the same
+ * time.  Every copy of a Ptr<Object> then takes a locked increment,
+ * about 3% of the run time of a serial scratch/cda without compression,
+ * so the default build keeps a plain counter.
  */
+#ifdef NS3_MULTITHREADED
+class Object : public SimpleRefCount<Object, ObjectBase, ObjectDeleter, std::atomic<uint32_t> >
+#else
 class Object : public SimpleRefCount<Object, ObjectBase, ObjectDeleter>
+#endif
 {
 public:
   /**
@@ -24,6 +24,8 @@
 #include "config.h"
 #include "log.h"
 
+#include <atomic>
+
 /**
  * \file
  * \ingroup randomvariable
@@ -37,9 +39,10 @@ NS_LOG_COMPONENT_DEFINE ("RngSeedManager");
 /**
  * \relates RngSeedManager
  * The next random number generator stream number to use
- * for automatic assignment.
+ * for automatic assignment.  Atomic because random variables may be
+ * created concurrently by the threads of a multithreaded simulator.
  */
-static uint64_t g_nextStreamIndex = 0;
+static std::atomic<uint64_t> g_nextStreamIndex (0);
 /**
  * \relates RngSeedManager
  * The random number generator seed number global value.  This is used to
@@ -100,9 +103,7 @@ uint64_t RngSeedManager::GetRun ()
 uint64_t RngSeedManager::GetNextStreamIndex (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  uint64_t next = g_nextStreamIndex;
-  g_nextStreamIndex++;
-  return next;
+  return g_nextStreamIndex++;
 }
 
 } // namespace ns3
@@ -66,10 +66,13 @@ namespace ns3 {
  *      a public static method named 'Delete'. This method will be called
  *      whenever the SimpleRefCount template detects that no references
  *      to the object it manages exist anymore.
+ * \tparam COUNTER \explicit The type of the reference count.  By
+ *      default this is a plain \c uint32_t; \c std::atomic<uint32_t>
+ *      lets several threads hold references to the same object.
  *
  * Interesting users of this class include ns3::Object as well as ns3::Packet.
  */
-template <typename T, typename PARENT = empty, typename DELETER = DefaultDeleter<T> >
+template <typename T, typename PARENT = empty, typename DELETER = DefaultDeleter<T>, typename COUNTER = uint32_t>
 class SimpleRefCount : public PARENT
 {
 public:
@@ -115,8 +118,7 @@ public:
    */
   inline void Unref (void) const
   {
-    m_count--;
-    if (m_count == 0)
+    if (--m_count == 0)
       {
         DELETER::Delete (static_cast<T*> (const_cast<SimpleRefCount *> (this)));
       }
@@ -141,7 +143,7 @@ private:
    * Note we make this mutable so that the const methods can still
    * change it.
    */
-  mutable uint32_t m_count;
+  mutable COUNTER m_count;
 };
 
 } // namespace ns3
@@ -23,6 +23,10 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/make-event.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -461,6 +465,198 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * Check that a scheduler returns events in the same order as MapScheduler,
+ * the reference, under a long mix of insertions, removals of the next
+ * event and removals of arbitrary events.  Time stamps are drawn close to
+ * the last event removed, far in the future or equal to it, as simulations
+ * schedule them, so that every tier of bucket-based schedulers is used.
+ */
+class SchedulerOrderingTestCase : public TestCase
+{
+public:
+  SchedulerOrderingTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  uint32_t Random (uint32_t n);
+  ObjectFactory m_schedulerFactory;
+  uint32_t m_state;
+};
+
+SchedulerOrderingTestCase::SchedulerOrderingTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check that events come out in MapScheduler order with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory),
+    m_state (1)
+{
+}
+
+uint32_t
+SchedulerOrderingTestCase::Random (uint32_t n)
+{
+  m_state = m_state * 1103515245 + 12345;
+  return (m_state >> 8) % n;
+}
+
+void
+SchedulerOrderingTestCase::DoRun (void)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  Ptr<Scheduler> reference = CreateObject<MapScheduler> ();
+  std::vector<Scheduler::Event> pending;
+  uint64_t now = 0;
+  uint32_t uid = 0;
+  for (uint32_t step = 0; step < 200000; ++step)
+    {
+      uint32_t op = Random (100);
+      if (op < 50 || pending.empty ())
+        {
+          Scheduler::Event ev;
+          ev.impl = 0;
+          ev.key.m_uid = uid++;
+          ev.key.m_context = 0;
+          uint32_t kind = Random (10);
+          if (kind < 2)
+            {
+              ev.key.m_ts = now;
+            }
+          else if (kind < 9)
+            {
+              ev.key.m_ts = now + Random (1000);
+            }
+          else
+            {
+              ev.key.m_ts = now + 1000000 + Random (1000000000);
+            }
+          scheduler->Insert (ev);
+          reference->Insert (ev);
+          pending.push_back (ev);
+        }
+      else if (op < 95)
+        {
+          NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), false, "Scheduler lost events");
+          Scheduler::Event expected = reference->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (scheduler->PeekNext ().key.m_uid, expected.key.m_uid,
+                                 "Wrong next event at step " << step);
+          Scheduler::Event ev = scheduler->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, expected.key.m_uid, "Wrong event removed at step " << step);
+          NS_TEST_ASSERT_MSG_EQ (ev.key.m_ts, expected.key.m_ts, "Wrong time stamp at step " << step);
+          now = ev.key.m_ts;
+          for (std::size_t i = 0; i < pending.size (); ++i)
+            {
+              if (pending[i].key.m_uid == ev.key.m_uid)
+                {
+                  pending[i] = pending.back ();
+                  pending.pop_back ();
+                  break;
+                }
+            }
+        }
+      else
+        {
+          std::size_t i = Random (pending.size ());
+          scheduler->Remove (pending[i]);
+          reference->Remove (pending[i]);
+          pending[i] = pending.back ();
+          pending.pop_back ();
+        }
+    }
+  while (!reference->IsEmpty ())
+    {
+      NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), false, "Scheduler lost events");
+      NS_TEST_ASSERT_MSG_EQ (scheduler->RemoveNext ().key.m_uid, reference->RemoveNext ().key.m_uid,
+                             "Wrong event removed while draining");
+    }
+  NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), true, "Scheduler holds extra events");
+}
+
+/**
+ * Bound argument counting its live copies, of a configurable size.
+ */
+template <std::size_t N>
+class CountedArgument
+{
+public:
+  CountedArgument ()
+  {
+    m_live++;
+  }
+  CountedArgument (const CountedArgument &o)
+  {
+    m_live++;
+  }
+  ~CountedArgument ()
+  {
+    m_live--;
+  }
+  static int m_live;
+  char m_data[N];
+};
+
+template <std::size_t N>
+int CountedArgument<N>::m_live = 0;
+
+/**
+ * Check that pooled events are reused, and that their bound arguments are
+ * destroyed, whether they run, get cancelled or get removed, for events
+ * from the pool and larger ones.
+ */
+class EventPoolTestCase : public TestCase
+{
+public:
+  EventPoolTestCase ();
+  virtual void DoRun (void);
+  void Small (CountedArgument<8> a);
+  void Large (CountedArgument<EventImpl::MAX_POOLED_SIZE> a);
+  int m_runs;
+};
+
+EventPoolTestCase::EventPoolTestCase ()
+  : TestCase ("Check the event pool"),
+    m_runs (0)
+{
+}
+
+void
+EventPoolTestCase::Small (CountedArgument<8> a)
+{
+  m_runs++;
+}
+
+void
+EventPoolTestCase::Large (CountedArgument<EventImpl::MAX_POOLED_SIZE> a)
+{
+  m_runs++;
+}
+
+void
+EventPoolTestCase::DoRun (void)
+{
+  EventImpl *first = MakeEvent (&foo1, 1);
+  first->Unref ();
+  EventImpl *second = MakeEvent (&foo1, 2);
+  NS_TEST_ASSERT_MSG_EQ (second, first, "The block of a deleted event is not reused");
+  second->Unref ();
+
+  {
+    CountedArgument<8> small;
+    CountedArgument<EventImpl::MAX_POOLED_SIZE> large;
+    Simulator::Schedule (Seconds (1), &EventPoolTestCase::Small, this, small);
+    Simulator::Schedule (Seconds (1), &EventPoolTestCase::Large, this, large);
+    Simulator::Schedule (Seconds (1), &EventPoolTestCase::Small, this, small).Cancel ();
+    Simulator::Schedule (Seconds (1), &EventPoolTestCase::Large, this, large).Cancel ();
+    EventId id = Simulator::Schedule (Seconds (1), &EventPoolTestCase::Small, this, small);
+    Simulator::Remove (id);
+    id = Simulator::Schedule (Seconds (1), &EventPoolTestCase::Large, this, large);
+    Simulator::Remove (id);
+  }
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_runs, 2, "Wrong number of events run");
+  NS_TEST_ASSERT_MSG_EQ (CountedArgument<8>::m_live, 0, "Arguments of pooled events leaked");
+  NS_TEST_ASSERT_MSG_EQ (CountedArgument<EventImpl::MAX_POOLED_SIZE>::m_live, 0,
+                         "Arguments of large events leaked");
+  Simulator::Destroy ();
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -477,5 +673,11 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SchedulerOrderingTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderingTestCase (factory), TestCase::QUICK);
+    AddTestCase (new EventPoolTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
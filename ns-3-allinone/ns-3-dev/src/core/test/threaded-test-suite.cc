@@ -23,10 +23,12 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
 #include "ns3/config.h"
 #include "ns3/string.h"
 #include "ns3/system-thread.h"
 
+#include <atomic>
 #include <chrono>  // seconds, milliseconds
 #include <ctime>
 #include <list>
@@ -226,6 +228,99 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_a, m_d, "Bad scheduling");
 }
 
+/**
+ * Check that events scheduled by threads in bursts, faster than the main
+ * thread takes them, all run, in the order each thread scheduled them.
+ */
+class ThreadedSimulatorBurstTestCase : public TestCase
+{
+public:
+  ThreadedSimulatorBurstTestCase (unsigned int threads, unsigned int events);
+  void Receive (unsigned int threadno, unsigned int i);
+  void Poll (void);
+  static void SchedulingThread (std::pair<ThreadedSimulatorBurstTestCase *, unsigned int> context);
+  unsigned int m_threads;
+  unsigned int m_events;
+  std::atomic<unsigned int> m_done;
+  unsigned int m_next[MAXTHREADS];
+  uint64_t m_received;
+  bool m_ordered;
+
+private:
+  virtual void DoRun (void);
+};
+
+ThreadedSimulatorBurstTestCase::ThreadedSimulatorBurstTestCase (unsigned int threads, unsigned int events)
+  : TestCase ("Check bursts of " + std::to_string (events) + " events from " +
+              std::to_string (threads) + " threads"),
+    m_threads (threads),
+    m_events (events)
+{
+}
+
+void
+ThreadedSimulatorBurstTestCase::SchedulingThread (std::pair<ThreadedSimulatorBurstTestCase *, unsigned int> context)
+{
+  ThreadedSimulatorBurstTestCase *me = context.first;
+  unsigned int threadno = context.second;
+  for (unsigned int i = 0; i < me->m_events; ++i)
+    {
+      Simulator::ScheduleWithContext (threadno, Time (0),
+                                      &ThreadedSimulatorBurstTestCase::Receive, me, threadno, i);
+    }
+  me->m_done++;
+}
+
+void
+ThreadedSimulatorBurstTestCase::Receive (unsigned int threadno, unsigned int i)
+{
+  if (i != m_next[threadno])
+    {
+      m_ordered = false;
+    }
+  m_next[threadno] = i + 1;
+  m_received++;
+}
+
+void
+ThreadedSimulatorBurstTestCase::Poll (void)
+{
+  if (m_done < m_threads || m_received < uint64_t (m_threads) * m_events)
+    {
+      Simulator::Schedule (NanoSeconds (1), &ThreadedSimulatorBurstTestCase::Poll, this);
+    }
+}
+
+void
+ThreadedSimulatorBurstTestCase::DoRun (void)
+{
+  m_done = 0;
+  m_received = 0;
+  m_ordered = true;
+  std::list<Ptr<SystemThread> > threads;
+  for (unsigned int i = 0; i < m_threads; ++i)
+    {
+      m_next[i] = 0;
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (
+          &ThreadedSimulatorBurstTestCase::SchedulingThread,
+              std::pair<ThreadedSimulatorBurstTestCase *, unsigned int> (this, i))));
+    }
+  Simulator::Schedule (NanoSeconds (1), &ThreadedSimulatorBurstTestCase::Poll, this);
+  for (std::list<Ptr<SystemThread> >::iterator it = threads.begin (); it != threads.end (); ++it)
+    {
+      (*it)->Start ();
+    }
+  Simulator::Run ();
+  for (std::list<Ptr<SystemThread> >::iterator it = threads.begin (); it != threads.end (); ++it)
+    {
+      (*it)->Join ();
+    }
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_received, uint64_t (m_threads) * m_events, "Events lost");
+  NS_TEST_EXPECT_MSG_EQ (m_ordered, true, "Events of a thread run out of order");
+}
+
 class ThreadedSimulatorTestSuite : public TestSuite
 {
 public:
@@ -242,7 +337,8 @@ public:
       "ns3::ListScheduler",
       "ns3::HeapScheduler",
       "ns3::MapScheduler",
-      "ns3::CalendarScheduler"
+      "ns3::CalendarScheduler",
+      "ns3::LadderScheduler"
     };
     unsigned int threadcounts[] = {
       0,
@@ -263,5 +359,6 @@ public:
               }
           }
       }
+    AddTestCase (new ThreadedSimulatorBurstTestCase (8, 20000), TestCase::QUICK);
   }
 } g_threadedSimulatorTestSuite;
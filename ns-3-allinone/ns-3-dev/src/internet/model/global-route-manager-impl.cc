@@ -711,9 +711,10 @@ GlobalRouteManagerImpl::InitializeRoutes ()
       Ptr<GlobalRouter> rtr = 
         node->GetObject<GlobalRouter> ();
 
-      uint32_t systemId = MpiInterface::GetSystemId ();
-      // Ignore nodes that are not assigned to our systemId (distributed sim)
-      if (node->GetSystemId () != systemId) 
+      // Ignore nodes that are not assigned to our systemId (distributed sim).
+      // Without MPI, all the systems are simulated by this process.
+      if (MpiInterface::IsEnabled ()
+          && node->GetSystemId () != MpiInterface::GetSystemId ())
         {
           continue;
         }
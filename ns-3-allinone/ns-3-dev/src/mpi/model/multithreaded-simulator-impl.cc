@@ -0,0 +1,823 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/system-thread.h"
+#include "ns3/channel.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <thread>
+
+/**
+ * \file
+ * \ingroup mpi
+ * ns3::MultithreadedSimulatorImpl implementation.
+ */
+
+namespace ns3 {
+
+// Note:  Logging in this file is largely avoided due to the
+// number of calls that are made to these functions and the possibility
+// of causing recursions leading to stack overflow
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+/** The largest simulation time, also used for "no event". */
+static const uint64_t MAX_TS = 0x7fffffffffffffffULL;
+
+/** An event sent to another partition. */
+struct PartitionEvent
+{
+  uint64_t ts;        /**< The absolute time of the event. */
+  uint32_t context;   /**< The context of the event. */
+  EventImpl *event;   /**< The event, with the reference of the sender. */
+};
+
+struct MultithreadedSimulatorImpl::Partition
+{
+  uint32_t id;                   /**< The system id of the nodes of the partition. */
+  Ptr<Scheduler> events;         /**< The events of the partition. */
+  uint64_t currentTs;            /**< The time of the last event. */
+  uint32_t currentUid;           /**< The uid of the last event. */
+  uint32_t currentContext;       /**< The context of the last event. */
+  uint32_t uid;                  /**< The next event uid. */
+  uint64_t eventCount;           /**< The number of events executed. */
+  int unscheduledEvents;         /**< The number of events in the scheduler. */
+  bool stop;                     /**< Whether Stop () was called by an event. */
+  std::multiset<uint64_t> stopTimes;   /**< The times of the Stop (delay) calls. */
+  /**
+   * The events scheduled for each other partition during the current
+   * window, indexed by destination.  They are written by this partition
+   * during the window and read by the destination between windows.
+   */
+  std::vector<std::vector<PartitionEvent> > outboxes;
+  uint64_t nextTs;               /**< The next event time, published between windows. */
+  uint64_t stopTs;               /**< The next stop time, published between windows. */
+};
+
+/**
+ * The partition simulated by this thread, or 0 if this thread is not
+ * running a partition.
+ */
+static thread_local MultithreadedSimulatorImpl::Partition *g_partition = 0;
+
+MultithreadedSimulatorImpl::Barrier::Barrier ()
+  : m_n (1),
+    m_count (0),
+    m_generation (0)
+{
+}
+
+void
+MultithreadedSimulatorImpl::Barrier::Reset (uint32_t n)
+{
+  m_n = n;
+  m_count.store (0, std::memory_order_relaxed);
+}
+
+void
+MultithreadedSimulatorImpl::Barrier::Wait (void)
+{
+  uint32_t generation = m_generation.load (std::memory_order_acquire);
+  if (m_count.fetch_add (1, std::memory_order_acq_rel) + 1 == m_n)
+    {
+      // last one in: the others wait for the generation to change so
+      // the count can be reset for the next use
+      m_count.store (0, std::memory_order_relaxed);
+      m_generation.fetch_add (1, std::memory_order_release);
+      return;
+    }
+  uint32_t spins = 0;
+  while (m_generation.load (std::memory_order_acquire) == generation)
+    {
+      if (++spins > 1024)
+        {
+          std::this_thread::yield ();
+        }
+    }
+}
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Mpi")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+  m_lookAhead = GetMaximumSimulationTime ();
+  m_running = false;
+  m_stop = false;
+  // uids are allocated from 4.
+  // uid 0 is "invalid" events
+  // uid 1 is "now" events
+  // uid 2 is "destroy" events
+  m_uid = 4;
+  m_firstSetupUid = m_uid;
+  m_currentTs = 0;
+  m_currentContext = Simulator::NO_CONTEXT;
+  m_eventCount = 0;
+  m_unscheduledEvents = 0;
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_events->IsEmpty ())
+    {
+      Scheduler::Event next = m_events->RemoveNext ();
+      next.impl->Unref ();
+    }
+  m_events = 0;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Partition *partition = *i;
+      while (!partition->events->IsEmpty ())
+        {
+          Scheduler::Event next = partition->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      delete partition;
+    }
+  m_partitions.clear ();
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  NS_ASSERT_MSG (!m_running, "MultithreadedSimulatorImpl::SetScheduler(): called during Run");
+  m_schedulerFactory = schedulerFactory;
+
+  Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+  if (m_events != 0)
+    {
+      while (!m_events->IsEmpty ())
+        {
+          Scheduler::Event next = m_events->RemoveNext ();
+          scheduler->Insert (next);
+        }
+    }
+  m_events = scheduler;
+
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Partition *partition = *i;
+      scheduler = schedulerFactory.Create<Scheduler> ();
+      while (!partition->events->IsEmpty ())
+        {
+          Scheduler::Event next = partition->events->RemoveNext ();
+          scheduler->Insert (next);
+        }
+      partition->events = scheduler;
+    }
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return g_partition != 0 ? g_partition->id : 0;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionCount (void) const
+{
+  return m_partitions.size ();
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookAhead (void) const
+{
+  return m_lookAhead;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionId (uint32_t context, uint32_t current) const
+{
+  if (context < m_nodePartitions.size ())
+    {
+      return m_nodePartitions[context];
+    }
+  return current;
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (const EventId &id) const
+{
+  if (g_partition != 0)
+    {
+      return g_partition;
+    }
+  if (id.GetUid () >= m_firstSetupUid || m_partitions.empty ())
+    {
+      // not distributed yet
+      return 0;
+    }
+  return m_partitions[GetPartitionId (id.GetContext (), 0)];
+}
+
+void
+MultithreadedSimulatorImpl::CreatePartitions (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_nodePartitions.clear ();
+  uint32_t n = std::max<uint32_t> (m_partitions.size (), 1);
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      uint32_t systemId = (*i)->GetSystemId ();
+      m_nodePartitions.push_back (systemId);
+      n = std::max (n, systemId + 1);
+    }
+
+  while (m_partitions.size () < n)
+    {
+      Partition *partition = new Partition ();
+      partition->id = m_partitions.size ();
+      partition->events = m_schedulerFactory.Create<Scheduler> ();
+      partition->currentTs = m_currentTs;
+      partition->currentUid = 0;
+      partition->currentContext = Simulator::NO_CONTEXT;
+      partition->uid = m_uid;
+      partition->eventCount = 0;
+      partition->unscheduledEvents = 0;
+      partition->stop = false;
+      partition->nextTs = MAX_TS;
+      partition->stopTs = MAX_TS;
+      m_partitions.push_back (partition);
+    }
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      (*i)->outboxes.resize (n);
+    }
+  NS_LOG_INFO (n << " partitions");
+}
+
+void
+MultithreadedSimulatorImpl::CalculateLookAhead (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_lookAhead = GetMaximumSimulationTime ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      for (uint32_t j = 0; j < node->GetNDevices (); ++j)
+        {
+          Ptr<NetDevice> device = node->GetDevice (j);
+          Ptr<Channel> channel = device->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+          bool remote = false;
+          for (std::size_t k = 0; k < channel->GetNDevices (); ++k)
+            {
+              Ptr<NetDevice> other = channel->GetDevice (k);
+              if (other != 0 && other->GetNode () != 0
+                  && other->GetNode ()->GetSystemId () != node->GetSystemId ())
+                {
+                  remote = true;
+                }
+            }
+          if (!remote)
+            {
+              continue;
+            }
+          if (!device->IsPointToPoint ())
+            {
+              NS_FATAL_ERROR ("Node " << node->GetId () << " (system " << node->GetSystemId ()
+                              << ") is connected to another system by a channel which is not "
+                              "point-to-point: nodes of different systems may only be "
+                              "connected by point-to-point links");
+            }
+          TimeValue delay;
+          channel->GetAttribute ("Delay", delay);
+          if (!delay.Get ().IsStrictlyPositive ())
+            {
+              NS_FATAL_ERROR ("Node " << node->GetId () << " (system " << node->GetSystemId ()
+                              << ") is connected to another system by a link without delay: "
+                              "the systems could not run in parallel");
+            }
+          m_lookAhead = std::min (m_lookAhead, delay.Get ());
+        }
+    }
+  NS_LOG_INFO ("lookahead " << m_lookAhead);
+}
+
+void
+MultithreadedSimulatorImpl::DistributeEvents (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_events->IsEmpty ())
+    {
+      Scheduler::Event next = m_events->RemoveNext ();
+      Partition *partition = m_partitions[GetPartitionId (next.key.m_context, 0)];
+      partition->events->Insert (next);
+      partition->unscheduledEvents++;
+    }
+  m_unscheduledEvents = 0;
+
+  Partition *first = m_partitions[0];
+  first->stopTimes.insert (m_stopTimes.begin (), m_stopTimes.end ());
+  m_stopTimes.clear ();
+
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Partition *partition = *i;
+      partition->uid = std::max (partition->uid, m_uid);
+      partition->stop = false;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (Partition *partition)
+{
+  Scheduler::Event next = partition->events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= partition->currentTs);
+  partition->unscheduledEvents--;
+  partition->eventCount++;
+
+  NS_LOG_LOGIC ("handle " << next.key.m_ts);
+  partition->currentTs = next.key.m_ts;
+  partition->currentContext = next.key.m_context;
+  partition->currentUid = next.key.m_uid;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::ReceiveEvents (Partition *partition)
+{
+  // in the order of the senders, so that uids do not depend on
+  // thread scheduling
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      std::vector<PartitionEvent> &outbox = (*i)->outboxes[partition->id];
+      for (std::vector<PartitionEvent>::const_iterator j = outbox.begin (); j != outbox.end (); ++j)
+        {
+          NS_ASSERT (j->ts >= partition->currentTs);
+          Scheduler::Event ev;
+          ev.impl = j->event;
+          ev.key.m_ts = j->ts;
+          ev.key.m_context = j->context;
+          ev.key.m_uid = partition->uid;
+          partition->uid++;
+          partition->unscheduledEvents++;
+          partition->events->Insert (ev);
+        }
+      outbox.clear ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::RunPartitionThread (MultithreadedSimulatorImpl *simulator,
+                                                Partition *partition)
+{
+  simulator->RunPartition (partition);
+}
+
+void
+MultithreadedSimulatorImpl::RunPartition (Partition *partition)
+{
+  NS_LOG_FUNCTION (this << partition->id);
+  g_partition = partition;
+
+  while (true)
+    {
+      // the other partitions are done with the last window
+      m_barrier.Wait ();
+      ReceiveEvents (partition);
+      partition->nextTs = partition->events->IsEmpty () ?
+        MAX_TS : partition->events->PeekNext ().key.m_ts;
+      partition->stopTs = partition->stopTimes.empty () ?
+        MAX_TS : *partition->stopTimes.begin ();
+      // all the partitions have published their next event
+      m_barrier.Wait ();
+
+      // every partition reaches the same decision from the same data
+      uint64_t nextTs = MAX_TS;
+      uint64_t stopTs = MAX_TS;
+      bool stop = false;
+      for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+        {
+          nextTs = std::min (nextTs, (*i)->nextTs);
+          stopTs = std::min (stopTs, (*i)->stopTs);
+          stop = stop || (*i)->stop;
+        }
+      if (stop)
+        {
+          break;
+        }
+      if (nextTs >= stopTs)
+        {
+          if (stopTs != MAX_TS)
+            {
+              // the simulation reached a Stop (delay)
+              partition->currentTs = std::max (partition->currentTs, stopTs);
+              partition->currentUid = 0;
+              partition->stopTimes.erase (partition->stopTimes.begin (),
+                                          partition->stopTimes.upper_bound (stopTs));
+            }
+          break;
+        }
+
+      uint64_t lookAhead = m_lookAhead.GetTimeStep ();
+      uint64_t windowEnd = nextTs > MAX_TS - lookAhead ? MAX_TS : nextTs + lookAhead;
+      windowEnd = std::min (windowEnd, stopTs);
+      while (!partition->stop && !partition->events->IsEmpty ())
+        {
+          uint64_t ts = partition->events->PeekNext ().key.m_ts;
+          if (ts >= windowEnd
+              || (!partition->stopTimes.empty () && ts >= *partition->stopTimes.begin ()))
+            {
+              break;
+            }
+          ProcessOneEvent (partition);
+        }
+    }
+
+  g_partition = 0;
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (!m_running, "MultithreadedSimulatorImpl::Run(): already running");
+
+  CreatePartitions ();
+  CalculateLookAhead ();
+  DistributeEvents ();
+  m_stop = false;
+
+  m_barrier.Reset (m_partitions.size ());
+  m_running = true;
+  std::vector<Ptr<SystemThread> > threads;
+  for (std::size_t i = 1; i < m_partitions.size (); ++i)
+    {
+      Ptr<SystemThread> thread =
+        Create<SystemThread> (MakeBoundCallback (&MultithreadedSimulatorImpl::RunPartitionThread,
+                                                 this, m_partitions[i]));
+      thread->Start ();
+      threads.push_back (thread);
+    }
+  RunPartition (m_partitions[0]);
+  for (std::vector<Ptr<SystemThread> >::iterator i = threads.begin (); i != threads.end (); ++i)
+    {
+      (*i)->Join ();
+    }
+  m_running = false;
+
+  m_eventCount = 0;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Partition *partition = *i;
+      m_currentTs = std::max (m_currentTs, partition->currentTs);
+      m_uid = std::max (m_uid, partition->uid);
+      m_eventCount += partition->eventCount;
+      m_stopTimes.insert (partition->stopTimes.begin (), partition->stopTimes.end ());
+      partition->stopTimes.clear ();
+    }
+  m_firstSetupUid = m_uid;
+
+  // If the simulator stopped naturally by lack of events, make a
+  // consistency test to check that we didn't lose any events along the way.
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      NS_ASSERT (!(*i)->events->IsEmpty () || (*i)->unscheduledEvents == 0);
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (g_partition != 0)
+    {
+      return g_partition->events->IsEmpty () || g_partition->stop;
+    }
+  if (m_stop || !m_events->IsEmpty ())
+    {
+      return m_stop;
+    }
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      if ((*i)->stop)
+        {
+          return true;
+        }
+      if (!(*i)->events->IsEmpty ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (g_partition != 0)
+    {
+      g_partition->stop = true;
+    }
+  else
+    {
+      m_stop = true;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  NS_ASSERT_MSG (delay.IsPositive (), "MultithreadedSimulatorImpl::Stop(): Negative delay");
+  uint64_t ts = (delay + Now ()).GetTimeStep ();
+  if (g_partition != 0)
+    {
+      // published to the other partitions at the next window boundary
+      g_partition->stopTimes.insert (ts);
+    }
+  else
+    {
+      m_stopTimes.insert (ts);
+    }
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep () << event);
+  NS_ASSERT_MSG (delay.IsPositive (), "MultithreadedSimulatorImpl::Schedule(): Negative delay");
+
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = (uint64_t) (delay + Now ()).GetTimeStep ();
+  ev.key.m_context = GetContext ();
+  if (g_partition != 0)
+    {
+      ev.key.m_uid = g_partition->uid;
+      g_partition->uid++;
+      g_partition->unscheduledEvents++;
+      g_partition->events->Insert (ev);
+    }
+  else
+    {
+      NS_ASSERT_MSG (!m_running, "Simulator::Schedule Thread-unsafe invocation!");
+      ev.key.m_uid = m_uid;
+      m_uid++;
+      m_unscheduledEvents++;
+      m_events->Insert (ev);
+    }
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << delay.GetTimeStep () << event);
+
+  Partition *partition = g_partition;
+  if (partition == 0)
+    {
+      NS_ASSERT_MSG (!m_running, "Simulator::ScheduleWithContext Thread-unsafe invocation!");
+      Scheduler::Event ev;
+      ev.impl = event;
+      ev.key.m_ts = (uint64_t) (delay + TimeStep (m_currentTs)).GetTimeStep ();
+      ev.key.m_context = context;
+      ev.key.m_uid = m_uid;
+      m_uid++;
+      m_unscheduledEvents++;
+      m_events->Insert (ev);
+      return;
+    }
+
+  uint64_t ts = (uint64_t) (delay + TimeStep (partition->currentTs)).GetTimeStep ();
+  uint32_t target = GetPartitionId (context, partition->id);
+  if (target == partition->id)
+    {
+      Scheduler::Event ev;
+      ev.impl = event;
+      ev.key.m_ts = ts;
+      ev.key.m_context = context;
+      ev.key.m_uid = partition->uid;
+      partition->uid++;
+      partition->unscheduledEvents++;
+      partition->events->Insert (ev);
+      return;
+    }
+
+  if (delay < m_lookAhead)
+    {
+      NS_FATAL_ERROR ("Event for context " << context << " (system " << target
+                      << ") scheduled by system " << partition->id << " with a delay of "
+                      << delay << ", below the lookahead of " << m_lookAhead);
+    }
+  PartitionEvent ev;
+  ev.ts = ts;
+  ev.context = context;
+  ev.event = event;
+  partition->outboxes[target].push_back (ev);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return Schedule (TimeStep (0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  CriticalSection cs (m_destroyEventsMutex);
+  EventId id (Ptr<EventImpl> (event, false), Now ().GetTimeStep (), 0xffffffff, 2);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  return TimeStep (g_partition != 0 ? g_partition->currentTs : m_currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs ()) - Now ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_destroyEventsMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  Partition *partition = GetPartition (id);
+  if (partition != 0)
+    {
+      partition->events->Remove (event);
+      partition->unscheduledEvents--;
+    }
+  else
+    {
+      m_events->Remove (event);
+      m_unscheduledEvents--;
+    }
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0 ||
+          id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (m_destroyEventsMutex);
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  Partition *partition = GetPartition (id);
+  uint64_t currentTs = partition != 0 ? partition->currentTs : m_currentTs;
+  uint32_t currentUid = partition != 0 ? partition->currentUid : 0;
+  if (id.PeekEventImpl () == 0 ||
+      id.GetTs () < currentTs ||
+      (id.GetTs () == currentTs &&
+       id.GetUid () <= currentUid) ||
+      id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return g_partition != 0 ? g_partition->currentContext : m_currentContext;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetEventCount (void) const
+{
+  // inside Run, only the count of the calling partition is up to date
+  return g_partition != 0 ? g_partition->eventCount : m_eventCount;
+}
+
+} // namespace ns3
@@ -0,0 +1,261 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MULTITHREADED_SIMULATOR_IMPL_H
+#define NS3_MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/object-factory.h"
+#include "ns3/system-mutex.h"
+#include "ns3/ptr.h"
+
+#include <atomic>
+#include <list>
+#include <set>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup mpi
+ * ns3::MultithreadedSimulatorImpl declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ * \ingroup mpi
+ *
+ * \brief Conservative parallel simulator running the partitions of a
+ * simulation in the threads of a single process.
+ *
+ * The nodes are partitioned by their system id, as for the
+ * distributed simulators, but all the partitions are simulated by
+ * this process and no MPI installation is required: partition 0 is
+ * simulated by the thread which calls Simulator::Run and each other
+ * partition by a thread of its own.  Nodes of different partitions
+ * may only be connected by point-to-point links, which need not be
+ * PointToPointRemoteChannel: the smallest delay of these links is the
+ * lookahead of the simulation.
+ *
+ * The partitions advance in time windows.  At the start of a window,
+ * the partitions exchange the events they scheduled for each other
+ * during the previous one and agree on the earliest pending event
+ * time \c t; they then all process their events in [t, t + lookahead)
+ * without synchronizing.  An event scheduled for another partition is
+ * at least one lookahead away, so it always falls in a later window.
+ * The windows are separated by lock-free barriers and the events are
+ * exchanged through per-pair buffers that only one thread writes at a
+ * time, so no lock is taken while the simulation runs.  Packets sent
+ * to another partition are deep copied rather than serialized.
+ *
+ * Within a window each partition processes its events in timestamp
+ * order, and the events received from other partitions are inserted
+ * in a deterministic order, so the simulation results do not depend
+ * on thread scheduling.  Packet uids, which are allocated from a
+ * counter shared by all the threads, are unique but not
+ * reproducible.
+ *
+ * The events of a partition must only touch the nodes of that
+ * partition.  Objects shared by several partitions, such as a trace
+ * file or a callback connected to the devices of all the nodes, or
+ * singletons created while the simulation runs, are not protected.
+ * Stop () stops the calling partition immediately and the others at
+ * the end of the current window.  Stop (delay) called before Run, or
+ * by an event with a delay of at least the lookahead, stops all the
+ * partitions at the same time.  The other partitions only learn of it
+ * at the next window boundary, so with a shorter delay they stop at
+ * the end of the current window, after the time of the stop.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  MultithreadedSimulatorImpl ();
+  /** Destructor. */
+  ~MultithreadedSimulatorImpl ();
+
+  // Inherited
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &delay);
+  virtual EventId Schedule (Time const &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+  virtual uint64_t GetEventCount (void) const;
+
+  /**
+   * \return The number of partitions, that is one more than the
+   * largest node system id seen by the last Run.
+   */
+  uint32_t GetPartitionCount (void) const;
+  /**
+   * \return The lookahead computed by the last Run: the smallest delay
+   * of the point-to-point links between nodes of different partitions.
+   */
+  Time GetLookAhead (void) const;
+
+  /** The state of a partition. */
+  struct Partition;
+
+private:
+  virtual void DoDispose (void);
+
+  /**
+   * A lock-free barrier for the threads of a Run.
+   *
+   * The last thread to arrive releases the others by increasing the
+   * generation; the waiting threads spin on it, yielding the processor
+   * when they have been waiting for a while.
+   */
+  class Barrier
+  {
+  public:
+    /** Constructor. */
+    Barrier ();
+    /**
+     * Prepare the barrier for a Run.
+     * \param [in] n The number of threads which wait on the barrier.
+     */
+    void Reset (uint32_t n);
+    /** Wait until all the threads have reached the barrier. */
+    void Wait (void);
+
+  private:
+    uint32_t m_n;                          /**< The number of threads. */
+    std::atomic<uint32_t> m_count;         /**< The threads waiting in this generation. */
+    std::atomic<uint32_t> m_generation;    /**< The number of times the barrier opened. */
+  };
+
+  /**
+   * Entry point of the threads which simulate the partitions other
+   * than the first one.
+   * \param [in] simulator The simulator.
+   * \param [in] partition The partition to simulate.
+   */
+  static void RunPartitionThread (MultithreadedSimulatorImpl *simulator,
+                                  Partition *partition);
+  /**
+   * Simulate a partition until all the partitions are finished.
+   * \param [in] partition The partition to simulate.
+   */
+  void RunPartition (Partition *partition);
+  /**
+   * Process the next event of a partition.
+   * \param [in] partition The partition.
+   */
+  void ProcessOneEvent (Partition *partition);
+  /**
+   * Insert the events sent to a partition by the other partitions
+   * during the last window.
+   * \param [in] partition The receiving partition.
+   */
+  void ReceiveEvents (Partition *partition);
+
+  /**
+   * Map the nodes to partitions and create the missing partitions.
+   */
+  void CreatePartitions (void);
+  /**
+   * Compute the lookahead from the point-to-point links between
+   * nodes of different partitions.
+   */
+  void CalculateLookAhead (void);
+  /**
+   * Move the events scheduled before Run to their partitions.
+   */
+  void DistributeEvents (void);
+  /**
+   * \param [in] context A context.
+   * \param [in] current The partition to use for contexts which are
+   *        not node ids.
+   * \return The partition which simulates the context.
+   */
+  uint32_t GetPartitionId (uint32_t context, uint32_t current) const;
+  /**
+   * \param [in] id An event id.
+   * \return The partition which holds the event, or 0 if it is still
+   *         held by m_events.
+   */
+  Partition *GetPartition (const EventId &id) const;
+
+  /** Container type for the events to run at Simulator::Destroy(). */
+  typedef std::list<EventId> DestroyEvents;
+
+  /** The events to run at Simulator::Destroy(). */
+  DestroyEvents m_destroyEvents;
+  /** Protects m_destroyEvents, which all the partitions may use. */
+  mutable SystemMutex m_destroyEventsMutex;
+
+  /** The factory of the schedulers of the partitions. */
+  ObjectFactory m_schedulerFactory;
+  /** The events scheduled while no Run is in progress. */
+  Ptr<Scheduler> m_events;
+  /** The partitions, indexed by system id. */
+  std::vector<Partition *> m_partitions;
+  /** The partition of each node, indexed by node id. */
+  std::vector<uint32_t> m_nodePartitions;
+  /** The times of the Stop (delay) calls made while no Run is in progress. */
+  std::multiset<uint64_t> m_stopTimes;
+  /** The synchronization of the partitions between windows. */
+  Barrier m_barrier;
+  /** The lookahead of the last Run. */
+  Time m_lookAhead;
+  /** Whether a Run is in progress. */
+  bool m_running;
+  /** Whether Stop () was called while no Run is in progress. */
+  bool m_stop;
+
+  /** The next event uid to assign outside Run. */
+  uint32_t m_uid;
+  /** The uid of the first event scheduled after the last Run. */
+  uint32_t m_firstSetupUid;
+  /** The simulation time reached by the last Run. */
+  uint64_t m_currentTs;
+  /** The current context outside Run. */
+  uint32_t m_currentContext;
+  /** The number of events executed by all the partitions. */
+  uint64_t m_eventCount;
+  /**
+   * The number of events in m_events; the partitions count their own
+   * events.
+   */
+  int m_unscheduledEvents;
+};
+
+} // namespace ns3
+
+#endif /* NS3_MULTITHREADED_SIMULATOR_IMPL_H */
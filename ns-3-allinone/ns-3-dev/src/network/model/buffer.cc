@@ -50,7 +50,7 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
-uint32_t Buffer::g_recommendedStart = 0;
+thread_local uint32_t Buffer::g_recommendedStart = 0;
 #ifdef BUFFER_FREE_LIST
 /* The following macros are pretty evil but they are needed to allow us to
  * keep track of 3 possible states for the g_freeList variable:
@@ -75,9 +75,9 @@ uint32_t Buffer::g_recommendedStart = 0;
 #define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
 #define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
 #define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
+thread_local uint32_t Buffer::g_maxSize = 0;
+thread_local Buffer::FreeList *Buffer::g_freeList = 0;
+thread_local struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
 
 Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
 {
@@ -99,7 +99,12 @@ Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
+  if (IS_UNINITIALIZED (g_freeList))
+    {
+      /* the data was created by another thread. */
+      g_freeList = new Buffer::FreeList ();
+      (void)&g_localStaticDestructor;
+    }
   g_maxSize = std::max (g_maxSize, data->m_size);
   /* feed into free list */
   if (data->m_size < g_maxSize ||
@@ -123,6 +128,8 @@ Buffer::Create (uint32_t dataSize)
   if (IS_UNINITIALIZED (g_freeList))
     {
       g_freeList = new Buffer::FreeList ();
+      /* make sure the free list of this thread is released when it exits. */
+      (void)&g_localStaticDestructor;
     }
   else if (IS_INITIALIZED (g_freeList))
     {
@@ -396,6 +403,18 @@ Buffer::AddAtEnd (uint32_t end)
   NS_ASSERT (CheckInternalState ());
 }
 
+uint8_t *
+Buffer::AddAtEndForWrite (uint32_t end)
+{
+  NS_LOG_FUNCTION (this << end);
+  AddAtEnd (end);
+  /* the bytes added are the last ones of the internal buffer, after the
+   * zero area if any: no other Buffer uses them since AddAtEnd moved the
+   * dirty end past them.
+   */
+  return m_data->m_data + GetInternalEnd () - end;
+}
+
 void
 Buffer::AddAtEnd (const Buffer &o)
 {
@@ -552,6 +571,26 @@ Buffer::CreateFullCopy (void) const
   return *this;
 }
 
+Buffer
+Buffer::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (CheckInternalState ());
+  uint32_t dataEnd = m_end - (m_zeroAreaEnd - m_zeroAreaStart);
+  Buffer tmp (0, false);
+  tmp.m_data = Buffer::Create (dataEnd);
+  memcpy (tmp.m_data->m_data + m_start, m_data->m_data + m_start, dataEnd - m_start);
+  tmp.m_data->m_dirtyStart = m_start;
+  tmp.m_data->m_dirtyEnd = m_end;
+  tmp.m_maxZeroAreaStart = m_maxZeroAreaStart;
+  tmp.m_zeroAreaStart = m_zeroAreaStart;
+  tmp.m_zeroAreaEnd = m_zeroAreaEnd;
+  tmp.m_start = m_start;
+  tmp.m_end = m_end;
+  NS_ASSERT (tmp.CheckInternalState ());
+  return tmp;
+}
+
 uint32_t 
 Buffer::GetSerializedSize (void) const
 {
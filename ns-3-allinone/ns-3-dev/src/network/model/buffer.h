@@ -520,6 +520,17 @@ private:
    * pointing to this Buffer.
    */
   void AddAtEnd (uint32_t end);
+  /**
+   * \param end size to reserve
+   * \return a pointer to the end bytes added, for writing
+   *
+   * Add bytes at the end of the Buffer and give write access to them,
+   * so that a producer which needs contiguous storage, such as a codec,
+   * can fill them in place instead of through an Iterator.  The content
+   * of these bytes is undefined.  The pointer is invalidated by any
+   * further change of this Buffer, exactly as an Iterator is.
+   */
+  uint8_t *AddAtEndForWrite (uint32_t end);
 
   /**
    * \param o the buffer to append to the end of this buffer.
@@ -555,6 +566,15 @@ private:
    */
   Buffer CreateFragment (uint32_t start, uint32_t length) const;
 
+  /**
+   * \return a copy of this Buffer which shares no internal data with it.
+   *
+   * Unlike the copy constructor, the returned Buffer can be handed over
+   * to, and modified by, another thread while this one is still in use.
+   * The virtual zero area is preserved.
+   */
+  Buffer DeepCopy (void) const;
+
   /**
    * \return an Iterator which points to the
    * start of this Buffer.
@@ -767,7 +787,7 @@ private:
    * writing data. i.e., m_start should be initialized to this 
    * value.
    */
-  static uint32_t g_recommendedStart;
+  static thread_local uint32_t g_recommendedStart;
 
   /**
    * offset to the start of the virtual zero area from the start
@@ -798,9 +818,15 @@ private:
   {
     ~LocalStaticDestructor ();
   };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
+  /*
+   * The free list is per thread so that the partitions of a
+   * multithreaded simulation do not contend on it.  Data freed by
+   * another thread than the one which created it simply goes to the
+   * free list of the former.
+   */
+  static thread_local uint32_t g_maxSize; //!< Max observed data size
+  static thread_local FreeList *g_freeList; //!< Buffer data container
+  static thread_local struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
 #endif
 };
 
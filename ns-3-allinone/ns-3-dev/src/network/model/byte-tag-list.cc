@@ -51,14 +51,16 @@ struct ByteTagListData {
  *
  * \brief Container class for struct ByteTagListData
  *
- * Internal use only.
+ * Internal use only.  There is one per thread so that the partitions
+ * of a multithreaded simulation do not contend on it.
  */
-static class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
+static thread_local class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
 {
 public:
   ~ByteTagListDataFreeList ();
 } g_freeList; //!< Container for struct ByteTagListData
-static uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
+static thread_local uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
+static thread_local bool g_freeListDestroyed = false; //!< g_freeList of this thread has been destroyed
 
 ByteTagListDataFreeList::~ByteTagListDataFreeList ()
 {
@@ -69,6 +71,7 @@ ByteTagListDataFreeList::~ByteTagListDataFreeList ()
       uint8_t *buffer = (uint8_t *)(*i);
       delete [] buffer;
     }
+  g_freeListDestroyed = true;
 }
 #endif /* USE_FREE_LIST */
 
@@ -188,6 +191,24 @@ ByteTagList::~ByteTagList ()
   m_used = 0;
 }
 
+ByteTagList
+ByteTagList::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  ByteTagList copy;
+  copy.m_minStart = m_minStart;
+  copy.m_maxEnd = m_maxEnd;
+  copy.m_adjustment = m_adjustment;
+  if (m_data != 0)
+    {
+      copy.m_data = copy.Allocate (m_used);
+      std::memcpy (copy.m_data->data, m_data->data, m_used);
+      copy.m_data->dirty = m_used;
+      copy.m_used = m_used;
+    }
+  return copy;
+}
+
 TagBuffer
 ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
 {
@@ -345,7 +366,7 @@ struct ByteTagListData *
 ByteTagList::Allocate (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
-  while (!g_freeList.empty ())
+  while (!g_freeListDestroyed && !g_freeList.empty ())
     {
       struct ByteTagListData *data = g_freeList.back ();
       g_freeList.pop_back ();
@@ -379,7 +400,8 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
   data->count--;
   if (data->count == 0)
     {
-      if (g_freeList.size () > FREE_LIST_SIZE ||
+      if (g_freeListDestroyed ||
+          g_freeList.size () > FREE_LIST_SIZE ||
           data->size < g_maxSize)
         {
           uint8_t *buffer = (uint8_t *)data;
@@ -169,6 +169,14 @@ private:
   ByteTagList &operator = (const ByteTagList &o);
   ~ByteTagList ();
 
+  /**
+   * \returns a copy of this ByteTagList which shares no data with it.
+   *
+   * Unlike the copy constructor, the returned list can be handed over
+   * to another thread while this one is still in use.
+   */
+  ByteTagList DeepCopy (void) const;
+
   /**
    * \param tid the typeid of the tag added
    * \param bufferSize the size of the tag when its serialization will 
@@ -34,9 +34,10 @@ NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
 bool PacketMetadata::m_metadataSkipped = false;
-uint32_t PacketMetadata::m_maxSize = 0;
+thread_local uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+thread_local PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+thread_local bool PacketMetadata::m_freeListDestroyed = false;
 
 PacketMetadata::DataFreeList::~DataFreeList ()
 {
@@ -45,7 +46,7 @@ PacketMetadata::DataFreeList::~DataFreeList ()
     {
       PacketMetadata::Deallocate (*i);
     }
-  PacketMetadata::m_enable = false;
+  PacketMetadata::m_freeListDestroyed = true;
 }
 
 void 
@@ -575,7 +576,7 @@ PacketMetadata::Create (uint32_t size)
     {
       m_maxSize = size;
     }
-  while (!m_freeList.empty ()) 
+  while (!m_freeListDestroyed && !m_freeList.empty ()) 
     {
       struct PacketMetadata::Data *data = m_freeList.back ();
       m_freeList.pop_back ();
@@ -596,7 +597,7 @@ void
 PacketMetadata::Recycle (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  if (!m_enable)
+  if (!m_enable || m_freeListDestroyed)
     {
       PacketMetadata::Deallocate (data);
       return;
@@ -650,6 +651,15 @@ PacketMetadata::CreateFragment (uint32_t start, uint32_t end) const
   return fragment;
 }
 
+PacketMetadata
+PacketMetadata::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  PacketMetadata copy = *this;
+  copy.ReserveCopy (0);
+  return copy;
+}
+
 void 
 PacketMetadata::AddHeader (const Header &header, uint32_t size)
 {
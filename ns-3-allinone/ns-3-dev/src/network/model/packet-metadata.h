@@ -218,6 +218,16 @@ private:
    */
   PacketMetadata CreateFragment (uint32_t start, uint32_t end) const;
 
+  /**
+   * \brief Creates a copy which shares no data with this metadata.
+   *
+   * \return the copied metadata
+   *
+   * Unlike the copy constructor, the returned metadata can be handed
+   * over to another thread while this one is still in use.
+   */
+  PacketMetadata DeepCopy (void) const;
+
   /**
    * \brief Add a metadata at the metadata start
    * \param o the metadata to add
@@ -661,7 +671,12 @@ public:
    */
   static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList; //!< the metadata data storage
+  /*
+   * The free list is per thread so that the partitions of a
+   * multithreaded simulation do not contend on it.
+   */
+  static thread_local DataFreeList m_freeList; //!< the metadata data storage
+  static thread_local bool m_freeListDestroyed; //!< m_freeList of this thread has been destroyed
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
 
@@ -672,7 +687,7 @@ public:
    */
   static bool m_metadataSkipped;
 
-  static uint32_t m_maxSize; //!< maximum metadata size
+  static thread_local uint32_t m_maxSize; //!< maximum metadata size
   static uint16_t m_chunkUid; //!< Chunk Uid
 
   struct Data *m_data; //!< Metadata storage
@@ -294,6 +294,25 @@ PacketTagList::Peek (Tag &tag) const
   return false;
 }
 
+PacketTagList
+PacketTagList::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  PacketTagList copy;
+  struct TagData ** prevNext = &copy.m_next;
+  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+    {
+      struct TagData * tag = CreateTagData (cur->size);
+      tag->count = 1;
+      tag->next = 0;
+      tag->tid = cur->tid;
+      std::memcpy (tag->data, cur->data, cur->size);
+      *prevNext = tag;
+      prevNext = &tag->next;
+    }
+  return copy;
+}
+
 const struct PacketTagList::TagData *
 PacketTagList::Head (void) const
 {
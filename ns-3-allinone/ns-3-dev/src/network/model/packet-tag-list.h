@@ -177,6 +177,16 @@ public:
    */
   inline ~PacketTagList ();
 
+  /**
+   * Copy the tags without sharing any TagData with this list.
+   *
+   * \returns the copied object
+   *
+   * Unlike the copy constructor, the returned list can be handed over
+   * to another thread while this one is still in use.
+   */
+  PacketTagList DeepCopy (void) const;
+
   /**
    * Add a tag to the head of this branch.
    *
@@ -28,7 +28,7 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Packet");
 
-uint32_t Packet::m_globalUid = 0;
+std::atomic<uint32_t> Packet::m_globalUid (0);
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
@@ -126,6 +126,22 @@ Packet::Copy (void) const
   return Ptr<Packet> (new Packet (*this), false);
 }
 
+Ptr<Packet>
+Packet::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<Packet> copy = Ptr<Packet> (new Packet (m_buffer.DeepCopy (),
+                                              m_byteTagList.DeepCopy (),
+                                              m_packetTagList.DeepCopy (),
+                                              m_metadata.DeepCopy ()),
+                                  false);
+  if (m_nixVector)
+    {
+      copy->m_nixVector = m_nixVector->Copy ();
+    }
+  return copy;
+}
+
 Packet::Packet ()
   : m_buffer (),
     m_byteTagList (),
@@ -136,10 +152,9 @@ Packet::Packet ()
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid++, 0),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 
 Packet::Packet (const Packet &o)
@@ -178,10 +193,9 @@ Packet::Packet (uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid++, size),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
   : m_buffer (0, false),
@@ -204,15 +218,29 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid++, size),
     m_nixVector (0)
 {
-  m_globalUid++;
   m_buffer.AddAtStart (size);
   Buffer::Iterator i = m_buffer.Begin ();
   i.Write (buffer, size);
 }
 
+Packet::Packet (const Buffer &buffer)
+  : m_buffer (buffer),
+    m_byteTagList (),
+    m_packetTagList (),
+    /* The upper 32 bits of the packet id in 
+     * metadata is for the system id. For non-
+     * distributed simulations, this is simply 
+     * zero.  The lower 32 bits are for the 
+     * global UID
+     */
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid++, buffer.GetSize ()),
+    m_nixVector (0)
+{
+}
+
 Packet::Packet (const Buffer &buffer,  const ByteTagList &byteTagList, 
                 const PacketTagList &packetTagList, const PacketMetadata &metadata)
   : m_buffer (buffer),
@@ -386,6 +414,12 @@ Packet::CopyData (std::ostream *os, uint32_t size) const
   return m_buffer.CopyData (os, size);
 }
 
+Buffer
+Packet::GetBuffer (void) const
+{
+  return m_buffer;
+}
+
 uint64_t 
 Packet::GetUid (void) const
 {
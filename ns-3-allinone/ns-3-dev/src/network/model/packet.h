@@ -21,6 +21,7 @@
 #define PACKET_H
 
 #include <stdint.h>
+#include <atomic>
 #include "buffer.h"
 #include "header.h"
 #include "trailer.h"
@@ -284,6 +285,16 @@ public:
    * \param size the size of the input buffer.
    */
   Packet (uint8_t const*buffer, uint32_t size);
+  /**
+   * \brief Create a packet with payload the content of a Buffer.
+   *
+   * The buffer is not copied: the packet shares its data, copy on
+   * write.  Together with Buffer::AddAtEndForWrite, this lets a
+   * producer build a payload in place.
+   *
+   * \param buffer the payload of the packet.
+   */
+  Packet (const Buffer &buffer);
   /**
    * \brief Create a new packet which contains a fragment of the original
    * packet.
@@ -442,6 +453,14 @@ public:
    */
   void CopyData (std::ostream *os, uint32_t size) const;
 
+  /**
+   * \brief Get the payload of the packet as a Buffer.
+   *
+   * \returns a copy on write copy of the buffer of the packet, which
+   * shares its bytes: use Buffer::PeekData on it to read them in place.
+   */
+  Buffer GetBuffer (void) const;
+
   /**
    * \brief performs a COW copy of the packet.
    *
@@ -453,6 +472,19 @@ public:
    */
   Ptr<Packet> Copy (void) const;
 
+  /**
+   * \brief performs a deep copy of the packet.
+   *
+   * \returns a copy of the packet which shares no dataset with
+   * the original packet.
+   *
+   * This is more expensive than Copy but the returned packet can be
+   * handed over to another thread, for example to a node simulated by
+   * another partition of a multithreaded simulator, while the original
+   * packet is still in use.  The uid and all the tags are preserved.
+   */
+  Ptr<Packet> DeepCopy (void) const;
+
   /**
    * \brief Returns the packet's Uid.
    *
@@ -766,7 +798,7 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
-  static uint32_t m_globalUid; //!< Global counter of packets Uid
+  static std::atomic<uint32_t> m_globalUid; //!< Global counter of packets Uid
 };
 
 /**
@@ -376,6 +376,21 @@ BufferTest::DoRun (void)
   val2 <<= 8;
   val2 |= i.ReadU8 ();
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
+
+  // bytes written in place after a zero area, and not seen by a copy
+  // made before the write
+  buffer = Buffer (2);
+  Buffer copy = buffer;
+  uint8_t *written = buffer.AddAtEndForWrite (2);
+  written[0] = 0x55;
+  written[1] = 0x44;
+  ENSURE_WRITTEN_BYTES (buffer, 4, 0x00, 0x00, 0x55, 0x44);
+  NS_TEST_ASSERT_MSG_EQ (copy.GetSize (), 2, "Copy changed by AddAtEndForWrite");
+  copy.AddAtEnd (1);
+  i = copy.End ();
+  i.Prev ();
+  i.WriteU8 (0x11);
+  ENSURE_WRITTEN_BYTES (buffer, 4, 0x00, 0x00, 0x55, 0x44);
 }
 
 /**
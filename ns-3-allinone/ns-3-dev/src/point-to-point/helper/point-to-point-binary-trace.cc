@@ -0,0 +1,353 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/pcap-file.h"
+#include "ns3/trace-helper.h"
+#include "ns3/point-to-point-net-device.h"
+#include "point-to-point-binary-trace.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PointToPointBinaryTrace");
+
+/// Magic number at the start of a log
+static const char BINARY_TRACE_MAGIC[8] = { 'P', '2', 'P', 'T', 'R', 'A', 'C', 'E' };
+/// Version of the log format
+static const uint32_t BINARY_TRACE_VERSION = 1;
+/// Size of a record, without the frame bytes
+static const uint32_t BINARY_TRACE_RECORD_SIZE = 32;
+/// Size of the buffer written to disk at once
+static const uint32_t BINARY_TRACE_BUFFER_SIZE = 64 * 1024;
+
+PointToPointBinaryTrace::PointToPointBinaryTrace (std::string filename, uint32_t snaplen)
+  : m_snaplen (std::min<uint32_t> (snaplen, 255)),
+    m_pending (false),
+    m_pendingSource (0),
+    m_pendingOriginalSize (0)
+{
+  NS_LOG_FUNCTION (this << filename << snaplen);
+  m_file.open (filename.c_str (), std::ios::out | std::ios::binary);
+  NS_ABORT_MSG_UNLESS (m_file.is_open (), "Cannot open binary trace file " << filename);
+  m_buffer.reserve (BINARY_TRACE_BUFFER_SIZE + BINARY_TRACE_RECORD_SIZE + m_snaplen);
+  m_buffer.insert (m_buffer.end (), BINARY_TRACE_MAGIC, BINARY_TRACE_MAGIC + 8);
+  Put (BINARY_TRACE_VERSION, 4);
+  Put (m_snaplen, 4);
+}
+
+PointToPointBinaryTrace::~PointToPointBinaryTrace ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+  for (std::vector<Source *>::iterator i = m_sources.begin (); i != m_sources.end (); ++i)
+    {
+      delete *i;
+    }
+}
+
+void
+PointToPointBinaryTrace::Attach (Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (this << device);
+  Ptr<PointToPointNetDevice> p2p = device->GetObject<PointToPointNetDevice> ();
+  if (p2p == 0)
+    {
+      return;
+    }
+  Source *source = new Source;
+  source->trace = this;
+  source->node = p2p->GetNode ()->GetId ();
+  source->device = p2p->GetIfIndex ();
+  m_sources.push_back (source);
+
+  const Source *bound = source;
+  p2p->TraceConnectWithoutContext ("PhyTxBegin", MakeBoundCallback (&PhyTxBegin, bound));
+  p2p->TraceConnectWithoutContext ("PhyRxEnd", MakeBoundCallback (&PhyRxEnd, bound));
+  p2p->TraceConnectWithoutContext ("MacTxDrop", MakeBoundCallback (&TxDrop, bound));
+  p2p->TraceConnectWithoutContext ("PhyTxDrop", MakeBoundCallback (&TxDrop, bound));
+  p2p->TraceConnectWithoutContext ("PhyRxDrop", MakeBoundCallback (&RxDrop, bound));
+  p2p->TraceConnectWithoutContext ("CompressTx", MakeBoundCallback (&CompressTx, bound));
+  p2p->TraceConnectWithoutContext ("DecompressRx", MakeBoundCallback (&DecompressRx, bound));
+}
+
+void
+PointToPointBinaryTrace::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_file.is_open ())
+    {
+      return;
+    }
+  FlushPending ();
+  Flush ();
+  m_file.close ();
+}
+
+void
+PointToPointBinaryTrace::Put (uint64_t value, uint32_t bytes)
+{
+  for (uint32_t i = 0; i < bytes; ++i)
+    {
+      m_buffer.push_back (static_cast<uint8_t> (value >> (8 * i)));
+    }
+}
+
+void
+PointToPointBinaryTrace::Append (const Source *source, uint8_t event, Time time,
+                                 Ptr<const Packet> packet, uint32_t originalSize, uint32_t wireSize)
+{
+  if (!m_file.is_open ())
+    {
+      return;
+    }
+  uint32_t captured = std::min (m_snaplen, packet->GetSize ());
+  Put (time.GetNanoSeconds (), 8);
+  Put (packet->GetUid (), 8);
+  Put (source->node, 4);
+  Put (source->device, 2);
+  Put (event, 1);
+  Put (captured, 1);
+  Put (originalSize, 4);
+  Put (wireSize, 4);
+  if (captured > 0)
+    {
+      std::size_t offset = m_buffer.size ();
+      m_buffer.resize (offset + captured);
+      packet->CopyData (&m_buffer[offset], captured);
+    }
+  if (m_buffer.size () >= BINARY_TRACE_BUFFER_SIZE)
+    {
+      Flush ();
+    }
+}
+
+void
+PointToPointBinaryTrace::FlushPending (void)
+{
+  if (!m_pending)
+    {
+      return;
+    }
+  m_pending = false;
+  Append (m_pendingSource, RX, m_pendingTime, m_pendingPacket,
+          m_pendingOriginalSize, m_pendingPacket->GetSize ());
+  m_pendingPacket = 0;
+}
+
+void
+PointToPointBinaryTrace::Flush (void)
+{
+  if (m_buffer.empty ())
+    {
+      return;
+    }
+  m_file.write (reinterpret_cast<const char *> (&m_buffer[0]), m_buffer.size ());
+  NS_ABORT_MSG_IF (m_file.fail (), "Failed to write the binary trace");
+  m_buffer.clear ();
+}
+
+void
+PointToPointBinaryTrace::PhyTxBegin (const Source *source, Ptr<const Packet> packet)
+{
+  PointToPointBinaryTrace *trace = source->trace;
+  trace->FlushPending ();
+  uint32_t originalSize = packet->GetSize ();
+  std::map<uint64_t, uint32_t>::iterator i = trace->m_originalSizes.find (packet->GetUid ());
+  if (i != trace->m_originalSizes.end ())
+    {
+      originalSize = i->second;
+      trace->m_originalSizes.erase (i);
+    }
+  trace->Append (source, TX, Simulator::Now (), packet, originalSize, packet->GetSize ());
+}
+
+void
+PointToPointBinaryTrace::PhyRxEnd (const Source *source, Ptr<const Packet> packet)
+{
+  // The frame may be restored right after, so the record waits for its
+  // original size
+  PointToPointBinaryTrace *trace = source->trace;
+  trace->FlushPending ();
+  trace->m_pending = true;
+  trace->m_pendingSource = source;
+  trace->m_pendingTime = Simulator::Now ();
+  trace->m_pendingPacket = packet;
+  trace->m_pendingOriginalSize = packet->GetSize ();
+}
+
+void
+PointToPointBinaryTrace::TxDrop (const Source *source, Ptr<const Packet> packet)
+{
+  PointToPointBinaryTrace *trace = source->trace;
+  trace->FlushPending ();
+  uint32_t originalSize = packet->GetSize ();
+  std::map<uint64_t, uint32_t>::iterator i = trace->m_originalSizes.find (packet->GetUid ());
+  if (i != trace->m_originalSizes.end ())
+    {
+      originalSize = i->second;
+      trace->m_originalSizes.erase (i);
+    }
+  trace->Append (source, TX_DROP, Simulator::Now (), packet, originalSize, packet->GetSize ());
+}
+
+void
+PointToPointBinaryTrace::RxDrop (const Source *source, Ptr<const Packet> packet)
+{
+  PointToPointBinaryTrace *trace = source->trace;
+  trace->FlushPending ();
+  trace->Append (source, RX_DROP, Simulator::Now (), packet, packet->GetSize (), packet->GetSize ());
+}
+
+void
+PointToPointBinaryTrace::CompressTx (const Source *source, Ptr<const Packet> packet,
+                                     uint32_t inputSize, uint32_t outputSize, Time codecTime)
+{
+  source->trace->m_originalSizes[packet->GetUid ()] = inputSize;
+}
+
+void
+PointToPointBinaryTrace::DecompressRx (const Source *source, Ptr<const Packet> packet,
+                                       uint32_t inputSize, uint32_t outputSize, Time codecTime)
+{
+  PointToPointBinaryTrace *trace = source->trace;
+  if (trace->m_pending && trace->m_pendingSource == source
+      && trace->m_pendingTime == Simulator::Now ())
+    {
+      trace->m_pendingOriginalSize = outputSize;
+      trace->FlushPending ();
+      return;
+    }
+  // Restored later by the decompression engine
+  trace->FlushPending ();
+  trace->Append (source, DECOMPRESS, Simulator::Now (), packet, outputSize, inputSize);
+}
+
+bool
+PointToPointBinaryTrace::ReadHeader (std::istream &is, uint32_t &snaplen)
+{
+  uint8_t header[16];
+  is.read (reinterpret_cast<char *> (header), sizeof (header));
+  if (!is || std::memcmp (header, BINARY_TRACE_MAGIC, 8) != 0)
+    {
+      return false;
+    }
+  uint32_t version = 0;
+  snaplen = 0;
+  for (int i = 0; i < 4; ++i)
+    {
+      version |= static_cast<uint32_t> (header[8 + i]) << (8 * i);
+      snaplen |= static_cast<uint32_t> (header[12 + i]) << (8 * i);
+    }
+  return version == BINARY_TRACE_VERSION;
+}
+
+/**
+ * \brief Read a little-endian integer
+ * \param p the first byte
+ * \param bytes its size in bytes
+ * \return the integer
+ */
+static uint64_t
+GetLittleEndian (const uint8_t *p, uint32_t bytes)
+{
+  uint64_t value = 0;
+  for (uint32_t i = 0; i < bytes; ++i)
+    {
+      value |= static_cast<uint64_t> (p[i]) << (8 * i);
+    }
+  return value;
+}
+
+bool
+PointToPointBinaryTrace::ReadRecord (std::istream &is, Record &record)
+{
+  uint8_t buffer[BINARY_TRACE_RECORD_SIZE];
+  is.read (reinterpret_cast<char *> (buffer), sizeof (buffer));
+  if (is.gcount () != sizeof (buffer))
+    {
+      return false;
+    }
+  record.time = NanoSeconds (static_cast<int64_t> (GetLittleEndian (buffer, 8)));
+  record.uid = GetLittleEndian (buffer + 8, 8);
+  record.node = GetLittleEndian (buffer + 16, 4);
+  record.device = GetLittleEndian (buffer + 20, 2);
+  record.event = buffer[22];
+  uint8_t captured = buffer[23];
+  record.originalSize = GetLittleEndian (buffer + 24, 4);
+  record.wireSize = GetLittleEndian (buffer + 28, 4);
+  record.data.resize (captured);
+  if (captured > 0)
+    {
+      is.read (reinterpret_cast<char *> (&record.data[0]), captured);
+      if (is.gcount () != captured)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+uint64_t
+PointToPointBinaryTrace::ConvertToPcap (std::string filename, std::string prefix)
+{
+  NS_LOG_FUNCTION (filename << prefix);
+  std::ifstream is (filename.c_str (), std::ios::in | std::ios::binary);
+  NS_ABORT_MSG_UNLESS (is.is_open (), "Cannot open binary trace file " << filename);
+  uint32_t snaplen;
+  NS_ABORT_MSG_UNLESS (ReadHeader (is, snaplen), "Not a binary trace file: " << filename);
+
+  std::map<std::pair<uint32_t, uint16_t>, PcapFile *> files;
+  uint64_t frames = 0;
+  Record record;
+  while (ReadRecord (is, record))
+    {
+      if (record.event != TX && record.event != RX)
+        {
+          continue;
+        }
+      std::pair<uint32_t, uint16_t> key (record.node, record.device);
+      PcapFile *&file = files[key];
+      if (file == 0)
+        {
+          std::ostringstream oss;
+          oss << prefix << "-" << record.node << "-" << record.device << ".pcap";
+          file = new PcapFile;
+          file->Open (oss.str (), std::ios::out);
+          NS_ABORT_MSG_IF (file->Fail (), "Cannot open pcap file " << oss.str ());
+          file->Init (PcapHelper::DLT_PPP, snaplen);
+        }
+      // PcapFile captures min (snaplen, wire size) bytes, which is what was logged
+      const uint8_t *data = record.data.empty () ? 0 : &record.data[0];
+      int64_t us = record.time.GetMicroSeconds ();
+      file->Write (us / 1000000, us % 1000000, data, record.wireSize);
+      frames++;
+    }
+  for (std::map<std::pair<uint32_t, uint16_t>, PcapFile *>::iterator i = files.begin ();
+       i != files.end (); ++i)
+    {
+      i->second->Close ();
+      delete i->second;
+    }
+  return frames;
+}
+
+} // namespace ns3
@@ -0,0 +1,229 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef POINT_TO_POINT_BINARY_TRACE_H
+#define POINT_TO_POINT_BINARY_TRACE_H
+
+#include <fstream>
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+#include "ns3/simple-ref-count.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/net-device-container.h"
+
+namespace ns3 {
+
+class NetDevice;
+
+/**
+ * \ingroup point-to-point
+ * \brief Compact binary log of the frames sent and received by
+ * PointToPointNetDevice
+ *
+ * A lighter alternative to pcap for long runs: each event is a fixed
+ * 32-byte record, optionally followed by the first bytes of the frame,
+ * and records are gathered in a memory buffer written to disk in large
+ * blocks.  The file starts with the 8-byte magic "P2PTRACE", a version
+ * and the snap length, and each record holds, little-endian:
+ *
+ * - the time, in nanoseconds (8 bytes)
+ * - the packet uid (8 bytes)
+ * - the node id (4 bytes) and the interface index (2 bytes)
+ * - the event type (1 byte) and the number of frame bytes captured (1 byte)
+ * - the original size of the frame, before compression (4 bytes)
+ * - the size of the frame on the wire (4 bytes)
+ *
+ * ConvertToPcap turns the log into one pcap file per device, for the
+ * usual tools.
+ */
+class PointToPointBinaryTrace : public SimpleRefCount<PointToPointBinaryTrace>
+{
+public:
+  /// Events logged
+  enum EventType
+  {
+    TX = 0,             //!< Frame starts transmission
+    RX = 1,             //!< Frame fully received
+    TX_DROP = 2,        //!< Frame dropped before transmission
+    RX_DROP = 3,        //!< Frame dropped by the receive error model
+    DECOMPRESS = 4      //!< Frame restored after the RX event was logged
+  };
+
+  /// An event read back from a log
+  struct Record
+  {
+    Time time;                  //!< Time of the event
+    uint64_t uid;               //!< Packet uid
+    uint32_t node;              //!< Node id
+    uint16_t device;            //!< Interface index
+    uint8_t event;              //!< EventType
+    uint32_t originalSize;      //!< Frame size before compression
+    uint32_t wireSize;          //!< Frame size on the wire
+    std::vector<uint8_t> data;  //!< First bytes of the frame
+  };
+
+  /**
+   * \brief Create a log
+   * \param filename name of the log file
+   * \param snaplen number of leading frame bytes logged with each event, up
+   * to 255
+   */
+  PointToPointBinaryTrace (std::string filename, uint32_t snaplen);
+  ~PointToPointBinaryTrace ();
+
+  /**
+   * \brief Log the events of a device
+   * \param device the device, devices other than PointToPointNetDevice are
+   * ignored
+   */
+  void Attach (Ptr<NetDevice> device);
+
+  /**
+   * \brief Write the buffered records and close the file
+   */
+  void Close (void);
+
+  /**
+   * \brief Read the header of a log
+   * \param is the log
+   * \param [out] snaplen the snap length of the log
+   * \return whether the header is valid
+   */
+  static bool ReadHeader (std::istream &is, uint32_t &snaplen);
+
+  /**
+   * \brief Read the next record of a log
+   * \param is the log, past its header
+   * \param [out] record the record
+   * \return false at the end of the log
+   */
+  static bool ReadRecord (std::istream &is, Record &record);
+
+  /**
+   * \brief Write the frames sent and received in a log to pcap files
+   *
+   * Frames are written to prefix-<node>-<device>.pcap, with their wire
+   * size as original length, so the pcap files are truncated to the snap
+   * length of the log.
+   *
+   * \param filename name of the log file
+   * \param prefix prefix of the pcap files
+   * \return the number of frames written
+   */
+  static uint64_t ConvertToPcap (std::string filename, std::string prefix);
+
+private:
+  /// Device whose events are being logged, bound to the trace sinks
+  struct Source
+  {
+    PointToPointBinaryTrace *trace;     //!< The log
+    uint32_t node;                      //!< Node id
+    uint16_t device;                    //!< Interface index
+  };
+
+  /**
+   * \brief Append a record to the buffer
+   * \param source the device
+   * \param event the EventType
+   * \param time the time of the event
+   * \param packet the frame
+   * \param originalSize the frame size before compression
+   * \param wireSize the frame size on the wire
+   */
+  void Append (const Source *source, uint8_t event, Time time, Ptr<const Packet> packet,
+               uint32_t originalSize, uint32_t wireSize);
+
+  /**
+   * \brief Append the pending RX record to the buffer
+   */
+  void FlushPending (void);
+
+  /**
+   * \brief Write the buffer to the file
+   */
+  void Flush (void);
+
+  /**
+   * \brief Append a little-endian integer to the buffer
+   * \param value the integer
+   * \param bytes its size in bytes
+   */
+  void Put (uint64_t value, uint32_t bytes);
+
+  /**
+   * \brief PhyTxBegin sink, logs a TX event
+   * \param source the device
+   * \param packet the frame
+   */
+  static void PhyTxBegin (const Source *source, Ptr<const Packet> packet);
+  /**
+   * \brief PhyRxEnd sink, logs an RX event
+   * \param source the device
+   * \param packet the frame
+   */
+  static void PhyRxEnd (const Source *source, Ptr<const Packet> packet);
+  /**
+   * \brief MacTxDrop and PhyTxDrop sink, logs a TX_DROP event
+   * \param source the device
+   * \param packet the frame
+   */
+  static void TxDrop (const Source *source, Ptr<const Packet> packet);
+  /**
+   * \brief PhyRxDrop sink, logs an RX_DROP event
+   * \param source the device
+   * \param packet the frame
+   */
+  static void RxDrop (const Source *source, Ptr<const Packet> packet);
+  /**
+   * \brief CompressTx sink, remembers the original size of the frame
+   * \param source the device
+   * \param packet the compressed frame
+   * \param inputSize bytes given to the codec
+   * \param outputSize bytes out of the codec
+   * \param codecTime codec processing time
+   */
+  static void CompressTx (const Source *source, Ptr<const Packet> packet,
+                          uint32_t inputSize, uint32_t outputSize, Time codecTime);
+  /**
+   * \brief DecompressRx sink, gives the pending RX record its original
+   * size, or logs a DECOMPRESS event
+   * \param source the device
+   * \param packet the restored frame
+   * \param inputSize bytes given to the codec
+   * \param outputSize bytes out of the codec
+   * \param codecTime codec processing time
+   */
+  static void DecompressRx (const Source *source, Ptr<const Packet> packet,
+                            uint32_t inputSize, uint32_t outputSize, Time codecTime);
+
+  std::ofstream m_file;                 //!< The log file
+  uint32_t m_snaplen;                   //!< Frame bytes logged per event
+  std::vector<uint8_t> m_buffer;        //!< Records not yet written
+  std::vector<Source *> m_sources;      //!< Devices attached
+  std::map<uint64_t, uint32_t> m_originalSizes; //!< Original size of compressed frames by uid
+  bool m_pending;                       //!< Whether an RX record awaits its original size
+  const Source *m_pendingSource;        //!< Device of the pending RX record
+  Time m_pendingTime;                   //!< Time of the pending RX record
+  Ptr<const Packet> m_pendingPacket;    //!< Frame of the pending RX record
+  uint32_t m_pendingOriginalSize;       //!< Original size of the pending RX record
+};
+
+} // namespace ns3
+
+#endif /* POINT_TO_POINT_BINARY_TRACE_H */
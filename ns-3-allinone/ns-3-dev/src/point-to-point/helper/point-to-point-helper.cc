@@ -18,6 +18,8 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 
+#include <fstream>
+#include <sstream>
 #include "ns3/abort.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
@@ -33,6 +35,10 @@
 #include "ns3/mpi-receiver.h"
 
 #include "ns3/trace-helper.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/type-id.h"
+#include "point-to-point-binary-trace.h"
 #include "point-to-point-helper.h"
 
 namespace ns3 {
@@ -308,4 +314,104 @@ PointToPointHelper::Install (std::string aName, std::string bName)
   return Install (a, b);
 }
 
+/**
+ * \brief Write the compression counters of devices to a CSV file
+ *
+ * \param filename name of the CSV file
+ * \param devices the devices
+ * \param ids node and interface index of each device, which are gone from
+ * the devices once they are disposed
+ */
+static void
+WriteCompressionSummary (std::string filename, std::vector<Ptr<PointToPointNetDevice> > devices,
+                         std::vector<std::string> ids)
+{
+  std::ofstream os (filename.c_str ());
+  NS_ABORT_MSG_UNLESS (os.is_open (), "Cannot open compression summary file " << filename);
+  os << "node,interface,codec,tx_frames,tx_original_bytes,tx_compressed_bytes,tx_ratio,"
+     << "tx_codec_time_s,bypassed_frames,rx_frames,rx_compressed_bytes,rx_decompressed_bytes,"
+     << "rx_codec_time_s" << std::endl;
+  for (std::size_t i = 0; i < devices.size (); ++i)
+    {
+      Ptr<PointToPointNetDevice> device = devices[i];
+      TypeIdValue codec;
+      UintegerValue txFrames, txOriginal, txCompressed, bypassed, rxFrames, rxCompressed, rxDecompressed;
+      TimeValue txTime, rxTime;
+      device->GetAttribute ("CompressionCodec", codec);
+      device->GetAttribute ("CompressTxFrames", txFrames);
+      device->GetAttribute ("CompressTxOriginalBytes", txOriginal);
+      device->GetAttribute ("CompressTxCompressedBytes", txCompressed);
+      device->GetAttribute ("CompressTxCodecTime", txTime);
+      device->GetAttribute ("CompressionBypassedFrames", bypassed);
+      device->GetAttribute ("DecompressRxFrames", rxFrames);
+      device->GetAttribute ("DecompressRxCompressedBytes", rxCompressed);
+      device->GetAttribute ("DecompressRxDecompressedBytes", rxDecompressed);
+      device->GetAttribute ("DecompressRxCodecTime", rxTime);
+      double ratio = txCompressed.Get () > 0
+        ? static_cast<double> (txOriginal.Get ()) / txCompressed.Get () : 0;
+      os << ids[i] << "," << codec.Get ().GetName () << ","
+         << txFrames.Get () << "," << txOriginal.Get () << "," << txCompressed.Get () << ","
+         << ratio << "," << txTime.Get ().GetSeconds () << "," << bypassed.Get () << ","
+         << rxFrames.Get () << "," << rxCompressed.Get () << "," << rxDecompressed.Get () << ","
+         << rxTime.Get ().GetSeconds () << std::endl;
+    }
+}
+
+void
+PointToPointHelper::EnableCompressionSummary (std::string filename, NetDeviceContainer devices)
+{
+  std::vector<Ptr<PointToPointNetDevice> > p2pDevices;
+  std::vector<std::string> ids;
+  for (NetDeviceContainer::Iterator i = devices.Begin (); i != devices.End (); ++i)
+    {
+      Ptr<PointToPointNetDevice> device = (*i)->GetObject<PointToPointNetDevice> ();
+      if (device == 0)
+        {
+          continue;
+        }
+      std::ostringstream oss;
+      oss << device->GetNode ()->GetId () << "," << device->GetIfIndex ();
+      p2pDevices.push_back (device);
+      ids.push_back (oss.str ());
+    }
+  Simulator::ScheduleDestroy (&WriteCompressionSummary, filename, p2pDevices, ids);
+}
+
+void
+PointToPointHelper::EnableCompressionSummary (std::string filename)
+{
+  NetDeviceContainer devices;
+  NodeContainer nodes = NodeContainer::GetGlobal ();
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      for (uint32_t j = 0; j < (*i)->GetNDevices (); ++j)
+        {
+          devices.Add ((*i)->GetDevice (j));
+        }
+    }
+  EnableCompressionSummary (filename, devices);
+}
+
+/**
+ * \brief Complete a binary trace at the end of the simulation
+ * \param trace the trace
+ */
+static void
+CloseBinaryTrace (Ptr<PointToPointBinaryTrace> trace)
+{
+  trace->Close ();
+}
+
+void
+PointToPointHelper::EnableBinaryTrace (std::string filename, NetDeviceContainer devices,
+                                       uint32_t snaplen)
+{
+  Ptr<PointToPointBinaryTrace> trace = Create<PointToPointBinaryTrace> (filename, snaplen);
+  for (NetDeviceContainer::Iterator i = devices.Begin (); i != devices.End (); ++i)
+    {
+      trace->Attach (*i);
+    }
+  Simulator::ScheduleDestroy (&CloseBinaryTrace, trace);
+}
+
 } // namespace ns3
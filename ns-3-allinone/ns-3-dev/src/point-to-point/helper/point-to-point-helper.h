@@ -150,6 +150,43 @@ public:
    */
   NetDeviceContainer Install (std::string aNode, std::string bNode);
 
+  /**
+   * \brief Write the compression counters of some devices to a CSV file
+   *
+   * The file is written at Simulator::Destroy, with a line per device
+   * giving the node and interface index, the codec, the frames and bytes
+   * compressed and restored, the compression ratio and the codec time.
+   *
+   * \param filename name of the CSV file
+   * \param devices the devices to report, devices other than
+   * PointToPointNetDevice are ignored
+   */
+  static void EnableCompressionSummary (std::string filename, NetDeviceContainer devices);
+
+  /**
+   * \brief Write the compression counters of every PointToPointNetDevice
+   * to a CSV file
+   *
+   * \param filename name of the CSV file
+   */
+  static void EnableCompressionSummary (std::string filename);
+
+  /**
+   * \brief Log the frames of some devices to a compact binary trace
+   *
+   * A cheaper alternative to pcap for long runs, see
+   * PointToPointBinaryTrace.  The records are buffered in memory and the
+   * file is completed at Simulator::Destroy.
+   *
+   * \param filename name of the trace file
+   * \param devices the devices to log, devices other than
+   * PointToPointNetDevice are ignored
+   * \param snaplen number of leading frame bytes logged with each event,
+   * up to 255
+   */
+  static void EnableBinaryTrace (std::string filename, NetDeviceContainer devices,
+                                 uint32_t snaplen = 0);
+
 private:
   /**
    * \brief Enable pcap output the indicated net device.
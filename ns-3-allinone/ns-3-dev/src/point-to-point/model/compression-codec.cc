@@ -0,0 +1,1095 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
+#include "ns3/integer.h"
+#include "ns3/string.h"
+#include "compression-codec.h"
+#include "zlib.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CompressionCodec");
+
+NS_OBJECT_ENSURE_REGISTERED (CompressionCodec);
+
+TypeId
+CompressionCodec::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CompressionCodec")
+    .SetParent<Object> ()
+    .SetGroupName ("PointToPoint")
+    .AddAttribute ("CompressRate",
+                   "Throughput of the compression engine, measured on uncompressed bytes. "
+                   "Zero selects the nominal rate of the codec.",
+                   DataRateValue (DataRate (0)),
+                   MakeDataRateAccessor (&CompressionCodec::m_compressRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("DecompressRate",
+                   "Throughput of the decompression engine, measured on uncompressed bytes. "
+                   "Zero selects the nominal rate of the codec.",
+                   DataRateValue (DataRate (0)),
+                   MakeDataRateAccessor (&CompressionCodec::m_decompressRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("Calibrate",
+                   "Measure the throughput of the codec on this host on first use "
+                   "instead of using the nominal rates",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&CompressionCodec::m_calibrate),
+                   MakeBooleanChecker ())
+  ;
+  return tid;
+}
+
+CompressionCodec::CompressionCodec ()
+  : m_calibrate (false),
+    m_calibrated (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CompressionCodec::~CompressionCodec ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+CompressionCodec::Compress (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+{
+  NS_LOG_FUNCTION (this << srcSize << dstCapacity);
+  uint32_t size = DoCompress (src, srcSize, dst, dstCapacity);
+  NS_LOG_LOGIC ("compressed " << srcSize << " bytes into " << size);
+  return size;
+}
+
+uint32_t
+CompressionCodec::Decompress (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+{
+  NS_LOG_FUNCTION (this << srcSize << dstCapacity);
+  uint32_t size = DoDecompress (src, srcSize, dst, dstCapacity);
+  NS_LOG_LOGIC ("decompressed " << srcSize << " bytes into " << size);
+  return size;
+}
+
+uint32_t
+CompressionCodec::CompressStream (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+{
+  NS_LOG_FUNCTION (this << srcSize << dstCapacity);
+  uint32_t size = DoCompressStream (src, srcSize, dst, dstCapacity);
+  NS_LOG_LOGIC ("stream compressed " << srcSize << " bytes into " << size);
+  return size;
+}
+
+uint32_t
+CompressionCodec::DecompressStream (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+{
+  NS_LOG_FUNCTION (this << srcSize << dstCapacity);
+  uint32_t size = DoDecompressStream (src, srcSize, dst, dstCapacity);
+  NS_LOG_LOGIC ("stream decompressed " << srcSize << " bytes into " << size);
+  return size;
+}
+
+void
+CompressionCodec::ResetCompressStream (void)
+{
+  NS_LOG_FUNCTION (this);
+  DoResetCompressStream ();
+}
+
+void
+CompressionCodec::ResetDecompressStream (void)
+{
+  NS_LOG_FUNCTION (this);
+  DoResetDecompressStream ();
+}
+
+uint32_t
+CompressionCodec::DoCompressStream (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+{
+  return DoCompress (src, srcSize, dst, dstCapacity);
+}
+
+uint32_t
+CompressionCodec::DoDecompressStream (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+{
+  return DoDecompress (src, srcSize, dst, dstCapacity);
+}
+
+void
+CompressionCodec::DoResetCompressStream (void)
+{
+}
+
+void
+CompressionCodec::DoResetDecompressStream (void)
+{
+}
+
+Time
+CompressionCodec::GetCompressTime (uint32_t bytes)
+{
+  if (m_calibrate && !m_calibrated)
+    {
+      Calibrate ();
+    }
+  DataRate rate = m_compressRate.GetBitRate () ? m_compressRate : GetNominalCompressRate ();
+  if (rate.GetBitRate () == 0)
+    {
+      return Seconds (0);
+    }
+  return rate.CalculateBytesTxTime (bytes);
+}
+
+Time
+CompressionCodec::GetDecompressTime (uint32_t bytes)
+{
+  if (m_calibrate && !m_calibrated)
+    {
+      Calibrate ();
+    }
+  DataRate rate = m_decompressRate.GetBitRate () ? m_decompressRate : GetNominalDecompressRate ();
+  if (rate.GetBitRate () == 0)
+    {
+      return Seconds (0);
+    }
+  return rate.CalculateBytesTxTime (bytes);
+}
+
+void
+CompressionCodec::Calibrate (void)
+{
+  NS_LOG_FUNCTION (this);
+  const uint32_t SAMPLE_SIZE = 64 * 1024;
+  const uint32_t ROUNDS = 8;
+
+  // Half repeated text, half pseudo-random bytes, so that neither the
+  // match finder nor the literal coder dominates the measurement
+  std::vector<uint8_t> sample (SAMPLE_SIZE);
+  const char *text = "compression detection over a point to point link; ";
+  uint32_t textLen = std::strlen (text);
+  uint32_t state = 1;
+  for (uint32_t i = 0; i < SAMPLE_SIZE; ++i)
+    {
+      state = state * 1103515245 + 12345;
+      sample[i] = (i / 512) % 2 ? static_cast<uint8_t> (state >> 16) : text[i % textLen];
+    }
+  std::vector<uint8_t> compressed (GetMaxCompressedSize (SAMPLE_SIZE));
+  std::vector<uint8_t> restored (SAMPLE_SIZE);
+
+  uint32_t size = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  for (uint32_t i = 0; i < ROUNDS; ++i)
+    {
+      size = DoCompress (sample.data (), SAMPLE_SIZE, compressed.data (), compressed.size ());
+    }
+  std::chrono::duration<double> compressTime = std::chrono::steady_clock::now () - start;
+  NS_ABORT_MSG_IF (size == 0, "Calibration sample did not compress");
+
+  start = std::chrono::steady_clock::now ();
+  for (uint32_t i = 0; i < ROUNDS; ++i)
+    {
+      DoDecompress (compressed.data (), size, restored.data (), restored.size ());
+    }
+  std::chrono::duration<double> decompressTime = std::chrono::steady_clock::now () - start;
+
+  double bits = 8.0 * SAMPLE_SIZE * ROUNDS;
+  if (compressTime.count () > 0)
+    {
+      m_compressRate = DataRate (static_cast<uint64_t> (bits / compressTime.count ()));
+    }
+  if (decompressTime.count () > 0)
+    {
+      m_decompressRate = DataRate (static_cast<uint64_t> (bits / decompressTime.count ()));
+    }
+  m_calibrated = true;
+  NS_LOG_INFO ("Calibrated " << GetInstanceTypeId ().GetName () << ": compress "
+               << m_compressRate << ", decompress " << m_decompressRate);
+}
+
+//
+// NullCompressionCodec
+//
+
+NS_OBJECT_ENSURE_REGISTERED (NullCompressionCodec);
+
+TypeId
+NullCompressionCodec::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::NullCompressionCodec")
+    .SetParent<CompressionCodec> ()
+    .SetGroupName ("PointToPoint")
+    .AddConstructor<NullCompressionCodec> ()
+  ;
+  return tid;
+}
+
+NullCompressionCodec::NullCompressionCodec ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+NullCompressionCodec::~NullCompressionCodec ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+NullCompressionCodec::GetMaxCompressedSize (uint32_t srcSize) const
+{
+  return srcSize;
+}
+
+DataRate
+NullCompressionCodec::GetNominalCompressRate (void) const
+{
+  return DataRate (0);
+}
+
+DataRate
+NullCompressionCodec::GetNominalDecompressRate (void) const
+{
+  return DataRate (0);
+}
+
+uint32_t
+NullCompressionCodec::DoCompress (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+{
+  if (srcSize > dstCapacity)
+    {
+      return 0;
+    }
+  std::memcpy (dst, src, srcSize);
+  return srcSize;
+}
+
+uint32_t
+NullCompressionCodec::DoDecompress (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+{
+  return DoCompress (src, srcSize, dst, dstCapacity);
+}
+
+//
+// ZlibCompressionCodec
+//
+
+NS_OBJECT_ENSURE_REGISTERED (ZlibCompressionCodec);
+
+TypeId
+ZlibCompressionCodec::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ZlibCompressionCodec")
+    .SetParent<CompressionCodec> ()
+    .SetGroupName ("PointToPoint")
+    .AddConstructor<ZlibCompressionCodec> ()
+    .AddAttribute ("Level",
+                   "The zlib compression level, from 0 (no compression) to 9 (best compression)",
+                   IntegerValue (Z_BEST_COMPRESSION),
+                   MakeIntegerAccessor (&ZlibCompressionCodec::SetLevel,
+                                        &ZlibCompressionCodec::GetLevel),
+                   MakeIntegerChecker<int> (Z_NO_COMPRESSION, Z_BEST_COMPRESSION))
+    .AddAttribute ("Dictionary",
+                   "Preset dictionary loaded into both ends of the stream mode whenever "
+                   "the stream is reset.  Both ends of a link must use the same one.",
+                   StringValue (""),
+                   MakeStringAccessor (&ZlibCompressionCodec::SetDictionary,
+                                       &ZlibCompressionCodec::GetDictionary),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+ZlibCompressionCodec::ZlibCompressionCodec ()
+  : m_level (Z_BEST_COMPRESSION),
+    m_deflateStream (0),
+    m_inflateStream (0),
+    m_arenaUsed (0),
+    m_streamDeflate (0),
+    m_streamInflate (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ZlibCompressionCodec::~ZlibCompressionCodec ()
+{
+  NS_LOG_FUNCTION (this);
+  DisposeStreams ();
+  DisposeStreamContexts ();
+}
+
+void
+ZlibCompressionCodec::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  DisposeStreams ();
+  DisposeStreamContexts ();
+  CompressionCodec::DoDispose ();
+}
+
+void
+ZlibCompressionCodec::SetLevel (int level)
+{
+  NS_LOG_FUNCTION (this << level);
+  if (level != m_level)
+    {
+      // the contexts are rebuilt with the new level on next use
+      DisposeStreams ();
+    }
+  m_level = level;
+}
+
+int
+ZlibCompressionCodec::GetLevel (void) const
+{
+  return m_level;
+}
+
+void
+ZlibCompressionCodec::SetDictionary (std::string dictionary)
+{
+  NS_LOG_FUNCTION (this << dictionary.size ());
+  // the stream contexts load it on their next reset
+  m_dictionary = dictionary;
+}
+
+std::string
+ZlibCompressionCodec::GetDictionary (void) const
+{
+  return m_dictionary;
+}
+
+int
+ZlibCompressionCodec::GetWindowBits (void) const
+{
+  return MAX_WBITS;
+}
+
+uint32_t
+ZlibCompressionCodec::GetMaxCompressedSize (uint32_t srcSize) const
+{
+  // the stream mode may add a zlib header and a sync flush
+  return compressBound (srcSize) + 16;
+}
+
+DataRate
+ZlibCompressionCodec::GetNominalCompressRate (void) const
+{
+  // Single core deflate throughput on mixed traffic, in MB/s, by level
+  static const uint32_t rates[] = { 400, 90, 80, 65, 55, 45, 35, 28, 18, 12 };
+  return DataRate (rates[m_level] * 8000000ULL);
+}
+
+DataRate
+ZlibCompressionCodec::GetNominalDecompressRate (void) const
+{
+  // inflate speed barely depends on the level used to deflate
+  return DataRate ("2400Mbps");
+}
+
+void *
+ZlibCompressionCodec::ZlibAlloc (void *opaque, unsigned int items, unsigned int size)
+{
+  ZlibCompressionCodec *codec = static_cast<ZlibCompressionCodec *> (opaque);
+  // keep every block 16-byte aligned, as malloc would
+  uint32_t bytes = (items * size + 15) & ~15u;
+  if (codec->m_arenaUsed + bytes <= codec->m_arena.size ())
+    {
+      void *block = &codec->m_arena[codec->m_arenaUsed];
+      codec->m_arenaUsed += bytes;
+      return block;
+    }
+  NS_LOG_LOGIC ("zlib arena exhausted, falling back to malloc for " << bytes << " bytes");
+  return std::malloc (bytes);
+}
+
+void
+ZlibCompressionCodec::ZlibFree (void *opaque, void *address)
+{
+  ZlibCompressionCodec *codec = static_cast<ZlibCompressionCodec *> (opaque);
+  uint8_t *block = static_cast<uint8_t *> (address);
+  if (!codec->m_arena.empty () && block >= &codec->m_arena.front ()
+      && block <= &codec->m_arena.back ())
+    {
+      // arena memory is released as a whole in DisposeStreams ()
+      return;
+    }
+  std::free (address);
+}
+
+void
+ZlibCompressionCodec::InitializeStreams (void)
+{
+  if (m_deflateStream != 0)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  m_arena.resize (ARENA_SIZE);
+  m_arenaUsed = 0;
+
+  m_deflateStream = new z_stream;
+  m_deflateStream->zalloc = &ZlibCompressionCodec::ZlibAlloc;
+  m_deflateStream->zfree = &ZlibCompressionCodec::ZlibFree;
+  m_deflateStream->opaque = this;
+  // memLevel 8 is what deflateInit uses
+  int res = deflateInit2 (m_deflateStream, m_level, Z_DEFLATED, GetWindowBits (),
+                          8, Z_DEFAULT_STRATEGY);
+  NS_ABORT_MSG_UNLESS (res == Z_OK, "deflateInit2 failed: " << res);
+
+  m_inflateStream = new z_stream;
+  m_inflateStream->zalloc = &ZlibCompressionCodec::ZlibAlloc;
+  m_inflateStream->zfree = &ZlibCompressionCodec::ZlibFree;
+  m_inflateStream->opaque = this;
+  m_inflateStream->next_in = Z_NULL;
+  m_inflateStream->avail_in = 0;
+  res = inflateInit2 (m_inflateStream, GetWindowBits ());
+  NS_ABORT_MSG_UNLESS (res == Z_OK, "inflateInit2 failed: " << res);
+}
+
+void
+ZlibCompressionCodec::DisposeStreams (void)
+{
+  if (m_deflateStream != 0)
+    {
+      deflateEnd (m_deflateStream);
+      delete m_deflateStream;
+      m_deflateStream = 0;
+    }
+  if (m_inflateStream != 0)
+    {
+      inflateEnd (m_inflateStream);
+      delete m_inflateStream;
+      m_inflateStream = 0;
+    }
+  std::vector<uint8_t> ().swap (m_arena);
+  m_arenaUsed = 0;
+}
+
+uint32_t
+ZlibCompressionCodec::DoCompress (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+{
+  InitializeStreams ();
+
+  z_stream &strm = *m_deflateStream;
+  deflateReset (&strm);
+  strm.next_in = const_cast<Bytef *> (src);
+  strm.avail_in = srcSize;
+  strm.next_out = dst;
+  strm.avail_out = dstCapacity;
+
+  int res = deflate (&strm, Z_FINISH);
+  if (res != Z_STREAM_END)
+    {
+      // Z_OK or Z_BUF_ERROR here both mean the output buffer was too small
+      NS_LOG_LOGIC ("deflate did not fit in " << dstCapacity << " bytes: " << res);
+      return 0;
+    }
+  return strm.total_out;
+}
+
+uint32_t
+ZlibCompressionCodec::DoDecompress (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+{
+  InitializeStreams ();
+
+  z_stream &strm = *m_inflateStream;
+  inflateReset (&strm);
+  strm.next_in = const_cast<Bytef *> (src);
+  strm.avail_in = srcSize;
+  strm.next_out = dst;
+  strm.avail_out = dstCapacity;
+
+  int res = inflate (&strm, Z_FINISH);
+  if (res != Z_STREAM_END)
+    {
+      NS_LOG_LOGIC ("inflate failed: " << res);
+      return 0;
+    }
+  return strm.total_out;
+}
+
+void
+ZlibCompressionCodec::InitializeStreamContexts (void)
+{
+  if (m_streamDeflate != 0)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  m_streamDeflate = new z_stream;
+  m_streamDeflate->zalloc = Z_NULL;
+  m_streamDeflate->zfree = Z_NULL;
+  m_streamDeflate->opaque = Z_NULL;
+  int res = deflateInit2 (m_streamDeflate, m_level, Z_DEFLATED, GetWindowBits (),
+                          8, Z_DEFAULT_STRATEGY);
+  NS_ABORT_MSG_UNLESS (res == Z_OK, "deflateInit2 failed: " << res);
+
+  m_streamInflate = new z_stream;
+  m_streamInflate->zalloc = Z_NULL;
+  m_streamInflate->zfree = Z_NULL;
+  m_streamInflate->opaque = Z_NULL;
+  m_streamInflate->next_in = Z_NULL;
+  m_streamInflate->avail_in = 0;
+  res = inflateInit2 (m_streamInflate, GetWindowBits ());
+  NS_ABORT_MSG_UNLESS (res == Z_OK, "inflateInit2 failed: " << res);
+
+  DoResetCompressStream ();
+  DoResetDecompressStream ();
+}
+
+void
+ZlibCompressionCodec::DisposeStreamContexts (void)
+{
+  if (m_streamDeflate != 0)
+    {
+      deflateEnd (m_streamDeflate);
+      delete m_streamDeflate;
+      m_streamDeflate = 0;
+    }
+  if (m_streamInflate != 0)
+    {
+      inflateEnd (m_streamInflate);
+      delete m_streamInflate;
+      m_streamInflate = 0;
+    }
+}
+
+void
+ZlibCompressionCodec::DoResetCompressStream (void)
+{
+  InitializeStreamContexts ();
+  deflateReset (m_streamDeflate);
+  // picks up a level changed since the contexts were created
+  deflateParams (m_streamDeflate, m_level, Z_DEFAULT_STRATEGY);
+  if (!m_dictionary.empty ())
+    {
+      deflateSetDictionary (m_streamDeflate,
+                            reinterpret_cast<const Bytef *> (m_dictionary.data ()),
+                            m_dictionary.size ());
+    }
+}
+
+void
+ZlibCompressionCodec::DoResetDecompressStream (void)
+{
+  InitializeStreamContexts ();
+  inflateReset (m_streamInflate);
+  if (!m_dictionary.empty () && GetWindowBits () < 0)
+    {
+      // raw deflate has no header asking for the dictionary, load it now
+      inflateSetDictionary (m_streamInflate,
+                            reinterpret_cast<const Bytef *> (m_dictionary.data ()),
+                            m_dictionary.size ());
+    }
+}
+
+/// The empty stored block ending every sync flush
+static const uint8_t SYNC_FLUSH_TRAILER[] = { 0x00, 0x00, 0xff, 0xff };
+
+uint32_t
+ZlibCompressionCodec::DoCompressStream (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+{
+  InitializeStreamContexts ();
+
+  z_stream &strm = *m_streamDeflate;
+  strm.next_in = const_cast<Bytef *> (src);
+  strm.avail_in = srcSize;
+  strm.next_out = dst;
+  strm.avail_out = dstCapacity;
+
+  int res = deflate (&strm, Z_SYNC_FLUSH);
+  if (res != Z_OK || strm.avail_in != 0 || strm.avail_out == 0)
+    {
+      // with no room left the flush may be incomplete
+      NS_LOG_LOGIC ("stream deflate did not fit in " << dstCapacity << " bytes: " << res);
+      return 0;
+    }
+  uint32_t size = dstCapacity - strm.avail_out;
+  if (size >= sizeof (SYNC_FLUSH_TRAILER)
+      && std::memcmp (dst + size - sizeof (SYNC_FLUSH_TRAILER), SYNC_FLUSH_TRAILER,
+                      sizeof (SYNC_FLUSH_TRAILER)) == 0)
+    {
+      size -= sizeof (SYNC_FLUSH_TRAILER);
+    }
+  return size;
+}
+
+uint32_t
+ZlibCompressionCodec::DoDecompressStream (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+{
+  InitializeStreamContexts ();
+
+  z_stream &strm = *m_streamInflate;
+  strm.next_out = dst;
+  strm.avail_out = dstCapacity;
+
+  const uint8_t *parts[] = { src, SYNC_FLUSH_TRAILER };
+  const uint32_t sizes[] = { srcSize, sizeof (SYNC_FLUSH_TRAILER) };
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      strm.next_in = const_cast<Bytef *> (parts[i]);
+      strm.avail_in = sizes[i];
+      while (strm.avail_in != 0)
+        {
+          int res = inflate (&strm, Z_SYNC_FLUSH);
+          if (res == Z_NEED_DICT)
+            {
+              if (m_dictionary.empty ()
+                  || inflateSetDictionary (&strm,
+                                           reinterpret_cast<const Bytef *> (m_dictionary.data ()),
+                                           m_dictionary.size ()) != Z_OK)
+                {
+                  NS_LOG_LOGIC ("stream needs a dictionary this codec does not have");
+                  return 0;
+                }
+              continue;
+            }
+          if (res != Z_OK || strm.avail_out == 0)
+            {
+              NS_LOG_LOGIC ("stream inflate failed: " << res);
+              return 0;
+            }
+        }
+    }
+  return dstCapacity - strm.avail_out;
+}
+
+//
+// DeflateCompressionCodec
+//
+
+NS_OBJECT_ENSURE_REGISTERED (DeflateCompressionCodec);
+
+TypeId
+DeflateCompressionCodec::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DeflateCompressionCodec")
+    .SetParent<ZlibCompressionCodec> ()
+    .SetGroupName ("PointToPoint")
+    .AddConstructor<DeflateCompressionCodec> ()
+  ;
+  return tid;
+}
+
+DeflateCompressionCodec::DeflateCompressionCodec ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+DeflateCompressionCodec::~DeflateCompressionCodec ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+int
+DeflateCompressionCodec::GetWindowBits (void) const
+{
+  // negative windowBits select raw deflate in zlib
+  return -MAX_WBITS;
+}
+
+//
+// Lz4CompressionCodec
+//
+
+namespace {
+
+const uint32_t LZ4_MIN_MATCH = 4;       //!< Shortest match the format can express
+const uint32_t LZ4_LAST_LITERALS = 5;   //!< The last bytes of a block are always literals
+const uint32_t LZ4_MF_LIMIT = 12;       //!< No match may start in the last bytes of a block
+const uint32_t LZ4_MAX_DISTANCE = 65535; //!< Largest offset a match can reference
+
+/**
+ * \param p pointer to four readable bytes
+ * \return the bytes as a little-endian 32 bit word
+ */
+uint32_t
+Lz4Read32 (const uint8_t *p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t> (p[3]) << 24);
+}
+
+/**
+ * \brief Write a length in the LZ4 "15 then runs of 255" extension encoding
+ * \param len the length beyond the 15 held in the token nibble
+ * \param op output cursor, advanced
+ * \param oend end of the output buffer
+ * \return false if the output buffer is too small
+ */
+bool
+Lz4WriteLength (uint32_t len, uint8_t *&op, const uint8_t *oend)
+{
+  while (len >= 255)
+    {
+      if (op >= oend)
+        {
+          return false;
+        }
+      *op++ = 255;
+      len -= 255;
+    }
+  if (op >= oend)
+    {
+      return false;
+    }
+  *op++ = static_cast<uint8_t> (len);
+  return true;
+}
+
+/**
+ * \brief Emit one LZ4 sequence
+ * \param lit start of the literals
+ * \param litLen number of literals
+ * \param offset match distance, unused when matchLen is zero
+ * \param matchLen match length, zero for the final literal-only sequence
+ * \param op output cursor, advanced
+ * \param oend end of the output buffer
+ * \return false if the output buffer is too small
+ */
+bool
+Lz4WriteSequence (const uint8_t *lit, uint32_t litLen, uint32_t offset, uint32_t matchLen,
+                  uint8_t *&op, const uint8_t *oend)
+{
+  if (op >= oend)
+    {
+      return false;
+    }
+  uint8_t *token = op++;
+  *token = static_cast<uint8_t> ((litLen >= 15 ? 15 : litLen) << 4);
+  if (litLen >= 15 && !Lz4WriteLength (litLen - 15, op, oend))
+    {
+      return false;
+    }
+  if (static_cast<uint32_t> (oend - op) < litLen)
+    {
+      return false;
+    }
+  std::memcpy (op, lit, litLen);
+  op += litLen;
+  if (matchLen == 0)
+    {
+      return true;
+    }
+  if (oend - op < 2)
+    {
+      return false;
+    }
+  *op++ = static_cast<uint8_t> (offset);
+  *op++ = static_cast<uint8_t> (offset >> 8);
+  uint32_t ml = matchLen - LZ4_MIN_MATCH;
+  *token |= static_cast<uint8_t> (ml >= 15 ? 15 : ml);
+  return ml < 15 || Lz4WriteLength (ml - 15, op, oend);
+}
+
+} // anonymous namespace
+
+NS_OBJECT_ENSURE_REGISTERED (Lz4CompressionCodec);
+
+TypeId
+Lz4CompressionCodec::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Lz4CompressionCodec")
+    .SetParent<CompressionCodec> ()
+    .SetGroupName ("PointToPoint")
+    .AddConstructor<Lz4CompressionCodec> ()
+  ;
+  return tid;
+}
+
+Lz4CompressionCodec::Lz4CompressionCodec ()
+  : m_hashTable (1 << HASH_LOG)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Lz4CompressionCodec::~Lz4CompressionCodec ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+Lz4CompressionCodec::GetMaxCompressedSize (uint32_t srcSize) const
+{
+  return srcSize + srcSize / 255 + 16;
+}
+
+DataRate
+Lz4CompressionCodec::GetNominalCompressRate (void) const
+{
+  return DataRate ("4000Mbps");
+}
+
+DataRate
+Lz4CompressionCodec::GetNominalDecompressRate (void) const
+{
+  return DataRate ("16000Mbps");
+}
+
+uint32_t
+Lz4CompressionCodec::DoCompress (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+{
+  uint8_t *op = dst;
+  const uint8_t *oend = dst + dstCapacity;
+  uint32_t anchor = 0;
+
+  if (srcSize > LZ4_MF_LIMIT)
+    {
+      std::fill (m_hashTable.begin (), m_hashTable.end (), -1);
+      uint32_t matchLimit = srcSize - LZ4_LAST_LITERALS;
+      uint32_t ip = 0;
+      while (ip + LZ4_MF_LIMIT <= srcSize)
+        {
+          uint32_t sequence = Lz4Read32 (src + ip);
+          uint32_t h = (sequence * 2654435761u) >> (32 - HASH_LOG);
+          int32_t ref = m_hashTable[h];
+          m_hashTable[h] = ip;
+          if (ref < 0 || ip - ref > LZ4_MAX_DISTANCE || Lz4Read32 (src + ref) != sequence)
+            {
+              ++ip;
+              continue;
+            }
+          uint32_t matchLen = LZ4_MIN_MATCH;
+          while (ip + matchLen < matchLimit && src[ref + matchLen] == src[ip + matchLen])
+            {
+              ++matchLen;
+            }
+          if (!Lz4WriteSequence (src + anchor, ip - anchor, ip - ref, matchLen, op, oend))
+            {
+              return 0;
+            }
+          ip += matchLen;
+          anchor = ip;
+        }
+    }
+  if (!Lz4WriteSequence (src + anchor, srcSize - anchor, 0, 0, op, oend))
+    {
+      return 0;
+    }
+  return op - dst;
+}
+
+uint32_t
+Lz4CompressionCodec::DoDecompress (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+{
+  const uint8_t *ip = src;
+  const uint8_t *iend = src + srcSize;
+  uint8_t *op = dst;
+  uint8_t *oend = dst + dstCapacity;
+
+  while (ip < iend)
+    {
+      uint8_t token = *ip++;
+      uint32_t litLen = token >> 4;
+      if (litLen == 15)
+        {
+          uint8_t b;
+          do
+            {
+              if (ip >= iend)
+                {
+                  return 0;
+                }
+              b = *ip++;
+              litLen += b;
+            }
+          while (b == 255);
+        }
+      if (static_cast<uint32_t> (iend - ip) < litLen || static_cast<uint32_t> (oend - op) < litLen)
+        {
+          return 0;
+        }
+      std::memcpy (op, ip, litLen);
+      ip += litLen;
+      op += litLen;
+      if (ip == iend)
+        {
+          // the last sequence carries literals only
+          break;
+        }
+      if (iend - ip < 2)
+        {
+          return 0;
+        }
+      uint32_t offset = ip[0] | (ip[1] << 8);
+      ip += 2;
+      if (offset == 0 || offset > static_cast<uint32_t> (op - dst))
+        {
+          return 0;
+        }
+      uint32_t matchLen = token & 15;
+      if (matchLen == 15)
+        {
+          uint8_t b;
+          do
+            {
+              if (ip >= iend)
+                {
+                  return 0;
+                }
+              b = *ip++;
+              matchLen += b;
+            }
+          while (b == 255);
+        }
+      matchLen += LZ4_MIN_MATCH;
+      if (static_cast<uint32_t> (oend - op) < matchLen)
+        {
+          return 0;
+        }
+      // byte by byte: source and destination overlap for short offsets
+      const uint8_t *match = op - offset;
+      for (uint32_t i = 0; i < matchLen; ++i)
+        {
+          op[i] = match[i];
+        }
+      op += matchLen;
+    }
+  return op - dst;
+}
+
+//
+// RleCompressionCodec
+//
+
+NS_OBJECT_ENSURE_REGISTERED (RleCompressionCodec);
+
+TypeId
+RleCompressionCodec::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RleCompressionCodec")
+    .SetParent<CompressionCodec> ()
+    .SetGroupName ("PointToPoint")
+    .AddConstructor<RleCompressionCodec> ()
+  ;
+  return tid;
+}
+
+RleCompressionCodec::RleCompressionCodec ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RleCompressionCodec::~RleCompressionCodec ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+RleCompressionCodec::GetMaxCompressedSize (uint32_t srcSize) const
+{
+  return srcSize + (srcSize + 127) / 128;
+}
+
+DataRate
+RleCompressionCodec::GetNominalCompressRate (void) const
+{
+  return DataRate ("6000Mbps");
+}
+
+DataRate
+RleCompressionCodec::GetNominalDecompressRate (void) const
+{
+  return DataRate ("8000Mbps");
+}
+
+uint32_t
+RleCompressionCodec::DoCompress (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+{
+  const uint32_t MIN_RUN = 3;
+  const uint32_t MAX_RUN = 130;
+  const uint32_t MAX_LITERALS = 128;
+
+  uint32_t ip = 0;
+  uint32_t op = 0;
+  while (ip < srcSize)
+    {
+      uint32_t run = 1;
+      while (ip + run < srcSize && run < MAX_RUN && src[ip + run] == src[ip])
+        {
+          ++run;
+        }
+      if (run >= MIN_RUN)
+        {
+          if (op + 2 > dstCapacity)
+            {
+              return 0;
+            }
+          dst[op++] = static_cast<uint8_t> (run + 125);
+          dst[op++] = src[ip];
+          ip += run;
+          continue;
+        }
+      // gather literals until the next run worth encoding
+      uint32_t start = ip;
+      while (ip < srcSize && ip - start < MAX_LITERALS)
+        {
+          if (ip + 2 < srcSize && src[ip] == src[ip + 1] && src[ip] == src[ip + 2])
+            {
+              break;
+            }
+          ++ip;
+        }
+      uint32_t count = ip - start;
+      if (op + 1 + count > dstCapacity)
+        {
+          return 0;
+        }
+      dst[op++] = static_cast<uint8_t> (count - 1);
+      std::memcpy (dst + op, src + start, count);
+      op += count;
+    }
+  return op;
+}
+
+uint32_t
+RleCompressionCodec::DoDecompress (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+{
+  uint32_t ip = 0;
+  uint32_t op = 0;
+  while (ip < srcSize)
+    {
+      uint8_t control = src[ip++];
+      if (control < 128)
+        {
+          uint32_t count = control + 1;
+          if (ip + count > srcSize || op + count > dstCapacity)
+            {
+              return 0;
+            }
+          std::memcpy (dst + op, src + ip, count);
+          ip += count;
+          op += count;
+        }
+      else
+        {
+          uint32_t run = control - 125;
+          if (ip >= srcSize || op + run > dstCapacity)
+            {
+              return 0;
+            }
+          std::memset (dst + op, src[ip++], run);
+          op += run;
+        }
+    }
+  return op;
+}
+
+} // namespace ns3
@@ -0,0 +1,478 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef COMPRESSION_CODEC_H
+#define COMPRESSION_CODEC_H
+
+#include <string>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/data-rate.h"
+#include "ns3/nstime.h"
+
+struct z_stream_s;
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief Interface of the payload compressors used by the compression link.
+ *
+ * A codec turns a contiguous buffer into a smaller one and back.  Each
+ * PointToPointNetDevice owns its own codec instance, so implementations
+ * are free to keep per-device state (contexts, dictionaries, scratch
+ * memory) between calls.  Both ends of a link must use the same codec.
+ *
+ * Besides transforming bytes, a codec models how long a compression engine
+ * takes to process them.  The CompressRate and DecompressRate attributes
+ * fix the engine throughput; when left at zero each codec falls back to a
+ * nominal figure for its algorithm and level, or, with Calibrate set, to
+ * the throughput measured by running the codec on this host.
+ */
+class CompressionCodec : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  CompressionCodec ();
+  virtual ~CompressionCodec ();
+
+  /**
+   * \brief Compress a buffer
+   *
+   * \param src the bytes to compress
+   * \param srcSize number of bytes in src
+   * \param dst the output buffer
+   * \param dstCapacity size of the output buffer
+   * \return the number of bytes written to dst, or zero if the compressed
+   * form did not fit in dstCapacity bytes
+   */
+  uint32_t Compress (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity);
+
+  /**
+   * \brief Decompress a buffer produced by Compress
+   *
+   * \param src the compressed bytes
+   * \param srcSize number of bytes in src
+   * \param dst the output buffer
+   * \param dstCapacity size of the output buffer
+   * \return the number of bytes written to dst, or zero if the input is
+   * malformed or the output did not fit in dstCapacity bytes
+   */
+  uint32_t Decompress (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity);
+
+  /**
+   * \brief Compress a buffer as the continuation of a stream
+   *
+   * Unlike Compress, the output may refer back to every buffer compressed
+   * since the last ResetCompressStream, so the peer must feed the results
+   * to DecompressStream in the same order and without gaps.  Codecs without
+   * a stream mode compress each buffer independently.
+   *
+   * \param src the bytes to compress
+   * \param srcSize number of bytes in src
+   * \param dst the output buffer
+   * \param dstCapacity size of the output buffer
+   * \return the number of bytes written to dst, or zero on failure, after
+   * which the stream must be reset
+   */
+  uint32_t CompressStream (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity);
+
+  /**
+   * \brief Decompress a buffer produced by CompressStream
+   *
+   * \param src the compressed bytes
+   * \param srcSize number of bytes in src
+   * \param dst the output buffer
+   * \param dstCapacity size of the output buffer
+   * \return the number of bytes written to dst, or zero on failure, after
+   * which the stream must be reset
+   */
+  uint32_t DecompressStream (const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity);
+
+  /**
+   * \brief Forget the history of the compression stream
+   */
+  void ResetCompressStream (void);
+
+  /**
+   * \brief Forget the history of the decompression stream
+   */
+  void ResetDecompressStream (void);
+
+  /**
+   * \param srcSize size of an uncompressed buffer
+   * \return an upper bound of the size Compress or CompressStream can
+   * produce for it
+   */
+  virtual uint32_t GetMaxCompressedSize (uint32_t srcSize) const = 0;
+
+  /**
+   * \param bytes number of uncompressed bytes
+   * \return the time the compression engine needs to compress them
+   */
+  Time GetCompressTime (uint32_t bytes);
+
+  /**
+   * \param bytes number of uncompressed bytes
+   * \return the time the compression engine needs to restore them
+   */
+  Time GetDecompressTime (uint32_t bytes);
+
+  /**
+   * \brief Measure the wall clock throughput of this codec on this host
+   *
+   * Compresses and decompresses a synthetic mixed-entropy sample several
+   * times and uses the observed rates in place of the nominal ones.  The
+   * result depends on the host, so simulations relying on it are not
+   * reproducible across machines.
+   */
+  void Calibrate (void);
+
+protected:
+  /**
+   * \return the compression throughput assumed when neither CompressRate
+   * nor Calibrate is set; zero means compression takes no time
+   */
+  virtual DataRate GetNominalCompressRate (void) const = 0;
+
+  /**
+   * \return the decompression throughput assumed when neither
+   * DecompressRate nor Calibrate is set; zero means it takes no time
+   */
+  virtual DataRate GetNominalDecompressRate (void) const = 0;
+
+private:
+  /**
+   * \brief Codec specific implementation of Compress
+   * \param src the bytes to compress
+   * \param srcSize number of bytes in src
+   * \param dst the output buffer
+   * \param dstCapacity size of the output buffer
+   * \return the number of bytes written, zero on failure
+   */
+  virtual uint32_t DoCompress (const uint8_t *src, uint32_t srcSize,
+                               uint8_t *dst, uint32_t dstCapacity) = 0;
+
+  /**
+   * \brief Codec specific implementation of Decompress
+   * \param src the compressed bytes
+   * \param srcSize number of bytes in src
+   * \param dst the output buffer
+   * \param dstCapacity size of the output buffer
+   * \return the number of bytes written, zero on failure
+   */
+  virtual uint32_t DoDecompress (const uint8_t *src, uint32_t srcSize,
+                                 uint8_t *dst, uint32_t dstCapacity) = 0;
+
+  /**
+   * \brief Codec specific implementation of CompressStream
+   *
+   * The default compresses the buffer on its own with DoCompress.
+   *
+   * \param src the bytes to compress
+   * \param srcSize number of bytes in src
+   * \param dst the output buffer
+   * \param dstCapacity size of the output buffer
+   * \return the number of bytes written, zero on failure
+   */
+  virtual uint32_t DoCompressStream (const uint8_t *src, uint32_t srcSize,
+                                     uint8_t *dst, uint32_t dstCapacity);
+
+  /**
+   * \brief Codec specific implementation of DecompressStream
+   *
+   * The default decompresses the buffer on its own with DoDecompress.
+   *
+   * \param src the compressed bytes
+   * \param srcSize number of bytes in src
+   * \param dst the output buffer
+   * \param dstCapacity size of the output buffer
+   * \return the number of bytes written, zero on failure
+   */
+  virtual uint32_t DoDecompressStream (const uint8_t *src, uint32_t srcSize,
+                                       uint8_t *dst, uint32_t dstCapacity);
+
+  /**
+   * \brief Codec specific implementation of ResetCompressStream
+   */
+  virtual void DoResetCompressStream (void);
+
+  /**
+   * \brief Codec specific implementation of ResetDecompressStream
+   */
+  virtual void DoResetDecompressStream (void);
+
+  DataRate m_compressRate;   //!< Configured or calibrated compression throughput, zero for nominal
+  DataRate m_decompressRate; //!< Configured or calibrated decompression throughput, zero for nominal
+  bool m_calibrate;          //!< Whether to measure the throughput on first use
+  bool m_calibrated;         //!< Whether Calibrate has run
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Identity codec: the output is a copy of the input.
+ *
+ * Useful as a baseline to separate the cost of the compression machinery
+ * from the cost of the compressor itself.
+ */
+class NullCompressionCodec : public CompressionCodec
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  NullCompressionCodec ();
+  virtual ~NullCompressionCodec ();
+
+  virtual uint32_t GetMaxCompressedSize (uint32_t srcSize) const;
+
+protected:
+  virtual DataRate GetNominalCompressRate (void) const;
+  virtual DataRate GetNominalDecompressRate (void) const;
+
+private:
+  virtual uint32_t DoCompress (const uint8_t *src, uint32_t srcSize,
+                               uint8_t *dst, uint32_t dstCapacity);
+  virtual uint32_t DoDecompress (const uint8_t *src, uint32_t srcSize,
+                                 uint8_t *dst, uint32_t dstCapacity);
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief zlib (RFC 1950) codec.
+ *
+ * The deflate and inflate contexts are created on first use and afterwards
+ * only reset between buffers, so the window and hash tables are allocated
+ * once per codec instead of once per packet.  zlib allocations are served
+ * from an arena owned by the codec.
+ *
+ * In stream mode a second pair of contexts keeps the sliding window across
+ * buffers: each buffer is closed with a sync flush, whose fixed four byte
+ * empty stored block is stripped from the output and restored by the
+ * decompressor (as PPP Deflate does, \RFC{1979}).  Resetting the stream
+ * primes both sides with the preset Dictionary, so that even the first
+ * buffers after a resynchronization find matches.
+ */
+class ZlibCompressionCodec : public CompressionCodec
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  ZlibCompressionCodec ();
+  virtual ~ZlibCompressionCodec ();
+
+  /**
+   * \param level the zlib compression level, 0 (store) to 9 (best)
+   */
+  void SetLevel (int level);
+
+  /**
+   * \return the zlib compression level
+   */
+  int GetLevel (void) const;
+
+  /**
+   * \param dictionary the preset dictionary loaded on every stream reset
+   */
+  void SetDictionary (std::string dictionary);
+
+  /**
+   * \return the preset dictionary loaded on every stream reset
+   */
+  std::string GetDictionary (void) const;
+
+  virtual uint32_t GetMaxCompressedSize (uint32_t srcSize) const;
+
+protected:
+  virtual void DoDispose (void);
+  virtual DataRate GetNominalCompressRate (void) const;
+  virtual DataRate GetNominalDecompressRate (void) const;
+
+  /**
+   * \return the windowBits argument handed to deflateInit2/inflateInit2
+   */
+  virtual int GetWindowBits (void) const;
+
+private:
+  virtual uint32_t DoCompress (const uint8_t *src, uint32_t srcSize,
+                               uint8_t *dst, uint32_t dstCapacity);
+  virtual uint32_t DoDecompress (const uint8_t *src, uint32_t srcSize,
+                                 uint8_t *dst, uint32_t dstCapacity);
+
+  virtual uint32_t DoCompressStream (const uint8_t *src, uint32_t srcSize,
+                                     uint8_t *dst, uint32_t dstCapacity);
+  virtual uint32_t DoDecompressStream (const uint8_t *src, uint32_t srcSize,
+                                       uint8_t *dst, uint32_t dstCapacity);
+  virtual void DoResetCompressStream (void);
+  virtual void DoResetDecompressStream (void);
+
+  /**
+   * \brief Set up the persistent deflate and inflate contexts
+   */
+  void InitializeStreams (void);
+
+  /**
+   * \brief Set up the contexts used in stream mode
+   *
+   * These keep their state for the lifetime of the stream rather than a
+   * single buffer, so they are allocated from the heap instead of the arena.
+   */
+  void InitializeStreamContexts (void);
+
+  /**
+   * \brief Tear down the zlib contexts and release the arena backing them
+   */
+  void DisposeStreams (void);
+
+  /**
+   * \brief Tear down the contexts used in stream mode
+   */
+  void DisposeStreamContexts (void);
+
+  /**
+   * \brief zlib allocation hook serving requests from the codec arena
+   * \param opaque the ZlibCompressionCodec owning the arena
+   * \param items number of items to allocate
+   * \param size size of each item
+   * \return pointer to the allocated memory, or 0 on failure
+   */
+  static void * ZlibAlloc (void *opaque, unsigned int items, unsigned int size);
+
+  /**
+   * \brief zlib deallocation hook matching ZlibAlloc
+   * \param opaque the ZlibCompressionCodec owning the arena
+   * \param address memory previously returned by ZlibAlloc
+   */
+  static void ZlibFree (void *opaque, void *address);
+
+  static const uint32_t ARENA_SIZE = 384 * 1024; //!< Arena size, fits a level 9 deflate and an inflate context
+
+  int m_level; //!< zlib compression level
+  z_stream_s *m_deflateStream; //!< Persistent deflate context, reset per buffer
+  z_stream_s *m_inflateStream; //!< Persistent inflate context, reset per buffer
+  std::vector<uint8_t> m_arena; //!< Backing memory for zlib allocations
+  uint32_t m_arenaUsed; //!< Bytes of m_arena handed out so far
+  z_stream_s *m_streamDeflate; //!< Deflate context of the stream mode
+  z_stream_s *m_streamInflate; //!< Inflate context of the stream mode
+  std::string m_dictionary; //!< Preset dictionary of the stream mode
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Raw deflate (RFC 1951) codec.
+ *
+ * Same compressor as ZlibCompressionCodec without the two byte header and
+ * the Adler-32 trailer of the zlib format.
+ */
+class DeflateCompressionCodec : public ZlibCompressionCodec
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  DeflateCompressionCodec ();
+  virtual ~DeflateCompressionCodec ();
+
+protected:
+  virtual int GetWindowBits (void) const;
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Fast LZ77 codec producing the LZ4 block format.
+ *
+ * Greedy single-probe hash matcher with a 64 KB window: much cheaper than
+ * deflate at the price of a lower compression ratio.
+ */
+class Lz4CompressionCodec : public CompressionCodec
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  Lz4CompressionCodec ();
+  virtual ~Lz4CompressionCodec ();
+
+  virtual uint32_t GetMaxCompressedSize (uint32_t srcSize) const;
+
+protected:
+  virtual DataRate GetNominalCompressRate (void) const;
+  virtual DataRate GetNominalDecompressRate (void) const;
+
+private:
+  virtual uint32_t DoCompress (const uint8_t *src, uint32_t srcSize,
+                               uint8_t *dst, uint32_t dstCapacity);
+  virtual uint32_t DoDecompress (const uint8_t *src, uint32_t srcSize,
+                                 uint8_t *dst, uint32_t dstCapacity);
+
+  static const uint32_t HASH_LOG = 12; //!< log2 of the number of hash table entries
+
+  std::vector<int32_t> m_hashTable; //!< Last position seen for each hashed 4-byte sequence
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Byte-oriented run-length codec (PackBits style).
+ *
+ * A control byte c below 128 is followed by c + 1 literal bytes; a control
+ * byte of 128 or more is followed by one byte repeated c - 125 times.
+ */
+class RleCompressionCodec : public CompressionCodec
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  RleCompressionCodec ();
+  virtual ~RleCompressionCodec ();
+
+  virtual uint32_t GetMaxCompressedSize (uint32_t srcSize) const;
+
+protected:
+  virtual DataRate GetNominalCompressRate (void) const;
+  virtual DataRate GetNominalDecompressRate (void) const;
+
+private:
+  virtual uint32_t DoCompress (const uint8_t *src, uint32_t srcSize,
+                               uint8_t *dst, uint32_t dstCapacity);
+  virtual uint32_t DoDecompress (const uint8_t *src, uint32_t srcSize,
+                                 uint8_t *dst, uint32_t dstCapacity);
+};
+
+} // namespace ns3
+
+#endif /* COMPRESSION_CODEC_H */
@@ -0,0 +1,204 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "compression-filter.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CompressionFilter");
+
+NS_OBJECT_ENSURE_REGISTERED (CompressionFilter);
+
+TypeId
+CompressionFilter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CompressionFilter")
+    .SetParent<Object> ()
+    .SetGroupName ("PointToPoint")
+  ;
+  return tid;
+}
+
+CompressionFilter::CompressionFilter ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CompressionFilter::~CompressionFilter ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+int32_t
+CompressionFilter::Classify (Ptr<const Packet> packet, uint16_t protocol) const
+{
+  NS_LOG_FUNCTION (this << packet << protocol);
+
+  if (!CheckProtocol (protocol))
+    {
+      NS_LOG_LOGIC ("Unable to classify packets of this protocol");
+      return CF_NO_MATCH;
+    }
+
+  return DoClassify (packet);
+}
+
+NS_OBJECT_ENSURE_REGISTERED (Ipv4CompressionFilter);
+
+TypeId
+Ipv4CompressionFilter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Ipv4CompressionFilter")
+    .SetParent<CompressionFilter> ()
+    .SetGroupName ("PointToPoint")
+    .AddConstructor<Ipv4CompressionFilter> ()
+  ;
+  return tid;
+}
+
+Ipv4CompressionFilter::Rule::Rule ()
+  : source (Ipv4Address::GetAny ()),
+    sourceMask (Ipv4Mask::GetZero ()),
+    destination (Ipv4Address::GetAny ()),
+    destinationMask (Ipv4Mask::GetZero ()),
+    protocol (-1),
+    sourcePortMin (0),
+    sourcePortMax (65535),
+    destinationPortMin (0),
+    destinationPortMax (65535),
+    dscp (-1),
+    action (COMPRESS)
+{
+}
+
+Ipv4CompressionFilter::Ipv4CompressionFilter ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ipv4CompressionFilter::~Ipv4CompressionFilter ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+Ipv4CompressionFilter::AddRule (const Rule &rule)
+{
+  NS_LOG_FUNCTION (this);
+  m_rules.push_back (rule);
+}
+
+void
+Ipv4CompressionFilter::AddProtocolRule (uint8_t protocol, Action action)
+{
+  NS_LOG_FUNCTION (this << +protocol << action);
+  Rule rule;
+  rule.protocol = protocol;
+  rule.action = action;
+  AddRule (rule);
+}
+
+void
+Ipv4CompressionFilter::AddPortRule (uint16_t port, bool source, Action action)
+{
+  NS_LOG_FUNCTION (this << port << source << action);
+  Rule rule;
+  if (source)
+    {
+      rule.sourcePortMin = port;
+      rule.sourcePortMax = port;
+    }
+  else
+    {
+      rule.destinationPortMin = port;
+      rule.destinationPortMax = port;
+    }
+  rule.action = action;
+  AddRule (rule);
+}
+
+void
+Ipv4CompressionFilter::AddDscpRule (uint8_t dscp, Action action)
+{
+  NS_LOG_FUNCTION (this << +dscp << action);
+  Rule rule;
+  rule.dscp = dscp;
+  rule.action = action;
+  AddRule (rule);
+}
+
+std::size_t
+Ipv4CompressionFilter::GetNRules (void) const
+{
+  return m_rules.size ();
+}
+
+bool
+Ipv4CompressionFilter::CheckProtocol (uint16_t protocol) const
+{
+  return protocol == 0x0800;
+}
+
+int32_t
+Ipv4CompressionFilter::DoClassify (Ptr<const Packet> packet) const
+{
+  NS_LOG_FUNCTION (this << packet);
+
+  // an IPv4 header with the largest options, followed by the two ports
+  uint8_t buf[64];
+  uint32_t size = packet->CopyData (buf, sizeof (buf));
+  if (size < 20 || (buf[0] >> 4) != 4)
+    {
+      return CF_NO_MATCH;
+    }
+  uint32_t ihl = (buf[0] & 0x0f) * 4;
+  uint8_t dscp = buf[1] >> 2;
+  uint8_t protocol = buf[9];
+  Ipv4Address source = Ipv4Address::Deserialize (buf + 12);
+  Ipv4Address destination = Ipv4Address::Deserialize (buf + 16);
+  bool firstFragment = ((buf[6] & 0x1f) | buf[7]) == 0;
+  bool hasPorts = (protocol == 6 || protocol == 17) && firstFragment && size >= ihl + 4;
+  uint16_t sourcePort = hasPorts ? (buf[ihl] << 8) | buf[ihl + 1] : 0;
+  uint16_t destinationPort = hasPorts ? (buf[ihl + 2] << 8) | buf[ihl + 3] : 0;
+
+  for (std::vector<Rule>::const_iterator r = m_rules.begin (); r != m_rules.end (); ++r)
+    {
+      if (!r->sourceMask.IsMatch (source, r->source)
+          || !r->destinationMask.IsMatch (destination, r->destination)
+          || (r->protocol >= 0 && r->protocol != protocol)
+          || (r->dscp >= 0 && r->dscp != dscp))
+        {
+          continue;
+        }
+      bool anySourcePort = r->sourcePortMin == 0 && r->sourcePortMax == 65535;
+      bool anyDestinationPort = r->destinationPortMin == 0 && r->destinationPortMax == 65535;
+      if (!anySourcePort || !anyDestinationPort)
+        {
+          if (!hasPorts
+              || sourcePort < r->sourcePortMin || sourcePort > r->sourcePortMax
+              || destinationPort < r->destinationPortMin || destinationPort > r->destinationPortMax)
+            {
+              continue;
+            }
+        }
+      NS_LOG_LOGIC ("Rule " << r - m_rules.begin () << " matched, action " << r->action);
+      return r->action;
+    }
+  return CF_NO_MATCH;
+}
+
+} // namespace ns3
@@ -0,0 +1,179 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef COMPRESSION_FILTER_H
+#define COMPRESSION_FILTER_H
+
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief Abstract base class of the filters choosing, frame by frame,
+ * whether a PointToPointNetDevice compresses
+ *
+ * Filters are the counterpart for the compression link of the
+ * PacketFilter of traffic control: the device asks its filters in turn,
+ * and the first one able to classify the frame decides.  Frames no filter
+ * classifies are compressed.
+ */
+class CompressionFilter : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  CompressionFilter ();
+  virtual ~CompressionFilter ();
+
+  /// Value returned by filters that cannot classify a frame
+  static const int32_t CF_NO_MATCH = -1;
+
+  /// What the device does with a frame
+  enum Action
+  {
+    COMPRESS = 0,       //!< Compress the frame as configured on the device
+    BYPASS = 1          //!< Send the frame as is, without queueing it for the codec
+  };
+
+  /**
+   * \brief Classify a frame
+   *
+   * \param packet the frame, starting with its network header
+   * \param protocol the EtherType of the network header
+   * \return CF_NO_MATCH if this filter cannot classify packets of this
+   * protocol or the packet matches none of its conditions, the Action to
+   * take otherwise
+   */
+  int32_t Classify (Ptr<const Packet> packet, uint16_t protocol) const;
+
+private:
+  /**
+   * \brief Check whether the filter can classify packets of a protocol
+   *
+   * \param protocol the EtherType
+   * \return true if this filter can classify packets of this protocol
+   */
+  virtual bool CheckProtocol (uint16_t protocol) const = 0;
+
+  /**
+   * \brief Classify a frame of a protocol accepted by CheckProtocol
+   *
+   * \param packet the frame, starting with its network header
+   * \return CF_NO_MATCH if the packet matches none of the conditions, the
+   * Action to take otherwise
+   */
+  virtual int32_t DoClassify (Ptr<const Packet> packet) const = 0;
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Compression filter matching IPv4 datagrams on their 5-tuple,
+ * DSCP and protocol
+ *
+ * Rules are tried in the order they were added and the first rule
+ * matching the datagram gives the Action.  Ports are only known for the
+ * first fragment of TCP and UDP datagrams; a rule with a port condition
+ * does not match other datagrams.
+ */
+class Ipv4CompressionFilter : public CompressionFilter
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  Ipv4CompressionFilter ();
+  virtual ~Ipv4CompressionFilter ();
+
+  /**
+   * \brief Conditions on a datagram and the action to take when they all hold
+   *
+   * A default-constructed rule matches every datagram and compresses it.
+   */
+  struct Rule
+  {
+    Rule ();
+
+    Ipv4Address source;             //!< Source address, compared under sourceMask
+    Ipv4Mask sourceMask;            //!< Mask of the source address, zero for any
+    Ipv4Address destination;        //!< Destination address, compared under destinationMask
+    Ipv4Mask destinationMask;       //!< Mask of the destination address, zero for any
+    int16_t protocol;               //!< IP protocol number, -1 for any
+    uint16_t sourcePortMin;         //!< Lowest source port
+    uint16_t sourcePortMax;         //!< Highest source port
+    uint16_t destinationPortMin;    //!< Lowest destination port
+    uint16_t destinationPortMax;    //!< Highest destination port
+    int16_t dscp;                   //!< DSCP, -1 for any
+    Action action;                  //!< Action taken on matching datagrams
+  };
+
+  /**
+   * \brief Add a rule behind those already added
+   * \param rule the rule
+   */
+  void AddRule (const Rule &rule);
+
+  /**
+   * \brief Add a rule matching an IP protocol
+   * \param protocol the IP protocol number
+   * \param action the action taken on matching datagrams
+   */
+  void AddProtocolRule (uint8_t protocol, Action action);
+
+  /**
+   * \brief Add a rule matching TCP or UDP datagrams to or from a port
+   *
+   * Both directions of the flows of a server are matched by adding one rule
+   * on each device of the link.
+   *
+   * \param port the destination port, or the source port with \p source
+   * \param source whether \p port is the source port
+   * \param action the action taken on matching datagrams
+   */
+  void AddPortRule (uint16_t port, bool source, Action action);
+
+  /**
+   * \brief Add a rule matching a DSCP
+   * \param dscp the DSCP, the upper six bits of the TOS byte
+   * \param action the action taken on matching datagrams
+   */
+  void AddDscpRule (uint8_t dscp, Action action);
+
+  /**
+   * \return the number of rules
+   */
+  std::size_t GetNRules (void) const;
+
+private:
+  virtual bool CheckProtocol (uint16_t protocol) const;
+  virtual int32_t DoClassify (Ptr<const Packet> packet) const;
+
+  std::vector<Rule> m_rules;        //!< Rules, in the order they are tried
+};
+
+} // namespace ns3
+
+#endif /* COMPRESSION_FILTER_H */
@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "compression-worker-pool.h"
+#include "compression-codec.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CompressionWorkerPool");
+
+/**
+ * \ingroup point-to-point
+ * The number of threads compressing frames offloaded by the devices.
+ */
+static GlobalValue g_compressionWorkerThreads =
+  GlobalValue ("CompressionWorkerThreads",
+               "Number of threads compressing the frames of devices with CompressionOffload set; "
+               "with 0 the simulator thread compresses them",
+               UintegerValue (0),
+               MakeUintegerChecker<uint32_t> ());
+
+CompressionWorkerPool::CompressionWorkerPool ()
+  : m_stop (false)
+{
+  NS_LOG_FUNCTION (this);
+  UintegerValue threads;
+  g_compressionWorkerThreads.GetValue (threads);
+  NS_LOG_INFO ("Starting " << threads.Get () << " compression workers");
+  for (uint32_t i = 0; i < threads.Get (); ++i)
+    {
+      Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&CompressionWorkerPool::Work, this));
+      m_threads.push_back (thread);
+      thread->Start ();
+    }
+}
+
+CompressionWorkerPool::~CompressionWorkerPool ()
+{
+  NS_LOG_FUNCTION (this);
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_stop = true;
+    m_workAvailable.notify_all ();
+  }
+  for (std::vector<Ptr<SystemThread> >::iterator i = m_threads.begin (); i != m_threads.end (); ++i)
+    {
+      (*i)->Join ();
+    }
+  // jobs of devices not disposed yet
+  for (std::list<Job *>::iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+    {
+      (*i)->result = (*i)->codec->Compress ((*i)->src, (*i)->srcSize, (*i)->dst, (*i)->dstCapacity);
+      (*i)->done = true;
+    }
+}
+
+uint32_t
+CompressionWorkerPool::GetNThreads (void) const
+{
+  return m_threads.size ();
+}
+
+void
+CompressionWorkerPool::Submit (Job *job)
+{
+  NS_LOG_FUNCTION (this << job);
+  job->done = false;
+  if (m_threads.empty ())
+    {
+      return;
+    }
+  std::lock_guard<std::mutex> lock (m_mutex);
+  m_queue.push_back (job);
+  m_workAvailable.notify_one ();
+}
+
+void
+CompressionWorkerPool::Wait (Job *job)
+{
+  NS_LOG_FUNCTION (this << job);
+  if (m_threads.empty ())
+    {
+      if (!job->done)
+        {
+          job->result = job->codec->Compress (job->src, job->srcSize, job->dst, job->dstCapacity);
+          job->done = true;
+        }
+      return;
+    }
+
+  std::unique_lock<std::mutex> lock (m_mutex);
+  std::list<Job *>::iterator i = std::find (m_queue.begin (), m_queue.end (), job);
+  if (i != m_queue.end () && m_busy.find (job->codec) == m_busy.end ())
+    {
+      // nobody started it, rather than sleeping do it here
+      m_queue.erase (i);
+      m_busy.insert (job->codec);
+      lock.unlock ();
+      Run (job);
+      return;
+    }
+  // done is only written with m_mutex held, so no completion can slip
+  // between this test and the wait
+  while (!job->done)
+    {
+      m_jobDone.wait (lock);
+    }
+}
+
+CompressionWorkerPool::Job *
+CompressionWorkerPool::TakeJob (void)
+{
+  for (std::list<Job *>::iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+    {
+      if (m_busy.find ((*i)->codec) == m_busy.end ())
+        {
+          Job *job = *i;
+          m_queue.erase (i);
+          m_busy.insert (job->codec);
+          return job;
+        }
+    }
+  return 0;
+}
+
+void
+CompressionWorkerPool::Run (Job *job)
+{
+  uint32_t result = job->codec->Compress (job->src, job->srcSize, job->dst, job->dstCapacity);
+  std::lock_guard<std::mutex> lock (m_mutex);
+  job->result = result;
+  job->done = true;
+  m_busy.erase (job->codec);
+  m_jobDone.notify_all ();
+  if (!m_queue.empty ())
+    {
+      // the codec just released may be the one the next job waits for
+      m_workAvailable.notify_all ();
+    }
+}
+
+void
+CompressionWorkerPool::Work (void)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (!m_stop)
+    {
+      Job *job = TakeJob ();
+      if (job == 0)
+        {
+          // nothing runnable: the queue is empty or its codecs are busy
+          m_workAvailable.wait (lock);
+          continue;
+        }
+      lock.unlock ();
+      Run (job);
+      lock.lock ();
+    }
+}
+
+} // namespace ns3
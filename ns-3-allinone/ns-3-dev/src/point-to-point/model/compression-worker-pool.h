@@ -0,0 +1,122 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef COMPRESSION_WORKER_POOL_H
+#define COMPRESSION_WORKER_POOL_H
+
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <set>
+#include <vector>
+#include "ns3/ptr.h"
+#include "ns3/system-thread.h"
+
+namespace ns3 {
+
+class CompressionCodec;
+
+/**
+ * \ingroup point-to-point
+ * \brief Threads that compress frames off the simulator thread
+ *
+ * The pool is shared by every device of the simulation; use
+ * SimulationSingleton<CompressionWorkerPool>::Get () to reach it.  The
+ * number of threads is read from the CompressionWorkerThreads global value
+ * when the pool is first used.  With no threads, every job runs on the
+ * simulator thread when it is waited for.
+ *
+ * Jobs only handle raw buffers prepared by the simulator thread, so no
+ * reference count or other simulation state is touched concurrently.  Jobs
+ * submitted with the same codec run one at a time and in order, since the
+ * codecs keep scratch state between calls; for the same reason, the
+ * simulator thread must not use a codec it submits jobs with.  Devices
+ * therefore offload to a codec of their own.  Log output of the codecs may
+ * interleave when they run on several threads.
+ */
+class CompressionWorkerPool
+{
+public:
+  /**
+   * \brief One buffer to compress with CompressionCodec::Compress
+   */
+  struct Job
+  {
+    CompressionCodec *codec; //!< Codec to run, also the ordering key
+    const uint8_t *src;      //!< Data to compress
+    uint32_t srcSize;        //!< Size of the data
+    uint8_t *dst;            //!< Output buffer
+    uint32_t dstCapacity;    //!< Size of the output buffer
+    uint32_t result;         //!< Compressed size, 0 on failure; valid once done
+    bool done;               //!< Whether the job has run
+  };
+
+  CompressionWorkerPool ();
+  ~CompressionWorkerPool ();
+
+  /**
+   * \brief Queue a job for the worker threads
+   *
+   * The job and its buffers must stay valid until Wait returns for it.
+   *
+   * \param job the job
+   */
+  void Submit (Job *job);
+
+  /**
+   * \brief Wait for a job to complete
+   *
+   * A job no worker has started yet is run on the calling thread.
+   *
+   * \param job a job previously submitted
+   */
+  void Wait (Job *job);
+
+  /**
+   * \return the number of worker threads
+   */
+  uint32_t GetNThreads (void) const;
+
+private:
+  /**
+   * \brief Main loop of a worker thread
+   */
+  void Work (void);
+
+  /**
+   * \brief Take the first queued job whose codec is idle, with m_mutex held
+   * \return the job, or 0 if none can run now
+   */
+  Job * TakeJob (void);
+
+  /**
+   * \brief Run a job taken off the queue and publish its result
+   * \param job the job
+   */
+  void Run (Job *job);
+
+  std::vector<Ptr<SystemThread> > m_threads; //!< Worker threads
+  std::mutex m_mutex;                //!< Protects the members below and Job::done
+  std::condition_variable m_workAvailable; //!< Notified when a queued job may be runnable
+  std::condition_variable m_jobDone; //!< Notified when a job completes
+  std::list<Job *> m_queue;          //!< Jobs not started yet, in submission order
+  std::set<CompressionCodec *> m_busy; //!< Codecs a job is running on
+  bool m_stop;                       //!< Whether the workers must exit
+};
+
+} // namespace ns3
+
+#endif /* COMPRESSION_WORKER_POOL_H */
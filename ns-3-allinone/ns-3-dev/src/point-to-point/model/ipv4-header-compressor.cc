@@ -0,0 +1,348 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ipv4-header-compressor.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4HeaderCompressor");
+
+NS_OBJECT_ENSURE_REGISTERED (Ipv4HeaderCompressor);
+
+const uint16_t Ipv4HeaderCompressor::FULL_HEADER;
+const uint16_t Ipv4HeaderCompressor::COMPRESSED_UDP;
+const uint16_t Ipv4HeaderCompressor::CONTEXT_STATE;
+const uint32_t Ipv4HeaderCompressor::HEADER_SIZE;
+
+namespace {
+
+/// Flag of a compressed header: the UDP checksum follows
+const uint8_t FLAG_UDP_CHECKSUM = 0x01;
+/// Flag of a compressed header: the whole IP identification follows
+const uint8_t FLAG_FULL_ID = 0x02;
+/// Mask of the generation in the flags byte of a compressed header
+const uint8_t GENERATION_MASK = 0x3f;
+
+/**
+ * \param p pointer to two bytes in network order
+ * \return their value
+ */
+uint16_t
+ReadU16 (const uint8_t *p)
+{
+  return (p[0] << 8) | p[1];
+}
+
+/**
+ * \param p pointer to two bytes to write in network order
+ * \param v the value to write
+ */
+void
+WriteU16 (uint8_t *p, uint16_t v)
+{
+  p[0] = v >> 8;
+  p[1] = v & 0xff;
+}
+
+/**
+ * \param a an IPv4 and UDP header
+ * \param b another IPv4 and UDP header of the same flow
+ * \return whether the fields assumed constant within a flow are equal
+ */
+bool
+SameStaticFields (const uint8_t *a, const uint8_t *b)
+{
+  // version, IHL and TOS; flags and fragment offset; TTL and protocol;
+  // addresses and ports
+  return std::memcmp (a, b, 2) == 0 && std::memcmp (a + 6, b + 6, 4) == 0
+         && std::memcmp (a + 12, b + 12, 12) == 0;
+}
+
+} // anonymous namespace
+
+TypeId
+Ipv4HeaderCompressor::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Ipv4HeaderCompressor")
+    .SetParent<Object> ()
+    .SetGroupName ("PointToPoint")
+    .AddConstructor<Ipv4HeaderCompressor> ()
+    .AddAttribute ("MaxContexts",
+                   "Number of flows compressed at once; the least recently used "
+                   "context is taken over by a new flow",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&Ipv4HeaderCompressor::m_maxContexts),
+                   MakeUintegerChecker<uint32_t> (1, 256))
+    .AddAttribute ("RefreshInterval",
+                   "Number of compressed headers sent between two full headers of a flow",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&Ipv4HeaderCompressor::m_refreshInterval),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+Ipv4HeaderCompressor::Ipv4HeaderCompressor ()
+  : m_maxContexts (16),
+    m_refreshInterval (256),
+    m_decompressor (256),
+    m_useCounter (0)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::size_t i = 0; i < m_decompressor.size (); ++i)
+    {
+      m_decompressor[i].valid = false;
+      m_decompressor[i].reported = false;
+      m_decompressor[i].generation = 0;
+    }
+}
+
+Ipv4HeaderCompressor::~Ipv4HeaderCompressor ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ipv4HeaderCompressor::CompressorContext &
+Ipv4HeaderCompressor::GetContext (const FlowKey &key)
+{
+  std::map<FlowKey, CompressorContext>::iterator it = m_compressor.find (key);
+  if (it != m_compressor.end ())
+    {
+      return it->second;
+    }
+
+  CompressorContext context;
+  context.generation = 0;
+  if (m_compressor.size () < m_maxContexts)
+    {
+      context.cid = m_compressor.size ();
+    }
+  else
+    {
+      std::map<FlowKey, CompressorContext>::iterator oldest = m_compressor.begin ();
+      for (it = m_compressor.begin (); it != m_compressor.end (); ++it)
+        {
+          if (it->second.lastUse < oldest->second.lastUse)
+            {
+              oldest = it;
+            }
+        }
+      NS_LOG_LOGIC ("Reusing context " << static_cast<uint32_t> (oldest->second.cid));
+      context.cid = oldest->second.cid;
+      context.generation = (oldest->second.generation + 1) & GENERATION_MASK;
+      m_compressor.erase (oldest);
+    }
+  context.sinceRefresh = 0;
+  context.refresh = true;
+  return m_compressor.insert (std::make_pair (key, context)).first->second;
+}
+
+Ptr<Packet>
+Ipv4HeaderCompressor::Compress (Ptr<const Packet> packet, uint16_t &protocol)
+{
+  NS_LOG_FUNCTION (this << packet);
+  uint8_t header[HEADER_SIZE];
+  if (packet->CopyData (header, HEADER_SIZE) < HEADER_SIZE
+      || header[0] != 0x45                                  // IPv4 without options
+      || header[9] != 17                                    // UDP
+      || (ReadU16 (header + 6) & 0x3fff) != 0               // not a fragment
+      || ReadU16 (header + 2) != packet->GetSize ()
+      || ReadU16 (header + 24) != packet->GetSize () - 20)
+    {
+      return 0;
+    }
+
+  FlowKey key (static_cast<uint64_t> (ReadU16 (header + 12)) << 48
+               | static_cast<uint64_t> (ReadU16 (header + 14)) << 32
+               | static_cast<uint64_t> (ReadU16 (header + 16)) << 16
+               | static_cast<uint64_t> (ReadU16 (header + 18)),
+               static_cast<uint32_t> (ReadU16 (header + 20)) << 16
+               | static_cast<uint32_t> (ReadU16 (header + 22)));
+  CompressorContext &context = GetContext (key);
+  context.lastUse = ++m_useCounter;
+
+  if (context.refresh || context.sinceRefresh >= m_refreshInterval
+      || !SameStaticFields (header, context.header))
+    {
+      NS_LOG_LOGIC ("Full header for context " << static_cast<uint32_t> (context.cid));
+      std::memcpy (context.header, header, HEADER_SIZE);
+      context.refresh = false;
+      context.sinceRefresh = 0;
+      uint8_t prefix[2] = { context.cid, context.generation };
+      Ptr<Packet> frame = Create<Packet> (prefix, sizeof (prefix));
+      frame->AddAtEnd (packet);
+      protocol = FULL_HEADER;
+      return frame;
+    }
+
+  uint8_t compressed[6];
+  uint32_t size = 2;
+  uint16_t id = ReadU16 (header + 4);
+  uint16_t udpChecksum = ReadU16 (header + 26);
+  compressed[0] = context.cid;
+  compressed[1] = context.generation << 2;
+  // the decompressor rebuilds the identification from its low byte as long
+  // as it has not missed more than half of the byte range
+  if (static_cast<uint16_t> (id - ReadU16 (context.header + 4)) < 128)
+    {
+      compressed[size++] = id & 0xff;
+    }
+  else
+    {
+      compressed[1] |= FLAG_FULL_ID;
+      WriteU16 (compressed + size, id);
+      size += 2;
+    }
+  if (udpChecksum != 0)
+    {
+      compressed[1] |= FLAG_UDP_CHECKSUM;
+      WriteU16 (compressed + size, udpChecksum);
+      size += 2;
+    }
+  std::memcpy (context.header, header, HEADER_SIZE);
+  context.sinceRefresh++;
+
+  Ptr<Packet> frame = Create<Packet> (compressed, size);
+  frame->AddAtEnd (packet->CreateFragment (HEADER_SIZE, packet->GetSize () - HEADER_SIZE));
+  protocol = COMPRESSED_UDP;
+  return frame;
+}
+
+Ptr<Packet>
+Ipv4HeaderCompressor::Decompress (Ptr<const Packet> packet, uint16_t protocol, int32_t &lostCid)
+{
+  NS_LOG_FUNCTION (this << packet << protocol);
+  lostCid = -1;
+  uint8_t prefix[6];
+  uint32_t available = packet->CopyData (prefix, sizeof (prefix));
+  if (available < 2)
+    {
+      return 0;
+    }
+  DecompressorContext &context = m_decompressor[prefix[0]];
+
+  if (protocol == FULL_HEADER)
+    {
+      Ptr<Packet> datagram = packet->CreateFragment (2, packet->GetSize () - 2);
+      if (datagram->CopyData (context.header, HEADER_SIZE) < HEADER_SIZE)
+        {
+          context.valid = false;
+          return 0;
+        }
+      context.valid = true;
+      context.reported = false;
+      context.generation = prefix[1];
+      return datagram;
+    }
+
+  uint8_t flags = prefix[1];
+  uint32_t size = 2 + ((flags & FLAG_FULL_ID) ? 2 : 1) + ((flags & FLAG_UDP_CHECKSUM) ? 2 : 0);
+  if (!context.valid || context.generation != (flags >> 2))
+    {
+      NS_LOG_LOGIC ("No context for CID " << static_cast<uint32_t> (prefix[0]));
+      if (!context.reported)
+        {
+          context.reported = true;
+          lostCid = prefix[0];
+        }
+      return 0;
+    }
+  if (available < size)
+    {
+      return 0;
+    }
+
+  uint8_t *header = context.header;
+  const uint8_t *field = prefix + 2;
+  uint16_t id;
+  if (flags & FLAG_FULL_ID)
+    {
+      id = ReadU16 (field);
+      field += 2;
+    }
+  else
+    {
+      uint16_t last = ReadU16 (header + 4);
+      id = last + static_cast<uint8_t> (*field - (last & 0xff));
+      field += 1;
+    }
+  uint16_t udpChecksum = 0;
+  if (flags & FLAG_UDP_CHECKSUM)
+    {
+      udpChecksum = ReadU16 (field);
+    }
+
+  uint32_t payloadSize = packet->GetSize () - size;
+  bool ipChecksum = ReadU16 (header + 10) != 0;
+  WriteU16 (header + 2, HEADER_SIZE + payloadSize);
+  WriteU16 (header + 4, id);
+  WriteU16 (header + 10, 0);
+  if (ipChecksum)
+    {
+      // a zero checksum means the sender does not compute them
+      WriteU16 (header + 10, Ipv4Checksum (header));
+    }
+  WriteU16 (header + 24, HEADER_SIZE - 20 + payloadSize);
+  WriteU16 (header + 26, udpChecksum);
+
+  Ptr<Packet> datagram = Create<Packet> (header, HEADER_SIZE);
+  datagram->AddAtEnd (packet->CreateFragment (size, payloadSize));
+  return datagram;
+}
+
+Ptr<Packet>
+Ipv4HeaderCompressor::CreateContextState (uint8_t cid) const
+{
+  return Create<Packet> (&cid, 1);
+}
+
+void
+Ipv4HeaderCompressor::ReceiveContextState (Ptr<const Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  std::vector<uint8_t> cids (packet->GetSize ());
+  packet->CopyData (cids.data (), cids.size ());
+  for (std::map<FlowKey, CompressorContext>::iterator it = m_compressor.begin ();
+       it != m_compressor.end (); ++it)
+    {
+      if (std::find (cids.begin (), cids.end (), it->second.cid) != cids.end ())
+        {
+          NS_LOG_LOGIC ("Peer lost context " << static_cast<uint32_t> (it->second.cid));
+          it->second.refresh = true;
+        }
+    }
+}
+
+uint16_t
+Ipv4HeaderCompressor::Ipv4Checksum (const uint8_t *header)
+{
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < 20; i += 2)
+    {
+      sum += ReadU16 (header + i);
+    }
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  return ~sum & 0xffff;
+}
+
+} // namespace ns3
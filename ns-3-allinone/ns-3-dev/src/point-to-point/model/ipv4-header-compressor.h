@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_HEADER_COMPRESSOR_H
+#define IPV4_HEADER_COMPRESSOR_H
+
+#include <map>
+#include <utility>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/packet.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief IPv4/UDP header compression contexts of one end of a link
+ *
+ * A simplified form of IP header compression (\RFC{2507}, framed as in
+ * \RFC{2509}).  The compressor gives each UDP flow a context identifier
+ * (CID) and sends the first datagram of the flow with its full headers,
+ * which the decompressor stores.  Later datagrams only carry the CID, the
+ * low byte of the IP identification and, if set, the UDP checksum; lengths
+ * and the IP checksum are rebuilt from the frame.  A full header is sent
+ * again every RefreshInterval datagrams, whenever a field expected to be
+ * constant changes, and when the decompressor reports that it lost the
+ * context.  The generation number carried in every header tells a
+ * decompressor that its context belongs to an earlier flow of the same CID.
+ *
+ * Only unfragmented IPv4 datagrams without options carrying UDP are
+ * compressed; Compress returns 0 for anything else.
+ */
+class Ipv4HeaderCompressor : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  Ipv4HeaderCompressor ();
+  virtual ~Ipv4HeaderCompressor ();
+
+  static const uint16_t FULL_HEADER = 0x0061;    //!< PPP protocol of datagrams with full headers
+  static const uint16_t COMPRESSED_UDP = 0x2063; //!< PPP protocol of datagrams with compressed headers
+  static const uint16_t CONTEXT_STATE = 0x2065;  //!< PPP protocol of context loss reports
+
+  /**
+   * \brief Compress the headers of a datagram
+   *
+   * \param packet an IPv4 datagram, without PPP header
+   * \param protocol set to the PPP protocol to send the result under
+   * \return the frame payload, or 0 if the datagram cannot be compressed
+   */
+  Ptr<Packet> Compress (Ptr<const Packet> packet, uint16_t &protocol);
+
+  /**
+   * \brief Restore the headers of a datagram
+   *
+   * \param packet the frame payload, without PPP header
+   * \param protocol the PPP protocol the frame was received under
+   * \param lostCid set to the CID whose context is missing or stale, to be
+   * reported to the peer, or to -1
+   * \return the IPv4 datagram, or 0 if it cannot be restored
+   */
+  Ptr<Packet> Decompress (Ptr<const Packet> packet, uint16_t protocol, int32_t &lostCid);
+
+  /**
+   * \brief Build the report of a lost decompression context
+   *
+   * \param cid the CID of the lost context
+   * \return the frame payload, to be sent under CONTEXT_STATE
+   */
+  Ptr<Packet> CreateContextState (uint8_t cid) const;
+
+  /**
+   * \brief Process a context loss report of the peer decompressor
+   *
+   * The contexts listed are refreshed with a full header on next use.
+   *
+   * \param packet the frame payload, without PPP header
+   */
+  void ReceiveContextState (Ptr<const Packet> packet);
+
+  static const uint32_t HEADER_SIZE = 28; //!< Size of the IPv4 and UDP headers compressed
+
+private:
+  /**
+   * Compressor state of one flow
+   */
+  struct CompressorContext
+  {
+    uint8_t cid;                   //!< Context identifier
+    uint8_t generation;            //!< Generation of the context, six bits
+    uint8_t header[HEADER_SIZE];   //!< Last header sent
+    uint32_t sinceRefresh;         //!< Compressed headers sent since the last full one
+    bool refresh;                  //!< Whether the next header must be sent in full
+    uint64_t lastUse;              //!< Value of m_useCounter at last use
+  };
+
+  /**
+   * Decompressor state of one CID
+   */
+  struct DecompressorContext
+  {
+    bool valid;                    //!< Whether a full header was received
+    bool reported;                 //!< Whether a loss was reported since
+    uint8_t generation;            //!< Generation of the stored header
+    uint8_t header[HEADER_SIZE];   //!< Last header restored
+  };
+
+  /// Flow key: source and destination address, source and destination port
+  typedef std::pair<uint64_t, uint32_t> FlowKey;
+
+  /**
+   * \brief Find or set up the compressor context of a flow
+   *
+   * \param key the flow
+   * \return the context, flagged for refresh if it is new
+   */
+  CompressorContext & GetContext (const FlowKey &key);
+
+  /**
+   * \brief Compute the IPv4 header checksum
+   * \param header the IPv4 header, with its checksum field zeroed
+   * \return the checksum
+   */
+  static uint16_t Ipv4Checksum (const uint8_t *header);
+
+  uint32_t m_maxContexts;      //!< Number of CIDs in use at most
+  uint32_t m_refreshInterval;  //!< Compressed headers between two full ones
+  std::map<FlowKey, CompressorContext> m_compressor; //!< Compressor contexts by flow
+  std::vector<DecompressorContext> m_decompressor;   //!< Decompressor contexts by CID
+  uint64_t m_useCounter;       //!< Datagrams compressed so far, orders contexts by age
+};
+
+} // namespace ns3
+
+#endif /* IPV4_HEADER_COMPRESSOR_H */
@@ -97,9 +97,14 @@ PointToPointChannel::TransmitStart (
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
 
-  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
+  Ptr<Node> dst = m_link[wire].m_dst->GetNode ();
+  // Nodes of different systems may be simulated by different threads
+  // (see MultithreadedSimulatorImpl), which must not share packet data.
+  Ptr<Packet> copy = dst->GetSystemId () == src->GetNode ()->GetSystemId () ?
+    p->Copy () : p->DeepCopy ();
+  Simulator::ScheduleWithContext (dst->GetId (),
                                   txTime + m_delay, &PointToPointNetDevice::Receive,
-                                  m_link[wire].m_dst, p->Copy ());
+                                  m_link[wire].m_dst, copy);
 
   // Call the tx anim callback on the net device
   m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
@@ -25,11 +25,24 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
 #include "point-to-point-net-device.h"
 #include "point-to-point-channel.h"
 #include "ppp-header.h"
-#include "zlib.h"
+#include "compression-codec.h"
+#include "ppp-compression-header.h"
+#include "ipv4-header-compressor.h"
+#include "compression-worker-pool.h"
+#include "compression-filter.h"
 #include "ns3/integer.h"
+#include "ns3/object-factory.h"
+#include "ns3/simulation-singleton.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
 
 namespace ns3 {
 
@@ -37,6 +50,17 @@ NS_LOG_COMPONENT_DEFINE ("PointToPointNetDevice");
 
 NS_OBJECT_ENSURE_REGISTERED (PointToPointNetDevice);
 
+/**
+ * A frame whose compression was handed to the CompressionWorkerPool
+ */
+struct PointToPointNetDevice::OffloadedFrame
+{
+  Ptr<Packet> packet;                 //!< The frame to compress
+  Buffer source;                      //!< The bytes of the frame, kept alive for the worker
+  Buffer compressed;                  //!< Buffer the worker compresses into
+  CompressionWorkerPool::Job job;     //!< The job of the worker pool
+};
+
 TypeId
 PointToPointNetDevice::GetTypeId (void)
 {
@@ -73,6 +97,165 @@ PointToPointNetDevice::GetTypeId (void)
                          "Protocol number of packets that should be compressed", IntegerValue (0),
                          MakeIntegerAccessor (&PointToPointNetDevice::SetCompressionProtocol),
                          MakeIntegerChecker<int> (INT_MIN, INT_MAX))
+          .AddAttribute ("CompressionCodec",
+                         "Type of the CompressionCodec used to compress frames on this link",
+                         TypeIdValue (ZlibCompressionCodec::GetTypeId ()),
+                         MakeTypeIdAccessor (&PointToPointNetDevice::m_codecTypeId),
+                         MakeTypeIdChecker ())
+          .AddAttribute ("CompressionEngineEnabled",
+                         "Whether compressing and decompressing frames takes simulated time, "
+                         "as given by the throughput of the codec",
+                         BooleanValue (false),
+                         MakeBooleanAccessor (&PointToPointNetDevice::m_compressionEngineEnabled),
+                         MakeBooleanChecker ())
+          .AddAttribute ("CompressionEngineQueueSize",
+                         "Number of frames the compression (and the decompression) engine can "
+                         "hold; frames arriving at a full engine are dropped",
+                         UintegerValue (100),
+                         MakeUintegerAccessor (&PointToPointNetDevice::m_compressionEngineQueueSize),
+                         MakeUintegerChecker<uint32_t> (1))
+          .AddAttribute ("CompressionOffload",
+                         "Compress frames on the threads of the CompressionWorkerPool, "
+                         "sized by the CompressionWorkerThreads global value.  Frames are "
+                         "queued for transmission later in the same simulated instant, or "
+                         "when the compression engine is done with them, so the results do "
+                         "not depend on the number of threads.  Without CompressionEngineEnabled "
+                         "the workers therefore only overlap the frames sent in the same "
+                         "simulated instant, by this or other devices; with it, they also run "
+                         "ahead over the engine processing time.  Not used in adaptive and "
+                         "stateful modes, whose frames depend on the result of the previous one.",
+                         BooleanValue (false),
+                         MakeBooleanAccessor (&PointToPointNetDevice::m_compressionOffload),
+                         MakeBooleanChecker ())
+          .AddAttribute ("AdaptiveCompression",
+                         "Send frames whose estimated compression gain is below "
+                         "AdaptiveMinGain, or that grow when compressed, uncompressed",
+                         BooleanValue (false),
+                         MakeBooleanAccessor (&PointToPointNetDevice::m_adaptiveCompression),
+                         MakeBooleanChecker ())
+          .AddAttribute ("AdaptiveEstimator",
+                         "How the adaptive mode estimates the compression gain of a frame",
+                         EnumValue (ESTIMATE_HISTOGRAM),
+                         MakeEnumAccessor (&PointToPointNetDevice::m_adaptiveEstimator),
+                         MakeEnumChecker (ESTIMATE_HISTOGRAM, "Histogram",
+                                          ESTIMATE_TRIAL, "Trial"))
+          .AddAttribute ("AdaptiveMinGain",
+                         "Smallest estimated fraction of bytes saved for which a frame is compressed",
+                         DoubleValue (0.1),
+                         MakeDoubleAccessor (&PointToPointNetDevice::m_adaptiveMinGain),
+                         MakeDoubleChecker<double> (0.0, 1.0))
+          .AddAttribute ("AdaptiveSampleSize",
+                         "Number of leading bytes of a frame the estimator looks at",
+                         UintegerValue (256),
+                         MakeUintegerAccessor (&PointToPointNetDevice::m_adaptiveSampleSize),
+                         MakeUintegerChecker<uint32_t> (16))
+          .AddAttribute ("AdaptiveLearnThreshold",
+                         "Number of incompressible frames in a row after which the frames "
+                         "of a flow are bypassed without estimating them",
+                         UintegerValue (4),
+                         MakeUintegerAccessor (&PointToPointNetDevice::m_adaptiveLearnThreshold),
+                         MakeUintegerChecker<uint32_t> (1))
+          .AddAttribute ("AdaptiveSkipCount",
+                         "Number of frames of a learned flow bypassed before the flow is probed again",
+                         UintegerValue (64),
+                         MakeUintegerAccessor (&PointToPointNetDevice::m_adaptiveSkipCount),
+                         MakeUintegerChecker<uint32_t> ())
+          .AddAttribute ("StatefulCompression",
+                         "Keep the compression history across frames, so that frames can "
+                         "refer to data sent in earlier ones.  Frames carry a sequence "
+                         "number and the stream is reset when the peer loses one.",
+                         BooleanValue (false),
+                         MakeBooleanAccessor (&PointToPointNetDevice::m_statefulCompression),
+                         MakeBooleanChecker ())
+          .AddAttribute ("StreamResyncInterval",
+                         "Smallest interval between two requests to reset the peer "
+                         "compression stream while it stays out of sync",
+                         TimeValue (MilliSeconds (10)),
+                         MakeTimeAccessor (&PointToPointNetDevice::m_streamResyncInterval),
+                         MakeTimeChecker ())
+          .AddAttribute ("AggregationEnabled",
+                         "Compress the frames waiting in the transmit queue together, as one "
+                         "super-frame, instead of one by one.  Adaptive bypass does not apply "
+                         "to aggregated frames.",
+                         BooleanValue (false),
+                         MakeBooleanAccessor (&PointToPointNetDevice::m_aggregationEnabled),
+                         MakeBooleanChecker ())
+          .AddAttribute ("AggregationMaxFrames",
+                         "Largest number of frames in one super-frame",
+                         UintegerValue (16),
+                         MakeUintegerAccessor (&PointToPointNetDevice::m_aggregationMaxFrames),
+                         MakeUintegerChecker<uint32_t> (1))
+          .AddAttribute ("AggregationMaxBytes",
+                         "Largest size of a super-frame before compression; the peer must "
+                         "be able to restore it (see its Mtu)",
+                         UintegerValue (4000),
+                         MakeUintegerAccessor (&PointToPointNetDevice::m_aggregationMaxBytes),
+                         MakeUintegerChecker<uint32_t> (1, 65535))
+          .AddAttribute ("AggregationTimeout",
+                         "Longest time an idle link holds a frame back waiting for more "
+                         "to aggregate; zero sends whatever is queued right away",
+                         TimeValue (Seconds (0)),
+                         MakeTimeAccessor (&PointToPointNetDevice::m_aggregationTimeout),
+                         MakeTimeChecker ())
+          .AddAttribute ("HeaderCompression",
+                         "Compress the IPv4 and UDP headers of outgoing datagrams against "
+                         "per-flow contexts (see Ipv4HeaderCompressor).  Datagrams sent this "
+                         "way bypass payload compression.",
+                         BooleanValue (false),
+                         MakeBooleanAccessor (&PointToPointNetDevice::m_headerCompression),
+                         MakeBooleanChecker ())
+          .AddAttribute ("CompressTxFrames", "Number of frames sent compressed",
+                         TypeId::ATTR_GET,
+                         UintegerValue (0),
+                         MakeUintegerAccessor (&PointToPointNetDevice::m_compressTxFrames),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("CompressTxOriginalBytes",
+                         "Bytes of the frames sent compressed, before compression",
+                         TypeId::ATTR_GET,
+                         UintegerValue (0),
+                         MakeUintegerAccessor (&PointToPointNetDevice::m_compressTxOriginalBytes),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("CompressTxCompressedBytes",
+                         "Bytes of the frames sent compressed, as sent",
+                         TypeId::ATTR_GET,
+                         UintegerValue (0),
+                         MakeUintegerAccessor (&PointToPointNetDevice::m_compressTxCompressedBytes),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("CompressTxCodecTime",
+                         "Codec time spent on the frames sent compressed",
+                         TypeId::ATTR_GET,
+                         TimeValue (Seconds (0)),
+                         MakeTimeAccessor (&PointToPointNetDevice::m_compressTxCodecTime),
+                         MakeTimeChecker ())
+          .AddAttribute ("CompressionBypassedFrames",
+                         "Number of frames of the CompressionProtocol sent uncompressed",
+                         TypeId::ATTR_GET,
+                         UintegerValue (0),
+                         MakeUintegerAccessor (&PointToPointNetDevice::m_compressionBypassedFrames),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("DecompressRxFrames", "Number of frames received compressed and restored",
+                         TypeId::ATTR_GET,
+                         UintegerValue (0),
+                         MakeUintegerAccessor (&PointToPointNetDevice::m_decompressRxFrames),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("DecompressRxCompressedBytes",
+                         "Bytes of the frames restored, as received",
+                         TypeId::ATTR_GET,
+                         UintegerValue (0),
+                         MakeUintegerAccessor (&PointToPointNetDevice::m_decompressRxCompressedBytes),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("DecompressRxDecompressedBytes",
+                         "Bytes of the frames restored, after decompression",
+                         TypeId::ATTR_GET,
+                         UintegerValue (0),
+                         MakeUintegerAccessor (&PointToPointNetDevice::m_decompressRxDecompressedBytes),
+                         MakeUintegerChecker<uint64_t> ())
+          .AddAttribute ("DecompressRxCodecTime",
+                         "Codec time spent on the frames restored",
+                         TypeId::ATTR_GET,
+                         TimeValue (Seconds (0)),
+                         MakeTimeAccessor (&PointToPointNetDevice::m_decompressRxCodecTime),
+                         MakeTimeChecker ())
 
           //
           // Transmit queueing discipline for the device which includes its own set
@@ -96,6 +279,41 @@ PointToPointNetDevice::GetTypeId (void)
                            "by the device before transmission",
                            MakeTraceSourceAccessor (&PointToPointNetDevice::m_macTxDropTrace),
                            "ns3::Packet::TracedCallback")
+          .AddTraceSource ("AdaptiveDecision",
+                           "An outgoing frame was compressed or bypassed by the adaptive "
+                           "mode, with the bytes saved and the engine time spent on it",
+                           MakeTraceSourceAccessor (&PointToPointNetDevice::m_adaptiveDecisionTrace),
+                           "ns3::PointToPointNetDevice::AdaptiveDecisionTracedCallback")
+          .AddTraceSource ("StreamDesync",
+                           "A frame compressed in stream mode was lost or could not be "
+                           "decompressed, and the peer is asked to reset its stream",
+                           MakeTraceSourceAccessor (&PointToPointNetDevice::m_streamDesyncTrace),
+                           "ns3::PointToPointNetDevice::StreamDesyncTracedCallback")
+          .AddTraceSource ("Aggregate",
+                           "A super-frame of several queued frames was compressed for "
+                           "transmission",
+                           MakeTraceSourceAccessor (&PointToPointNetDevice::m_aggregateTrace),
+                           "ns3::PointToPointNetDevice::AggregateTracedCallback")
+          .AddTraceSource ("HeaderCompression",
+                           "A datagram was sent by header compression, with full or "
+                           "compressed headers, and the bytes this saved",
+                           MakeTraceSourceAccessor (&PointToPointNetDevice::m_headerCompressionTrace),
+                           "ns3::PointToPointNetDevice::HeaderCompressionTracedCallback")
+          .AddTraceSource ("CompressTx",
+                           "A frame was compressed for transmission, with its size before "
+                           "and after compression and the codec time",
+                           MakeTraceSourceAccessor (&PointToPointNetDevice::m_compressTxTrace),
+                           "ns3::PointToPointNetDevice::CodecTracedCallback")
+          .AddTraceSource ("CompressionBypassed",
+                           "A frame of the CompressionProtocol was sent uncompressed, by "
+                           "the adaptive mode or because the codec failed",
+                           MakeTraceSourceAccessor (&PointToPointNetDevice::m_compressionBypassedTrace),
+                           "ns3::Packet::TracedCallback")
+          .AddTraceSource ("DecompressRx",
+                           "A compressed frame was received and restored, with its size "
+                           "before and after decompression and the codec time",
+                           MakeTraceSourceAccessor (&PointToPointNetDevice::m_decompressRxTrace),
+                           "ns3::PointToPointNetDevice::CodecTracedCallback")
           .AddTraceSource ("MacPromiscRx",
                            "A packet has been received by this device, "
                            "has been passed up from the physical layer "
@@ -181,7 +399,39 @@ PointToPointNetDevice::PointToPointNetDevice ()
       m_currentPkt (0),
       //default compressionEnable is false
       m_compressionEnabled (false),
-      m_compressionProtocol (0)
+      m_compressionProtocol (0),
+      m_codec (0),
+      m_offloadCodec (0),
+      m_compressionEngineEnabled (false),
+      m_compressionEngineQueueSize (100),
+      m_decompressionEnginePending (0),
+      m_compressionOffload (false),
+      m_adaptiveCompression (false),
+      m_adaptiveEstimator (ESTIMATE_HISTOGRAM),
+      m_adaptiveMinGain (0.1),
+      m_adaptiveSampleSize (256),
+      m_adaptiveLearnThreshold (4),
+      m_adaptiveSkipCount (64),
+      m_trialCodec (0),
+      m_statefulCompression (false),
+      m_txStreamSequence (0),
+      m_txStreamReset (true),
+      m_rxStreamSequence (0),
+      m_rxStreamSynchronized (false),
+      m_rxStreamResetRequested (false),
+      m_ccpIdentifier (0),
+      m_aggregationEnabled (false),
+      m_aggregationMaxFrames (16),
+      m_aggregationMaxBytes (4000),
+      m_headerCompression (false),
+      m_headerCompressor (0),
+      m_compressTxFrames (0),
+      m_compressTxOriginalBytes (0),
+      m_compressTxCompressedBytes (0),
+      m_compressionBypassedFrames (0),
+      m_decompressRxFrames (0),
+      m_decompressRxCompressedBytes (0),
+      m_decompressRxDecompressedBytes (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -205,6 +455,68 @@ PointToPointNetDevice::SetCompressionProtocol (int compressionProtocol)
   m_compressionProtocol = compressionProtocol;
 }
 
+void
+PointToPointNetDevice::SetCompressionCodec (Ptr<CompressionCodec> codec)
+{
+  NS_LOG_FUNCTION (this << codec);
+  m_codec = codec;
+  m_offloadCodec = 0;
+}
+
+Ptr<Ipv4HeaderCompressor>
+PointToPointNetDevice::GetHeaderCompressor (void)
+{
+  if (m_headerCompressor == 0)
+    {
+      m_headerCompressor = CreateObject<Ipv4HeaderCompressor> ();
+    }
+  return m_headerCompressor;
+}
+
+Ptr<CompressionCodec>
+PointToPointNetDevice::GetCompressionCodec (void)
+{
+  if (m_codec == 0)
+    {
+      ObjectFactory factory;
+      factory.SetTypeId (m_codecTypeId);
+      m_codec = factory.Create<CompressionCodec> ();
+    }
+  return m_codec;
+}
+
+void
+PointToPointNetDevice::AddCompressionFilter (Ptr<CompressionFilter> filter)
+{
+  NS_LOG_FUNCTION (this << filter);
+  m_compressionFilters.push_back (filter);
+}
+
+Ptr<CompressionFilter>
+PointToPointNetDevice::GetCompressionFilter (std::size_t i) const
+{
+  NS_ASSERT (i < m_compressionFilters.size ());
+  return m_compressionFilters[i];
+}
+
+std::size_t
+PointToPointNetDevice::GetNCompressionFilters (void) const
+{
+  return m_compressionFilters.size ();
+}
+
+bool
+PointToPointNetDevice::IsCompressionBypassed (Ptr<const Packet> packet, uint16_t protocolNumber) const
+{
+  int32_t ret = CompressionFilter::CF_NO_MATCH;
+  for (std::vector<Ptr<CompressionFilter> >::const_iterator f = m_compressionFilters.begin ();
+       f != m_compressionFilters.end () && ret == CompressionFilter::CF_NO_MATCH; f++)
+    {
+      ret = (*f)->Classify (packet, protocolNumber);
+    }
+  return ret == CompressionFilter::BYPASS;
+}
+
 void
 PointToPointNetDevice::AddHeader (Ptr<Packet> p, uint16_t protocolNumber)
 {
@@ -252,6 +564,29 @@ PointToPointNetDevice::DoDispose ()
   m_receiveErrorModel = 0;
   m_currentPkt = 0;
   m_queue = 0;
+  m_compressionEngineQueue.clear ();
+  // the workers may still write into the buffers of these frames
+  while (!m_offloadedFrames.empty ())
+    {
+      SimulationSingleton<CompressionWorkerPool>::Get ()->Wait (&m_offloadedFrames.front ()->job);
+      delete m_offloadedFrames.front ();
+      m_offloadedFrames.pop_front ();
+    }
+  m_adaptiveFlows.clear ();
+  m_trialCodec = 0;
+  m_aggregationTimer.Cancel ();
+  m_headerCompressor = 0;
+  m_compressionFilters.clear ();
+  if (m_codec != 0)
+    {
+      m_codec->Dispose ();
+      m_codec = 0;
+    }
+  if (m_offloadCodec != 0)
+    {
+      m_offloadCodec->Dispose ();
+      m_offloadCodec = 0;
+    }
   NetDevice::DoDispose ();
 }
 
@@ -318,11 +653,30 @@ PointToPointNetDevice::TransmitComplete (void)
   m_phyTxEndTrace (m_currentPkt);
   m_currentPkt = 0;
 
-  Ptr<Packet> p = m_queue->Dequeue ();
+  StartTransmission ();
+}
+
+bool
+PointToPointNetDevice::StartTransmission (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (m_txMachineState == READY, "Must be READY to transmit");
+  m_aggregationTimer.Cancel ();
+
+  Time processingTime;
+  Ptr<Packet> p = DequeueForTransmission (processingTime);
   if (p == 0)
     {
-      NS_LOG_LOGIC ("No pending packets in device queue after tx complete");
-      return;
+      NS_LOG_LOGIC ("No pending packets in device queue");
+      return true;
+    }
+
+  if (processingTime.IsStrictlyPositive ())
+    {
+      // hold the transmitter while the engine compresses the super-frame
+      m_txMachineState = BUSY;
+      Simulator::Schedule (processingTime, &PointToPointNetDevice::AggregateCompressed, this, p);
+      return true;
     }
 
   //
@@ -330,7 +684,157 @@ PointToPointNetDevice::TransmitComplete (void)
   //
   m_snifferTrace (p);
   m_promiscSnifferTrace (p);
-  TransmitStart (p);
+  return TransmitStart (p);
+}
+
+void
+PointToPointNetDevice::AggregateCompressed (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  m_txMachineState = READY;
+  m_snifferTrace (packet);
+  m_promiscSnifferTrace (packet);
+  TransmitStart (packet);
+}
+
+bool
+PointToPointNetDevice::IsAggregatable (Ptr<const Packet> packet) const
+{
+  if (!m_aggregationEnabled || !m_compressionEnabled)
+    {
+      return false;
+    }
+  PppHeader ppp;
+  packet->PeekHeader (ppp);
+  if (ppp.GetProtocol () != m_compressionProtocol)
+    {
+      return false;
+    }
+  if (m_compressionFilters.empty ())
+    {
+      return true;
+    }
+  // the filters only need the network and transport headers
+  uint32_t offset = ppp.GetSerializedSize ();
+  Ptr<Packet> headers = packet->CreateFragment (offset, std::min<uint32_t> (64, packet->GetSize () - offset));
+  return !IsCompressionBypassed (headers, PppToEther (ppp.GetProtocol ()));
+}
+
+bool
+PointToPointNetDevice::WaitForAggregate (void)
+{
+  if (!m_aggregationEnabled || !m_aggregationTimeout.IsStrictlyPositive ())
+    {
+      return false;
+    }
+  Ptr<const Packet> head = m_queue->Peek ();
+  if (head == 0 || !IsAggregatable (head)
+      || m_queue->GetNPackets () >= m_aggregationMaxFrames
+      || m_queue->GetNBytes () >= m_aggregationMaxBytes)
+    {
+      return false;
+    }
+  if (!m_aggregationTimer.IsRunning ())
+    {
+      NS_LOG_LOGIC ("Holding " << m_queue->GetNPackets () << " frames for aggregation");
+      m_aggregationTimer = Simulator::Schedule (m_aggregationTimeout,
+                                                &PointToPointNetDevice::FlushAggregate, this);
+    }
+  return true;
+}
+
+void
+PointToPointNetDevice::FlushAggregate (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_txMachineState == READY)
+    {
+      StartTransmission ();
+    }
+}
+
+Ptr<Packet>
+PointToPointNetDevice::DequeueForTransmission (Time &processingTime)
+{
+  NS_LOG_FUNCTION (this);
+  processingTime = Seconds (0);
+  Ptr<Packet> p = m_queue->Dequeue ();
+  if (p == 0 || !IsAggregatable (p))
+    {
+      return p;
+    }
+
+  // The receiver restores the whole super-frame into one buffer
+  uint32_t maxBytes = std::min (m_aggregationMaxBytes, GetMaxFrameSize () - 1);
+  PppSubframeHeader subframe;
+  std::vector<Ptr<Packet> > frames (1, p);
+  subframe.SetLength (p->GetSize ());
+  uint32_t bytes = p->GetSize () + subframe.GetSerializedSize ();
+  while (frames.size () < m_aggregationMaxFrames)
+    {
+      Ptr<const Packet> next = m_queue->Peek ();
+      if (next == 0 || !IsAggregatable (next))
+        {
+          break;
+        }
+      subframe.SetLength (next->GetSize ());
+      if (bytes + next->GetSize () + subframe.GetSerializedSize () > maxBytes)
+        {
+          break;
+        }
+      frames.push_back (m_queue->Dequeue ());
+      bytes += next->GetSize () + subframe.GetSerializedSize ();
+    }
+
+  Ptr<Packet> aggregate = Create<Packet> ();
+  for (std::size_t i = 0; i < frames.size (); ++i)
+    {
+      Ptr<Packet> frame = frames[i]->Copy ();
+      subframe.SetLength (frame->GetSize ());
+      frame->AddHeader (subframe);
+      aggregate->AddAtEnd (frame);
+    }
+  NS_LOG_LOGIC ("Aggregated " << frames.size () << " frames, " << bytes << " bytes");
+
+  Ptr<Packet> compressed = m_statefulCompression
+    ? CompressPacketStream (aggregate, true) : CompressPacket (aggregate);
+  if (compressed == 0)
+    {
+      NS_LOG_LOGIC ("Dropping an aggregate that failed to compress");
+      for (std::size_t i = 0; i < frames.size (); ++i)
+        {
+          m_macTxDropTrace (frames[i]);
+        }
+      return DequeueForTransmission (processingTime);
+    }
+  PppHeader ppp;
+  ppp.SetProtocol (m_statefulCompression ? 0x00FD : 0x4023);
+  compressed->AddHeader (ppp);
+  NotifyCompressTx (compressed, aggregate->GetSize ());
+
+  if (m_compressionEngineEnabled)
+    {
+      processingTime = GetCompressionCodec ()->GetCompressTime (aggregate->GetSize ());
+    }
+  m_aggregateTrace (compressed, frames.size ());
+  return compressed;
+}
+
+bool
+PointToPointNetDevice::SplitAggregate (Ptr<Packet> aggregate, std::vector<Ptr<Packet> > &frames)
+{
+  PppSubframeHeader subframe;
+  while (aggregate->GetSize () > 0)
+    {
+      aggregate->RemoveHeader (subframe);
+      if (subframe.GetLength () > aggregate->GetSize ())
+        {
+          return false;
+        }
+      frames.push_back (aggregate->CreateFragment (0, subframe.GetLength ()));
+      aggregate->RemoveAtStart (subframe.GetLength ());
+    }
+  return aggregate->GetSize () == 0 && !frames.empty ();
 }
 
 bool
@@ -494,7 +998,6 @@ void
 PointToPointNetDevice::Receive (Ptr<Packet> packet)
 {
   NS_LOG_FUNCTION (this << packet);
-  uint16_t protocol = 0;
 
   PppHeader ppp_o;
   packet->PeekHeader (ppp_o);
@@ -518,29 +1021,134 @@ PointToPointNetDevice::Receive (Ptr<Packet> packet)
       m_promiscSnifferTrace (packet);
       m_phyRxEndTrace (packet);
 
-      if (m_compressionEnabled == 1)
+      if (ppp_o.GetProtocol () == 0x80FD)
+        {
+          ReceiveCcp (packet);
+          return;
+        }
+
+      if (ppp_o.GetProtocol () == Ipv4HeaderCompressor::CONTEXT_STATE)
         {
-          packet = DecompressPacket (packet);
           PppHeader ppp;
-          packet->PeekHeader (ppp);
+          packet->RemoveHeader (ppp);
+          GetHeaderCompressor ()->ReceiveContextState (packet);
+          return;
         }
 
-      //
-      // Trace sinks will expect complete packets, not packets without some of the
-      // headers.
-      //
-      Ptr<Packet> originalPacket = packet->Copy ();
+      if (ppp_o.GetProtocol () == Ipv4HeaderCompressor::FULL_HEADER
+          || ppp_o.GetProtocol () == Ipv4HeaderCompressor::COMPRESSED_UDP)
+        {
+          PppHeader ppp;
+          packet->RemoveHeader (ppp);
+          int32_t lostCid;
+          Ptr<Packet> datagram = GetHeaderCompressor ()->Decompress (packet, ppp.GetProtocol (), lostCid);
+          if (lostCid >= 0)
+            {
+              Ptr<Packet> report = GetHeaderCompressor ()->CreateContextState (lostCid);
+              ppp.SetProtocol (Ipv4HeaderCompressor::CONTEXT_STATE);
+              report->AddHeader (ppp);
+              EnqueueForTransmission (report);
+            }
+          if (datagram == 0)
+            {
+              NS_LOG_LOGIC ("Dropping datagram whose headers cannot be restored");
+              m_phyRxDropTrace (packet);
+              return;
+            }
+          AddHeader (datagram, 0x0800);
+          ForwardUp (datagram);
+          return;
+        }
 
-      ProcessHeader (packet, protocol);
-      if (!m_promiscCallback.IsNull ())
+      if (m_compressionEnabled == 1
+          && (ppp_o.GetProtocol () == 0x4021 || ppp_o.GetProtocol () == 0x4023
+              || ppp_o.GetProtocol () == 0x00FD))
         {
-          m_macPromiscRxTrace (packet);
-          m_promiscCallback (this, packet, protocol, GetRemote (), GetAddress (),
-                             NetDevice::PACKET_HOST);
+          if (m_compressionEngineEnabled
+              && m_decompressionEnginePending >= m_compressionEngineQueueSize)
+            {
+              NS_LOG_LOGIC ("Decompression engine full, dropping frame");
+              m_phyRxDropTrace (packet);
+              return;
+            }
+          bool aggregate = ppp_o.GetProtocol () == 0x4023;
+          uint32_t compressedSize = packet->GetSize ();
+          Ptr<Packet> decompressed = ppp_o.GetProtocol () == 0x00FD
+            ? DecompressPacketStream (packet, aggregate) : DecompressPacket (packet);
+          if (decompressed == 0)
+            {
+              NS_LOG_LOGIC ("Dropping frame that failed to decompress");
+              m_phyRxDropTrace (packet);
+              return;
+            }
+          uint32_t decompressedSize = decompressed->GetSize ();
+          NotifyDecompressRx (decompressed, compressedSize);
+          std::vector<Ptr<Packet> > frames;
+          if (!aggregate)
+            {
+              frames.push_back (decompressed);
+            }
+          else if (!SplitAggregate (decompressed, frames))
+            {
+              NS_LOG_LOGIC ("Dropping malformed aggregate");
+              m_phyRxDropTrace (packet);
+              return;
+            }
+          if (m_compressionEngineEnabled)
+            {
+              Time start = std::max (Simulator::Now (), m_decompressionEngineBusyUntil);
+              m_decompressionEngineBusyUntil =
+                  start + GetCompressionCodec ()->GetDecompressTime (decompressedSize);
+              m_decompressionEnginePending++;
+              Simulator::Schedule (m_decompressionEngineBusyUntil - Simulator::Now (),
+                                   &PointToPointNetDevice::DecompressionEngineComplete, this,
+                                   frames);
+              return;
+            }
+          for (std::size_t i = 0; i < frames.size (); ++i)
+            {
+              ForwardUp (frames[i]);
+            }
+          return;
         }
-      m_macRxTrace (packet);
-      m_rxCallback (this, packet, protocol, GetRemote ());
+
+      ForwardUp (packet);
+    }
+}
+
+void
+PointToPointNetDevice::DecompressionEngineComplete (std::vector<Ptr<Packet> > frames)
+{
+  NS_LOG_FUNCTION (this << frames.size ());
+  NS_ASSERT (m_decompressionEnginePending > 0);
+  m_decompressionEnginePending--;
+  for (std::size_t i = 0; i < frames.size (); ++i)
+    {
+      ForwardUp (frames[i]);
+    }
+}
+
+void
+PointToPointNetDevice::ForwardUp (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  uint16_t protocol = 0;
+
+  //
+  // Trace sinks will expect complete packets, not packets without some of the
+  // headers.
+  //
+  Ptr<Packet> originalPacket = packet->Copy ();
+
+  ProcessHeader (packet, protocol);
+  if (!m_promiscCallback.IsNull ())
+    {
+      m_macPromiscRxTrace (packet);
+      m_promiscCallback (this, packet, protocol, GetRemote (), GetAddress (),
+                         NetDevice::PACKET_HOST);
     }
+  m_macRxTrace (packet);
+  m_rxCallback (this, packet, protocol, GetRemote ());
 }
 
 bool
@@ -562,15 +1170,107 @@ PointToPointNetDevice::Send (Ptr<Packet> packet, const Address &dest, uint16_t p
       return false;
     }
 
-  if (m_compressionEnabled == 1 && m_compressionProtocol == 33)
+  // Datagrams whose headers can be compressed skip payload compression
+  if (m_headerCompression && protocolNumber == 0x0800)
     {
-      PppHeader ppp;
-      ppp.SetProtocol (0x0021);
-      packet->AddHeader (ppp);
-      packet = CompressPacket (packet);
-      PppHeader ppp2;
-      ppp2.SetProtocol (0x4021);
-      packet->AddHeader (ppp2);
+      uint16_t pppProtocol;
+      Ptr<Packet> frame = GetHeaderCompressor ()->Compress (packet, pppProtocol);
+      if (frame != 0)
+        {
+          int32_t bytesSaved = static_cast<int32_t> (packet->GetSize ())
+            - static_cast<int32_t> (frame->GetSize ());
+          PppHeader ppp;
+          ppp.SetProtocol (pppProtocol);
+          frame->AddHeader (ppp);
+          m_headerCompressionTrace (frame, bytesSaved);
+          m_macTxTrace (frame);
+          return EnqueueForTransmission (frame);
+        }
+    }
+
+  //
+  // CompressionProtocol holds the PPP protocol number (33, i.e. 0x0021 for
+  // IPv4) of the frames to compress.  The original PPP header is compressed
+  // along with the payload and the result is sent under protocol 0x4021,
+  // or 0x00FD behind a PppCompressionHeader in stateful mode, in both cases
+  // behind a PppOriginalLengthHeader giving its size once restored.
+  //
+  // In aggregation mode frames are compressed when they leave the queue
+  if (m_compressionEnabled == 1 && m_compressionProtocol == EtherToPpp (protocolNumber)
+      && !m_aggregationEnabled)
+    {
+      // bypassed frames never enter the engine, however full it is
+      if (IsCompressionBypassed (packet, protocolNumber))
+        {
+          NS_LOG_LOGIC ("Compression filter bypassed the frame");
+          AddHeader (packet, protocolNumber);
+          NotifyCompressionBypassed (packet);
+          m_macTxTrace (packet);
+          return EnqueueForTransmission (packet);
+        }
+      if (m_compressionEngineEnabled
+          && m_compressionEngineQueue.size () >= m_compressionEngineQueueSize)
+        {
+          NS_LOG_LOGIC ("Compression engine full, dropping packet");
+          m_macTxDropTrace (packet);
+          return false;
+        }
+      FlowTuple flow;
+      bool hasFlow = ParseFlowTuple (packet, flow);
+      AddHeader (packet, protocolNumber);
+      uint32_t originalSize = packet->GetSize ();
+      if (m_compressionOffload && !m_adaptiveCompression && !m_statefulCompression)
+        {
+          OffloadCompression (packet, GetCompressionCodec ()->GetCompressTime (originalSize));
+          return true;
+        }
+      Time cpuTime = Seconds (0);
+      bool compress = !m_adaptiveCompression
+        || ShouldCompress (packet, hasFlow ? &flow : 0, cpuTime);
+      Ptr<Packet> compressed = 0;
+      if (compress)
+        {
+          compressed = m_statefulCompression
+            ? CompressPacketStream (packet, false) : CompressPacket (packet);
+        }
+      if (compress)
+        {
+          cpuTime += GetCompressionCodec ()->GetCompressTime (originalSize);
+        }
+      // Once in the stream history a frame must reach the peer compressed
+      if (m_adaptiveCompression && !m_statefulCompression && compressed != 0
+          && compressed->GetSize () + 2 >= originalSize)
+        {
+          NS_LOG_LOGIC ("Frame grew when compressed, sending it as is");
+          compressed = 0;
+        }
+      if (m_adaptiveCompression && compress)
+        {
+          LearnFlow (hasFlow ? &flow : 0, compressed != 0);
+        }
+      int32_t bytesSaved = 0;
+      if (compressed != 0)
+        {
+          packet = compressed;
+          PppHeader ppp2;
+          ppp2.SetProtocol (m_statefulCompression ? 0x00FD : 0x4021);
+          packet->AddHeader (ppp2);
+          bytesSaved = static_cast<int32_t> (originalSize) - static_cast<int32_t> (packet->GetSize ());
+          NotifyCompressTx (packet, originalSize);
+        }
+      else
+        {
+          NotifyCompressionBypassed (packet);
+        }
+      if (m_adaptiveCompression)
+        {
+          m_adaptiveDecisionTrace (packet, compressed != 0, bytesSaved, cpuTime);
+        }
+      if (m_compressionEngineEnabled)
+        {
+          m_macTxTrace (packet);
+          return CompressionEngineEnqueue (packet, cpuTime);
+        }
     }
   else
     {
@@ -582,6 +1282,147 @@ PointToPointNetDevice::Send (Ptr<Packet> packet, const Address &dest, uint16_t p
     }
 
   m_macTxTrace (packet);
+  return EnqueueForTransmission (packet);
+}
+
+bool
+PointToPointNetDevice::FlowTuple::operator < (const FlowTuple &o) const
+{
+  if (source != o.source)
+    {
+      return source < o.source;
+    }
+  if (destination != o.destination)
+    {
+      return destination < o.destination;
+    }
+  if (protocol != o.protocol)
+    {
+      return protocol < o.protocol;
+    }
+  if (sourcePort != o.sourcePort)
+    {
+      return sourcePort < o.sourcePort;
+    }
+  return destinationPort < o.destinationPort;
+}
+
+bool
+PointToPointNetDevice::ParseFlowTuple (Ptr<const Packet> packet, FlowTuple &tuple)
+{
+  // an IPv4 header with the largest options, followed by the two ports
+  uint8_t buf[64];
+  uint32_t size = packet->CopyData (buf, sizeof (buf));
+  if (size < 20 || (buf[0] >> 4) != 4)
+    {
+      return false;
+    }
+  uint32_t ihl = (buf[0] & 0x0f) * 4;
+  tuple.protocol = buf[9];
+  tuple.source = (buf[12] << 24) | (buf[13] << 16) | (buf[14] << 8) | buf[15];
+  tuple.destination = (buf[16] << 24) | (buf[17] << 16) | (buf[18] << 8) | buf[19];
+  tuple.sourcePort = 0;
+  tuple.destinationPort = 0;
+  bool firstFragment = ((buf[6] & 0x1f) | buf[7]) == 0;
+  if ((tuple.protocol == 6 || tuple.protocol == 17) && firstFragment && size >= ihl + 4)
+    {
+      tuple.sourcePort = (buf[ihl] << 8) | buf[ihl + 1];
+      tuple.destinationPort = (buf[ihl + 2] << 8) | buf[ihl + 3];
+    }
+  return true;
+}
+
+bool
+PointToPointNetDevice::ShouldCompress (Ptr<const Packet> packet, const FlowTuple *flow, Time &cpuTime)
+{
+  NS_LOG_FUNCTION (this << packet);
+  if (flow != 0)
+    {
+      std::map<FlowTuple, AdaptiveFlowState>::iterator it = m_adaptiveFlows.find (*flow);
+      if (it != m_adaptiveFlows.end () && it->second.skipRemaining > 0)
+        {
+          it->second.skipRemaining--;
+          NS_LOG_LOGIC ("Flow known to be incompressible, " << it->second.skipRemaining
+                        << " frames left before probing it again");
+          return false;
+        }
+    }
+
+  uint32_t sampleSize = std::min (packet->GetSize (), m_adaptiveSampleSize);
+  m_adaptiveScratch.resize (sampleSize);
+  packet->CopyData (m_adaptiveScratch.data (), sampleSize);
+
+  double gain = 0;
+  if (m_adaptiveEstimator == ESTIMATE_TRIAL)
+    {
+      if (m_trialCodec == 0)
+        {
+          m_trialCodec = CreateObject<Lz4CompressionCodec> ();
+        }
+      std::vector<uint8_t> out (m_trialCodec->GetMaxCompressedSize (sampleSize));
+      uint32_t size = m_trialCodec->Compress (m_adaptiveScratch.data (), sampleSize,
+                                              out.data (), out.size ());
+      cpuTime += m_trialCodec->GetCompressTime (sampleSize);
+      gain = 1.0 - static_cast<double> (size) / sampleSize;
+    }
+  else
+    {
+      uint32_t counts[256] = { 0 };
+      for (uint32_t i = 0; i < sampleSize; ++i)
+        {
+          counts[m_adaptiveScratch[i]]++;
+        }
+      double entropy = 0;
+      uint32_t symbols = 0;
+      for (uint32_t i = 0; i < 256; ++i)
+        {
+          if (counts[i] != 0)
+            {
+              double p = static_cast<double> (counts[i]) / sampleSize;
+              entropy -= p * std::log2 (p);
+              symbols++;
+            }
+        }
+      // Miller-Madow correction: the plug-in estimate is biased low on
+      // samples not much larger than the alphabet
+      entropy += (symbols - 1) / (2.0 * sampleSize * std::log (2.0));
+      gain = 1.0 - entropy / 8.0;
+    }
+  NS_LOG_LOGIC ("Estimated gain " << gain << " on " << sampleSize << " bytes");
+
+  if (gain < m_adaptiveMinGain)
+    {
+      LearnFlow (flow, false);
+      return false;
+    }
+  return true;
+}
+
+void
+PointToPointNetDevice::LearnFlow (const FlowTuple *flow, bool compressible)
+{
+  if (flow == 0)
+    {
+      return;
+    }
+  AdaptiveFlowState &state = m_adaptiveFlows[*flow];
+  if (compressible)
+    {
+      state.incompressibleStreak = 0;
+      return;
+    }
+  if (++state.incompressibleStreak >= m_adaptiveLearnThreshold)
+    {
+      NS_LOG_LOGIC ("Flow learned as incompressible");
+      state.incompressibleStreak = 0;
+      state.skipRemaining = m_adaptiveSkipCount;
+    }
+}
+
+bool
+PointToPointNetDevice::EnqueueForTransmission (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
   //
   // We should enqueue and dequeue the packet to hit the tracing hooks.
   //
@@ -590,13 +1431,9 @@ PointToPointNetDevice::Send (Ptr<Packet> packet, const Address &dest, uint16_t p
       //
       // If the channel is ready for transition we send the packet right now
       //
-      if (m_txMachineState == READY)
+      if (m_txMachineState == READY && !WaitForAggregate ())
         {
-          packet = m_queue->Dequeue ();
-          m_snifferTrace (packet);
-          m_promiscSnifferTrace (packet);
-          bool ret = TransmitStart (packet);
-          return ret;
+          return StartTransmission ();
         }
       return true;
     }
@@ -607,6 +1444,162 @@ PointToPointNetDevice::Send (Ptr<Packet> packet, const Address &dest, uint16_t p
   return false;
 }
 
+bool
+PointToPointNetDevice::CompressionEngineEnqueue (Ptr<Packet> packet, Time processingTime)
+{
+  NS_LOG_FUNCTION (this << packet << processingTime);
+  m_compressionEngineQueue.push_back (std::make_pair (packet, processingTime));
+  if (m_compressionEngineQueue.size () == 1)
+    {
+      // the engine was idle, start on this frame right away
+      Simulator::Schedule (processingTime, &PointToPointNetDevice::CompressionEngineComplete, this);
+    }
+  return true;
+}
+
+void
+PointToPointNetDevice::CompressionEngineComplete (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!m_compressionEngineQueue.empty ());
+  Ptr<Packet> packet = m_compressionEngineQueue.front ().first;
+  m_compressionEngineQueue.pop_front ();
+  if (packet == 0)
+    {
+      // placeholder of an offloaded frame
+      packet = JoinOffloadedFrame ();
+    }
+  if (!m_compressionEngineQueue.empty ())
+    {
+      Simulator::Schedule (m_compressionEngineQueue.front ().second,
+                           &PointToPointNetDevice::CompressionEngineComplete, this);
+    }
+  EnqueueForTransmission (packet);
+}
+
+Ptr<CompressionCodec>
+PointToPointNetDevice::GetOffloadCodec (void)
+{
+  if (m_offloadCodec == 0)
+    {
+      Ptr<CompressionCodec> codec = GetCompressionCodec ();
+      ObjectFactory factory;
+      factory.SetTypeId (codec->GetInstanceTypeId ());
+      for (TypeId tid = codec->GetInstanceTypeId (); tid != Object::GetTypeId (); tid = tid.GetParent ())
+        {
+          for (uint32_t i = 0; i < tid.GetAttributeN (); ++i)
+            {
+              struct TypeId::AttributeInformation info = tid.GetAttribute (i);
+              if ((info.flags & TypeId::ATTR_GET) && (info.flags & TypeId::ATTR_SET)
+                  && info.accessor->HasGetter () && info.accessor->HasSetter ())
+                {
+                  Ptr<AttributeValue> value = info.checker->Create ();
+                  codec->GetAttribute (info.name, *value);
+                  factory.Set (info.name, *value);
+                }
+            }
+        }
+      m_offloadCodec = factory.Create<CompressionCodec> ();
+    }
+  return m_offloadCodec;
+}
+
+void
+PointToPointNetDevice::OffloadCompression (Ptr<Packet> packet, Time processingTime)
+{
+  NS_LOG_FUNCTION (this << packet << processingTime);
+  Ptr<CompressionCodec> codec = GetOffloadCodec ();
+  OffloadedFrame *frame = new OffloadedFrame;
+  frame->packet = packet;
+  frame->job.codec = PeekPointer (codec);
+  frame->source = packet->GetBuffer ();
+  frame->job.srcSize = frame->source.GetSize ();
+  frame->job.src = frame->source.PeekData ();
+  frame->job.dstCapacity = codec->GetMaxCompressedSize (frame->job.srcSize);
+  frame->job.dst = frame->compressed.AddAtEndForWrite (frame->job.dstCapacity);
+  SimulationSingleton<CompressionWorkerPool>::Get ()->Submit (&frame->job);
+  m_offloadedFrames.push_back (frame);
+
+  if (m_compressionEngineEnabled)
+    {
+      CompressionEngineEnqueue (0, processingTime);
+    }
+  else
+    {
+      // The frame must be queued with its compressed size, which the queue
+      // limits and traces depend on, so it cannot wait for its transmit
+      // slot: only the events of this instant overlap with the workers
+      Simulator::ScheduleNow (&PointToPointNetDevice::OffloadComplete, this);
+    }
+}
+
+void
+PointToPointNetDevice::OffloadComplete (void)
+{
+  NS_LOG_FUNCTION (this);
+  EnqueueForTransmission (JoinOffloadedFrame ());
+}
+
+Ptr<Packet>
+PointToPointNetDevice::JoinOffloadedFrame (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!m_offloadedFrames.empty ());
+  OffloadedFrame *frame = m_offloadedFrames.front ();
+  m_offloadedFrames.pop_front ();
+  SimulationSingleton<CompressionWorkerPool>::Get ()->Wait (&frame->job);
+
+  Ptr<Packet> packet = frame->packet;
+  if (frame->job.result != 0)
+    {
+      frame->compressed.RemoveAtEnd (frame->job.dstCapacity - frame->job.result);
+      packet = Create<Packet> (frame->compressed);
+      PppOriginalLengthHeader length;
+      length.SetLength (frame->job.srcSize);
+      packet->AddHeader (length);
+      PppHeader ppp;
+      ppp.SetProtocol (0x4021);
+      packet->AddHeader (ppp);
+      NotifyCompressTx (packet, frame->job.srcSize);
+    }
+  else
+    {
+      NotifyCompressionBypassed (packet);
+    }
+  delete frame;
+  m_macTxTrace (packet);
+  return packet;
+}
+
+void
+PointToPointNetDevice::NotifyCompressTx (Ptr<const Packet> packet, uint32_t originalSize)
+{
+  Time codecTime = GetCompressionCodec ()->GetCompressTime (originalSize);
+  m_compressTxFrames++;
+  m_compressTxOriginalBytes += originalSize;
+  m_compressTxCompressedBytes += packet->GetSize ();
+  m_compressTxCodecTime += codecTime;
+  m_compressTxTrace (packet, originalSize, packet->GetSize (), codecTime);
+}
+
+void
+PointToPointNetDevice::NotifyCompressionBypassed (Ptr<const Packet> packet)
+{
+  m_compressionBypassedFrames++;
+  m_compressionBypassedTrace (packet);
+}
+
+void
+PointToPointNetDevice::NotifyDecompressRx (Ptr<const Packet> packet, uint32_t compressedSize)
+{
+  Time codecTime = GetCompressionCodec ()->GetDecompressTime (packet->GetSize ());
+  m_decompressRxFrames++;
+  m_decompressRxCompressedBytes += compressedSize;
+  m_decompressRxDecompressedBytes += packet->GetSize ();
+  m_decompressRxCodecTime += codecTime;
+  m_decompressRxTrace (packet, compressedSize, packet->GetSize (), codecTime);
+}
+
 bool
 PointToPointNetDevice::SendFrom (Ptr<Packet> packet, const Address &source, const Address &dest,
                                  uint16_t protocolNumber)
@@ -650,80 +1643,210 @@ PointToPointNetDevice::SetPromiscReceiveCallback (NetDevice::PromiscReceiveCallb
 Ptr<Packet>
 PointToPointNetDevice::CompressPacket (Ptr<Packet> packet)
 {
-  uint32_t destSize = 10000;
-  uint32_t dataSize = packet->GetSize ();
-  uint8_t *data_ptr = new uint8_t[packet->GetSize ()];
-  packet->CopyData (data_ptr, packet->GetSize ());
-
-  const size_t BUFSIZE = 10000;
-  uint8_t temp_buffer[BUFSIZE];
-  uint8_t *temp_buf_ptr = temp_buffer;
-
-  z_stream strm;
-  strm.zalloc = 0;
-  strm.zfree = 0;
-  strm.next_in = data_ptr;
-  strm.avail_in = dataSize;
-  strm.next_out = temp_buf_ptr;
-  strm.avail_out = BUFSIZE;
+  NS_LOG_FUNCTION (this << packet);
+  Ptr<CompressionCodec> codec = GetCompressionCodec ();
+
+  // The codec reads the packet buffer in place and writes into the buffer
+  // of the new packet, trimmed to the compressed size afterwards
+  Buffer source = packet->GetBuffer ();
+  uint32_t dataSize = source.GetSize ();
+  uint32_t capacity = codec->GetMaxCompressedSize (dataSize);
+  Buffer buffer;
+  uint32_t destSize = codec->Compress (source.PeekData (), dataSize,
+                                       buffer.AddAtEndForWrite (capacity), capacity);
+  if (destSize == 0)
+    {
+      return 0;
+    }
+  buffer.RemoveAtEnd (capacity - destSize);
+  Ptr<Packet> compressed = Create<Packet> (buffer);
+  PppOriginalLengthHeader length;
+  length.SetLength (dataSize);
+  compressed->AddHeader (length);
+  return compressed;
+}
 
-  deflateInit (&strm, Z_BEST_COMPRESSION);
+Ptr<Packet>
+PointToPointNetDevice::DecompressPacket (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  Ptr<CompressionCodec> codec = GetCompressionCodec ();
 
-  while (strm.avail_in != 0)
+  //remove 4021 header
+  PppHeader pH;
+  packet->RemoveHeader (pH);
+  PppOriginalLengthHeader length;
+  packet->RemoveHeader (length);
+  if (length.GetLength () > GetMaxFrameSize ())
     {
-      int res = deflate (&strm, Z_NO_FLUSH);
-      NS_ASSERT (res == Z_OK);
+      NS_LOG_LOGIC ("Frame would restore to " << length.GetLength () << " bytes");
+      return 0;
     }
 
-  int deflate_res = Z_OK;
-  while (deflate_res == Z_OK)
+  // The frame is restored in place, in a packet of its announced size
+  uint32_t capacity = length.GetLength ();
+  Buffer source = packet->GetBuffer ();
+  Buffer buffer;
+  uint32_t destSize = codec->Decompress (source.PeekData (), source.GetSize (),
+                                         buffer.AddAtEndForWrite (capacity), capacity);
+  if (destSize != capacity)
     {
-      deflate_res = deflate (&strm, Z_FINISH);
+      NS_LOG_LOGIC ("Frame restored to " << destSize << " bytes instead of " << capacity);
+      return 0;
     }
+  return Create<Packet> (buffer);
+}
 
-  NS_ASSERT (deflate_res == Z_STREAM_END);
-
-  destSize = strm.total_out;
-  deflateEnd (&strm);
+uint32_t
+PointToPointNetDevice::GetMaxFrameSize (void) const
+{
+  // the PPP header in front of an MTU sized payload, or an aggregate of
+  // smaller frames
+  return std::max<uint32_t> (m_mtu + PppHeader ().GetSerializedSize (), 10000);
+}
 
-  Ptr<Packet> compPacket = Create<Packet> (temp_buf_ptr, destSize);
+Ptr<Packet>
+PointToPointNetDevice::CompressPacketStream (Ptr<Packet> packet, bool aggregate)
+{
+  NS_LOG_FUNCTION (this << packet);
+  Ptr<CompressionCodec> codec = GetCompressionCodec ();
 
-  return compPacket;
+  PppCompressionHeader header;
+  if (m_txStreamReset)
+    {
+      NS_LOG_LOGIC ("Restarting the compression stream at " << m_txStreamSequence);
+      codec->ResetCompressStream ();
+      header.SetReset (true);
+      m_txStreamReset = false;
+    }
+  header.SetSequence (m_txStreamSequence);
+  header.SetAggregate (aggregate);
+
+  Buffer source = packet->GetBuffer ();
+  uint32_t dataSize = source.GetSize ();
+  uint32_t capacity = codec->GetMaxCompressedSize (dataSize);
+  Buffer buffer;
+  uint32_t destSize = codec->CompressStream (source.PeekData (), dataSize,
+                                             buffer.AddAtEndForWrite (capacity), capacity);
+  if (destSize == 0)
+    {
+      // the compressor state is undefined now, start afresh
+      m_txStreamReset = true;
+      return 0;
+    }
+  m_txStreamSequence++;
+  buffer.RemoveAtEnd (capacity - destSize);
+  Ptr<Packet> compressed = Create<Packet> (buffer);
+  PppOriginalLengthHeader length;
+  length.SetLength (dataSize);
+  compressed->AddHeader (length);
+  compressed->AddHeader (header);
+  return compressed;
 }
 
 Ptr<Packet>
-PointToPointNetDevice::DecompressPacket (Ptr<Packet> packet)
+PointToPointNetDevice::DecompressPacketStream (Ptr<Packet> packet, bool &aggregate)
 {
-  //remove 4021 header
+  NS_LOG_FUNCTION (this << packet);
+  Ptr<CompressionCodec> codec = GetCompressionCodec ();
+
   PppHeader pH;
   packet->RemoveHeader (pH);
+  PppCompressionHeader header;
+  packet->RemoveHeader (header);
+  PppOriginalLengthHeader length;
+  packet->RemoveHeader (length);
+  aggregate = header.IsAggregate ();
 
-  const size_t BUFSIZE = 10000;
-  uint8_t temp_buffer[BUFSIZE];
-  uint8_t *temp_buf_ptr = temp_buffer;
-
-  uint32_t destSize = 10000;
-  uint32_t dataSize = packet->GetSize ();
+  if (header.IsReset ())
+    {
+      NS_LOG_LOGIC ("Peer restarted its stream at " << header.GetSequence ());
+      codec->ResetDecompressStream ();
+      m_rxStreamSynchronized = true;
+      m_rxStreamResetRequested = false;
+      m_rxStreamSequence = header.GetSequence ();
+    }
+  else if (!m_rxStreamSynchronized)
+    {
+      NS_LOG_LOGIC ("Waiting for the peer to restart its stream, dropping "
+                    << header.GetSequence ());
+      RequestStreamReset ();
+      return 0;
+    }
+  else if (header.GetSequence () != m_rxStreamSequence)
+    {
+      NS_LOG_LOGIC ("Expected frame " << m_rxStreamSequence << ", got " << header.GetSequence ());
+      m_streamDesyncTrace (m_rxStreamSequence, header.GetSequence ());
+      m_rxStreamSynchronized = false;
+      RequestStreamReset ();
+      return 0;
+    }
 
-  uint8_t *data_ptr = new uint8_t[packet->GetSize ()];
-  packet->CopyData (data_ptr, dataSize);
+  if (length.GetLength () > GetMaxFrameSize ())
+    {
+      NS_LOG_LOGIC ("Frame would restore to " << length.GetLength () << " bytes");
+      m_rxStreamSynchronized = false;
+      RequestStreamReset ();
+      return 0;
+    }
 
-  z_stream infstream;
-  infstream.zalloc = Z_NULL;
-  infstream.zfree = Z_NULL;
-  infstream.avail_in = dataSize;
-  infstream.next_in = data_ptr; // input char array
-  infstream.avail_out = BUFSIZE; // size of output
-  infstream.next_out = temp_buf_ptr; // output char array
+  // the spare byte lets the stream decompressor tell a full buffer from a
+  // truncated frame
+  uint32_t capacity = length.GetLength () + 1;
+  Buffer source = packet->GetBuffer ();
+  Buffer buffer;
+  uint32_t destSize = codec->DecompressStream (source.PeekData (), source.GetSize (),
+                                               buffer.AddAtEndForWrite (capacity), capacity);
+  if (destSize != length.GetLength ())
+    {
+      m_streamDesyncTrace (m_rxStreamSequence, header.GetSequence ());
+      m_rxStreamSynchronized = false;
+      RequestStreamReset ();
+      return 0;
+    }
+  m_rxStreamSequence = header.GetSequence () + 1;
+  buffer.RemoveAtEnd (capacity - destSize);
+  return Create<Packet> (buffer);
+}
 
-  // the actual DE-compression work.
-  inflateInit (&infstream);
-  inflate (&infstream, Z_NO_FLUSH);
-  destSize = infstream.total_out;
-  inflateEnd (&infstream);
+void
+PointToPointNetDevice::RequestStreamReset (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_rxStreamResetRequested
+      && Simulator::Now () < m_rxStreamResetRequestTime + m_streamResyncInterval)
+    {
+      return;
+    }
+  m_rxStreamResetRequested = true;
+  m_rxStreamResetRequestTime = Simulator::Now ();
+
+  CcpHeader ccp;
+  ccp.SetCode (CcpHeader::RESET_REQUEST);
+  ccp.SetIdentifier (++m_ccpIdentifier);
+  Ptr<Packet> request = Create<Packet> ();
+  request->AddHeader (ccp);
+  PppHeader ppp;
+  ppp.SetProtocol (0x80FD);
+  request->AddHeader (ppp);
+  EnqueueForTransmission (request);
+}
 
-  Ptr<Packet> decompPacket = Create<Packet> (temp_buf_ptr, destSize);
-  return decompPacket;
+void
+PointToPointNetDevice::ReceiveCcp (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  PppHeader ppp;
+  packet->RemoveHeader (ppp);
+  CcpHeader ccp;
+  packet->RemoveHeader (ccp);
+  if (ccp.GetCode () == CcpHeader::RESET_REQUEST)
+    {
+      // The reset flag of the next compressed frame doubles as the Reset-Ack
+      NS_LOG_LOGIC ("Peer requested a stream reset, id "
+                    << static_cast<uint32_t> (ccp.GetIdentifier ()));
+      m_txStreamReset = true;
+    }
 }
 
 bool
@@ -20,6 +20,10 @@
 #define POINT_TO_POINT_NET_DEVICE_H
 
 #include <cstring>
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
 #include "ns3/address.h"
 #include "ns3/node.h"
 #include "ns3/net-device.h"
@@ -27,6 +31,7 @@
 #include "ns3/packet.h"
 #include "ns3/traced-callback.h"
 #include "ns3/nstime.h"
+#include "ns3/event-id.h"
 #include "ns3/data-rate.h"
 #include "ns3/ptr.h"
 #include "ns3/mac48-address.h"
@@ -36,6 +41,9 @@ namespace ns3 {
 template <typename Item> class Queue;
 class PointToPointChannel;
 class ErrorModel;
+class CompressionCodec;
+class CompressionFilter;
+class Ipv4HeaderCompressor;
 
 /**
  * \defgroup point-to-point Point-To-Point Network Device
@@ -198,6 +206,117 @@ public:
 
   virtual void SetCompressionProtocol (int compressionProtocol);
 
+  /**
+   * \brief Replace the codec used to compress outgoing frames
+   *
+   * The peer device must use a codec of the same type.
+   *
+   * \param codec the codec to use
+   */
+  void SetCompressionCodec (Ptr<CompressionCodec> codec);
+
+  /**
+   * \brief Get the codec, creating it from the CompressionCodec attribute
+   * if this is the first use
+   *
+   * \return the codec used to compress outgoing frames
+   */
+  Ptr<CompressionCodec> GetCompressionCodec (void);
+
+  /**
+   * \brief Add a filter to the tail of the list of filters choosing which
+   * frames of the compressed protocol are compressed
+   *
+   * Frames a filter bypasses are sent as is and go straight to the transmit
+   * queue, without waiting behind the compression engine, so that flows
+   * sensitive to latency do not pay for the codec.  Frames no filter
+   * classifies are compressed.
+   *
+   * \param filter the filter to add
+   */
+  void AddCompressionFilter (Ptr<CompressionFilter> filter);
+
+  /**
+   * \brief Get a compression filter
+   * \param i the index of the filter
+   * \return the i-th filter
+   */
+  Ptr<CompressionFilter> GetCompressionFilter (std::size_t i) const;
+
+  /**
+   * \brief Get the number of compression filters
+   * \return the number of compression filters
+   */
+  std::size_t GetNCompressionFilters (void) const;
+
+  /**
+   * \brief Get the IPv4/UDP header compression contexts, creating them if
+   * this is the first use
+   *
+   * \return the header compressor of this device
+   */
+  Ptr<Ipv4HeaderCompressor> GetHeaderCompressor (void);
+
+  /**
+   * How the adaptive mode estimates whether a frame is worth compressing
+   */
+  enum AdaptiveEstimator
+  {
+    ESTIMATE_HISTOGRAM, /**< Order-0 entropy of a byte histogram of the frame prefix */
+    ESTIMATE_TRIAL      /**< Size of a fast LZ compression of the frame prefix */
+  };
+
+  /**
+   * TracedCallback signature for adaptive compression decisions.
+   *
+   * \param [in] packet The frame as queued for transmission.
+   * \param [in] compressed Whether the frame was sent compressed.
+   * \param [in] bytesSaved Bytes saved on the wire, zero when bypassed.
+   * \param [in] cpuTime Engine time spent estimating and compressing.
+   */
+  typedef void (* AdaptiveDecisionTracedCallback)
+    (Ptr<const Packet> packet, bool compressed, int32_t bytesSaved, Time cpuTime);
+
+  /**
+   * TracedCallback signature for a loss of synchronization of the
+   * decompression stream.
+   *
+   * \param [in] expected The sequence number the decompressor expected.
+   * \param [in] received The sequence number of the frame received.
+   */
+  typedef void (* StreamDesyncTracedCallback)
+    (uint16_t expected, uint16_t received);
+
+  /**
+   * TracedCallback signature for super-frames sent in aggregation mode.
+   *
+   * \param [in] packet The compressed super-frame.
+   * \param [in] frames The number of frames it carries.
+   */
+  typedef void (* AggregateTracedCallback)
+    (Ptr<const Packet> packet, uint32_t frames);
+
+  /**
+   * TracedCallback signature for datagrams sent with compressed headers.
+   *
+   * \param [in] packet The frame as queued for transmission.
+   * \param [in] bytesSaved Bytes saved on the wire, negative for a full header.
+   */
+  typedef void (* HeaderCompressionTracedCallback)
+    (Ptr<const Packet> packet, int32_t bytesSaved);
+
+  /**
+   * TracedCallback signature for frames compressed or decompressed by the
+   * codec.
+   *
+   * \param [in] packet The compressed frame sent, or the frame restored.
+   * \param [in] inputSize Bytes given to the codec, with the PPP header.
+   * \param [in] outputSize Bytes out of the codec, with the PPP header.
+   * \param [in] codecTime Codec processing time, as charged by the engine.
+   */
+  typedef void (* CodecTracedCallback)
+    (Ptr<const Packet> packet, uint32_t inputSize, uint32_t outputSize, Time codecTime);
+
 protected:
   /**
    * \brief Handler for MPI receive event
@@ -262,6 +381,268 @@ private:
 
   bool CompressionProcessHeader (Ptr<Packet> p, uint16_t &param);
 
+  /**
+   * \brief 5-tuple identifying the flow an IPv4 frame belongs to
+   */
+  struct FlowTuple
+  {
+    uint32_t source;          //!< Source IPv4 address
+    uint32_t destination;     //!< Destination IPv4 address
+    uint8_t protocol;         //!< IP protocol number
+    uint16_t sourcePort;      //!< Source port, zero if not TCP or UDP
+    uint16_t destinationPort; //!< Destination port, zero if not TCP or UDP
+
+    /**
+     * \brief Strict weak ordering, so tuples can key a std::map
+     * \param o the other tuple
+     * \return true if this tuple sorts before \p o
+     */
+    bool operator < (const FlowTuple &o) const;
+  };
+
+  /**
+   * \brief Extract the flow of an IPv4 datagram from its raw bytes
+   *
+   * \param packet the datagram, starting with its IPv4 header
+   * \param tuple the flow, filled on success
+   * \return false if the packet does not start with an IPv4 header
+   */
+  static bool ParseFlowTuple (Ptr<const Packet> packet, FlowTuple &tuple);
+
+  /**
+   * \brief Ask the compression filters, one at a time, whether a frame must
+   * bypass compression
+   *
+   * \param packet the frame, starting with its network header
+   * \param protocolNumber the EtherType of the frame
+   * \return true if the first filter able to classify the frame bypasses it
+   */
+  bool IsCompressionBypassed (Ptr<const Packet> packet, uint16_t protocolNumber) const;
+
+  /**
+   * \brief Adaptive mode: decide whether a frame is worth compressing
+   *
+   * Frames of flows recently found incompressible are bypassed without
+   * looking at them; otherwise the gain is estimated on a prefix of the
+   * frame and compared against AdaptiveMinGain.
+   *
+   * \param packet the frame, with its PPP header
+   * \param flow the flow of the frame, if known
+   * \param cpuTime incremented by the engine time spent estimating
+   * \return true if the frame should be compressed
+   */
+  bool ShouldCompress (Ptr<const Packet> packet, const FlowTuple *flow, Time &cpuTime);
+
+  /**
+   * \brief Adaptive mode: remember the outcome for a frame of a flow
+   *
+   * \param flow the flow of the frame, if known
+   * \param compressible whether the frame was worth compressing
+   */
+  void LearnFlow (const FlowTuple *flow, bool compressible);
+
+  /**
+   * \brief Hand a framed packet to the transmit queue and start
+   * transmitting if the device is idle
+   *
+   * \param packet the packet, with its PPP header
+   * \return false if the transmit queue dropped the packet
+   */
+  bool EnqueueForTransmission (Ptr<Packet> packet);
+
+  /**
+   * \brief Queue a compressed frame behind the compression engine
+   *
+   * The frame reaches the transmit queue only once the engine has spent
+   * \p processingTime on it and on every frame queued before it.
+   *
+   * \param packet the compressed frame
+   * \param processingTime time the engine needs for this frame
+   * \return false if the engine queue is full and the frame was dropped
+   */
+  bool CompressionEngineEnqueue (Ptr<Packet> packet, Time processingTime);
+
+  /**
+   * \brief The compression engine finished the frame at the head of its
+   * queue; pass it on and start on the next one
+   */
+  void CompressionEngineComplete (void);
+
+  /**
+   * \brief Get the codec run by the CompressionWorkerPool, creating it
+   * with the type and attribute values of the codec of the device if
+   * this is the first use
+   *
+   * The worker threads never share a codec with the simulator thread,
+   * which decompresses the received frames with the codec of the device.
+   *
+   * \return the codec compressing the offloaded frames
+   */
+  Ptr<CompressionCodec> GetOffloadCodec (void);
+
+  /**
+   * \brief Hand the compression of a frame to the CompressionWorkerPool
+   *
+   * The result is collected by OffloadComplete in the current simulated
+   * instant, or when the compression engine is done with the frame.
+   *
+   * \param packet the frame to compress, with its PPP header
+   * \param processingTime the time the compression engine needs for it
+   */
+  void OffloadCompression (Ptr<Packet> packet, Time processingTime);
+
+  /**
+   * \brief Collect the oldest offloaded frame and queue it for transmission
+   */
+  void OffloadComplete (void);
+
+  /**
+   * \brief Wait for the oldest offloaded frame to be compressed
+   *
+   * \return the frame to transmit, compressed unless the codec failed
+   */
+  Ptr<Packet> JoinOffloadedFrame (void);
+
+  /**
+   * \brief Account for a frame sent compressed
+   *
+   * \param packet the compressed frame, with its PPP header
+   * \param originalSize the size of the frame before compression
+   */
+  void NotifyCompressTx (Ptr<const Packet> packet, uint32_t originalSize);
+
+  /**
+   * \brief Account for a frame of the compressed protocol sent as is
+   *
+   * \param packet the frame, with its PPP header
+   */
+  void NotifyCompressionBypassed (Ptr<const Packet> packet);
+
+  /**
+   * \brief Account for a frame restored by the codec
+   *
+   * \param packet the frame restored
+   * \param compressedSize the size of the frame received, with its PPP header
+   */
+  void NotifyDecompressRx (Ptr<const Packet> packet, uint32_t compressedSize);
+
+  /**
+   * \brief The decompression engine finished a received frame
+   *
+   * \param frames the restored frames, with their original PPP header;
+   * more than one if the peer sent an aggregate
+   */
+  void DecompressionEngineComplete (std::vector<Ptr<Packet> > frames);
+
+  /**
+   * \brief Start transmitting the next frame of the queue, if any
+   *
+   * The device must be idle.
+   *
+   * \return false if the frame could not be sent
+   */
+  bool StartTransmission (void);
+
+  /**
+   * \brief Take the next frame to transmit off the queue
+   *
+   * In aggregation mode, compressible frames at the head of the queue are
+   * coalesced and compressed into a single super-frame.
+   *
+   * \param processingTime set to the compression engine time the frame
+   * needs before it can be transmitted
+   * \return the frame, or 0 if the queue is empty
+   */
+  Ptr<Packet> DequeueForTransmission (Time &processingTime);
+
+  /**
+   * \param packet a frame with its PPP header
+   * \return whether packet may be coalesced into an aggregate
+   */
+  bool IsAggregatable (Ptr<const Packet> packet) const;
+
+  /**
+   * \brief Decide whether to hold the transmitter idle a little longer
+   * so that more frames can join the next aggregate
+   *
+   * \return true if the transmission was deferred
+   */
+  bool WaitForAggregate (void);
+
+  /**
+   * \brief The aggregation timeout expired, send what is queued
+   */
+  void FlushAggregate (void);
+
+  /**
+   * \brief The compression engine finished a super-frame, send it
+   *
+   * \param packet the compressed super-frame
+   */
+  void AggregateCompressed (Ptr<Packet> packet);
+
+  /**
+   * \brief Split a decompressed aggregate into its frames
+   *
+   * \param aggregate the decompressed aggregate
+   * \param frames receives the frames, with their PPP header
+   * \return false if the aggregate is malformed
+   */
+  static bool SplitAggregate (Ptr<Packet> aggregate, std::vector<Ptr<Packet> > &frames);
+
+  /**
+   * \brief Strip the PPP header and hand a received frame to the stack
+   *
+   * \param packet the received frame, with its PPP header
+   */
+  void ForwardUp (Ptr<Packet> packet);
+
+  /**
+   * \brief Largest size a received frame may announce it restores to
+   *
+   * \return an upper bound of the size of the frames the peer can compress
+   */
+  uint32_t GetMaxFrameSize (void) const;
+
+  /**
+   * \brief Compress a frame as the continuation of the compression stream
+   *
+   * \param packet the frame to compress, with its PPP header
+   * \param aggregate whether packet is an aggregate of several frames
+   * \return the compressed payload with its PppCompressionHeader, or 0 if
+   * compression failed, in which case the stream restarts with the next
+   * frame
+   */
+  Ptr<Packet> CompressPacketStream (Ptr<Packet> packet, bool aggregate);
+
+  /**
+   * \brief Restore a frame compressed in stream mode
+   *
+   * Frames received out of sequence, or before the decompressor could
+   * restart from a reset frame, cannot be decompressed; they are dropped and
+   * the peer is asked to reset its compressor.
+   *
+   * \param packet the received frame, with its 0x00FD PPP header
+   * \param aggregate set to whether the result is an aggregate of frames
+   * \return the original frame, or 0 if it had to be dropped
+   */
+  Ptr<Packet> DecompressPacketStream (Ptr<Packet> packet, bool &aggregate);
+
+  /**
+   * \brief Ask the peer to reset its compression stream
+   *
+   * While the stream stays out of sync, requests are repeated at most once
+   * per StreamResyncInterval.
+   */
+  void RequestStreamReset (void);
+
+  /**
+   * \brief Process a Compression Control Protocol packet from the peer
+   *
+   * \param packet the received frame, with its 0x80FD PPP header
+   */
+  void ReceiveCcp (Ptr<Packet> packet);
+
   /**
    * Start Sending a Packet Down the Wire.
    *
@@ -471,6 +852,106 @@ private:
 
   bool m_compressionEnabled; //!< Whether to compress data or not
   int m_compressionProtocol;
+  TypeId m_codecTypeId; //!< Type of the codec created on first use
+  Ptr<CompressionCodec> m_codec; //!< Codec compressing the payload of outgoing frames
+  Ptr<CompressionCodec> m_offloadCodec; //!< Copy of m_codec run by the worker threads
+  std::vector<Ptr<CompressionFilter> > m_compressionFilters; //!< Filters choosing the frames to compress
+
+  bool m_compressionEngineEnabled; //!< Whether codec processing takes simulated time
+  uint32_t m_compressionEngineQueueSize; //!< Frames each engine may hold, including the one in process
+  std::deque<std::pair<Ptr<Packet>, Time> > m_compressionEngineQueue; //!< Frames waiting for, or in, the compression engine
+  uint32_t m_decompressionEnginePending; //!< Frames waiting for, or in, the decompression engine
+  Time m_decompressionEngineBusyUntil; //!< Time at which the decompression engine drains
+
+  bool m_compressionOffload; //!< Whether frames are compressed by the worker pool
+  struct OffloadedFrame;
+  std::deque<OffloadedFrame *> m_offloadedFrames; //!< Frames handed to the worker pool, oldest first
+
+  /**
+   * Adaptive mode knowledge about one flow
+   */
+  struct AdaptiveFlowState
+  {
+    uint32_t incompressibleStreak; //!< Consecutive frames not worth compressing
+    uint32_t skipRemaining;        //!< Frames left to bypass without an estimate
+  };
+
+  bool m_adaptiveCompression; //!< Whether to bypass frames not worth compressing
+  AdaptiveEstimator m_adaptiveEstimator; //!< How the gain of a frame is estimated
+  double m_adaptiveMinGain; //!< Smallest estimated saved fraction worth compressing
+  uint32_t m_adaptiveSampleSize; //!< Bytes of the frame looked at by the estimator
+  uint32_t m_adaptiveLearnThreshold; //!< Incompressible frames in a row before a flow is skipped
+  uint32_t m_adaptiveSkipCount; //!< Frames of a learned flow bypassed before probing again
+  std::map<FlowTuple, AdaptiveFlowState> m_adaptiveFlows; //!< Per-flow learning state
+  Ptr<CompressionCodec> m_trialCodec; //!< Fast codec used by the trial estimator
+  std::vector<uint8_t> m_adaptiveScratch; //!< Scratch memory of the estimators
+
+  /**
+   * The trace source fired for every frame considered for compression in
+   * adaptive mode.
+   */
+  TracedCallback<Ptr<const Packet>, bool, int32_t, Time> m_adaptiveDecisionTrace;
+
+  bool m_statefulCompression; //!< Whether compression history is kept across frames
+  Time m_streamResyncInterval; //!< Smallest interval between two reset requests
+  uint16_t m_txStreamSequence; //!< Sequence number of the next compressed frame
+  bool m_txStreamReset; //!< Whether the next compressed frame restarts the stream
+  uint16_t m_rxStreamSequence; //!< Sequence number expected from the peer
+  bool m_rxStreamSynchronized; //!< Whether the decompressor follows the peer stream
+  bool m_rxStreamResetRequested; //!< Whether a reset request is outstanding
+  Time m_rxStreamResetRequestTime; //!< Time the last reset request was sent
+  uint8_t m_ccpIdentifier; //!< Identifier of the last reset request sent
+
+  /**
+   * The trace source fired when a lost or corrupted frame desynchronizes
+   * the decompression stream.
+   */
+  TracedCallback<uint16_t, uint16_t> m_streamDesyncTrace;
+
+  bool m_aggregationEnabled; //!< Whether queued frames are compressed together
+  uint32_t m_aggregationMaxFrames; //!< Most frames in one aggregate
+  uint32_t m_aggregationMaxBytes; //!< Largest aggregate before compression
+  Time m_aggregationTimeout; //!< Longest time an idle link waits for more frames
+  EventId m_aggregationTimer; //!< Pending FlushAggregate event
+
+  /**
+   * The trace source fired for every super-frame sent in aggregation mode.
+   */
+  TracedCallback<Ptr<const Packet>, uint32_t> m_aggregateTrace;
+
+  bool m_headerCompression; //!< Whether to compress IPv4/UDP headers
+  Ptr<Ipv4HeaderCompressor> m_headerCompressor; //!< Header compression contexts
+
+  /**
+   * The trace source fired for every datagram sent by header compression.
+   */
+  TracedCallback<Ptr<const Packet>, int32_t> m_headerCompressionTrace;
+
+  uint64_t m_compressTxFrames;          //!< Frames sent compressed
+  uint64_t m_compressTxOriginalBytes;   //!< Bytes of these frames before compression
+  uint64_t m_compressTxCompressedBytes; //!< Bytes of these frames on the wire
+  Time m_compressTxCodecTime;           //!< Codec time spent compressing them
+  uint64_t m_compressionBypassedFrames; //!< Frames of the compressed protocol sent as is
+  uint64_t m_decompressRxFrames;        //!< Frames restored by the codec
+  uint64_t m_decompressRxCompressedBytes;   //!< Bytes of these frames on the wire
+  uint64_t m_decompressRxDecompressedBytes; //!< Bytes of these frames once restored
+  Time m_decompressRxCodecTime;         //!< Codec time spent restoring them
+
+  /**
+   * The trace source fired for every frame sent compressed.
+   */
+  TracedCallback<Ptr<const Packet>, uint32_t, uint32_t, Time> m_compressTxTrace;
+
+  /**
+   * The trace source fired for every frame of the compressed protocol sent
+   * uncompressed.
+   */
+  TracedCallback<Ptr<const Packet> > m_compressionBypassedTrace;
+
+  /**
+   * The trace source fired for every frame restored by the codec.
+   */
+  TracedCallback<Ptr<const Packet>, uint32_t, uint32_t, Time> m_decompressRxTrace;
 
   /**
    * \brief PPP to Ethernet protocol number mapping
@@ -0,0 +1,417 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <iostream>
+#include "ns3/log.h"
+#include "ppp-compression-header.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PppCompressionHeader");
+
+NS_OBJECT_ENSURE_REGISTERED (PppCompressionHeader);
+
+PppCompressionHeader::PppCompressionHeader ()
+  : m_flags (0),
+    m_sequence (0)
+{
+}
+
+PppCompressionHeader::~PppCompressionHeader ()
+{
+}
+
+TypeId
+PppCompressionHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PppCompressionHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("PointToPoint")
+    .AddConstructor<PppCompressionHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+PppCompressionHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+PppCompressionHeader::Print (std::ostream &os) const
+{
+  os << "seq=" << m_sequence;
+  if (IsReset ())
+    {
+      os << " reset";
+    }
+  if (IsAggregate ())
+    {
+      os << " aggregate";
+    }
+}
+
+uint32_t
+PppCompressionHeader::GetSerializedSize (void) const
+{
+  return 3;
+}
+
+void
+PppCompressionHeader::Serialize (Buffer::Iterator start) const
+{
+  start.WriteU8 (m_flags);
+  start.WriteHtonU16 (m_sequence);
+}
+
+uint32_t
+PppCompressionHeader::Deserialize (Buffer::Iterator start)
+{
+  m_flags = start.ReadU8 ();
+  m_sequence = start.ReadNtohU16 ();
+  return GetSerializedSize ();
+}
+
+void
+PppCompressionHeader::SetSequence (uint16_t sequence)
+{
+  m_sequence = sequence;
+}
+
+uint16_t
+PppCompressionHeader::GetSequence (void) const
+{
+  return m_sequence;
+}
+
+void
+PppCompressionHeader::SetReset (bool reset)
+{
+  if (reset)
+    {
+      m_flags |= RESET;
+    }
+  else
+    {
+      m_flags &= ~RESET;
+    }
+}
+
+bool
+PppCompressionHeader::IsReset (void) const
+{
+  return (m_flags & RESET) != 0;
+}
+
+void
+PppCompressionHeader::SetAggregate (bool aggregate)
+{
+  if (aggregate)
+    {
+      m_flags |= AGGREGATE;
+    }
+  else
+    {
+      m_flags &= ~AGGREGATE;
+    }
+}
+
+bool
+PppCompressionHeader::IsAggregate (void) const
+{
+  return (m_flags & AGGREGATE) != 0;
+}
+
+NS_OBJECT_ENSURE_REGISTERED (CcpHeader);
+
+CcpHeader::CcpHeader ()
+  : m_code (RESET_REQUEST),
+    m_identifier (0)
+{
+}
+
+CcpHeader::~CcpHeader ()
+{
+}
+
+TypeId
+CcpHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CcpHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("PointToPoint")
+    .AddConstructor<CcpHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+CcpHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+CcpHeader::Print (std::ostream &os) const
+{
+  switch (m_code)
+    {
+    case RESET_REQUEST:
+      os << "Reset-Request";
+      break;
+    case RESET_ACK:
+      os << "Reset-Ack";
+      break;
+    default:
+      os << "code=" << static_cast<uint32_t> (m_code);
+    }
+  os << " id=" << static_cast<uint32_t> (m_identifier);
+}
+
+uint32_t
+CcpHeader::GetSerializedSize (void) const
+{
+  return 4;
+}
+
+void
+CcpHeader::Serialize (Buffer::Iterator start) const
+{
+  start.WriteU8 (m_code);
+  start.WriteU8 (m_identifier);
+  // Reset packets carry no data, the length covers this header only
+  start.WriteHtonU16 (GetSerializedSize ());
+}
+
+uint32_t
+CcpHeader::Deserialize (Buffer::Iterator start)
+{
+  m_code = start.ReadU8 ();
+  m_identifier = start.ReadU8 ();
+  start.ReadNtohU16 ();
+  return GetSerializedSize ();
+}
+
+void
+CcpHeader::SetCode (uint8_t code)
+{
+  m_code = code;
+}
+
+uint8_t
+CcpHeader::GetCode (void) const
+{
+  return m_code;
+}
+
+void
+CcpHeader::SetIdentifier (uint8_t identifier)
+{
+  m_identifier = identifier;
+}
+
+uint8_t
+CcpHeader::GetIdentifier (void) const
+{
+  return m_identifier;
+}
+
+/**
+ * \brief Get the size of a length written by WriteLength
+ * \param length the length
+ * \return its size in bytes, from 1 to 5
+ */
+static uint32_t
+GetLengthSize (uint32_t length)
+{
+  uint32_t size = 1;
+  while (length >= 0x80)
+    {
+      length >>= 7;
+      size++;
+    }
+  return size;
+}
+
+/**
+ * \brief Write a length in groups of 7 bits, most significant first, the
+ * high bit of a byte telling that more follow
+ * \param start where to write
+ * \param length the length
+ */
+static void
+WriteLength (Buffer::Iterator start, uint32_t length)
+{
+  for (uint32_t i = GetLengthSize (length); i > 1; --i)
+    {
+      start.WriteU8 (0x80 | ((length >> (7 * (i - 1))) & 0x7f));
+    }
+  start.WriteU8 (length & 0x7f);
+}
+
+/**
+ * \brief Read a length written by WriteLength
+ * \param start where to read
+ * \param [out] length the length, or 0xffffffff if the buffer ends first
+ * \return the number of bytes read
+ */
+static uint32_t
+ReadLength (Buffer::Iterator start, uint32_t &length)
+{
+  length = 0;
+  for (uint32_t i = 1; i <= 5 && !start.IsEnd (); ++i)
+    {
+      uint8_t byte = start.ReadU8 ();
+      length = (length << 7) | (byte & 0x7f);
+      if ((byte & 0x80) == 0)
+        {
+          return i;
+        }
+    }
+  length = 0xffffffff;
+  return 0;
+}
+
+NS_OBJECT_ENSURE_REGISTERED (PppSubframeHeader);
+
+PppSubframeHeader::PppSubframeHeader ()
+  : m_length (0)
+{
+}
+
+PppSubframeHeader::~PppSubframeHeader ()
+{
+}
+
+TypeId
+PppSubframeHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PppSubframeHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("PointToPoint")
+    .AddConstructor<PppSubframeHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+PppSubframeHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+PppSubframeHeader::Print (std::ostream &os) const
+{
+  os << "length=" << m_length;
+}
+
+uint32_t
+PppSubframeHeader::GetSerializedSize (void) const
+{
+  return GetLengthSize (m_length);
+}
+
+void
+PppSubframeHeader::Serialize (Buffer::Iterator start) const
+{
+  WriteLength (start, m_length);
+}
+
+uint32_t
+PppSubframeHeader::Deserialize (Buffer::Iterator start)
+{
+  return ReadLength (start, m_length);
+}
+
+void
+PppSubframeHeader::SetLength (uint32_t length)
+{
+  m_length = length;
+}
+
+uint32_t
+PppSubframeHeader::GetLength (void) const
+{
+  return m_length;
+}
+
+NS_OBJECT_ENSURE_REGISTERED (PppOriginalLengthHeader);
+
+PppOriginalLengthHeader::PppOriginalLengthHeader ()
+  : m_length (0)
+{
+}
+
+PppOriginalLengthHeader::~PppOriginalLengthHeader ()
+{
+}
+
+TypeId
+PppOriginalLengthHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PppOriginalLengthHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("PointToPoint")
+    .AddConstructor<PppOriginalLengthHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+PppOriginalLengthHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+PppOriginalLengthHeader::Print (std::ostream &os) const
+{
+  os << "original length=" << m_length;
+}
+
+uint32_t
+PppOriginalLengthHeader::GetSerializedSize (void) const
+{
+  return GetLengthSize (m_length);
+}
+
+void
+PppOriginalLengthHeader::Serialize (Buffer::Iterator start) const
+{
+  WriteLength (start, m_length);
+}
+
+uint32_t
+PppOriginalLengthHeader::Deserialize (Buffer::Iterator start)
+{
+  return ReadLength (start, m_length);
+}
+
+void
+PppOriginalLengthHeader::SetLength (uint32_t length)
+{
+  m_length = length;
+}
+
+uint32_t
+PppOriginalLengthHeader::GetLength (void) const
+{
+  return m_length;
+}
+
+} // namespace ns3
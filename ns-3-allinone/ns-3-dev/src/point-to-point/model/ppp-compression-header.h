@@ -0,0 +1,240 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PPP_COMPRESSION_HEADER_H
+#define PPP_COMPRESSION_HEADER_H
+
+#include "ns3/header.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief Header of the frames compressed in stream mode
+ *
+ * Carried right after the PPP header of protocol 0x00FD (compressed
+ * datagram, \RFC{1962}).  The sequence number lets the decompressor notice
+ * a lost frame, after which its history no longer matches the compressor's;
+ * the reset flag marks the frame with which the compressor restarted its
+ * history, so that the decompressor can start over from it.  The aggregate
+ * flag tells that the compressed payload is a sequence of frames, each
+ * behind a PppSubframeHeader.
+ */
+class PppCompressionHeader : public Header
+{
+public:
+  /// Flag bits
+  enum Flags
+  {
+    RESET = 0x01,    //!< the compressor reset its history before this frame
+    AGGREGATE = 0x02 //!< the payload holds several length-prefixed frames
+  };
+
+  PppCompressionHeader ();
+  virtual ~PppCompressionHeader ();
+
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual uint32_t GetSerializedSize (void) const;
+
+  /**
+   * \param sequence the sequence number of the frame in the stream
+   */
+  void SetSequence (uint16_t sequence);
+
+  /**
+   * \return the sequence number of the frame in the stream
+   */
+  uint16_t GetSequence (void) const;
+
+  /**
+   * \param reset whether the compressor reset its history before this frame
+   */
+  void SetReset (bool reset);
+
+  /**
+   * \return whether the compressor reset its history before this frame
+   */
+  bool IsReset (void) const;
+
+  /**
+   * \param aggregate whether the payload holds several frames
+   */
+  void SetAggregate (bool aggregate);
+
+  /**
+   * \return whether the payload holds several frames
+   */
+  bool IsAggregate (void) const;
+
+private:
+  uint8_t m_flags;     //!< Flag bits
+  uint16_t m_sequence; //!< Sequence number of the frame in the stream
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Compression Control Protocol packet header
+ *
+ * Carried after a PPP header of protocol 0x80FD.  Only the Reset-Request
+ * and Reset-Ack codes of \RFC{1962} are used: a decompressor that lost
+ * track of the stream asks the compressor to restart its history.
+ */
+class CcpHeader : public Header
+{
+public:
+  /// CCP codes
+  enum Code
+  {
+    RESET_REQUEST = 14, //!< ask the peer compressor to reset its history
+    RESET_ACK = 15      //!< acknowledge a Reset-Request
+  };
+
+  CcpHeader ();
+  virtual ~CcpHeader ();
+
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual uint32_t GetSerializedSize (void) const;
+
+  /**
+   * \param code the CCP code
+   */
+  void SetCode (uint8_t code);
+
+  /**
+   * \return the CCP code
+   */
+  uint8_t GetCode (void) const;
+
+  /**
+   * \param identifier the identifier matching requests and replies
+   */
+  void SetIdentifier (uint8_t identifier);
+
+  /**
+   * \return the identifier matching requests and replies
+   */
+  uint8_t GetIdentifier (void) const;
+
+private:
+  uint8_t m_code;       //!< CCP code
+  uint8_t m_identifier; //!< Identifier matching requests and replies
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Length prefix of a frame inside an aggregate
+ *
+ * An aggregate concatenates several PPP frames, each preceded by this
+ * header, and is compressed as a whole.  The length is written in groups
+ * of 7 bits, most significant first, with the high bit of each byte but
+ * the last set, so frames of up to 16383 bytes take 2 bytes and jumbo
+ * frames 3.
+ */
+class PppSubframeHeader : public Header
+{
+public:
+  PppSubframeHeader ();
+  virtual ~PppSubframeHeader ();
+
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual uint32_t GetSerializedSize (void) const;
+
+  /**
+   * \param length the size of the frame following this header
+   */
+  void SetLength (uint32_t length);
+
+  /**
+   * \return the size of the frame following this header
+   */
+  uint32_t GetLength (void) const;
+
+private:
+  uint32_t m_length; //!< Size of the frame following this header
+};
+
+/**
+ * \ingroup point-to-point
+ * \brief Size of a compressed payload once restored
+ *
+ * Precedes the output of the codec in every compressed frame, behind the
+ * PPP header, and the PppCompressionHeader in stream mode, so that the
+ * receiver allocates the restored frame at its exact size and rejects a
+ * payload that does not restore to it.  The length is written like that of
+ * PppSubframeHeader.
+ */
+class PppOriginalLengthHeader : public Header
+{
+public:
+  PppOriginalLengthHeader ();
+  virtual ~PppOriginalLengthHeader ();
+
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual uint32_t GetSerializedSize (void) const;
+
+  /**
+   * \param length the size of the payload once restored
+   */
+  void SetLength (uint32_t length);
+
+  /**
+   * \return the size of the payload once restored
+   */
+  uint32_t GetLength (void) const;
+
+private:
+  uint32_t m_length; //!< Size of the payload once restored
+};
+
+} // namespace ns3
+
+#endif /* PPP_COMPRESSION_HEADER_H */
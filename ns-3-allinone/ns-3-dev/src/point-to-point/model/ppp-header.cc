@@ -67,6 +67,27 @@ PppHeader::Print (std::ostream &os) const
     case 0x0057: /* IPv6 */
       proto = "IPv6 (0x0057)";
       break;
+    case 0x4021: /* Compressed IPv4 */
+      proto = "Compressed IP (0x4021)";
+      break;
+    case 0x4023: /* Compressed aggregate of IPv4 frames */
+      proto = "Compressed IP Aggregate (0x4023)";
+      break;
+    case 0x00FD: /* Stream compressed datagram */
+      proto = "Compressed Datagram (0x00fd)";
+      break;
+    case 0x0061: /* IP header compression, full header */
+      proto = "Full Header (0x0061)";
+      break;
+    case 0x2063: /* IP header compression, compressed non-TCP */
+      proto = "Compressed Non-TCP (0x2063)";
+      break;
+    case 0x2065: /* IP header compression, context state */
+      proto = "Context State (0x2065)";
+      break;
+    case 0x80FD: /* CCP */
+      proto = "CCP (0x80fd)";
+      break;
     default:
       NS_ASSERT_MSG (false, "PPP Protocol number not defined!");
     }
@@ -23,7 +23,25 @@
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/compression-codec.h"
+#include "ns3/compression-filter.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/object-factory.h"
 #include "ns3/net-device-queue-interface.h"
+#include "ns3/boolean.h"
+#include "ns3/integer.h"
+#include "ns3/uinteger.h"
+#include "ns3/data-rate.h"
+#include "ns3/enum.h"
+#include "ns3/error-model.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/point-to-point-binary-trace.h"
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
 
 using namespace ns3;
 
@@ -94,6 +112,1949 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test class for the compression link
+ *
+ * It sends several packets of varying compressibility, up to the largest
+ * MTU, over a pair of compression-enabled devices and checks that every
+ * payload comes out of the receiver unchanged.
+ */
+class PointToPointCompressionTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   *
+   * \param stateful whether the devices compress in stream mode
+   */
+  PointToPointCompressionTest (bool stateful);
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send one packet with the given payload to the device specified
+   *
+   * \param device NetDevice to send to
+   * \param payload bytes carried by the packet
+   */
+  void SendPayload (Ptr<PointToPointNetDevice> device, std::vector<uint8_t> payload);
+
+  /**
+   * \brief Receive callback installed on the receiving device
+   *
+   * \param device the receiving device
+   * \param p the received packet
+   * \param protocol the protocol number of the packet
+   * \param from the sender address
+   * \return always true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  bool m_stateful;                               //!< Whether to compress in stream mode
+  std::vector<std::vector<uint8_t> > m_sent;     //!< Payloads handed to the sender
+  std::vector<std::vector<uint8_t> > m_received; //!< Payloads delivered by the receiver
+};
+
+PointToPointCompressionTest::PointToPointCompressionTest (bool stateful)
+  : TestCase (stateful ? "PointToPoint stream compression round trip"
+                       : "PointToPoint compression round trip"),
+    m_stateful (stateful)
+{
+}
+
+void
+PointToPointCompressionTest::SendPayload (Ptr<PointToPointNetDevice> device, std::vector<uint8_t> payload)
+{
+  m_sent.push_back (payload);
+  Ptr<Packet> p = Create<Packet> (payload.data (), payload.size ());
+  device->Send (p, device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointCompressionTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  NS_TEST_EXPECT_MSG_EQ (protocol, 0x800, "Unexpected protocol number");
+  std::vector<uint8_t> payload (p->GetSize ());
+  p->CopyData (payload.data (), payload.size ());
+  m_received.push_back (payload);
+  return true;
+}
+
+void
+PointToPointCompressionTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devA->SetAttribute ("CompressionEnabled", BooleanValue (true));
+  devA->SetAttribute ("CompressionProtocol", IntegerValue (33));
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devB->SetAttribute ("CompressionEnabled", BooleanValue (true));
+  devB->SetAttribute ("CompressionProtocol", IntegerValue (33));
+  devA->SetAttribute ("StatefulCompression", BooleanValue (m_stateful));
+  devB->SetAttribute ("StatefulCompression", BooleanValue (m_stateful));
+  // jumbo frames must be restored whole
+  devA->SetMtu (65535);
+  devB->SetMtu (65535);
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devB->SetReceiveCallback (MakeCallback (&PointToPointCompressionTest::Receive, this));
+
+  std::vector<uint8_t> zeros (1100, 0);
+  std::vector<uint8_t> pattern (1100);
+  uint32_t state = 12345;
+  for (std::size_t i = 0; i < pattern.size (); ++i)
+    {
+      state = state * 1103515245 + 12345;
+      pattern[i] = static_cast<uint8_t> (state >> 16);
+    }
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      Simulator::Schedule (Seconds (1.0 + i), &PointToPointCompressionTest::SendPayload, this,
+                           devA, (i % 2) ? pattern : zeros);
+    }
+  std::vector<uint8_t> jumbo (16000);
+  for (std::size_t i = 0; i < jumbo.size (); ++i)
+    {
+      jumbo[i] = pattern[i % pattern.size ()] ^ static_cast<uint8_t> (i / pattern.size ());
+    }
+  Simulator::Schedule (Seconds (5.0), &PointToPointCompressionTest::SendPayload, this, devA, jumbo);
+  jumbo.resize (65535);
+  Simulator::Schedule (Seconds (6.0), &PointToPointCompressionTest::SendPayload, this, devA, jumbo);
+
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_received.size (), m_sent.size (), "Not every packet was delivered");
+  for (std::size_t i = 0; i < m_sent.size (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((m_received[i] == m_sent[i]), true, "Payload " << i << " was altered");
+    }
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test class for the compression engine latency model
+ *
+ * A burst of frames is offered to a slow compression engine with room
+ * for two frames: the third frame must be dropped and the other two
+ * must leave the engine one processing time apart.
+ */
+class PointToPointCompressionEngineTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointCompressionEngineTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send a burst of packets to the device specified
+   *
+   * \param device NetDevice to send to
+   * \param count number of packets in the burst
+   */
+  void SendBurst (Ptr<PointToPointNetDevice> device, uint32_t count);
+
+  /**
+   * \brief Receive callback installed on the receiving device
+   *
+   * \param device the receiving device
+   * \param p the received packet
+   * \param protocol the protocol number of the packet
+   * \param from the sender address
+   * \return always true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  std::vector<Time> m_rxTimes; //!< Reception time of each delivered packet
+  uint32_t m_accepted;         //!< Packets accepted by Send
+};
+
+PointToPointCompressionEngineTest::PointToPointCompressionEngineTest ()
+  : TestCase ("PointToPoint compression engine latency"),
+    m_accepted (0)
+{
+}
+
+void
+PointToPointCompressionEngineTest::SendBurst (Ptr<PointToPointNetDevice> device, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      if (device->Send (Create<Packet> (998), device->GetBroadcast (), 0x800))
+        {
+          m_accepted++;
+        }
+    }
+}
+
+bool
+PointToPointCompressionEngineTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  m_rxTimes.push_back (Simulator::Now ());
+  return true;
+}
+
+void
+PointToPointCompressionEngineTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+
+  // 1000 bytes (payload and PPP header) at 80 kbps take 100 ms to compress
+  Ptr<CompressionCodec> codecA = CreateObject<NullCompressionCodec> ();
+  codecA->SetAttribute ("CompressRate", DataRateValue (DataRate ("80kbps")));
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devA->SetAttribute ("DataRate", DataRateValue (DataRate ("1Gbps")));
+  devA->SetAttribute ("CompressionEnabled", BooleanValue (true));
+  devA->SetAttribute ("CompressionProtocol", IntegerValue (33));
+  devA->SetAttribute ("CompressionEngineEnabled", BooleanValue (true));
+  devA->SetAttribute ("CompressionEngineQueueSize", UintegerValue (2));
+  devA->SetCompressionCodec (codecA);
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devB->SetAttribute ("CompressionEnabled", BooleanValue (true));
+  devB->SetAttribute ("CompressionEngineEnabled", BooleanValue (true));
+  devB->SetCompressionCodec (CreateObject<NullCompressionCodec> ());
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devB->SetReceiveCallback (MakeCallback (&PointToPointCompressionEngineTest::Receive, this));
+
+  Simulator::Schedule (Seconds (1.0), &PointToPointCompressionEngineTest::SendBurst, this, devA, 3);
+
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_accepted, 2, "The engine should have room for two frames only");
+  NS_TEST_ASSERT_MSG_EQ (m_rxTimes.size (), 2, "Both accepted frames should be delivered");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (m_rxTimes[0], Seconds (1.1), "First frame left the engine too early");
+  NS_TEST_EXPECT_MSG_LT (m_rxTimes[0], Seconds (1.11), "First frame was held too long");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_rxTimes[1] - m_rxTimes[0], MilliSeconds (100), MicroSeconds (1),
+                             "Frames should leave the engine one processing time apart");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test class for the adaptive compression mode
+ *
+ * A flow of incompressible datagrams must be bypassed, learned after
+ * AdaptiveLearnThreshold frames and then skipped without estimation for
+ * AdaptiveSkipCount frames, while a compressible flow keeps being
+ * compressed.  Every frame must still reach the peer intact.
+ */
+class PointToPointAdaptiveCompressionTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointAdaptiveCompressionTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send one fake IPv4/UDP datagram to the device specified
+   *
+   * \param device NetDevice to send to
+   * \param port UDP source port, identifying the flow
+   * \param noisy whether the payload is random or all zero
+   */
+  void SendDatagram (Ptr<PointToPointNetDevice> device, uint16_t port, bool noisy);
+
+  /**
+   * \brief AdaptiveDecision trace sink
+   *
+   * \param packet the frame as queued for transmission
+   * \param compressed whether it was compressed
+   * \param bytesSaved bytes saved on the wire
+   * \param cpuTime engine time spent on the frame
+   */
+  void Decision (Ptr<const Packet> packet, bool compressed, int32_t bytesSaved, Time cpuTime);
+
+  /**
+   * \brief Receive callback installed on the receiving device
+   *
+   * \param device the receiving device
+   * \param p the received packet
+   * \param protocol the protocol number of the packet
+   * \param from the sender address
+   * \return always true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  std::vector<bool> m_compressed;   //!< Compression decision of each frame
+  std::vector<Time> m_cpuTime;      //!< Engine time charged for each frame
+  uint32_t m_received;              //!< Frames delivered by the receiver
+  uint32_t m_state;                 //!< Pseudo-random generator state
+};
+
+PointToPointAdaptiveCompressionTest::PointToPointAdaptiveCompressionTest ()
+  : TestCase ("PointToPoint adaptive compression bypass"),
+    m_received (0),
+    m_state (7)
+{
+}
+
+void
+PointToPointAdaptiveCompressionTest::SendDatagram (Ptr<PointToPointNetDevice> device, uint16_t port, bool noisy)
+{
+  std::vector<uint8_t> bytes (1028, 0);
+  const uint8_t header[] = { 0x45, 0, 0x04, 0x04, 0, 0, 0, 0, 64, 17, 0, 0,
+                             10, 1, 1, 1, 10, 1, 2, 2 };
+  std::copy (header, header + sizeof (header), bytes.begin ());
+  bytes[20] = port >> 8;
+  bytes[21] = port & 0xff;
+  bytes[23] = 9;
+  for (std::size_t i = 28; noisy && i < bytes.size (); ++i)
+    {
+      m_state = m_state * 1103515245 + 12345;
+      bytes[i] = static_cast<uint8_t> (m_state >> 16);
+    }
+  device->Send (Create<Packet> (bytes.data (), bytes.size ()), device->GetBroadcast (), 0x800);
+}
+
+void
+PointToPointAdaptiveCompressionTest::Decision (Ptr<const Packet> packet, bool compressed, int32_t bytesSaved, Time cpuTime)
+{
+  m_compressed.push_back (compressed);
+  m_cpuTime.push_back (cpuTime);
+  NS_TEST_EXPECT_MSG_EQ ((bytesSaved > 0), compressed, "Only compressed frames save bytes");
+}
+
+bool
+PointToPointAdaptiveCompressionTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 1028, "Frame altered on the way");
+  m_received++;
+  return true;
+}
+
+void
+PointToPointAdaptiveCompressionTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devA->SetAttribute ("CompressionEnabled", BooleanValue (true));
+  devA->SetAttribute ("CompressionProtocol", IntegerValue (33));
+  devA->SetAttribute ("AdaptiveCompression", BooleanValue (true));
+  devA->SetAttribute ("AdaptiveEstimator", EnumValue (PointToPointNetDevice::ESTIMATE_TRIAL));
+  devA->SetAttribute ("AdaptiveLearnThreshold", UintegerValue (2));
+  devA->SetAttribute ("AdaptiveSkipCount", UintegerValue (2));
+  devA->TraceConnectWithoutContext ("AdaptiveDecision",
+                                    MakeCallback (&PointToPointAdaptiveCompressionTest::Decision, this));
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devB->SetAttribute ("CompressionEnabled", BooleanValue (true));
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devB->SetReceiveCallback (MakeCallback (&PointToPointAdaptiveCompressionTest::Receive, this));
+
+  // five noisy frames of one flow interleaved with compressible frames of another
+  for (uint32_t i = 0; i < 5; ++i)
+    {
+      Simulator::Schedule (Seconds (1.0 + i), &PointToPointAdaptiveCompressionTest::SendDatagram,
+                           this, devA, 1000, true);
+      Simulator::Schedule (Seconds (1.5 + i), &PointToPointAdaptiveCompressionTest::SendDatagram,
+                           this, devA, 2000, false);
+    }
+
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_compressed.size (), 10, "Every frame should be traced");
+  NS_TEST_EXPECT_MSG_EQ (m_received, 10, "Every frame should be delivered");
+  for (uint32_t i = 0; i < 5; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_compressed[2 * i], false, "Noisy frame " << i << " was compressed");
+      NS_TEST_EXPECT_MSG_EQ (m_compressed[2 * i + 1], true, "Zero frame " << i << " was bypassed");
+    }
+  // frames 0 and 1 of the noisy flow are estimated, 2 and 3 skipped, 4 probed again
+  NS_TEST_EXPECT_MSG_GT (m_cpuTime[0], Seconds (0), "First noisy frame should be estimated");
+  NS_TEST_EXPECT_MSG_GT (m_cpuTime[2], Seconds (0), "Second noisy frame should be estimated");
+  NS_TEST_EXPECT_MSG_EQ (m_cpuTime[4], Seconds (0), "Third noisy frame should be skipped");
+  NS_TEST_EXPECT_MSG_EQ (m_cpuTime[6], Seconds (0), "Fourth noisy frame should be skipped");
+  NS_TEST_EXPECT_MSG_GT (m_cpuTime[8], Seconds (0), "Fifth noisy frame should be probed");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test class for the compression filters
+ *
+ * Datagrams matched by a bypass rule, on their destination port or on
+ * their DSCP, must skip a slow compression engine and reach the peer ahead
+ * of a bulk datagram sent before them, which must still be compressed.
+ * The engine only holds that bulk datagram: a second one must be dropped,
+ * but not the bypassed datagrams.  The rules on addresses and protocol are
+ * checked on Classify directly.
+ */
+class PointToPointCompressionFilterTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointCompressionFilterTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Build a fake IPv4 datagram from 10.1.1.1 to 10.1.2.2
+   *
+   * \param protocol the IP protocol number
+   * \param port the destination port
+   * \param dscp the DSCP
+   * \return the datagram
+   */
+  static Ptr<Packet> MakeDatagram (uint8_t protocol, uint16_t port, uint8_t dscp);
+
+  /**
+   * \brief Send a datagram to the device specified
+   *
+   * \param device NetDevice to send to
+   * \param port the UDP destination port
+   * \param dscp the DSCP
+   */
+  void SendDatagram (Ptr<PointToPointNetDevice> device, uint16_t port, uint8_t dscp);
+
+  /**
+   * \brief Receive callback installed on the receiving device
+   *
+   * \param device the receiving device
+   * \param p the received packet
+   * \param protocol the protocol number of the packet
+   * \param from the sender address
+   * \return always true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  std::vector<uint16_t> m_ports;    //!< Destination port of each delivered datagram
+  std::vector<Time> m_rxTimes;      //!< Reception time of each delivered datagram
+};
+
+PointToPointCompressionFilterTest::PointToPointCompressionFilterTest ()
+  : TestCase ("PointToPoint compression filters")
+{
+}
+
+Ptr<Packet>
+PointToPointCompressionFilterTest::MakeDatagram (uint8_t protocol, uint16_t port, uint8_t dscp)
+{
+  std::vector<uint8_t> bytes (998, 0);
+  const uint8_t header[] = { 0x45, 0, 0x03, 0xe6, 0, 0, 0, 0, 64, 17, 0, 0,
+                             10, 1, 1, 1, 10, 1, 2, 2 };
+  std::copy (header, header + sizeof (header), bytes.begin ());
+  bytes[1] = dscp << 2;
+  bytes[9] = protocol;
+  bytes[20] = 0x04;
+  bytes[22] = port >> 8;
+  bytes[23] = port & 0xff;
+  return Create<Packet> (bytes.data (), bytes.size ());
+}
+
+void
+PointToPointCompressionFilterTest::SendDatagram (Ptr<PointToPointNetDevice> device, uint16_t port, uint8_t dscp)
+{
+  device->Send (MakeDatagram (17, port, dscp), device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointCompressionFilterTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  uint8_t buf[24];
+  p->CopyData (buf, sizeof (buf));
+  m_ports.push_back ((buf[22] << 8) | buf[23]);
+  m_rxTimes.push_back (Simulator::Now ());
+  return true;
+}
+
+void
+PointToPointCompressionFilterTest::DoRun (void)
+{
+  Ptr<Ipv4CompressionFilter> filter = CreateObject<Ipv4CompressionFilter> ();
+  Ipv4CompressionFilter::Rule rule;
+  rule.source = Ipv4Address ("10.1.1.0");
+  rule.sourceMask = Ipv4Mask ("255.255.255.0");
+  rule.protocol = 6;
+  rule.action = CompressionFilter::BYPASS;
+  filter->AddRule (rule);
+  rule.source = Ipv4Address ("10.1.3.0");
+  rule.protocol = 17;
+  filter->AddRule (rule);
+  NS_TEST_EXPECT_MSG_EQ (filter->Classify (MakeDatagram (6, 80, 0), 0x800), CompressionFilter::BYPASS,
+                         "TCP from 10.1.1.0/24 should be bypassed");
+  NS_TEST_EXPECT_MSG_EQ (filter->Classify (MakeDatagram (17, 80, 0), 0x800), CompressionFilter::CF_NO_MATCH,
+                         "UDP from 10.1.1.0/24 should match no rule");
+  NS_TEST_EXPECT_MSG_EQ (filter->Classify (MakeDatagram (6, 80, 0), 0x86dd), CompressionFilter::CF_NO_MATCH,
+                         "IPv6 should not be classified");
+
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+
+  // 1000 bytes (payload and PPP header) at 80 kbps take 100 ms to compress
+  Ptr<CompressionCodec> codecA = CreateObject<NullCompressionCodec> ();
+  codecA->SetAttribute ("CompressRate", DataRateValue (DataRate ("80kbps")));
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devA->SetAttribute ("DataRate", DataRateValue (DataRate ("1Gbps")));
+  devA->SetAttribute ("CompressionEnabled", BooleanValue (true));
+  devA->SetAttribute ("CompressionProtocol", IntegerValue (33));
+  devA->SetAttribute ("CompressionEngineEnabled", BooleanValue (true));
+  devA->SetAttribute ("CompressionEngineQueueSize", UintegerValue (1));
+  devA->SetCompressionCodec (codecA);
+  filter = CreateObject<Ipv4CompressionFilter> ();
+  filter->AddPortRule (5000, false, CompressionFilter::BYPASS);
+  filter->AddDscpRule (46, CompressionFilter::BYPASS);
+  devA->AddCompressionFilter (filter);
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devB->SetAttribute ("CompressionEnabled", BooleanValue (true));
+  devB->SetCompressionCodec (CreateObject<NullCompressionCodec> ());
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devB->SetReceiveCallback (MakeCallback (&PointToPointCompressionFilterTest::Receive, this));
+
+  Simulator::Schedule (Seconds (1.0), &PointToPointCompressionFilterTest::SendDatagram, this, devA, 9, 0);
+  Simulator::Schedule (Seconds (1.0), &PointToPointCompressionFilterTest::SendDatagram, this, devA, 11, 0);
+  Simulator::Schedule (Seconds (1.0), &PointToPointCompressionFilterTest::SendDatagram, this, devA, 5000, 0);
+  Simulator::Schedule (Seconds (1.0), &PointToPointCompressionFilterTest::SendDatagram, this, devA, 7, 46);
+
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_ports.size (), 3, "All but the second bulk datagram should be delivered");
+  NS_TEST_EXPECT_MSG_EQ (m_ports[0], 5000, "Port rule should bypass the engine");
+  NS_TEST_EXPECT_MSG_EQ (m_ports[1], 7, "DSCP rule should bypass the engine");
+  NS_TEST_EXPECT_MSG_EQ (m_ports[2], 9, "Bulk datagram should wait for the engine");
+  NS_TEST_EXPECT_MSG_LT (m_rxTimes[1], Seconds (1.01), "Bypassed datagrams were delayed");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (m_rxTimes[2], Seconds (1.1), "Bulk datagram left the engine too early");
+  UintegerValue frames;
+  devA->GetAttribute ("CompressTxFrames", frames);
+  NS_TEST_EXPECT_MSG_EQ (frames.Get (), 1, "Only the bulk datagram should be compressed");
+  devA->GetAttribute ("CompressionBypassedFrames", frames);
+  NS_TEST_EXPECT_MSG_EQ (frames.Get (), 2, "Both filtered datagrams should count as bypassed");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test class for the stateful compression mode
+ *
+ * Repeated payloads must shrink once the stream history holds them, and a
+ * frame lost by the receiver must be detected from its sequence number and
+ * recovered from by resetting the stream.
+ */
+class PointToPointStreamCompressionTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointStreamCompressionTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send one copy of the payload to the device specified
+   *
+   * \param device NetDevice to send to
+   */
+  void SendOne (Ptr<PointToPointNetDevice> device);
+
+  /**
+   * \brief MacTx trace sink recording the size of the frames sent
+   *
+   * \param packet the frame as queued for transmission
+   */
+  void Sent (Ptr<const Packet> packet);
+
+  /**
+   * \brief StreamDesync trace sink
+   *
+   * \param expected the sequence number the receiver expected
+   * \param received the sequence number received
+   */
+  void Desync (uint16_t expected, uint16_t received);
+
+  /**
+   * \brief Receive callback installed on the receiving device
+   *
+   * \param device the receiving device
+   * \param p the received packet
+   * \param protocol the protocol number of the packet
+   * \param from the sender address
+   * \return always true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  std::vector<uint8_t> m_payload;    //!< Payload sent in every frame
+  std::vector<uint32_t> m_sentSizes; //!< Size of each frame on the wire
+  uint32_t m_received;               //!< Frames delivered intact
+  uint32_t m_desyncs;                //!< Desynchronizations reported
+};
+
+PointToPointStreamCompressionTest::PointToPointStreamCompressionTest ()
+  : TestCase ("PointToPoint stateful compression and resynchronization"),
+    m_payload (1000),
+    m_received (0),
+    m_desyncs (0)
+{
+  uint32_t state = 3;
+  for (std::size_t i = 0; i < m_payload.size (); ++i)
+    {
+      state = state * 1103515245 + 12345;
+      m_payload[i] = static_cast<uint8_t> (state >> 16);
+    }
+}
+
+void
+PointToPointStreamCompressionTest::SendOne (Ptr<PointToPointNetDevice> device)
+{
+  device->Send (Create<Packet> (m_payload.data (), m_payload.size ()), device->GetBroadcast (), 0x800);
+}
+
+void
+PointToPointStreamCompressionTest::Sent (Ptr<const Packet> packet)
+{
+  m_sentSizes.push_back (packet->GetSize ());
+}
+
+void
+PointToPointStreamCompressionTest::Desync (uint16_t expected, uint16_t received)
+{
+  m_desyncs++;
+  NS_TEST_EXPECT_MSG_EQ (expected, 2, "Wrong sequence number expected");
+  NS_TEST_EXPECT_MSG_EQ (received, 3, "Wrong sequence number received");
+}
+
+bool
+PointToPointStreamCompressionTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  std::vector<uint8_t> data (p->GetSize ());
+  p->CopyData (data.data (), data.size ());
+  NS_TEST_EXPECT_MSG_EQ ((data == m_payload), true, "Frame altered on the way");
+  m_received++;
+  return true;
+}
+
+void
+PointToPointStreamCompressionTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  for (Ptr<PointToPointNetDevice> dev : { devA, devB })
+    {
+      dev->SetAttribute ("CompressionEnabled", BooleanValue (true));
+      dev->SetAttribute ("CompressionProtocol", IntegerValue (33));
+      dev->SetAttribute ("StatefulCompression", BooleanValue (true));
+    }
+
+  // lose the third frame
+  Ptr<ReceiveListErrorModel> em = CreateObject<ReceiveListErrorModel> ();
+  em->SetList (std::list<uint32_t> (1, 2));
+  devB->SetReceiveErrorModel (em);
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devA->TraceConnectWithoutContext ("MacTx", MakeCallback (&PointToPointStreamCompressionTest::Sent, this));
+  devB->TraceConnectWithoutContext ("StreamDesync", MakeCallback (&PointToPointStreamCompressionTest::Desync, this));
+  devB->SetReceiveCallback (MakeCallback (&PointToPointStreamCompressionTest::Receive, this));
+
+  for (uint32_t i = 0; i < 6; ++i)
+    {
+      Simulator::Schedule (Seconds (1.0 + i), &PointToPointStreamCompressionTest::SendOne, this, devA);
+    }
+
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_sentSizes.size (), 6, "Every frame should be sent");
+  NS_TEST_EXPECT_MSG_LT (m_sentSizes[1], m_payload.size () / 10, "Second copy should refer to the first");
+  NS_TEST_EXPECT_MSG_EQ (m_desyncs, 1, "The lost frame should be detected once");
+  // frame 3 arrives out of sequence, frame 4 restarts the stream
+  NS_TEST_EXPECT_MSG_EQ (m_received, 4, "Frames 0, 1, 4 and 5 should be delivered");
+  NS_TEST_EXPECT_MSG_GT (m_sentSizes[4], m_payload.size (), "Frame 4 should restart the stream");
+  NS_TEST_EXPECT_MSG_LT (m_sentSizes[5], m_payload.size () / 10, "Frame 5 should refer to frame 4");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test class for the aggregation mode
+ *
+ * A burst of small datagrams must leave the device as super-frames of at
+ * most AggregationMaxFrames frames and reach the peer as the original
+ * datagrams, in order.
+ */
+class PointToPointAggregationTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   *
+   * \param timeout the AggregationTimeout of the sender
+   * \param stateful whether to compress in stream mode
+   * \param expected the number of frames expected in each super-frame
+   */
+  PointToPointAggregationTest (Time timeout, bool stateful, std::vector<uint32_t> expected);
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send one small datagram to the device specified
+   *
+   * \param device NetDevice to send to
+   * \param index position of the datagram in the burst
+   */
+  void SendOne (Ptr<PointToPointNetDevice> device, uint8_t index);
+
+  /**
+   * \brief Aggregate trace sink
+   *
+   * \param packet the compressed super-frame
+   * \param frames the number of frames it carries
+   */
+  void Aggregated (Ptr<const Packet> packet, uint32_t frames);
+
+  /**
+   * \brief Receive callback installed on the receiving device
+   *
+   * \param device the receiving device
+   * \param p the received packet
+   * \param protocol the protocol number of the packet
+   * \param from the sender address
+   * \return always true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  Time m_timeout;                   //!< AggregationTimeout of the sender
+  bool m_stateful;                  //!< Whether to compress in stream mode
+  std::vector<uint32_t> m_expected; //!< Expected frames per super-frame
+  std::vector<uint32_t> m_frames;   //!< Frames per super-frame sent
+  std::vector<uint8_t> m_received;  //!< Index of each datagram received
+};
+
+PointToPointAggregationTest::PointToPointAggregationTest (Time timeout, bool stateful,
+                                                          std::vector<uint32_t> expected)
+  : TestCase ("PointToPoint frame aggregation, timeout " + std::to_string (timeout.GetMilliSeconds ())
+              + " ms" + (stateful ? ", stateful" : "")),
+    m_timeout (timeout),
+    m_stateful (stateful),
+    m_expected (expected)
+{
+}
+
+void
+PointToPointAggregationTest::SendOne (Ptr<PointToPointNetDevice> device, uint8_t index)
+{
+  std::vector<uint8_t> payload (100, index);
+  device->Send (Create<Packet> (payload.data (), payload.size ()), device->GetBroadcast (), 0x800);
+}
+
+void
+PointToPointAggregationTest::Aggregated (Ptr<const Packet> packet, uint32_t frames)
+{
+  m_frames.push_back (frames);
+}
+
+bool
+PointToPointAggregationTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  std::vector<uint8_t> data (p->GetSize ());
+  p->CopyData (data.data (), data.size ());
+  NS_TEST_EXPECT_MSG_EQ (protocol, 0x800, "Wrong protocol");
+  NS_TEST_EXPECT_MSG_EQ ((data == std::vector<uint8_t> (100, data[0])), true, "Datagram altered");
+  m_received.push_back (data[0]);
+  return true;
+}
+
+void
+PointToPointAggregationTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  for (Ptr<PointToPointNetDevice> dev : { devA, devB })
+    {
+      dev->SetAttribute ("CompressionEnabled", BooleanValue (true));
+      dev->SetAttribute ("CompressionProtocol", IntegerValue (33));
+      dev->SetAttribute ("StatefulCompression", BooleanValue (m_stateful));
+    }
+  devA->SetAttribute ("AggregationEnabled", BooleanValue (true));
+  devA->SetAttribute ("AggregationMaxFrames", UintegerValue (4));
+  devA->SetAttribute ("AggregationTimeout", TimeValue (m_timeout));
+  devA->TraceConnectWithoutContext ("Aggregate", MakeCallback (&PointToPointAggregationTest::Aggregated, this));
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devB->SetReceiveCallback (MakeCallback (&PointToPointAggregationTest::Receive, this));
+
+  for (uint8_t i = 0; i < 10; ++i)
+    {
+      Simulator::Schedule (Seconds (1), &PointToPointAggregationTest::SendOne, this, devA, i);
+    }
+
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ ((m_frames == m_expected), true, "Unexpected super-frame sizes");
+  NS_TEST_ASSERT_MSG_EQ (m_received.size (), 10, "Every datagram should be delivered");
+  for (uint8_t i = 0; i < 10; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (static_cast<uint32_t> (m_received[i]), i, "Datagram out of order");
+    }
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test class for IPv4/UDP header compression
+ *
+ * Two UDP flows cross the link.  The first datagram of each flow must carry
+ * its full headers and the following ones compressed headers; every
+ * datagram delivered must be identical to the one sent.  The first frame is
+ * lost, so the decompressor has to report the missing context and the
+ * compressor has to send the next header of that flow in full.
+ *
+ * In the second scenario two sources of 192.168.0.0/16 send to the same
+ * destination and ports, and each must keep its own context.
+ */
+class PointToPointHeaderCompressionTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   *
+   * \param twoSources whether to run the scenario with two sources
+   */
+  PointToPointHeaderCompressionTest (bool twoSources);
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Build an IPv4/UDP datagram
+   *
+   * \param port the UDP destination port, which tells the flows apart
+   * \param id the IP identification
+   * \param udpChecksum the UDP checksum, 0 if unused
+   * \param source the IP source address
+   * \param destination the IP destination address
+   * \return the datagram
+   */
+  static std::vector<uint8_t> MakeDatagram (uint16_t port, uint16_t id, uint16_t udpChecksum,
+                                            Ipv4Address source, Ipv4Address destination);
+
+  /**
+   * \brief Send one datagram to the device specified
+   *
+   * \param device NetDevice to send to
+   * \param datagram the datagram
+   */
+  void SendOne (Ptr<PointToPointNetDevice> device, std::vector<uint8_t> datagram);
+
+  /**
+   * \brief HeaderCompression trace sink
+   *
+   * \param packet the frame queued
+   * \param bytesSaved the bytes saved by header compression
+   */
+  void Compressed (Ptr<const Packet> packet, int32_t bytesSaved);
+
+  /**
+   * \brief Receive callback installed on the receiving device
+   *
+   * \param device the receiving device
+   * \param p the received packet
+   * \param protocol the protocol number of the packet
+   * \param from the sender address
+   * \return always true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  bool m_twoSources;                             //!< Whether two sources share a destination
+  std::vector<int32_t> m_saved;                  //!< Bytes saved per datagram sent
+  std::vector<std::vector<uint8_t> > m_sent;     //!< Datagrams sent
+  std::vector<std::vector<uint8_t> > m_received; //!< Datagrams received
+};
+
+PointToPointHeaderCompressionTest::PointToPointHeaderCompressionTest (bool twoSources)
+  : TestCase (twoSources ? "PointToPoint IPv4 and UDP header compression, two sources"
+              : "PointToPoint IPv4 and UDP header compression"),
+    m_twoSources (twoSources)
+{
+}
+
+std::vector<uint8_t>
+PointToPointHeaderCompressionTest::MakeDatagram (uint16_t port, uint16_t id, uint16_t udpChecksum,
+                                                 Ipv4Address source, Ipv4Address destination)
+{
+  std::vector<uint8_t> d (128, static_cast<uint8_t> (id));
+  uint8_t header[28] = {
+    0x45, 0, 0, 128, static_cast<uint8_t> (id >> 8), static_cast<uint8_t> (id), 0x40, 0,
+    64, 17, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0x30, 0x39, static_cast<uint8_t> (port >> 8), static_cast<uint8_t> (port), 0, 108,
+    static_cast<uint8_t> (udpChecksum >> 8), static_cast<uint8_t> (udpChecksum)
+  };
+  source.Serialize (header + 12);
+  destination.Serialize (header + 16);
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < 20; i += 2)
+    {
+      sum += (header[i] << 8) | header[i + 1];
+    }
+  sum = (sum & 0xffff) + (sum >> 16);
+  sum = ~((sum & 0xffff) + (sum >> 16));
+  header[10] = (sum >> 8) & 0xff;
+  header[11] = sum & 0xff;
+  std::copy (header, header + 28, d.begin ());
+  return d;
+}
+
+void
+PointToPointHeaderCompressionTest::SendOne (Ptr<PointToPointNetDevice> device, std::vector<uint8_t> datagram)
+{
+  m_sent.push_back (datagram);
+  device->Send (Create<Packet> (datagram.data (), datagram.size ()), device->GetBroadcast (), 0x800);
+}
+
+void
+PointToPointHeaderCompressionTest::Compressed (Ptr<const Packet> packet, int32_t bytesSaved)
+{
+  m_saved.push_back (bytesSaved);
+}
+
+bool
+PointToPointHeaderCompressionTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  std::vector<uint8_t> data (p->GetSize ());
+  p->CopyData (data.data (), data.size ());
+  NS_TEST_EXPECT_MSG_EQ (protocol, 0x800, "Wrong protocol");
+  m_received.push_back (data);
+  return true;
+}
+
+void
+PointToPointHeaderCompressionTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devA->SetAttribute ("HeaderCompression", BooleanValue (true));
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devA->TraceConnectWithoutContext ("HeaderCompression", MakeCallback (&PointToPointHeaderCompressionTest::Compressed, this));
+  devB->SetReceiveCallback (MakeCallback (&PointToPointHeaderCompressionTest::Receive, this));
+
+  if (m_twoSources)
+    {
+      // the destination address and a port above 0x7fff, whose high bits
+      // once overwrote the source address in the flow key
+      Ipv4Address sources[4] = { "192.168.1.1", "192.168.2.1", "192.168.1.1", "192.168.2.1" };
+      for (uint32_t i = 0; i < 4; ++i)
+        {
+          Simulator::Schedule (Seconds (1.0 + i), &PointToPointHeaderCompressionTest::SendOne, this, devA,
+                               MakeDatagram (0x9000, 100 + i, 0, sources[i], Ipv4Address ("192.168.3.1")));
+        }
+      Simulator::Run ();
+
+      // a full header per source, then compressed ones
+      int32_t saved[4] = { -2, -2, 25, 25 };
+      NS_TEST_ASSERT_MSG_EQ (m_saved.size (), 4, "Every datagram should be header compressed");
+      for (uint32_t i = 0; i < 4; ++i)
+        {
+          NS_TEST_EXPECT_MSG_EQ (m_saved[i], saved[i], "Unexpected header size of datagram " << i);
+        }
+      NS_TEST_ASSERT_MSG_EQ (m_received.size (), 4, "Every datagram should be delivered");
+      for (uint32_t i = 0; i < 4; ++i)
+        {
+          NS_TEST_EXPECT_MSG_EQ ((m_received[i] == m_sent[i]), true, "Datagram " << i << " altered");
+        }
+      Simulator::Destroy ();
+      return;
+    }
+
+  // lose the first full header
+  Ptr<ReceiveListErrorModel> em = CreateObject<ReceiveListErrorModel> ();
+  em->SetList (std::list<uint32_t> (1, 0));
+  devB->SetReceiveErrorModel (em);
+
+  uint16_t ports[6] = { 1000, 1000, 2000, 1000, 2000, 1000 };
+  uint16_t checksums[6] = { 0, 0, 0, 0, 0, 0xbeef };
+  for (uint32_t i = 0; i < 6; ++i)
+    {
+      Simulator::Schedule (Seconds (1.0 + i), &PointToPointHeaderCompressionTest::SendOne, this, devA,
+                           MakeDatagram (ports[i], 100 + i, checksums[i],
+                                         Ipv4Address ("10.1.1.1"), Ipv4Address ("10.1.1.2")));
+    }
+
+  Simulator::Run ();
+
+  // full, compressed (unknown to the peer), full, full (refreshed),
+  // compressed, compressed with UDP checksum
+  int32_t saved[6] = { -2, 25, -2, -2, 25, 23 };
+  NS_TEST_ASSERT_MSG_EQ (m_saved.size (), 6, "Every datagram should be header compressed");
+  for (uint32_t i = 0; i < 6; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_saved[i], saved[i], "Unexpected header size of datagram " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_received.size (), 4, "Datagrams 2 to 5 should be delivered");
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((m_received[i] == m_sent[i + 2]), true, "Datagram " << i + 2 << " altered");
+    }
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test class for the compression statistics
+ *
+ * Compressible and random frames cross a link in adaptive mode.  The
+ * CompressTx, CompressionBypassed and DecompressRx traces must fire for
+ * the right frames, the counters must add up to what the traces reported,
+ * and the summary written at Simulator::Destroy must hold them.
+ */
+class PointToPointCompressionStatsTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointCompressionStatsTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send one packet to the device specified
+   *
+   * \param device NetDevice to send to
+   * \param noisy whether the payload is random or all zero
+   */
+  void SendOne (Ptr<PointToPointNetDevice> device, bool noisy);
+
+  /**
+   * \brief CompressTx trace sink
+   *
+   * \param packet the compressed frame
+   * \param originalSize size before compression
+   * \param compressedSize size after compression
+   * \param codecTime codec time
+   */
+  void CompressTx (Ptr<const Packet> packet, uint32_t originalSize, uint32_t compressedSize, Time codecTime);
+
+  /**
+   * \brief CompressionBypassed trace sink
+   *
+   * \param packet the frame sent uncompressed
+   */
+  void Bypassed (Ptr<const Packet> packet);
+
+  /**
+   * \brief DecompressRx trace sink
+   *
+   * \param packet the frame restored
+   * \param compressedSize size as received
+   * \param decompressedSize size once restored
+   * \param codecTime codec time
+   */
+  void DecompressRx (Ptr<const Packet> packet, uint32_t compressedSize, uint32_t decompressedSize, Time codecTime);
+
+  uint32_t m_txFrames;      //!< Frames reported by CompressTx
+  uint64_t m_txOriginal;    //!< Bytes before compression reported by CompressTx
+  uint64_t m_txCompressed;  //!< Bytes after compression reported by CompressTx
+  Time m_txTime;            //!< Codec time reported by CompressTx
+  uint32_t m_bypassed;      //!< Frames reported by CompressionBypassed
+  uint32_t m_rxFrames;      //!< Frames reported by DecompressRx
+  uint64_t m_rxCompressed;  //!< Bytes as received reported by DecompressRx
+  uint32_t m_state;         //!< Pseudo-random generator state
+};
+
+PointToPointCompressionStatsTest::PointToPointCompressionStatsTest ()
+  : TestCase ("PointToPoint compression statistics"),
+    m_txFrames (0),
+    m_txOriginal (0),
+    m_txCompressed (0),
+    m_bypassed (0),
+    m_rxFrames (0),
+    m_rxCompressed (0),
+    m_state (11)
+{
+}
+
+void
+PointToPointCompressionStatsTest::SendOne (Ptr<PointToPointNetDevice> device, bool noisy)
+{
+  std::vector<uint8_t> payload (1000, 0);
+  for (std::size_t i = 0; noisy && i < payload.size (); ++i)
+    {
+      m_state = m_state * 1103515245 + 12345;
+      payload[i] = static_cast<uint8_t> (m_state >> 16);
+    }
+  device->Send (Create<Packet> (payload.data (), payload.size ()), device->GetBroadcast (), 0x800);
+}
+
+void
+PointToPointCompressionStatsTest::CompressTx (Ptr<const Packet> packet, uint32_t originalSize, uint32_t compressedSize, Time codecTime)
+{
+  NS_TEST_EXPECT_MSG_EQ (compressedSize, packet->GetSize (), "Wrong compressed size");
+  m_txFrames++;
+  m_txOriginal += originalSize;
+  m_txCompressed += compressedSize;
+  m_txTime += codecTime;
+}
+
+void
+PointToPointCompressionStatsTest::Bypassed (Ptr<const Packet> packet)
+{
+  m_bypassed++;
+}
+
+void
+PointToPointCompressionStatsTest::DecompressRx (Ptr<const Packet> packet, uint32_t compressedSize, uint32_t decompressedSize, Time codecTime)
+{
+  NS_TEST_EXPECT_MSG_EQ (decompressedSize, packet->GetSize (), "Wrong decompressed size");
+  m_rxFrames++;
+  m_rxCompressed += compressedSize;
+}
+
+void
+PointToPointCompressionStatsTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  for (Ptr<PointToPointNetDevice> dev : { devA, devB })
+    {
+      dev->SetAttribute ("CompressionEnabled", BooleanValue (true));
+      dev->SetAttribute ("CompressionProtocol", IntegerValue (33));
+    }
+  devA->SetAttribute ("AdaptiveCompression", BooleanValue (true));
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devA->TraceConnectWithoutContext ("CompressTx", MakeCallback (&PointToPointCompressionStatsTest::CompressTx, this));
+  devA->TraceConnectWithoutContext ("CompressionBypassed", MakeCallback (&PointToPointCompressionStatsTest::Bypassed, this));
+  devB->TraceConnectWithoutContext ("DecompressRx", MakeCallback (&PointToPointCompressionStatsTest::DecompressRx, this));
+
+  NetDeviceContainer devices;
+  devices.Add (devA);
+  devices.Add (devB);
+  std::string summary = CreateTempDirFilename ("compression-summary.csv");
+  PointToPointHelper::EnableCompressionSummary (summary, devices);
+
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      Simulator::Schedule (Seconds (1.0 + i), &PointToPointCompressionStatsTest::SendOne, this, devA, i % 2);
+    }
+
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_txFrames, 2, "Both zero frames should be compressed");
+  NS_TEST_EXPECT_MSG_EQ (m_bypassed, 2, "Both random frames should be sent as is");
+  NS_TEST_EXPECT_MSG_EQ (m_rxFrames, 2, "Both compressed frames should be restored");
+  NS_TEST_EXPECT_MSG_EQ (m_txOriginal, 2 * 1002, "Wrong original bytes");
+  NS_TEST_EXPECT_MSG_EQ (m_rxCompressed, m_txCompressed, "Peers disagree on compressed bytes");
+
+  UintegerValue value;
+  TimeValue time;
+  devA->GetAttribute ("CompressTxFrames", value);
+  NS_TEST_EXPECT_MSG_EQ (value.Get (), m_txFrames, "Wrong CompressTxFrames");
+  devA->GetAttribute ("CompressTxOriginalBytes", value);
+  NS_TEST_EXPECT_MSG_EQ (value.Get (), m_txOriginal, "Wrong CompressTxOriginalBytes");
+  devA->GetAttribute ("CompressTxCompressedBytes", value);
+  NS_TEST_EXPECT_MSG_EQ (value.Get (), m_txCompressed, "Wrong CompressTxCompressedBytes");
+  devA->GetAttribute ("CompressTxCodecTime", time);
+  NS_TEST_EXPECT_MSG_EQ (time.Get (), m_txTime, "Wrong CompressTxCodecTime");
+  NS_TEST_EXPECT_MSG_GT (time.Get (), Seconds (0), "Compression should cost codec time");
+  devA->GetAttribute ("CompressionBypassedFrames", value);
+  NS_TEST_EXPECT_MSG_EQ (value.Get (), m_bypassed, "Wrong CompressionBypassedFrames");
+  devB->GetAttribute ("DecompressRxFrames", value);
+  NS_TEST_EXPECT_MSG_EQ (value.Get (), m_rxFrames, "Wrong DecompressRxFrames");
+  devB->GetAttribute ("DecompressRxDecompressedBytes", value);
+  NS_TEST_EXPECT_MSG_EQ (value.Get (), m_txOriginal, "Wrong DecompressRxDecompressedBytes");
+
+  Simulator::Destroy ();
+
+  std::ifstream csv (summary.c_str ());
+  std::vector<std::string> lines;
+  std::string line;
+  while (std::getline (csv, line))
+    {
+      lines.push_back (line);
+    }
+  NS_TEST_ASSERT_MSG_EQ (lines.size (), 3, "Summary should have a header and a line per device");
+  std::ostringstream sender;
+  sender << a->GetId () << "," << devA->GetIfIndex () << ",ns3::ZlibCompressionCodec,2,2004," << m_txCompressed << ",";
+  NS_TEST_EXPECT_MSG_EQ (lines[1].substr (0, sender.str ().size ()), sender.str (), "Wrong sender line");
+}
+
+/**
+ * \brief Test class for the binary trace
+ *
+ * Compressible frames cross a compression link logged to a binary trace.
+ * The trace must hold a TX and an RX record per frame, with the size
+ * before compression and on the wire and the first bytes of the frame,
+ * and convert to a pcap file per device.
+ */
+class PointToPointBinaryTraceTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointBinaryTraceTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send one all-zero packet to the device specified
+   *
+   * \param device NetDevice to send to
+   */
+  void SendOne (Ptr<PointToPointNetDevice> device);
+};
+
+PointToPointBinaryTraceTest::PointToPointBinaryTraceTest ()
+  : TestCase ("PointToPoint binary trace")
+{
+}
+
+void
+PointToPointBinaryTraceTest::SendOne (Ptr<PointToPointNetDevice> device)
+{
+  device->Send (Create<Packet> (1000), device->GetBroadcast (), 0x800);
+}
+
+void
+PointToPointBinaryTraceTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  for (Ptr<PointToPointNetDevice> dev : { devA, devB })
+    {
+      dev->SetAttribute ("CompressionEnabled", BooleanValue (true));
+      dev->SetAttribute ("CompressionProtocol", IntegerValue (33));
+    }
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+
+  NetDeviceContainer devices;
+  devices.Add (devA);
+  devices.Add (devB);
+  std::string filename = CreateTempDirFilename ("binary.trace");
+  PointToPointHelper::EnableBinaryTrace (filename, devices, 4);
+
+  Simulator::Schedule (Seconds (1.0), &PointToPointBinaryTraceTest::SendOne, this, devA);
+  Simulator::Schedule (Seconds (2.0), &PointToPointBinaryTraceTest::SendOne, this, devA);
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  std::ifstream is (filename.c_str (), std::ios::in | std::ios::binary);
+  uint32_t snaplen;
+  NS_TEST_ASSERT_MSG_EQ (PointToPointBinaryTrace::ReadHeader (is, snaplen), true, "Bad header");
+  NS_TEST_EXPECT_MSG_EQ (snaplen, 4, "Wrong snap length");
+  std::vector<PointToPointBinaryTrace::Record> records;
+  PointToPointBinaryTrace::Record record;
+  while (PointToPointBinaryTrace::ReadRecord (is, record))
+    {
+      records.push_back (record);
+    }
+  NS_TEST_ASSERT_MSG_EQ (records.size (), 4, "Expected a TX and an RX record per frame");
+  for (uint32_t i = 0; i < records.size (); ++i)
+    {
+      bool tx = i % 2 == 0;
+      uint32_t event = tx ? PointToPointBinaryTrace::TX : PointToPointBinaryTrace::RX;
+      uint32_t node = tx ? a->GetId () : b->GetId ();
+      NS_TEST_EXPECT_MSG_EQ (static_cast<uint32_t> (records[i].event), event, "Wrong event");
+      NS_TEST_EXPECT_MSG_EQ (records[i].node, node, "Wrong node");
+      NS_TEST_EXPECT_MSG_EQ (records[i].originalSize, 1002, "Wrong original size");
+      NS_TEST_EXPECT_MSG_LT (records[i].wireSize, 100, "Frame should be compressed on the wire");
+      NS_TEST_EXPECT_MSG_EQ (records[i].data.size (), 4, "Wrong number of frame bytes");
+    }
+  NS_TEST_EXPECT_MSG_EQ (records[0].time, Seconds (1.0), "Wrong TX time");
+  NS_TEST_EXPECT_MSG_GT (records[1].time, records[0].time, "RX before TX");
+
+  std::string prefix = CreateTempDirFilename ("binary");
+  NS_TEST_EXPECT_MSG_EQ (PointToPointBinaryTrace::ConvertToPcap (filename, prefix), 4, "Wrong number of frames converted");
+  std::ostringstream pcap;
+  pcap << prefix << "-" << a->GetId () << "-" << devA->GetIfIndex () << ".pcap";
+  std::ifstream converted (pcap.str ().c_str ());
+  NS_TEST_EXPECT_MSG_EQ (converted.is_open (), true, "Missing pcap file of the sender");
+}
+
+/**
+ * \brief Test class for compression offloaded to the worker pool
+ *
+ * Several links send bursts of frames both ways at the same instants
+ * with their compression offloaded, so that the devices decompress while
+ * the workers compress.  The frames sent and delivered, and when, must
+ * not depend on the number of worker threads, and must be those of the
+ * codecs, set to a non default level, run without offload.
+ */
+class PointToPointCompressionOffloadTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   *
+   * \param engine whether the compression engine latency is modelled
+   */
+  PointToPointCompressionOffloadTest (bool engine);
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Run the scenario once
+   *
+   * \param threads the number of worker threads
+   * \param offload whether the compression is offloaded
+   * \return a line per frame sent and per frame delivered, in event order
+   */
+  std::vector<std::string> RunScenario (uint32_t threads, bool offload);
+
+  /**
+   * \brief Send a burst of frames to the device specified
+   *
+   * \param device NetDevice to send to
+   * \param seed first value of the generator of the payloads
+   */
+  void SendBurst (Ptr<PointToPointNetDevice> device, uint32_t seed);
+
+  /**
+   * \brief MacTx trace sink of the senders
+   *
+   * \param test the test case
+   * \param link index of the link
+   * \param packet the frame queued
+   */
+  static void Sent (PointToPointCompressionOffloadTest *test, uint32_t link, Ptr<const Packet> packet);
+
+  /**
+   * \brief Receive callback installed on the receiving devices
+   *
+   * \param test the test case
+   * \param link index of the link
+   * \param device the receiving device
+   * \param p the received packet
+   * \param protocol the protocol number of the packet
+   * \param from the sender address
+   * \return always true
+   */
+  static bool Receive (PointToPointCompressionOffloadTest *test, uint32_t link, Ptr<NetDevice> device,
+                       Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  bool m_engine;                  //!< Whether the compression engine is modelled
+  std::vector<std::string> m_log; //!< Frames sent and delivered
+};
+
+PointToPointCompressionOffloadTest::PointToPointCompressionOffloadTest (bool engine)
+  : TestCase (std::string ("PointToPoint compression offload") + (engine ? ", with engine latency" : "")),
+    m_engine (engine)
+{
+}
+
+void
+PointToPointCompressionOffloadTest::SendBurst (Ptr<PointToPointNetDevice> device, uint32_t seed)
+{
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      // words of a small alphabet compress to varying sizes
+      std::vector<uint8_t> payload (600 + 100 * i);
+      uint32_t state = seed + i;
+      for (std::size_t j = 0; j < payload.size (); ++j)
+        {
+          state = state * 1103515245 + 12345;
+          payload[j] = 'a' + (state >> 16) % (2 + seed % 20);
+        }
+      device->Send (Create<Packet> (payload.data (), payload.size ()), device->GetBroadcast (), 0x800);
+    }
+}
+
+void
+PointToPointCompressionOffloadTest::Sent (PointToPointCompressionOffloadTest *test, uint32_t link, Ptr<const Packet> packet)
+{
+  std::ostringstream oss;
+  oss << Simulator::Now ().GetTimeStep () << " tx " << link << " " << packet->GetSize ();
+  test->m_log.push_back (oss.str ());
+}
+
+bool
+PointToPointCompressionOffloadTest::Receive (PointToPointCompressionOffloadTest *test, uint32_t link, Ptr<NetDevice> device,
+                                             Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  std::vector<uint8_t> data (p->GetSize ());
+  p->CopyData (data.data (), data.size ());
+  std::ostringstream oss;
+  oss << Simulator::Now ().GetTimeStep () << " rx " << link << " "
+      << std::string (data.begin (), data.end ());
+  test->m_log.push_back (oss.str ());
+  return true;
+}
+
+std::vector<std::string>
+PointToPointCompressionOffloadTest::RunScenario (uint32_t threads, bool offload)
+{
+  Config::SetGlobal ("CompressionWorkerThreads", UintegerValue (threads));
+  m_log.clear ();
+  for (uint32_t link = 0; link < 8; ++link)
+    {
+      Ptr<Node> a = CreateObject<Node> ();
+      Ptr<Node> b = CreateObject<Node> ();
+      Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+      Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+      Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+
+      devA->Attach (channel);
+      devA->SetAddress (Mac48Address::Allocate ());
+      devA->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+      devB->Attach (channel);
+      devB->SetAddress (Mac48Address::Allocate ());
+      devB->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+      for (Ptr<PointToPointNetDevice> dev : { devA, devB })
+        {
+          dev->SetAttribute ("CompressionEnabled", BooleanValue (true));
+          dev->SetAttribute ("CompressionProtocol", IntegerValue (33));
+          dev->SetAttribute ("CompressionEngineEnabled", BooleanValue (m_engine));
+          dev->SetAttribute ("CompressionOffload", BooleanValue (offload));
+          Ptr<ZlibCompressionCodec> codec = CreateObject<ZlibCompressionCodec> ();
+          codec->SetAttribute ("Level", IntegerValue (1));
+          dev->SetCompressionCodec (codec);
+        }
+
+      a->AddDevice (devA);
+      b->AddDevice (devB);
+      // the frames from b to a are logged as those of link + 8
+      devA->TraceConnectWithoutContext ("MacTx", MakeBoundCallback (&PointToPointCompressionOffloadTest::Sent, this, link));
+      devB->SetReceiveCallback (MakeBoundCallback (&PointToPointCompressionOffloadTest::Receive, this, link));
+      devB->TraceConnectWithoutContext ("MacTx", MakeBoundCallback (&PointToPointCompressionOffloadTest::Sent, this, link + 8));
+      devA->SetReceiveCallback (MakeBoundCallback (&PointToPointCompressionOffloadTest::Receive, this, link + 8));
+
+      for (uint32_t burst = 0; burst < 3; ++burst)
+        {
+          Simulator::Schedule (Seconds (1.0 + burst), &PointToPointCompressionOffloadTest::SendBurst,
+                               this, devA, link * 7 + burst);
+          Simulator::Schedule (Seconds (1.0 + burst) + MicroSeconds (300), &PointToPointCompressionOffloadTest::SendBurst,
+                               this, devB, link * 11 + burst);
+        }
+    }
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+  Config::SetGlobal ("CompressionWorkerThreads", UintegerValue (0));
+  return m_log;
+}
+
+void
+PointToPointCompressionOffloadTest::DoRun (void)
+{
+  std::vector<std::string> serial = RunScenario (0, true);
+  NS_TEST_ASSERT_MSG_EQ (serial.size (), 2 * 2 * 8 * 3 * 4, "Every frame should be sent and delivered");
+  uint32_t compressed = 0;
+  for (std::size_t i = 0; i < serial.size (); ++i)
+    {
+      std::istringstream iss (serial[i]);
+      int64_t ts;
+      std::string direction;
+      uint32_t link, size;
+      iss >> ts >> direction >> link >> size;
+      if (direction == "tx" && size < 600)
+        {
+          compressed++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_GT (compressed, 0, "Offloaded frames should be compressed");
+
+  std::vector<std::string> parallel = RunScenario (4, true);
+  NS_TEST_ASSERT_MSG_EQ (parallel.size (), serial.size (), "Thread count changed the frames");
+  for (std::size_t i = 0; i < serial.size (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (parallel[i], serial[i], "Thread count changed event " << i);
+    }
+
+  // offloaded frames are traced when they are compressed, instead of
+  // before the compression engine latency, so only the frames are compared
+  std::vector<std::string> direct = RunScenario (0, false);
+  NS_TEST_ASSERT_MSG_EQ (direct.size (), serial.size (), "Offload changed the frames");
+  std::multiset<std::string> directFrames, offloadedFrames;
+  for (std::size_t i = 0; i < serial.size (); ++i)
+    {
+      directFrames.insert (direct[i].substr (direct[i].find (' ')));
+      offloadedFrames.insert (serial[i].substr (serial[i].find (' ')));
+    }
+  NS_TEST_EXPECT_MSG_EQ ((directFrames == offloadedFrames), true,
+                         "The offload codec should be set like the codec of the device");
+}
+
+#ifdef NS3_MULTITHREADED
+/**
+ * \brief Test class for the multithreaded simulator
+ *
+ * Frames cross a chain of nodes spread over several systems, each node
+ * appending its index to the frames it forwards.  The frames delivered
+ * to each node, and when, must be the same with the default simulator
+ * and with the multithreaded one, which simulates each system in a
+ * thread of its own.
+ */
+class PointToPointMultithreadedTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointMultithreadedTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Run the scenario once
+   *
+   * \param simulator the SimulatorImplementationType to use
+   * \param stop the delay of a Stop called by an event of the first
+   * node, or zero to stop at 5s from before the run
+   * \return a line per frame delivered, node after node
+   */
+  std::vector<std::string> RunScenario (std::string simulator, Time stop);
+
+  /**
+   * \brief Stop the simulation from an event
+   *
+   * \param delay the delay of the stop
+   */
+  static void StopAfter (Time delay);
+
+  /**
+   * \brief Send a burst of frames on every device of a node
+   *
+   * \param node the sending node
+   * \param index index of the node in the chain
+   */
+  static void SendBurst (Ptr<Node> node, uint32_t index);
+
+  /**
+   * \brief Receive callback installed on every device
+   *
+   * \param test the test case
+   * \param index index of the receiving node in the chain
+   * \param device the receiving device
+   * \param p the received packet
+   * \param protocol the protocol number of the packet
+   * \param from the sender address
+   * \return always true
+   */
+  static bool Receive (PointToPointMultithreadedTest *test, uint32_t index, Ptr<NetDevice> device,
+                       Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  bool m_checkSystem;                           //!< Whether the system id of the thread is checked
+  std::vector<std::vector<std::string> > m_logs; //!< Frames delivered to each node
+  std::vector<uint32_t> m_wrongSystem;          //!< Frames handled by another system, per node
+};
+
+PointToPointMultithreadedTest::PointToPointMultithreadedTest ()
+  : TestCase ("PointToPoint links between the systems of a multithreaded simulation"),
+    m_checkSystem (false)
+{
+}
+
+void
+PointToPointMultithreadedTest::SendBurst (Ptr<Node> node, uint32_t index)
+{
+  for (uint32_t i = 0; i < node->GetNDevices (); ++i)
+    {
+      Ptr<NetDevice> device = node->GetDevice (i);
+      for (uint32_t j = 0; j < 5; ++j)
+        {
+          std::string payload = std::string (200 + 10 * j, 'A' + index) + char ('0' + i);
+          device->Send (Create<Packet> (reinterpret_cast<const uint8_t *> (payload.data ()), payload.size ()),
+                        device->GetBroadcast (), 0x800);
+        }
+    }
+}
+
+bool
+PointToPointMultithreadedTest::Receive (PointToPointMultithreadedTest *test, uint32_t index, Ptr<NetDevice> device,
+                                        Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  Ptr<Node> node = device->GetNode ();
+  if (test->m_checkSystem && Simulator::GetSystemId () != node->GetSystemId ())
+    {
+      test->m_wrongSystem[index]++;
+    }
+  std::vector<uint8_t> data (p->GetSize ());
+  p->CopyData (data.data (), data.size ());
+  std::ostringstream oss;
+  oss << index << " " << Simulator::Now ().GetTimeStep () << " "
+      << std::string (data.begin () + 195, data.end ());
+  test->m_logs[index].push_back (oss.str ());
+
+  for (uint32_t i = 0; i < node->GetNDevices (); ++i)
+    {
+      Ptr<NetDevice> next = node->GetDevice (i);
+      if (next != device)
+        {
+          Ptr<Packet> copy = p->Copy ();
+          uint8_t hop = 'a' + index;
+          copy->AddAtEnd (Create<Packet> (&hop, 1));
+          next->Send (copy, next->GetBroadcast (), protocol);
+        }
+    }
+  return true;
+}
+
+void
+PointToPointMultithreadedTest::StopAfter (Time delay)
+{
+  Simulator::Stop (delay);
+}
+
+std::vector<std::string>
+PointToPointMultithreadedTest::RunScenario (std::string simulator, Time stop)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (simulator));
+  const uint32_t n = 8;
+  m_logs.assign (n, std::vector<std::string> ());
+  m_wrongSystem.assign (n, 0);
+
+  // two nodes per system
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      nodes.push_back (CreateObject<Node> (i / 2));
+    }
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", DataRateValue (DataRate ("10Mbps")));
+  for (uint32_t i = 0; i + 1 < n; ++i)
+    {
+      bool remote = nodes[i]->GetSystemId () != nodes[i + 1]->GetSystemId ();
+      p2p.SetChannelAttribute ("Delay", TimeValue (remote ? MilliSeconds (2 + i % 3) : MicroSeconds (500)));
+      p2p.Install (nodes[i], nodes[i + 1]);
+    }
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      for (uint32_t j = 0; j < nodes[i]->GetNDevices (); ++j)
+        {
+          nodes[i]->GetDevice (j)->SetReceiveCallback (MakeBoundCallback (&PointToPointMultithreadedTest::Receive, this, i));
+        }
+    }
+  // the senders at both ends and one in the middle
+  for (uint32_t i : { 0u, 3u, n - 1 })
+    {
+      Simulator::ScheduleWithContext (nodes[i]->GetId (), Seconds (1.0 + 0.0001 * i),
+                                      &PointToPointMultithreadedTest::SendBurst, nodes[i], i);
+    }
+
+  Time stopTime = Seconds (5);
+  if (stop.IsZero ())
+    {
+      Simulator::Stop (stopTime);
+    }
+  else
+    {
+      stopTime = MilliSeconds (1001) + stop;
+      Simulator::ScheduleWithContext (nodes[0]->GetId (), MilliSeconds (1001),
+                                      &PointToPointMultithreadedTest::StopAfter, stop);
+    }
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), stopTime, "The simulation should stop at the stop time");
+  Simulator::Destroy ();
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+
+  // frames delivered at the same time to a node may come in any order
+  std::vector<std::string> log;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      std::sort (m_logs[i].begin (), m_logs[i].end ());
+      log.insert (log.end (), m_logs[i].begin (), m_logs[i].end ());
+    }
+  return log;
+}
+
+void
+PointToPointMultithreadedTest::DoRun (void)
+{
+  std::vector<std::string> serial = RunScenario ("ns3::DefaultSimulatorImpl", Seconds (0));
+  // the end nodes reach 7 nodes, the middle one 3 on one side and 4 on the other
+  NS_TEST_ASSERT_MSG_EQ (serial.size (), 5 * (7 + 7 + 3 + 4), "Every frame should cross the chain");
+
+  m_checkSystem = true;
+  std::vector<std::string> parallel = RunScenario ("ns3::MultithreadedSimulatorImpl", Seconds (0));
+  m_checkSystem = false;
+  for (uint32_t i = 0; i < m_wrongSystem.size (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_wrongSystem[i], 0, "Node " << i << " should be simulated by its system");
+    }
+  NS_TEST_ASSERT_MSG_EQ (parallel.size (), serial.size (), "The simulator changed the frames");
+  for (std::size_t i = 0; i < serial.size (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (parallel[i], serial[i], "The simulator changed event " << i);
+    }
+
+  // a stop from an event, one lookahead ahead, stops every system in time
+  serial = RunScenario ("ns3::DefaultSimulatorImpl", MilliSeconds (2));
+  NS_TEST_ASSERT_MSG_LT (serial.size (), 5 * (7 + 7 + 3 + 4), "The stop should cut the chain");
+  parallel = RunScenario ("ns3::MultithreadedSimulatorImpl", MilliSeconds (2));
+  NS_TEST_ASSERT_MSG_EQ (parallel.size (), serial.size (), "The simulator changed the frames before the stop");
+  for (std::size_t i = 0; i < serial.size (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (parallel[i], serial[i], "The simulator changed event " << i << " before the stop");
+    }
+}
+#endif // NS3_MULTITHREADED
+
+/**
+ * \brief Test class for the CompressionCodec implementations
+ *
+ * It round-trips buffers of different shapes through a codec and checks
+ * that compressible input shrinks and that truncated output is reported.
+ */
+class CompressionCodecTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   *
+   * \param tid the TypeId of the codec to test
+   * \param compresses whether the codec is expected to shrink redundant data
+   */
+  CompressionCodecTest (TypeId tid, bool compresses);
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Compress and decompress one buffer, checking the result
+   *
+   * \param codec the codec under test
+   * \param input the buffer to round-trip
+   * \return the compressed size
+   */
+  uint32_t RoundTrip (Ptr<CompressionCodec> codec, const std::vector<uint8_t> &input);
+
+  TypeId m_tid;      //!< Codec under test
+  bool m_compresses; //!< Whether redundant input must shrink
+};
+
+CompressionCodecTest::CompressionCodecTest (TypeId tid, bool compresses)
+  : TestCase ("CompressionCodec round trip for " + tid.GetName ()),
+    m_tid (tid),
+    m_compresses (compresses)
+{
+}
+
+uint32_t
+CompressionCodecTest::RoundTrip (Ptr<CompressionCodec> codec, const std::vector<uint8_t> &input)
+{
+  std::vector<uint8_t> compressed (codec->GetMaxCompressedSize (input.size ()));
+  uint32_t size = codec->Compress (input.data (), input.size (), compressed.data (), compressed.size ());
+  NS_TEST_EXPECT_MSG_NE (size, 0, "Compression failed for " << input.size () << " bytes");
+  if (size == 0)
+    {
+      return 0;
+    }
+
+  std::vector<uint8_t> output (input.size ());
+  uint32_t outSize = codec->Decompress (compressed.data (), size, output.data (), output.size ());
+  NS_TEST_EXPECT_MSG_EQ (outSize, input.size (), "Decompressed size differs");
+  NS_TEST_EXPECT_MSG_EQ ((output == input), true, "Decompressed data differs");
+
+  if (input.size () > 1)
+    {
+      uint32_t shortSize = codec->Decompress (compressed.data (), size, output.data (), input.size () - 1);
+      NS_TEST_EXPECT_MSG_EQ (shortSize, 0, "Overflowing output buffer not reported");
+    }
+  return size;
+}
+
+void
+CompressionCodecTest::DoRun (void)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (m_tid);
+  Ptr<CompressionCodec> codec = factory.Create<CompressionCodec> ();
+
+  std::vector<uint8_t> zeros (1100, 0);
+  std::vector<uint8_t> noise (1500);
+  uint32_t state = 42;
+  for (std::size_t i = 0; i < noise.size (); ++i)
+    {
+      state = state * 1103515245 + 12345;
+      noise[i] = static_cast<uint8_t> (state >> 16);
+    }
+  std::vector<uint8_t> text;
+  const std::string sentence = "the quick brown fox jumps over the lazy dog; ";
+  while (text.size () < 4000)
+    {
+      text.insert (text.end (), sentence.begin (), sentence.end ());
+      text.push_back (static_cast<uint8_t> (text.size ()));
+    }
+
+  uint32_t zeroSize = RoundTrip (codec, zeros);
+  RoundTrip (codec, noise);
+  uint32_t textSize = RoundTrip (codec, text);
+  RoundTrip (codec, std::vector<uint8_t> (1, 7));
+  RoundTrip (codec, std::vector<uint8_t> (noise.begin (), noise.begin () + 13));
+  if (m_compresses)
+    {
+      NS_TEST_EXPECT_MSG_LT (zeroSize, zeros.size () / 4, "Zero buffer did not compress");
+    }
+  if (m_compresses && m_tid != RleCompressionCodec::GetTypeId ())
+    {
+      NS_TEST_EXPECT_MSG_LT (textSize, text.size () / 2, "Repetitive text did not compress");
+    }
+
+  // Stream mode: the second copy of the noise can only shrink by referring
+  // back to the first one
+  codec->ResetCompressStream ();
+  codec->ResetDecompressStream ();
+  const std::vector<uint8_t> *stream[] = { &noise, &noise, &text, &zeros };
+  std::vector<uint32_t> streamSizes;
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      const std::vector<uint8_t> &input = *stream[i];
+      std::vector<uint8_t> compressed (codec->GetMaxCompressedSize (input.size ()));
+      uint32_t size = codec->CompressStream (input.data (), input.size (),
+                                             compressed.data (), compressed.size ());
+      NS_TEST_ASSERT_MSG_NE (size, 0, "Stream compression failed for buffer " << i);
+      std::vector<uint8_t> output (input.size () + 1);
+      uint32_t outSize = codec->DecompressStream (compressed.data (), size,
+                                                  output.data (), output.size ());
+      output.resize (outSize);
+      NS_TEST_EXPECT_MSG_EQ ((output == input), true, "Stream buffer " << i << " differs");
+      streamSizes.push_back (size);
+    }
+  if (m_tid == ZlibCompressionCodec::GetTypeId () || m_tid == DeflateCompressionCodec::GetTypeId ())
+    {
+      NS_TEST_EXPECT_MSG_LT (streamSizes[1], noise.size () / 10, "Stream history not used");
+    }
+  codec->Dispose ();
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -110,6 +2071,30 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointCompressionTest (false), TestCase::QUICK);
+  AddTestCase (new PointToPointCompressionTest (true), TestCase::QUICK);
+  AddTestCase (new PointToPointCompressionEngineTest, TestCase::QUICK);
+  AddTestCase (new PointToPointAdaptiveCompressionTest, TestCase::QUICK);
+  AddTestCase (new PointToPointCompressionFilterTest, TestCase::QUICK);
+  AddTestCase (new PointToPointStreamCompressionTest, TestCase::QUICK);
+  // an idle link sends the first frame alone, a 10 ms timeout lets it wait for company
+  AddTestCase (new PointToPointAggregationTest (Seconds (0), false, { 1, 4, 4, 1 }), TestCase::QUICK);
+  AddTestCase (new PointToPointAggregationTest (MilliSeconds (10), false, { 4, 4, 2 }), TestCase::QUICK);
+  AddTestCase (new PointToPointAggregationTest (MilliSeconds (10), true, { 4, 4, 2 }), TestCase::QUICK);
+  AddTestCase (new PointToPointHeaderCompressionTest (false), TestCase::QUICK);
+  AddTestCase (new PointToPointHeaderCompressionTest (true), TestCase::QUICK);
+  AddTestCase (new PointToPointCompressionStatsTest, TestCase::QUICK);
+  AddTestCase (new PointToPointBinaryTraceTest, TestCase::QUICK);
+  AddTestCase (new PointToPointCompressionOffloadTest (false), TestCase::QUICK);
+  AddTestCase (new PointToPointCompressionOffloadTest (true), TestCase::QUICK);
+#ifdef NS3_MULTITHREADED
+  AddTestCase (new PointToPointMultithreadedTest, TestCase::QUICK);
+#endif
+  AddTestCase (new CompressionCodecTest (NullCompressionCodec::GetTypeId (), false), TestCase::QUICK);
+  AddTestCase (new CompressionCodecTest (ZlibCompressionCodec::GetTypeId (), true), TestCase::QUICK);
+  AddTestCase (new CompressionCodecTest (DeflateCompressionCodec::GetTypeId (), true), TestCase::QUICK);
+  AddTestCase (new CompressionCodecTest (Lz4CompressionCodec::GetTypeId (), true), TestCase::QUICK);
+  AddTestCase (new CompressionCodecTest (RleCompressionCodec::GetTypeId (), true), TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "ns3/assert.h"
+#include "p2-quantile-estimator.h"
+
+namespace ns3 {
+
+P2QuantileEstimator::P2QuantileEstimator (double p)
+  : m_p (p)
+{
+  NS_ASSERT_MSG (p >= 0 && p <= 1, "Quantile " << p << " outside of [0, 1]");
+  Reset ();
+}
+
+void
+P2QuantileEstimator::Reset ()
+{
+  m_count = 0;
+  for (int i = 0; i < 5; ++i)
+    {
+      m_q[i] = 0;
+      m_n[i] = i;
+    }
+  m_np[0] = 0;
+  m_np[1] = 2 * m_p;
+  m_np[2] = 4 * m_p;
+  m_np[3] = 2 + 2 * m_p;
+  m_np[4] = 4;
+  m_dn[0] = 0;
+  m_dn[1] = m_p / 2;
+  m_dn[2] = m_p;
+  m_dn[3] = (1 + m_p) / 2;
+  m_dn[4] = 1;
+}
+
+double
+P2QuantileEstimator::Parabolic (int i, double d) const
+{
+  return m_q[i] + d / (m_n[i + 1] - m_n[i - 1])
+         * ((m_n[i] - m_n[i - 1] + d) * (m_q[i + 1] - m_q[i]) / (m_n[i + 1] - m_n[i])
+            + (m_n[i + 1] - m_n[i] - d) * (m_q[i] - m_q[i - 1]) / (m_n[i] - m_n[i - 1]));
+}
+
+double
+P2QuantileEstimator::Linear (int i, int d) const
+{
+  return m_q[i] + d * (m_q[i + d] - m_q[i]) / (m_n[i + d] - m_n[i]);
+}
+
+void
+P2QuantileEstimator::Update (double x)
+{
+  if (m_count < 5)
+    {
+      m_q[m_count++] = x;
+      if (m_count == 5)
+        {
+          std::sort (m_q, m_q + 5);
+        }
+      return;
+    }
+  m_count++;
+
+  // Cell of the sample, stretching the extreme markers if needed
+  int k;
+  if (x < m_q[0])
+    {
+      m_q[0] = x;
+      k = 0;
+    }
+  else if (x >= m_q[4])
+    {
+      m_q[4] = x;
+      k = 3;
+    }
+  else
+    {
+      k = 0;
+      while (x >= m_q[k + 1])
+        {
+          k++;
+        }
+    }
+  for (int i = k + 1; i < 5; ++i)
+    {
+      m_n[i]++;
+    }
+  for (int i = 0; i < 5; ++i)
+    {
+      m_np[i] += m_dn[i];
+    }
+
+  // Move the middle markers towards their desired positions
+  for (int i = 1; i < 4; ++i)
+    {
+      double d = m_np[i] - m_n[i];
+      if ((d >= 1 && m_n[i + 1] - m_n[i] > 1) || (d <= -1 && m_n[i - 1] - m_n[i] < -1))
+        {
+          int sign = d > 0 ? 1 : -1;
+          double q = Parabolic (i, sign);
+          if (m_q[i - 1] < q && q < m_q[i + 1])
+            {
+              m_q[i] = q;
+            }
+          else
+            {
+              m_q[i] = Linear (i, sign);
+            }
+          m_n[i] += sign;
+        }
+    }
+}
+
+double
+P2QuantileEstimator::Get () const
+{
+  if (m_count == 0)
+    {
+      return 0;
+    }
+  if (m_count < 5)
+    {
+      double sorted[5];
+      std::copy (m_q, m_q + m_count, sorted);
+      std::sort (sorted, sorted + m_count);
+      uint32_t i = static_cast<uint32_t> (std::floor (m_p * (m_count - 1) + 0.5));
+      return sorted[i];
+    }
+  return m_q[2];
+}
+
+} // namespace ns3
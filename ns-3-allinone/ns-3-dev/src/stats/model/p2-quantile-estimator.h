@@ -0,0 +1,82 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef P2_QUANTILE_ESTIMATOR_H
+#define P2_QUANTILE_ESTIMATOR_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup stats
+ *
+ * Streaming estimate of a quantile with the P-square algorithm of
+ * R. Jain and I. Chlamtac, "The P2 algorithm for dynamic calculation of
+ * quantiles and histograms without storing observations", Communications
+ * of the ACM 28(10), 1985.
+ *
+ * Five markers are kept whatever the number of samples; the estimate is
+ * exact up to five samples.
+ */
+class P2QuantileEstimator
+{
+public:
+  /**
+   * \param p the quantile to estimate, in [0, 1]
+   */
+  P2QuantileEstimator (double p = 0.5);
+
+  /// Add new sample
+  void Update (double x);
+  /// Reset statistics
+  void Reset ();
+
+  /// Sample size
+  uint32_t Count () const { return m_count; }
+  /// Quantile estimated
+  double GetP () const { return m_p; }
+  /// Estimate of the quantile, 0 without samples
+  double Get () const;
+
+private:
+  /**
+   * \brief Piecewise-parabolic prediction of marker i moved by d
+   * \param i the marker
+   * \param d the move, -1 or 1
+   * \return the predicted height
+   */
+  double Parabolic (int i, double d) const;
+
+  /**
+   * \brief Linear prediction of marker i moved by d
+   * \param i the marker
+   * \param d the move, -1 or 1
+   * \return the predicted height
+   */
+  double Linear (int i, int d) const;
+
+  double m_p;          //!< Quantile estimated
+  uint32_t m_count;    //!< Number of samples
+  double m_q[5];       //!< Marker heights
+  double m_n[5];       //!< Marker positions
+  double m_np[5];      //!< Desired marker positions
+  double m_dn[5];      //!< Increments of the desired positions
+};
+
+} // namespace ns3
+
+#endif /* P2_QUANTILE_ESTIMATOR_H */
@@ -0,0 +1,127 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/p2-quantile-estimator.h"
+
+using namespace ns3;
+
+// ===========================================================================
+// Test case for fewer samples than markers, where the estimate is exact.
+// ===========================================================================
+
+class FewSamplesP2QuantileTestCase : public TestCase
+{
+public:
+  FewSamplesP2QuantileTestCase ();
+  virtual ~FewSamplesP2QuantileTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FewSamplesP2QuantileTestCase::FewSamplesP2QuantileTestCase ()
+  : TestCase ("P2 Quantile Estimator Test using Three Values")
+
+{
+}
+
+FewSamplesP2QuantileTestCase::~FewSamplesP2QuantileTestCase ()
+{
+}
+
+void
+FewSamplesP2QuantileTestCase::DoRun (void)
+{
+  P2QuantileEstimator median (0.5);
+  NS_TEST_ASSERT_MSG_EQ (median.Get (), 0, "Estimate without samples");
+
+  median.Update (30);
+  median.Update (10);
+  median.Update (20);
+  NS_TEST_ASSERT_MSG_EQ (median.Count (), 3, "Wrong count");
+  NS_TEST_ASSERT_MSG_EQ (median.Get (), 20, "Wrong median of three values");
+
+  median.Reset ();
+  median.Update (7);
+  NS_TEST_ASSERT_MSG_EQ (median.Count (), 1, "Count not reset");
+  NS_TEST_ASSERT_MSG_EQ (median.Get (), 7, "Wrong median of one value");
+}
+
+
+// ===========================================================================
+// Test case for a long sequence of shuffled values.
+// ===========================================================================
+
+class ShuffledP2QuantileTestCase : public TestCase
+{
+public:
+  ShuffledP2QuantileTestCase ();
+  virtual ~ShuffledP2QuantileTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ShuffledP2QuantileTestCase::ShuffledP2QuantileTestCase ()
+  : TestCase ("P2 Quantile Estimator Test using Shuffled Values")
+
+{
+}
+
+ShuffledP2QuantileTestCase::~ShuffledP2QuantileTestCase ()
+{
+}
+
+void
+ShuffledP2QuantileTestCase::DoRun (void)
+{
+  P2QuantileEstimator median (0.5);
+  P2QuantileEstimator p95 (0.95);
+  P2QuantileEstimator p10 (0.1);
+
+  // 0, 1, ..., count - 1 in the order of a full-period linear congruential sequence
+  uint32_t count = 10000;
+  uint32_t x = 0;
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      x = (x * 4001 + 7) % count;
+      median.Update (x);
+      p95.Update (x);
+      p10.Update (x);
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (median.Count (), count, "Wrong count");
+  NS_TEST_ASSERT_MSG_EQ_TOL (median.Get (), 0.5 * count, 0.02 * count, "Median outside of tolerance");
+  NS_TEST_ASSERT_MSG_EQ_TOL (p95.Get (), 0.95 * count, 0.02 * count, "95th percentile outside of tolerance");
+  NS_TEST_ASSERT_MSG_EQ_TOL (p10.Get (), 0.1 * count, 0.02 * count, "10th percentile outside of tolerance");
+}
+
+
+class P2QuantileEstimatorTestSuite : public TestSuite
+{
+public:
+  P2QuantileEstimatorTestSuite ();
+};
+
+P2QuantileEstimatorTestSuite::P2QuantileEstimatorTestSuite ()
+  : TestSuite ("p2-quantile-estimator", UNIT)
+{
+  AddTestCase (new FewSamplesP2QuantileTestCase, TestCase::QUICK);
+  AddTestCase (new ShuffledP2QuantileTestCase, TestCase::QUICK);
+}
+
+static P2QuantileEstimatorTestSuite p2QuantileEstimatorTestSuite;
@@ -18,11 +18,23 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 
+#include <chrono>
 #include <iomanip>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <vector>
 #include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
 
 #include "ns3/core-module.h"
 
@@ -39,6 +51,79 @@ std::string g_me;
 // Output field width
 int g_fwidth = 6;
 
+/// Hardware cache miss counter of the calling thread, where available
+class CacheMissCounter
+{
+public:
+  CacheMissCounter ()
+    : m_fd (-1)
+  {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset (&attr, 0, sizeof (attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof (attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    m_fd = syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  }
+
+  ~CacheMissCounter ()
+  {
+    if (m_fd >= 0)
+      {
+        close (m_fd);
+      }
+  }
+
+  /// Start counting from zero
+  void Start (void)
+  {
+#ifdef __linux__
+    if (m_fd >= 0)
+      {
+        ioctl (m_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl (m_fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+#endif
+  }
+
+  /**
+   * Stop counting
+   * \return the cache misses since Start, or -1 if they cannot be counted
+   */
+  int64_t Stop (void)
+  {
+    int64_t count = -1;
+#ifdef __linux__
+    if (m_fd >= 0)
+      {
+        ioctl (m_fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read (m_fd, &count, sizeof (count)) != sizeof (count))
+          {
+            count = -1;
+          }
+      }
+#endif
+    return count;
+  }
+
+private:
+  int m_fd; ///< perf event file descriptor, -1 if unavailable
+};
+
+/// Outcome of a run
+struct BenchResult
+{
+  double init;          ///< initialization time (s)
+  double simu;          ///< simulation time (s)
+  uint32_t count;       ///< events executed, draining the population included
+  int64_t cacheMisses;  ///< cache misses during the simulation, -1 if unknown
+};
+
 /// Bench class
 class Bench
 {
@@ -51,7 +136,10 @@ public:
   Bench (const uint32_t population, const uint32_t total)
     : m_population (population),
       m_total (total),
-      m_count (0)
+      m_count (0),
+      m_executed (0),
+      m_fraction (0),
+      m_cancel (0)
   {
   }
 
@@ -64,6 +152,31 @@ public:
     m_rand = stream;
   }
 
+  /**
+   * Draw a fraction of the event delays from a second stream
+   * \param stream the random variable stream
+   * \param fraction the fraction of the delays drawn from \p stream
+   */
+  void SetSecondStream (Ptr<RandomVariableStream> stream, double fraction)
+  {
+    m_rand2 = stream;
+    m_fraction = fraction;
+  }
+
+  /**
+   * Set the hold/cancel mix
+   *
+   * A population of timers, \p cancel times the event population, is
+   * scheduled ten delays ahead, and each event restarts a random timer,
+   * removing it from the scheduler, with probability \p cancel.
+   *
+   * \param cancel the probability an event restarts a timer
+   */
+  void SetCancel (double cancel)
+  {
+    m_cancel = cancel;
+  }
+
   /**
    * Set population function
    * \param population the population
@@ -82,68 +195,131 @@ public:
     m_total = total;
   }
 
-  /// Run function
-  void RunBench (void);
+  /**
+   * Run function
+   * \return the times and counts of the run
+   */
+  BenchResult RunBench (void);
 private:
+  /**
+   * Draw an event delay
+   * \return the delay
+   */
+  Time GetDelay (void);
   /// callback function
   void Cb (void);
+  /// timer callback function
+  void Timer (void)
+  {
+    ++m_executed;
+  }
 
   Ptr<RandomVariableStream> m_rand; ///< random variable
+  Ptr<RandomVariableStream> m_rand2; ///< second random variable
+  Ptr<UniformRandomVariable> m_uniform; ///< choice of the stream and of the timers
   uint32_t m_population; ///< population
   uint32_t m_total; ///< total
-  uint32_t m_count; ///< count 
+  uint32_t m_count; ///< count of the events which scheduled another
+  uint32_t m_executed; ///< count of the events executed
+  double m_fraction; ///< fraction of the delays drawn from m_rand2
+  double m_cancel; ///< probability an event restarts a timer
+  std::vector<EventId> m_timers; ///< timers
+  CacheMissCounter m_misses; ///< cache miss counter
 };
 
-void
+BenchResult
 Bench::RunBench (void)
 {
-  SystemWallClockMs time;
+  // finer than SystemWallClockMs, small populations initialize in microseconds
+  typedef std::chrono::steady_clock Clock;
+  typedef std::chrono::duration<double> Seconds;
+  Clock::time_point start;
   double init, simu;
 
   DEB ("initializing");
   m_count = 0;
+  m_executed = 0;
+  m_timers.clear ();
+  if (m_uniform == 0)
+    {
+      m_uniform = CreateObject<UniformRandomVariable> ();
+    }
 
-
-  time.Start ();
+  start = Clock::now ();
   for (uint32_t i = 0; i < m_population; ++i)
     {
-      Time at = NanoSeconds (m_rand->GetValue ());
+      Time at = GetDelay ();
       Simulator::Schedule (at, &Bench::Cb, this);
     }
-  init = time.End ();
-  init /= 1000;
+  for (uint32_t i = 0; i < m_population * m_cancel; ++i)
+    {
+      m_timers.push_back (Simulator::Schedule (GetDelay () * 10, &Bench::Timer, this));
+    }
+  init = Seconds (Clock::now () - start).count ();
   DEB ("initialization took " << init << "s");
 
   DEB ("running");
-  time.Start ();
+  start = Clock::now ();
+  m_misses.Start ();
   Simulator::Run ();
-  simu = time.End ();
-  simu /= 1000;
+  int64_t misses = m_misses.Stop ();
+  simu = Seconds (Clock::now () - start).count ();
   DEB ("run took " << simu << "s");
 
-  LOG (std::setw (g_fwidth) << init <<
-       std::setw (g_fwidth) << (m_population / init) <<
-       std::setw (g_fwidth) << (init / m_population) <<
-       std::setw (g_fwidth) << simu <<
-       std::setw (g_fwidth) << (m_count / simu) <<
-       std::setw (g_fwidth) << (simu / m_count));
+  BenchResult result = { init, simu, m_executed, misses };
+  return result;
+}
 
+Time
+Bench::GetDelay (void)
+{
+  if (m_rand2 != 0 && m_uniform->GetValue () < m_fraction)
+    {
+      return NanoSeconds (m_rand2->GetValue ());
+    }
+  return NanoSeconds (m_rand->GetValue ());
 }
 
 void
 Bench::Cb (void)
 {
+  // once m_total events have run, the population drains without
+  // rescheduling, but each of these events still costs a removal
+  ++m_executed;
   if (m_count >= m_total)
     {
       return;
     }
   DEB ("event at " << Simulator::Now ().GetSeconds () << "s");
 
-  Time after = NanoSeconds (m_rand->GetValue ());
+  Time after = GetDelay ();
   Simulator::Schedule (after, &Bench::Cb, this);
+  if (!m_timers.empty () && m_uniform->GetValue () < m_cancel)
+    {
+      // restart a timer, as protocols do on activity
+      uint32_t i = m_uniform->GetInteger (0, m_timers.size () - 1);
+      Simulator::Remove (m_timers[i]);
+      m_timers[i] = Simulator::Schedule (GetDelay () * 10, &Bench::Timer, this);
+    }
   ++m_count;
 }
 
+/**
+ * Print a run as a row of the table
+ * \param population the population
+ * \param result the outcome of the run
+ */
+void
+PrintResult (uint32_t population, const BenchResult &result)
+{
+  LOG (std::setw (g_fwidth) << result.init <<
+       std::setw (g_fwidth) << (population / result.init) <<
+       std::setw (g_fwidth) << (result.init / population) <<
+       std::setw (g_fwidth) << result.simu <<
+       std::setw (g_fwidth) << (result.count / result.simu) <<
+       std::setw (g_fwidth) << (result.simu / result.count));
+}
+
 
 Ptr<RandomVariableStream>
 GetRandomStream (std::string filename)
@@ -198,6 +374,232 @@ GetRandomStream (std::string filename)
   return stream;
 }
 
+/**
+ * Read the event delays of a DesMetrics trace
+ *
+ * Each record of the trace holds the source context, the send time, the
+ * destination context and the execution time, in time steps.
+ *
+ * \param filename the trace
+ * \return the delays, in time steps
+ */
+std::vector<double>
+ReadDesMetrics (std::string filename)
+{
+  LOGME ("replaying event delays from DesMetrics trace " << filename);
+  std::ifstream input (filename.c_str ());
+  std::vector<double> delays;
+  std::string line;
+  bool events = false;
+  while (std::getline (input, line))
+    {
+      if (!events)
+        {
+          events = line.find ("\"events\"") != std::string::npos;
+          continue;
+        }
+      for (std::string::iterator c = line.begin (); c != line.end (); ++c)
+        {
+          if (*c == '[' || *c == ']' || *c == '"' || *c == ',')
+            {
+              *c = ' ';
+            }
+        }
+      std::istringstream record (line);
+      double send, recv;
+      std::string source, destination;
+      if (record >> source >> send >> destination >> recv)
+        {
+          delays.push_back (recv - send);
+        }
+    }
+  LOGME ("found " << delays.size () << " events");
+  return delays;
+}
+
+/**
+ * Set the event delay distribution of a bench
+ *
+ * \param bench the bench
+ * \param dist the distribution: constant, exponential, bimodal, file or
+ * desmetrics
+ * \param filename the file read by the file distribution
+ * \param replay the delays replayed by the desmetrics distribution
+ */
+void
+SetDistribution (Bench *bench, std::string dist, std::string filename,
+                 std::vector<double> &replay)
+{
+  if (dist == "constant")
+    {
+      Ptr<ConstantRandomVariable> crv = CreateObject<ConstantRandomVariable> ();
+      crv->SetAttribute ("Constant", DoubleValue (100));
+      bench->SetRandomStream (crv);
+    }
+  else if (dist == "exponential")
+    {
+      bench->SetRandomStream (GetRandomStream (""));
+    }
+  else if (dist == "bimodal")
+    {
+      // mostly packet-scale delays, with timer-scale ones
+      Ptr<ExponentialRandomVariable> shortDelay = CreateObject<ExponentialRandomVariable> ();
+      shortDelay->SetAttribute ("Mean", DoubleValue (100));
+      Ptr<ExponentialRandomVariable> longDelay = CreateObject<ExponentialRandomVariable> ();
+      longDelay->SetAttribute ("Mean", DoubleValue (1000000));
+      bench->SetRandomStream (shortDelay);
+      bench->SetSecondStream (longDelay, 0.1);
+    }
+  else if (dist == "file")
+    {
+      bench->SetRandomStream (GetRandomStream (filename));
+    }
+  else if (dist == "desmetrics")
+    {
+      NS_ABORT_MSG_IF (replay.empty (), "No events to replay");
+      Ptr<DeterministicRandomVariable> drv = CreateObject<DeterministicRandomVariable> ();
+      drv->SetValueArray (&replay[0], replay.size ());
+      bench->SetRandomStream (drv);
+    }
+  else
+    {
+      NS_FATAL_ERROR ("Unknown distribution " << dist);
+    }
+}
+
+/**
+ * Split a comma separated list
+ * \param list the list
+ * \return the items
+ */
+std::vector<std::string>
+Split (std::string list)
+{
+  std::vector<std::string> items;
+  std::istringstream is (list);
+  std::string item;
+  while (std::getline (is, item, ','))
+    {
+      if (!item.empty ())
+        {
+          items.push_back (item);
+        }
+    }
+  return items;
+}
+
+/**
+ * Run one configuration of the suite in a child process, so that each
+ * gets a fresh simulator and its own peak resident set size
+ *
+ * \param scheduler the scheduler type
+ * \param dist the distribution
+ * \param filename the file read by the file distribution
+ * \param replay the delays replayed by the desmetrics distribution
+ * \param population the population
+ * \param total the total
+ * \param cancel the hold/cancel mix
+ * \param timeout seconds after which the child is killed
+ * \return the CSV row
+ */
+std::string
+RunSuiteEntry (std::string scheduler, std::string dist, std::string filename,
+               std::vector<double> &replay, uint32_t population, uint32_t total,
+               double cancel, uint32_t timeout)
+{
+  std::ostringstream row;
+  row << scheduler << "," << dist << "," << population << "," << cancel << "," << total << ",";
+
+  int fds[2];
+  NS_ABORT_MSG_IF (pipe (fds) != 0, "Cannot create a pipe");
+  std::cout.flush ();
+  pid_t pid = fork ();
+  NS_ABORT_MSG_IF (pid < 0, "Cannot fork");
+  if (pid == 0)
+    {
+      close (fds[0]);
+      // keep the progress messages out of the CSV
+      int null = open ("/dev/null", O_WRONLY);
+      dup2 (null, STDOUT_FILENO);
+      alarm (timeout);
+      Simulator::SetScheduler (ObjectFactory (scheduler));
+      Bench bench (population, total);
+      SetDistribution (&bench, dist, filename, replay);
+      bench.SetCancel (cancel);
+      BenchResult result = bench.RunBench ();
+      struct rusage usage;
+      getrusage (RUSAGE_SELF, &usage);
+      std::ostringstream out;
+      out << "ok," << result.init << "," << result.simu << ","
+          << (result.count / result.simu) << "," << (1e9 * result.simu / result.count) << ","
+          << usage.ru_maxrss << "," << result.cacheMisses;
+      std::string line = out.str ();
+      ssize_t written = write (fds[1], line.c_str (), line.size ());
+      _exit (written == static_cast<ssize_t> (line.size ()) ? 0 : 1);
+    }
+  close (fds[1]);
+  std::string line;
+  char buf[256];
+  ssize_t n;
+  while ((n = read (fds[0], buf, sizeof (buf))) > 0)
+    {
+      line.append (buf, n);
+    }
+  close (fds[0]);
+  int status;
+  waitpid (pid, &status, 0);
+  if (WIFEXITED (status) && WEXITSTATUS (status) == 0)
+    {
+      row << line;
+    }
+  else
+    {
+      bool timedOut = WIFSIGNALED (status) && WTERMSIG (status) == SIGALRM;
+      row << (timedOut ? "timeout" : "failed") << ",,,,,,";
+    }
+  return row.str ();
+}
+
+/**
+ * Run every combination of schedulers, distributions, populations and
+ * hold/cancel mixes, and write one CSV row per run
+ *
+ * \param os the output
+ * \param schedulers the scheduler types
+ * \param dists the distributions
+ * \param filename the file read by the file distribution
+ * \param replay the delays replayed by the desmetrics distribution
+ * \param pops the populations
+ * \param total the total
+ * \param cancels the hold/cancel mixes
+ * \param timeout seconds after which a run is abandoned
+ */
+void
+RunSuite (std::ostream &os, std::vector<std::string> schedulers, std::vector<std::string> dists,
+          std::string filename, std::vector<double> &replay, std::vector<std::string> pops,
+          uint32_t total, std::vector<std::string> cancels, uint32_t timeout)
+{
+  os << "scheduler,distribution,population,cancel,total,status,init_s,run_s,"
+     << "events_per_s,ns_per_event,peak_rss_kb,cache_misses" << std::endl;
+  for (std::size_t s = 0; s < schedulers.size (); ++s)
+    {
+      for (std::size_t d = 0; d < dists.size (); ++d)
+        {
+          for (std::size_t p = 0; p < pops.size (); ++p)
+            {
+              for (std::size_t c = 0; c < cancels.size (); ++c)
+                {
+                  uint32_t population = static_cast<uint32_t> (atof (pops[p].c_str ()));
+                  double cancel = atof (cancels[c].c_str ());
+                  std::string row = RunSuiteEntry (schedulers[s], dists[d], filename, replay,
+                                                   population, total, cancel, timeout);
+                  os << row << std::endl;
+                  DEB (row);
+                }
+            }
+        }
+    }
+}
 
 
 int main (int argc, char *argv[])
@@ -205,6 +607,7 @@ int main (int argc, char *argv[])
 
   bool schedCal  = false;
   bool schedHeap = false;
+  bool schedLadder = false;
   bool schedList = false;
   bool schedMap  = true;
 
@@ -212,6 +615,17 @@ int main (int argc, char *argv[])
   uint32_t total = 1000000;
   uint32_t runs  =       1;
   std::string filename = "";
+  std::string dist = "";
+  std::string desMetrics = "";
+  double cancel = 0;
+
+  bool suite = false;
+  std::string schedulerList = "";
+  std::string distList = "";
+  std::string popList = "100,1000,10000,100000,1000000,10000000";
+  std::string cancelList = "0,0.1";
+  std::string output = "";
+  uint32_t timeout = 300;
 
   CommandLine cmd;
   cmd.Usage ("Benchmark the simulator scheduler.\n"
@@ -221,9 +635,21 @@ int main (int argc, char *argv[])
              "  an ascii file, given by the --file=\"<filename>\" argument,\n"
              "  or standard input, by the argument --file=\"-\"\n"
              "In the case of either --file form, the input is expected\n"
-             "to be ascii, giving the relative event times in ns.");
+             "to be ascii, giving the relative event times in ns.\n"
+             "\n"
+             "--dist selects a constant (100 ns), exponential, bimodal\n"
+             "(90% exponential with mean 100 ns, 10% with mean 1 ms) or desmetrics\n"
+             "distribution, the latter replaying the delays of the DesMetrics\n"
+             "trace given by --desmetrics.\n"
+             "\n"
+             "--suite runs every combination of --schedulers (all by default),\n"
+             "--dists, --pops and --cancels, each in its own process, and writes\n"
+             "one CSV row per run to --output: events per second, peak resident\n"
+             "set size, and hardware cache misses (-1 where perf events are not\n"
+             "available).");
   cmd.AddValue ("cal",   "use CalendarSheduler",          schedCal);
   cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
+  cmd.AddValue ("ladder","use LadderScheduler",           schedLadder);
   cmd.AddValue ("list",  "use ListSheduler",              schedList);
   cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
@@ -232,10 +658,60 @@ int main (int argc, char *argv[])
   cmd.AddValue ("runs",  "number of runs (default 1)",    runs);
   cmd.AddValue ("file",  "file of relative event times",  filename);
   cmd.AddValue ("prec",  "printed output precision",      g_fwidth);
+  cmd.AddValue ("dist",  "event delay distribution",      dist);
+  cmd.AddValue ("desmetrics", "DesMetrics trace whose event delays are replayed", desMetrics);
+  cmd.AddValue ("cancel", "probability an event restarts a timer (default 0)", cancel);
+  cmd.AddValue ("suite", "run the benchmark suite",       suite);
+  cmd.AddValue ("schedulers", "suite: comma separated scheduler types", schedulerList);
+  cmd.AddValue ("dists", "suite: comma separated distributions", distList);
+  cmd.AddValue ("pops",  "suite: comma separated populations", popList);
+  cmd.AddValue ("cancels", "suite: comma separated timer restart probabilities", cancelList);
+  cmd.AddValue ("output", "suite: CSV file (default standard output)", output);
+  cmd.AddValue ("timeout", "suite: seconds after which a run is abandoned", timeout);
   cmd.Parse (argc, argv);
   g_me = cmd.GetName () + ": ";
   g_fwidth += 6;  // 5 extra chars in '2.000002e+07 ': . e+0 _
 
+  std::vector<double> replay;
+  if (desMetrics != "")
+    {
+      replay = ReadDesMetrics (desMetrics);
+    }
+
+  if (suite)
+    {
+      std::vector<std::string> schedulers = Split (schedulerList);
+      for (uint16_t i = 0; schedulerList == "" && i < TypeId::GetRegisteredN (); ++i)
+        {
+          TypeId tid = TypeId::GetRegistered (i);
+          if (tid.IsChildOf (Scheduler::GetTypeId ()) && tid.HasConstructor ())
+            {
+              schedulers.push_back (tid.GetName ());
+            }
+        }
+      std::vector<std::string> dists = Split (distList);
+      if (distList == "")
+        {
+          dists = Split ("constant,exponential,bimodal");
+          if (filename != "")
+            {
+              dists.push_back ("file");
+            }
+          if (desMetrics != "")
+            {
+              dists.push_back ("desmetrics");
+            }
+        }
+      std::ofstream file;
+      if (output != "")
+        {
+          file.open (output.c_str ());
+        }
+      RunSuite (output != "" ? file : std::cout, schedulers, dists, filename, replay,
+                Split (popList), total, Split (cancelList), timeout);
+      return 0;
+    }
+
   ObjectFactory factory ("ns3::MapScheduler");
   if (schedCal)
     {
@@ -245,6 +721,10 @@ int main (int argc, char *argv[])
     {
       factory.SetTypeId ("ns3::HeapScheduler");
     }
+  if (schedLadder)
+    {
+      factory.SetTypeId ("ns3::LadderScheduler");
+    }
   if (schedList)
     {
       factory.SetTypeId ("ns3::ListScheduler");
@@ -260,7 +740,12 @@ int main (int argc, char *argv[])
   LOGME ("runs: " << runs);
 
   Bench *bench = new Bench (pop, total);
-  bench->SetRandomStream (GetRandomStream (filename));
+  if (dist == "")
+    {
+      dist = desMetrics != "" ? "desmetrics" : (filename != "" ? "file" : "exponential");
+    }
+  SetDistribution (bench, dist, filename, replay);
+  bench->SetCancel (cancel);
 
   // table header
   LOG ("");
@@ -288,7 +773,7 @@ int main (int argc, char *argv[])
   // prime
   DEB ("priming");
   std::cout << std::left << std::setw (g_fwidth) << "(prime)";
-  bench->RunBench ();
+  PrintResult (pop, bench->RunBench ());
 
   bench->SetPopulation (pop);
   bench->SetTotal (total);
@@ -296,7 +781,7 @@ int main (int argc, char *argv[])
     {
       std::cout << std::setw (g_fwidth) << i;
 
-      bench->RunBench ();
+      PrintResult (pop, bench->RunBench ());
     }
 
   LOG ("");